@@ -131,6 +131,8 @@ int do_recording(uint8_t device_index,
     {
         CHECK(k4a_record_add_imu_track(recording), device);
     }
+    // Captures are released right after they are written and never modified, so they don't need to be copied.
+    CHECK(k4a_record_set_zero_copy(recording, true), device);
     CHECK(k4a_record_write_header(recording), device);
 
     // Wait for the first capture before starting recording.
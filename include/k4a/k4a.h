@@ -85,6 +85,39 @@ K4A_EXPORT k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *
                                                       void *message_cb_context,
                                                       k4a_log_level_t min_level);
 
+/** Sets the callback functions for the SDK allocator
+ *
+ * \param allocate
+ * The callback function to allocate memory. When the SDK requires memory allocation this callback will be
+ * called and the application can provide a buffer and a context.
+ *
+ * \param free
+ * The callback function to free memory. The SDK will call this function when memory allocated by \p allocate
+ * is no longer needed.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the callback functions were set, ::K4A_RESULT_FAILED if only one of them was
+ * provided.
+ *
+ * \remarks
+ * Call this function to hook memory allocation by the SDK, for instance to back capture buffers with large pages or
+ * with memory local to a NUMA node. Calling with both \p allocate and \p free as NULL restores the default behavior.
+ *
+ * \remarks
+ * The SDK keeps a few buffers of each capture image size in a pool while the cameras are running, so \p allocate is
+ * not called for every capture. Each buffer is released with the \p free function that was set when it was
+ * allocated, so the callback functions may be changed while buffers are outstanding; the previous \p free function
+ * must remain callable until those buffers are released.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t *allocate, k4a_memory_destroy_cb_t *free);
+
 /** Open an Azure Kinect device.
  *
  * \param index
@@ -197,6 +230,35 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
                                                     k4a_capture_t *capture_handle,
                                                     int32_t timeout_in_ms);
 
+/** Reads the latency statistics of the captures returned by k4a_device_get_capture().
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param stats
+ * Location to write the statistics to.
+ *
+ * \remarks
+ * Summarizes the time between the ::k4a_capture_stage_t timestamps of every capture returned by
+ * k4a_device_get_capture() since k4a_device_start_cameras() was last called. The statistics are updated without locks
+ * and may be read at any time, from any thread, while the device is streaming.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p stats was written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_capture_latency_stats(k4a_device_t device_handle,
+                                                             k4a_capture_latency_stats_t *stats);
+
 /** Reads an IMU sample.
  *
  * \param device_handle
@@ -255,6 +317,63 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handl
                                                        k4a_imu_sample_t *imu_sample,
                                                        int32_t timeout_in_ms);
 
+/** Reads all available IMU samples, up to a maximum count.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param imu_samples
+ * Pointer to an array of \p max_samples samples for the API to write the IMU samples to, oldest first.
+ *
+ * \param max_samples
+ * The number of samples \p imu_samples can hold. Must be at least 1.
+ *
+ * \param sample_count
+ * Pointer to the location for the API to write the number of samples read.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for a sample if none is available. If set to 0,
+ * the function will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data
+ * is available, the device is disconnected, or another error occurs.
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if at least one sample is returned. If no sample is available before the timeout elapses,
+ * the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Behaves like k4a_device_get_imu_sample(), but returns every sample that is buffered, up to \p max_samples, in one
+ * call. The function only blocks when no sample is buffered, and returns as soon as one or more samples arrive. IMU
+ * samples are produced at about 1.6 kHz, so reading them in batches uses far fewer calls than reading them one at a
+ * time.
+ *
+ * \remarks
+ * Samples read by this function and by k4a_device_get_imu_sample() come from the same stream; each sample is returned
+ * only once.
+ *
+ * \remarks
+ * This function needs to be called while the device is in a running state;
+ * after k4a_device_start_imu() is called and before k4a_device_stop_imu() is called.
+ *
+ * \remarks
+ * If this function is waiting for data (non-zero timeout) when k4a_device_stop_imu() or k4a_device_close() is
+ * called on another thread, this function will return an error.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                                        k4a_imu_sample_t *imu_samples,
+                                                        size_t max_samples,
+                                                        size_t *sample_count,
+                                                        int32_t timeout_in_ms);
+
 /** Create an empty capture object.
  *
  * \param capture_handle
@@ -533,6 +652,36 @@ K4A_EXPORT void k4a_capture_set_temperature_c(k4a_capture_t capture_handle, floa
  */
 K4A_EXPORT float k4a_capture_get_temperature_c(k4a_capture_t capture_handle);
 
+/** Get the host time at which the capture passed a stage of the capture pipeline.
+ *
+ * \param capture_handle
+ * Capture handle to retrieve the timestamp from.
+ *
+ * \param stage
+ * Pipeline stage to retrieve the timestamp of.
+ *
+ * \remarks
+ * Timestamps are read from a monotonic host clock in microseconds, QueryPerformanceCounter() on Windows and
+ * CLOCK_MONOTONIC elsewhere. Their absolute value has no defined meaning, but timestamps of different stages and
+ * captures of the same process may be subtracted to measure latency. Unlike k4a_image_get_timestamp_usec(), they are
+ * not related to the device clock.
+ *
+ * \returns
+ * The timestamp in microseconds, or 0 if the capture did not pass \p stage. Captures created with
+ * k4a_capture_create() have no timestamps, and color only captures have none for the depth stages.
+ *
+ * \relates k4a_capture_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_capture_get_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage);
+
 /** Create an image.
  *
  * \param format
@@ -1679,6 +1828,226 @@ K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibr
                                                  k4a_float2_t *target_point2d,
                                                  int *valid);
 
+/** Transform an array of 3D points of a source coordinate system into 3D points of a target coordinate system.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points3d_mm
+ * Array of \p point_count 3D points in millimeters in \p source_camera coordinates.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points3d_mm
+ * Array of \p point_count elements where the 3D points in \p target_camera coordinates are stored in millimeters. May
+ * be the same array as \p source_points3d_mm.
+ *
+ * \param point_count
+ * Number of points to transform.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters.
+ *
+ * \remarks
+ * Produces the same results as calling k4a_calibration_3d_to_3d() for each point, but validates \p calibration only
+ * once.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_3d_to_3d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float3_t *source_points3d_mm,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float3_t *target_points3d_mm,
+                                                       size_t point_count);
+
+/** Transform an array of 2D pixel coordinates with associated depth values of the source camera into 3D points of the
+ * target coordinate system.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points2d
+ * Array of \p point_count 2D pixels in \p source_camera coordinates.
+ *
+ * \param source_depths_mm
+ * Array of \p point_count depths in millimeters, one for each pixel of \p source_points2d.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points3d_mm
+ * Array of \p point_count elements where the 3D points in \p target_camera coordinates are stored in millimeters.
+ *
+ * \param valid
+ * Array of \p point_count elements where 1 is stored for each pixel that is a valid coordinate in the calibration model
+ * and 0 for each pixel that is not.
+ *
+ * \param point_count
+ * Number of points to transform.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points3d_mm and \p valid were successfully written. ::K4A_RESULT_FAILED if \p
+ * calibration contained invalid transformation parameters. Points whose \p valid entry is 0 should be ignored.
+ *
+ * \remarks
+ * Produces the same results as calling k4a_calibration_2d_to_3d() for each point. The calibration is validated once
+ * and the lens distortion model is inverted for many points at a time using the vector instructions of the CPU, which
+ * is considerably faster than transforming the points one by one.
+ *
+ * \remarks
+ * The output arrays must not overlap the input arrays.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float2_t *source_points2d,
+                                                       const float *source_depths_mm,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float3_t *target_points3d_mm,
+                                                       int *valid,
+                                                       size_t point_count);
+
+/** Transform an array of 3D points of a source coordinate system into 2D pixel coordinates of the target camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points3d_mm
+ * Array of \p point_count 3D points in millimeters in \p source_camera coordinates.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points2d
+ * Array of \p point_count elements where the 2D pixels in \p target_camera coordinates are stored.
+ *
+ * \param valid
+ * Array of \p point_count elements where 1 is stored for each point that maps to a valid coordinate in the \p
+ * target_camera coordinate system and 0 for each point that does not.
+ *
+ * \param point_count
+ * Number of points to transform.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points2d and \p valid were successfully written. ::K4A_RESULT_FAILED if \p
+ * calibration contained invalid transformation parameters. Points whose \p valid entry is 0 should be ignored.
+ *
+ * \remarks
+ * Produces the same results as calling k4a_calibration_3d_to_2d() for each point. The calibration is validated once
+ * and the lens distortion model is evaluated for many points at a time using the vector instructions of the CPU.
+ *
+ * \remarks
+ * The output arrays must not overlap the input arrays.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float3_t *source_points3d_mm,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float2_t *target_points2d,
+                                                       int *valid,
+                                                       size_t point_count);
+
+/** Transform an array of 2D pixel coordinates with associated depth values of the source camera into 2D pixel
+ * coordinates of the target camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points2d
+ * Array of \p point_count 2D pixels in \p source_camera coordinates.
+ *
+ * \param source_depths_mm
+ * Array of \p point_count depths in millimeters, one for each pixel of \p source_points2d.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points2d
+ * Array of \p point_count elements where the 2D pixels in \p target_camera coordinates are stored.
+ *
+ * \param valid
+ * Array of \p point_count elements where 1 is stored for each pixel that maps to a valid coordinate in the \p
+ * target_camera coordinate system and 0 for each pixel that does not.
+ *
+ * \param point_count
+ * Number of points to transform.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points2d and \p valid were successfully written. ::K4A_RESULT_FAILED if \p
+ * calibration contained invalid transformation parameters. Points whose \p valid entry is 0 should be ignored.
+ *
+ * \remarks
+ * Produces the same results as calling k4a_calibration_2d_to_2d() for each point, using the same vectorized
+ * unprojection and projection as k4a_calibration_2d_to_3d_batch() and k4a_calibration_3d_to_2d_batch().
+ *
+ * \remarks
+ * If \p source_camera and \p target_camera are identical, \p source_points2d is copied to \p target_points2d and
+ * every \p valid entry is set to 1.
+ *
+ * \remarks
+ * The output arrays must not overlap the input arrays.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float2_t *source_points2d,
+                                                       const float *source_depths_mm,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float2_t *target_points2d,
+                                                       int *valid,
+                                                       size_t point_count);
+
 /** Get handle to transformation handle.
  *
  * \param calibration
@@ -1693,6 +2062,12 @@ K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibr
  * destroyed.
  *
  * \remarks
+ * The per-pixel unprojection tables of each camera are computed, using all processors, by the first function that
+ * needs them rather than by this function, so the first transformation on a handle takes longer than the following
+ * ones. If the environment variable K4A_TRANSFORMATION_CACHE_PATH names an existing directory, the tables are stored
+ * there keyed by the camera calibration and reloaded by later handles, including in other processes.
+ *
+ * \remarks
  * The transformation handle must be destroyed with k4a_transformation_destroy() when it is no longer to be used.
  *
  * \relates k4a_calibration_t
@@ -1724,6 +2099,82 @@ K4A_EXPORT k4a_transformation_t k4a_transformation_create(const k4a_calibration_
  */
 K4A_EXPORT void k4a_transformation_destroy(k4a_transformation_t transformation_handle);
 
+/** Select how the transformation handle computes depth to color and color to depth camera transformations.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param mode
+ * Implementation to use for k4a_transformation_depth_image_to_color_camera() and
+ * k4a_transformation_color_image_to_depth_camera().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the mode was set. ::K4A_RESULT_FAILED if \p mode is not valid, the handle is invalid, or
+ * the resources for the mode could not be created. Selecting ::K4A_TRANSFORMATION_MODE_CPU_FAST also fails if the
+ * calibration has the depth mode or the color resolution turned off.
+ *
+ * \remarks
+ * ::K4A_TRANSFORMATION_MODE_CPU computes the exact projection of every depth pixel on every call.
+ *
+ * \remarks
+ * ::K4A_TRANSFORMATION_MODE_CPU_FAST precomputes, for every depth pixel, a quadratic in 1 / depth that approximates
+ * where the pixel lands in the color camera. The tables are built the first time the mode is selected and take 36
+ * bytes per depth pixel. Afterwards each pixel costs a few multiply-adds per frame instead of a distortion model
+ * evaluation. For depths of 200 mm and beyond the approximated color pixel coordinates are within 0.05 pixels of the
+ * exact projection at every color resolution, and the depth in the color camera is within 0.01 mm. Transformed depth
+ * values can therefore differ by 1 mm, and pixels on the edge of a triangle can flip between covered and uncovered.
+ * Closer depths extrapolate the approximation and lose accuracy.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_set_mode(k4a_transformation_t transformation_handle,
+                                                    k4a_transformation_mode_t mode);
+
+/** Set the number of threads the transformation functions may use.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param thread_count
+ * Number of threads to split each transformation across, including the calling thread. Must be between 1 and 64.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the thread count was set. ::K4A_RESULT_FAILED if \p thread_count is out of range, the
+ * handle is invalid or the threads could not be started.
+ *
+ * \remarks
+ * By default each transformation runs on the calling thread only. With a larger thread count, transformations computed
+ * on the CPU split the image into horizontal bands that are processed in parallel. The output is identical to the
+ * single threaded output.
+ *
+ * \remarks
+ * The threads are started by this function and kept until the thread count is lowered or the handle is destroyed.
+ * Transformations on the same handle share these threads, so concurrent calls on one handle run one after another.
+ *
+ * \remarks
+ * Transformations offloaded to the GPU are not affected by this setting.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_set_thread_count(k4a_transformation_t transformation_handle,
+                                                            uint32_t thread_count);
+
 /** Transforms the depth map into the geometry of the color camera.
  *
  * \param transformation_handle
@@ -1874,6 +2325,155 @@ K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transf
                                                                       const k4a_calibration_type_t camera,
                                                                       k4a_image_t xyz_image);
 
+/** Transforms the depth image and the color image into a point cloud of the depth camera with a color per point.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param color_image
+ * Handle to input color image.
+ *
+ * \param point_format
+ * Layout of each point in \p point_cloud_image.
+ *
+ * \param skip_invalid_points
+ * If true, only points with a valid position and a valid color are written, back to back from the start of \p
+ * point_cloud_image. If false, one point is written for every depth pixel in row major order.
+ *
+ * \param point_cloud_image
+ * Handle to output point cloud image.
+ *
+ * \param point_count
+ * Location to write the number of points written to \p point_cloud_image. May be NULL.
+ *
+ * \remarks
+ * This produces the same positions as k4a_transformation_depth_image_to_point_cloud() with
+ * ::K4A_CALIBRATION_TYPE_DEPTH and the same colors as k4a_transformation_color_image_to_depth_camera(), but computes
+ * both in a single pass over the depth image without full frame intermediate images.
+ *
+ * \remarks
+ * \p depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16 and \p color_image must be of format
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32. Both need to represent the same moment in time.
+ *
+ * \remarks
+ * The format of \p point_cloud_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p point_cloud_image
+ * must match the width and height of \p depth_image, and its stride in bytes must be its width in pixels times the
+ * size of a point in \p point_format.
+ *
+ * \remarks
+ * Points without a valid position have X, Y and Z set to 0, and points without a color have all color channels set to
+ * 0. A valid color that is entirely 0 is written with its blue channel set to 1. When \p skip_invalid_points is true,
+ * the part of \p point_cloud_image after the last point is left unchanged.
+ *
+ * \remarks
+ * The colored point cloud is always computed on the CPU, using the mode, thread count and instruction set of the
+ * transformation handle. Handles that would use the GPU compute exact correspondences instead.
+ *
+ * \remarks
+ * \p point_cloud_image should be created by the caller using k4a_image_create() or k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p point_cloud_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                      const k4a_image_t depth_image,
+                                                      const k4a_image_t color_image,
+                                                      const k4a_colored_point_format_t point_format,
+                                                      bool skip_invalid_points,
+                                                      k4a_image_t point_cloud_image,
+                                                      size_t *point_count);
+
+/** Transforms the depth image into a point cloud with a choice of output layout, optionally keeping only valid points.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param camera
+ * Geometry in which depth map was computed.
+ *
+ * \param point_format
+ * Layout of the points in \p point_cloud_image.
+ *
+ * \param skip_invalid_points
+ * If true, only points of depth pixels with a valid position are written, back to back from the start of \p
+ * point_cloud_image. If false, one point is written for every depth pixel in row major order.
+ *
+ * \param point_cloud_image
+ * Handle to output point cloud image.
+ *
+ * \param pixel_index_image
+ * Handle to output pixel index image. May be NULL.
+ *
+ * \param point_count
+ * Location to write the number of points written to \p point_cloud_image. May be NULL.
+ *
+ * \remarks
+ * \p depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16. The \p camera parameter has the same meaning as for
+ * k4a_transformation_depth_image_to_point_cloud(), which this function matches for ::K4A_POINT_CLOUD_FORMAT_XYZ16 when
+ * \p skip_invalid_points is false.
+ *
+ * \remarks
+ * The format of \p point_cloud_image must be ::K4A_IMAGE_FORMAT_CUSTOM and its width must match the width of \p
+ * depth_image. For ::K4A_POINT_CLOUD_FORMAT_XYZ16 and ::K4A_POINT_CLOUD_FORMAT_XYZ32F its height must match the height
+ * of \p depth_image and its stride in bytes must be 6 or 12 times its width in pixels. For
+ * ::K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR its height must be 3 times the height of \p depth_image and its stride in
+ * bytes must be 4 times its width in pixels.
+ *
+ * \remarks
+ * If \p pixel_index_image is not NULL, its format must be ::K4A_IMAGE_FORMAT_CUSTOM, its width and height must match
+ * \p depth_image and its stride in bytes must be 4 times its width in pixels. It receives one uint32_t per point, the
+ * index y * width + x of the depth pixel the point was computed from.
+ *
+ * \remarks
+ * A depth pixel has a valid position if it has a non-zero depth and an unprojection in the calibration. Invalid pixels
+ * are written as (0, 0, 0) when \p skip_invalid_points is false. When \p skip_invalid_points is true, the points of
+ * the planar format are written to the start of each plane and the contents of \p point_cloud_image and \p
+ * pixel_index_image after the last point are undefined.
+ *
+ * \remarks
+ * \p point_cloud_image and \p pixel_index_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p point_cloud_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_formatted_point_cloud(k4a_transformation_t transformation_handle,
+                                                        const k4a_image_t depth_image,
+                                                        const k4a_calibration_type_t camera,
+                                                        const k4a_point_cloud_format_t point_format,
+                                                        bool skip_invalid_points,
+                                                        k4a_image_t point_cloud_image,
+                                                        k4a_image_t pixel_index_image,
+                                                        size_t *point_count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -569,6 +569,15 @@ public:
         return k4a_capture_get_temperature_c(m_handle);
     }
 
+    /** Get the host time at which the capture passed a stage of the capture pipeline, 0 if it did not.
+     *
+     * \sa k4a_capture_get_stage_timestamp_usec
+     */
+    std::chrono::microseconds get_stage_timestamp(k4a_capture_stage_t stage) const noexcept
+    {
+        return std::chrono::microseconds(k4a_capture_get_stage_timestamp_usec(m_handle, stage));
+    }
+
     /** Create an empty capture object.
      * Throws error on failure.
      *
@@ -689,6 +698,96 @@ struct calibration : public k4a_calibration_t
         return static_cast<bool>(valid);
     }
 
+    /** Transform an array of 3d points of a source coordinate system into 3d points of the target coordinate system
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_3d_to_3d_batch
+     */
+    void convert_3d_to_3d_batch(const k4a_float3_t *source_points3d,
+                                k4a_calibration_type_t source_camera,
+                                k4a_calibration_type_t target_camera,
+                                k4a_float3_t *target_points3d,
+                                size_t point_count) const
+    {
+        k4a_result_t result = k4a_calibration_3d_to_3d_batch(
+            this, source_points3d, source_camera, target_camera, target_points3d, point_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
+    /** Transform an array of 2d pixel coordinates with associated depth values of the source camera into 3d points of
+     * the target coordinate system
+     * Writes 0 to valid for each point that is invalid in the target coordinate system.
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_2d_to_3d_batch
+     */
+    void convert_2d_to_3d_batch(const k4a_float2_t *source_points2d,
+                                const float *source_depths,
+                                k4a_calibration_type_t source_camera,
+                                k4a_calibration_type_t target_camera,
+                                k4a_float3_t *target_points3d,
+                                int *valid,
+                                size_t point_count) const
+    {
+        k4a_result_t result = k4a_calibration_2d_to_3d_batch(
+            this, source_points2d, source_depths, source_camera, target_camera, target_points3d, valid, point_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
+    /** Transform an array of 3d points of a source coordinate system into 2d pixel coordinates of the target camera
+     * Writes 0 to valid for each point that is invalid in the target coordinate system.
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_3d_to_2d_batch
+     */
+    void convert_3d_to_2d_batch(const k4a_float3_t *source_points3d,
+                                k4a_calibration_type_t source_camera,
+                                k4a_calibration_type_t target_camera,
+                                k4a_float2_t *target_points2d,
+                                int *valid,
+                                size_t point_count) const
+    {
+        k4a_result_t result = k4a_calibration_3d_to_2d_batch(
+            this, source_points3d, source_camera, target_camera, target_points2d, valid, point_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
+    /** Transform an array of 2d pixel coordinates with associated depth values of the source camera into 2d pixel
+     * coordinates of the target camera
+     * Writes 0 to valid for each point that is invalid in the target coordinate system.
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_2d_to_2d_batch
+     */
+    void convert_2d_to_2d_batch(const k4a_float2_t *source_points2d,
+                                const float *source_depths,
+                                k4a_calibration_type_t source_camera,
+                                k4a_calibration_type_t target_camera,
+                                k4a_float2_t *target_points2d,
+                                int *valid,
+                                size_t point_count) const
+    {
+        k4a_result_t result = k4a_calibration_2d_to_2d_batch(
+            this, source_points2d, source_depths, source_camera, target_camera, target_points2d, valid, point_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
     /** Get the camera calibration for a device from a raw calibration blob.
      * Throws error on failure.
      *
@@ -812,6 +911,34 @@ public:
         }
     }
 
+    /** Selects how depth to color and color to depth camera transformations are computed.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_set_mode
+     */
+    void set_mode(k4a_transformation_mode_t mode)
+    {
+        k4a_result_t result = k4a_transformation_set_mode(m_handle, mode);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set transformation mode!");
+        }
+    }
+
+    /** Sets the number of threads the transformation functions may use.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_set_thread_count
+     */
+    void set_thread_count(uint32_t thread_count)
+    {
+        k4a_result_t result = k4a_transformation_set_thread_count(m_handle, thread_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set transformation thread count!");
+        }
+    }
+
     /** Transforms the depth map into the geometry of the color camera.
      * Throws error on failure
      *
@@ -862,6 +989,63 @@ public:
         }
     }
 
+    /** Transforms the depth image and the color image into a point cloud of the depth camera with a color per point.
+     * Returns the number of points written to point_cloud_image.
+     * Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_colored_point_cloud
+     */
+    size_t depth_image_to_colored_point_cloud(const image &depth_image,
+                                              const image &color_image,
+                                              k4a_colored_point_format_t point_format,
+                                              bool skip_invalid_points,
+                                              image *point_cloud_image) const
+    {
+        size_t point_count = 0;
+        k4a_result_t result = k4a_transformation_depth_image_to_colored_point_cloud(m_handle,
+                                                                                    depth_image.handle(),
+                                                                                    color_image.handle(),
+                                                                                    point_format,
+                                                                                    skip_invalid_points,
+                                                                                    point_cloud_image->handle(),
+                                                                                    &point_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to colored point cloud!");
+        }
+        return point_count;
+    }
+
+    /** Transforms the depth image into a point cloud with a choice of output layout, optionally keeping only valid
+     * points. pixel_index_image may be nullptr. Returns the number of points written to point_cloud_image.
+     * Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_formatted_point_cloud
+     */
+    size_t depth_image_to_formatted_point_cloud(const image &depth_image,
+                                                k4a_calibration_type_t camera,
+                                                k4a_point_cloud_format_t point_format,
+                                                bool skip_invalid_points,
+                                                image *point_cloud_image,
+                                                image *pixel_index_image = nullptr) const
+    {
+        size_t point_count = 0;
+        k4a_result_t result = k4a_transformation_depth_image_to_formatted_point_cloud(
+            m_handle,
+            depth_image.handle(),
+            camera,
+            point_format,
+            skip_invalid_points,
+            point_cloud_image->handle(),
+            pixel_index_image != nullptr ? pixel_index_image->handle() : nullptr,
+            &point_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to formatted point cloud!");
+        }
+        return point_count;
+    }
+
 private:
     k4a_transformation_t m_handle;
 };
@@ -953,6 +1137,22 @@ public:
         return true;
     }
 
+    /** Reads the latency statistics of the captures returned by get_capture().
+     * Throws error on failure.
+     *
+     * \sa k4a_device_get_capture_latency_stats
+     */
+    k4a_capture_latency_stats_t get_capture_latency_stats() const
+    {
+        k4a_capture_latency_stats_t stats;
+        k4a_result_t result = k4a_device_get_capture_latency_stats(m_handle, &stats);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to get capture latency statistics!");
+        }
+        return stats;
+    }
+
     /** Reads an IMU sample.  Returns true if a sample was read, false if the read timed out.
      * Throws error on failure.
      *
@@ -974,6 +1174,29 @@ public:
         return true;
     }
 
+    /** Reads all available IMU samples, up to max_samples.  Returns the number of samples read, or 0 if the read timed
+     * out.  Throws error on failure.
+     *
+     * \sa k4a_device_get_imu_samples
+     */
+    size_t get_imu_samples(k4a_imu_sample_t *imu_samples, size_t max_samples, std::chrono::milliseconds timeout)
+    {
+        size_t sample_count = 0;
+        int32_t timeout_ms = internal::clamp_cast<int32_t>(timeout.count());
+        k4a_wait_result_t result =
+            k4a_device_get_imu_samples(m_handle, imu_samples, max_samples, &sample_count, timeout_ms);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            throw error("Failed to get IMU samples from device!");
+        }
+        else if (result == K4A_WAIT_RESULT_TIMEOUT)
+        {
+            return 0;
+        }
+
+        return sample_count;
+    }
+
     /** Starts the K4A device's cameras
      * Throws error on failure.
      *
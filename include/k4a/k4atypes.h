@@ -201,6 +201,12 @@ K4A_DECLARE_HANDLE(k4a_transformation_t);
  *    't'  - log all messages of level 'trace' or higher criticality
  *    DEFAULT - log all message of level 'error' or higher criticality
  *
+ * K4A_LOG_ASYNC =
+ *    0    - write messages to the file or stdout on the thread that logged them
+ *    all else  - queue messages for the file or stdout and write them on a background thread. Messages are dropped
+ *                and counted, instead of blocking the caller, if the queue is full.
+ *    DEFAULT - write messages on the thread that logged them
+ *
  * See remarks section of \p k4a_set_debug_message_handler
  */
 
@@ -615,6 +621,87 @@ typedef enum
     K4A_COLOR_CONTROL_MODE_MANUAL,   /**< set the associated k4a_color_control_command_t to manual*/
 } k4a_color_control_mode_t;
 
+/** Transformation implementation.
+ *
+ * \remarks
+ * Selects how k4a_transformation_depth_image_to_color_camera() and k4a_transformation_color_image_to_depth_camera()
+ * are computed. Set with k4a_transformation_set_mode().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_TRANSFORMATION_MODE_DEFAULT = 0, /**< GPU if the handle has GPU support, otherwise exact CPU */
+    K4A_TRANSFORMATION_MODE_CPU,         /**< Exact projection of every pixel on the CPU */
+    K4A_TRANSFORMATION_MODE_CPU_FAST,    /**< Precomputed per pixel projection tables on the CPU, approximate */
+} k4a_transformation_mode_t;
+
+/** Colored point layout.
+ *
+ * \remarks
+ * Selects how each point is packed by k4a_transformation_depth_image_to_colored_point_cloud(). Points are stored back
+ * to back without padding between them. X, Y and Z are int16_t values in millimeters, stored in the byte order of the
+ * host, and colors are the 8 bit channels of the color image.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_COLORED_POINT_FORMAT_XYZ16_BGRA32 = 0,   /**< X, Y, Z, then B, G, R, A. 10 bytes per point */
+    K4A_COLORED_POINT_FORMAT_XYZ16_RGB24,        /**< X, Y, Z, then R, G, B. 9 bytes per point */
+    K4A_COLORED_POINT_FORMAT_XYZ16_PAD16_BGRA32, /**< X, Y, Z, 2 zero bytes, then B, G, R, A. 12 bytes per point */
+} k4a_colored_point_format_t;
+
+/** Point cloud layout.
+ *
+ * \remarks
+ * Selects how points are stored by k4a_transformation_depth_image_to_formatted_point_cloud(). X, Y and Z are in
+ * millimeters. int16_t coordinates are rounded to the nearest millimeter like those of
+ * k4a_transformation_depth_image_to_point_cloud(), float coordinates are not rounded.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_POINT_CLOUD_FORMAT_XYZ16 = 0,     /**< int16_t X, Y, Z per point. 6 bytes per point */
+    K4A_POINT_CLOUD_FORMAT_XYZ32F,        /**< float X, Y, Z per point. 12 bytes per point */
+    K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR, /**< A plane of float X values, then one of Y and one of Z values */
+} k4a_point_cloud_format_t;
+
+/** Capture pipeline stage.
+ *
+ * \remarks
+ * Captures returned by k4a_device_get_capture() are stamped with the host time as they pass each stage, see
+ * k4a_capture_get_stage_timestamp_usec(). The stages are listed in the order a depth capture passes them. Color only
+ * captures are not stamped at the depth stages.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_CAPTURE_STAGE_USB_TRANSFER = 0, /**< The USB transfer of the raw depth frame completed */
+    K4A_CAPTURE_STAGE_DEPTH_ENGINE,     /**< The depth engine finished processing the raw depth frame */
+    K4A_CAPTURE_STAGE_SYNC,             /**< Capture synchronization made the capture available to the user */
+    K4A_CAPTURE_STAGE_POP,              /**< k4a_device_get_capture() returned the capture */
+    K4A_CAPTURE_STAGE_COUNT,            /**< Number of capture pipeline stages */
+} k4a_capture_stage_t;
+
 /** Calibration types.
  *
  * Specifies a type of calibration.
@@ -899,6 +986,59 @@ typedef struct _k4a_imu_sample_t
     uint64_t gyro_timestamp_usec; /**< Timestamp of the gyroscope in microseconds */
 } k4a_imu_sample_t;
 
+/** Distribution of the latency of one part of the capture pipeline.
+ *
+ * \remarks
+ * Percentiles are read from a histogram with 16 buckets per power of two, so they are rounded up by at most 1/16 of
+ * their value. The maximum is exact.
+ *
+ * \see k4a_capture_latency_stats_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_capture_latency_t
+{
+    uint64_t count;    /**< Number of captures measured. All other fields are 0 if no capture was measured. */
+    uint64_t p50_usec; /**< Median latency in microseconds. */
+    uint64_t p99_usec; /**< 99th percentile latency in microseconds. */
+    uint64_t max_usec; /**< Largest latency in microseconds. */
+} k4a_capture_latency_t;
+
+/** Latency of the capture pipeline of a device.
+ *
+ * \remarks
+ * Each part measures the time between two ::k4a_capture_stage_t stamps of the captures returned by
+ * k4a_device_get_capture(). Captures missing either stamp are not counted for that part.
+ *
+ * \see k4a_device_get_capture_latency_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_capture_latency_stats_t
+{
+    /** From ::K4A_CAPTURE_STAGE_USB_TRANSFER to ::K4A_CAPTURE_STAGE_DEPTH_ENGINE, including the wait for the depth
+     * engine. */
+    k4a_capture_latency_t depth_engine;
+
+    /** From ::K4A_CAPTURE_STAGE_DEPTH_ENGINE to ::K4A_CAPTURE_STAGE_SYNC, including the wait for the matching color
+     * image. */
+    k4a_capture_latency_t sync;
+
+    /** From ::K4A_CAPTURE_STAGE_SYNC to ::K4A_CAPTURE_STAGE_POP, the time the capture waited for the user. */
+    k4a_capture_latency_t pop;
+
+    /** From ::K4A_CAPTURE_STAGE_USB_TRANSFER to ::K4A_CAPTURE_STAGE_POP. */
+    k4a_capture_latency_t end_to_end;
+} k4a_capture_latency_stats_t;
+
 /** Extrinsic calibration data.
  *
  * \remarks
@@ -1050,6 +1190,31 @@ typedef struct _k4a_calibration_t
  */
 typedef void(k4a_memory_destroy_cb_t)(void *buffer, void *context);
 
+/** Callback function for a memory allocation.
+ *
+ * \param size
+ * Minimum size in bytes needed for the buffer.
+ *
+ * \param context
+ * Output parameter for a context that will be provided in the subsequent call to the \ref k4a_memory_destroy_cb_t
+ * callback.
+ *
+ * \return
+ * A pointer to the newly allocated memory, or NULL if the allocation failed.
+ *
+ * \remarks
+ * A callback of this type is provided to \ref k4a_set_allocator() and is used by the SDK for the buffers of capture
+ * images.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef uint8_t *(k4a_memory_allocate_cb_t)(int size, void **context);
+
 /** Callback function for debug messages being generated by the Azure Kinect SDK.
  *
  * \param context
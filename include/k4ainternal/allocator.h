@@ -65,6 +65,42 @@ void allocator_free(void *buffer, void *context);
 
 long allocator_test_for_leaks(void);
 
+/** Sets the functions used to allocate and free memory
+ *
+ * \param allocate
+ * function that allocates memory, or NULL to use malloc
+ *
+ * \param free_cb
+ * function that frees memory from \p allocate, or NULL to use free
+ *
+ * Both functions must be NULL or both must be set. Outstanding allocations, including blocks cached in pools, are
+ * still released with the function that allocated them.
+ */
+k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t *allocate, k4a_memory_destroy_cb_t *free_cb);
+
+/** Reserves a pool of fixed size blocks for allocations of one source
+ *
+ * \param source
+ * the source of code that will allocate from the pool
+ *
+ * \param block_size
+ * size of each block, allocations of more than half and at most this size are served from the pool
+ *
+ * \param block_count
+ * number of blocks to allocate up front
+ *
+ * Reserving an existing pool of the same source and size adds \p block_count blocks to it. Allocations that no pool
+ * can serve, or that find every block of the pool in use, fall back to the allocate function. Each successful call
+ * must be paired with a call to allocator_release_pool() with the same arguments.
+ */
+k4a_result_t allocator_reserve_pool(allocation_source_t source, size_t block_size, uint32_t block_count);
+
+/** Releases a reservation made with allocator_reserve_pool()
+ *
+ * Cached blocks are freed immediately, blocks in use are freed when they are returned.
+ */
+void allocator_release_pool(allocation_source_t source, size_t block_size, uint32_t block_count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,129 @@
+/** \file atomic.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Minimal atomic operations for lock-free structures. The C runtime of every supported compiler does not provide
+ * stdatomic.h, so these map to the Interlocked functions on Windows and to the __atomic builtins elsewhere. All
+ * operations are sequentially consistent.
+ */
+
+#ifndef K4A_ATOMIC_H
+#define K4A_ATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+inline static long k4a_atomic_load_long(volatile long *target)
+{
+#ifdef _WIN32
+    return InterlockedCompareExchange(target, 0, 0);
+#else
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline static void k4a_atomic_store_long(volatile long *target, long value)
+{
+#ifdef _WIN32
+    InterlockedExchange(target, value);
+#else
+    __atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Returns the previous value
+inline static long k4a_atomic_exchange_long(volatile long *target, long value)
+{
+#ifdef _WIN32
+    return InterlockedExchange(target, value);
+#else
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Returns the new value
+inline static long k4a_atomic_increment_long(volatile long *target)
+{
+#ifdef _WIN32
+    return InterlockedIncrement(target);
+#else
+    return __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline static uint64_t k4a_atomic_load_64(volatile uint64_t *target)
+{
+#ifdef _WIN32
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)target, 0, 0);
+#else
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline static void k4a_atomic_store_64(volatile uint64_t *target, uint64_t value)
+{
+#ifdef _WIN32
+    InterlockedExchange64((volatile LONG64 *)target, (LONG64)value);
+#else
+    __atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Sets *target to desired if it holds *expected. Otherwise stores the current value in *expected and returns false.
+inline static bool k4a_atomic_compare_exchange_64(volatile uint64_t *target, uint64_t *expected, uint64_t desired)
+{
+#ifdef _WIN32
+    uint64_t previous = (uint64_t)
+        InterlockedCompareExchange64((volatile LONG64 *)target, (LONG64)desired, (LONG64)*expected);
+    if (previous == *expected)
+    {
+        return true;
+    }
+    *expected = previous;
+    return false;
+#else
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Spin lock for critical sections that only update a few fields and can not own a LOCK_HANDLE, because they run
+// before any initialization call or belong to objects created for every frame. Zero initialized means unlocked.
+typedef volatile long k4a_spin_lock_t;
+
+inline static void k4a_spin_lock(k4a_spin_lock_t *lock)
+{
+    while (k4a_atomic_exchange_long(lock, 1) != 0)
+    {
+        // Wait for the owner without writing to the lock, then try again
+        while (k4a_atomic_load_long(lock) != 0)
+        {
+#ifdef _WIN32
+            SwitchToThread();
+#else
+            sched_yield();
+#endif
+        }
+    }
+}
+
+inline static void k4a_spin_unlock(k4a_spin_lock_t *lock)
+{
+    k4a_atomic_store_long(lock, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* K4A_ATOMIC_H */
@@ -56,6 +56,30 @@ void capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle
 void capture_set_temperature_c(k4a_capture_t capture_handle, float temperature_c);
 float capture_get_temperature_c(k4a_capture_t capture_handle);
 
+/** Returns the current time of the monotonic host clock in microseconds.
+ *
+ * The clock is the one used for the stage timestamps of captures. It has no defined origin and is only meaningful
+ * relative to other readings in the same process.
+ */
+uint64_t capture_get_host_time_usec(void);
+
+/** Stamps a capture with the host time at which it passed a pipeline stage.
+ *
+ * \param capture_handle
+ * The capture to stamp
+ *
+ * \param stage
+ * The stage the capture passed
+ *
+ * \param timestamp_usec
+ * Host time from capture_get_host_time_usec(), or 0 to clear the stamp
+ */
+void capture_set_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage, uint64_t timestamp_usec);
+
+/** Returns the host time at which a capture passed a pipeline stage, or 0 if it was not stamped at that stage.
+ */
+uint64_t capture_get_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage);
+
 #ifdef __cplusplus
 }
 #endif
@@ -108,6 +108,21 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
                              k4a_capture_t capture_raw,
                              bool color_capture);
 
+/** Reads the latency statistics of the capture pipeline
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param stats
+ * The location to write the statistics to
+ *
+ * \remarks
+ * Summarizes the time between the stage timestamps of the captures returned by capturesync_get_capture() since
+ * capturesync_start() was last called. capturesync_get_capture() stamps each capture with
+ * ::K4A_CAPTURE_STAGE_POP and capturesync_add_capture() stamps the captures it queues with ::K4A_CAPTURE_STAGE_SYNC.
+ */
+k4a_result_t capturesync_get_latency_stats(capturesync_t capturesync_handle, k4a_capture_latency_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,17 +37,39 @@ extern "C" {
 #define STR_INTERNAL_CONTEXT_TYPE(type) STRINGIFY(type##_c)
 #endif
 
-/* K4A_DECLARE_CONTEXT creates type matched C functions to create, destroy and get the context. The create and destroy
-functions will ensure matched CPP constructor and destructor are called. To protext against the create function being
-used with CPP and destroy being used with C, or vise-vesa, the types get c or cpp appended to them. */
-#define K4A_DECLARE_CONTEXT(_public_handle_name_, _internal_context_type_)                                             \
+/* K4A_DECLARE_CONTEXT_WRAPPER declares the handle wrapper type shared by K4A_DECLARE_CONTEXT and the pooled variant
+in handle_pool.h. */
+#define K4A_DECLARE_CONTEXT_WRAPPER(_public_handle_name_, _internal_context_type_)                                     \
     extern char PRIV_HANDLE_TYPE(_public_handle_name_)[];                                                              \
     KSELECTANY char PRIV_HANDLE_TYPE(_public_handle_name_)[] = STR_INTERNAL_CONTEXT_TYPE(_internal_context_type_);     \
     typedef struct PUB_HANDLE_TYPE(_public_handle_name_)                                                               \
     {                                                                                                                  \
         char *handleType;                                                                                              \
         _internal_context_type_ context;                                                                               \
-    } PUB_HANDLE_TYPE(_public_handle_name_);                                                                           \
+    } PUB_HANDLE_TYPE(_public_handle_name_);
+
+/* K4A_DECLARE_CONTEXT_TYPE declares the handle wrapper type and the get context function for handles that point to
+their wrapper. */
+#define K4A_DECLARE_CONTEXT_TYPE(_public_handle_name_, _internal_context_type_)                                        \
+    K4A_DECLARE_CONTEXT_WRAPPER(_public_handle_name_, _internal_context_type_)                                         \
+                                                                                                                       \
+    /* Define "context_t* handle_t_get_context(handle_t handle)" function */                                           \
+    static inline _internal_context_type_ *_public_handle_name_##_get_context(_public_handle_name_ handle)             \
+    {                                                                                                                  \
+        if ((handle == NULL) ||                                                                                        \
+            ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType != PRIV_HANDLE_TYPE(_public_handle_name_))   \
+        {                                                                                                              \
+            IF_LOGGER(LOG_ERROR("Invalid " #_public_handle_name_ " %p", handle);)                                      \
+            return NULL;                                                                                               \
+        }                                                                                                              \
+        return &(((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->context);                                          \
+    }
+
+/* K4A_DECLARE_CONTEXT creates type matched C functions to create, destroy and get the context. The create and destroy
+functions will ensure matched CPP constructor and destructor are called. To protext against the create function being
+used with CPP and destroy being used with C, or vise-vesa, the types get c or cpp appended to them. */
+#define K4A_DECLARE_CONTEXT(_public_handle_name_, _internal_context_type_)                                             \
+    K4A_DECLARE_CONTEXT_TYPE(_public_handle_name_, _internal_context_type_)                                            \
                                                                                                                        \
     /* Define "context_t* handle_t_create(handle_t* handle)" function */                                               \
     static inline _internal_context_type_ *_public_handle_name_##_create(_public_handle_name_ *handle)                 \
@@ -67,18 +89,6 @@ used with CPP and destroy being used with C, or vise-vesa, the types get c or cp
         return &pContextWrapper->context;                                                                              \
     }                                                                                                                  \
                                                                                                                        \
-    /* Define "context_t* handle_t_get_context(handle_t handle)" function */                                           \
-    static inline _internal_context_type_ *_public_handle_name_##_get_context(_public_handle_name_ handle)             \
-    {                                                                                                                  \
-        if ((handle == NULL) ||                                                                                        \
-            ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType != PRIV_HANDLE_TYPE(_public_handle_name_))   \
-        {                                                                                                              \
-            IF_LOGGER(LOG_ERROR("Invalid " #_public_handle_name_ " %p", handle);)                                      \
-            return NULL;                                                                                               \
-        }                                                                                                              \
-        return &(((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->context);                                          \
-    }                                                                                                                  \
-                                                                                                                       \
     /* Define "void handle_t_destroy(handle_t handle) function */                                                      \
     static inline void _public_handle_name_##_destroy(_public_handle_name_ handle)                                     \
     {                                                                                                                  \
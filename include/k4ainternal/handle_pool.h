@@ -0,0 +1,181 @@
+/** \file handle_pool.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ */
+
+#ifndef K4A_INTERNAL_HANDLE_POOL_H
+#define K4A_INTERNAL_HANDLE_POOL_H
+
+#include <k4ainternal/handle.h>
+#include <k4ainternal/atomic.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* K4A_DECLARE_POOLED_CONTEXT is K4A_DECLARE_CONTEXT for handles that are created and destroyed many times per frame.
+The first _pool_count_ handles live in a static array and are recycled through a lock-free free list, so create and
+destroy are a single compare and exchange on the list head; only when every pooled handle is in use does create fall
+back to the heap. The free list head carries a tag that changes on every update, so a stale head can not be swapped
+back in after the entry it names was popped and pushed again.
+
+A pooled handle is not a pointer to its wrapper. It holds the entry index and the generation of the entry, which
+advances every time the entry is destroyed, so a handle kept after destroy stays invalid once the entry is reissued.
+The value is odd, so it never matches a heap allocated wrapper.
+
+The context must be plain data: it is zero filled on create, but no constructor or destructor runs. Because the pool is
+static, a handle type may only be declared pooled in one translation unit. */
+#define K4A_HANDLE_POOL_INDEX_BITS 15
+#define K4A_HANDLE_POOL_MAX_COUNT (1 << K4A_HANDLE_POOL_INDEX_BITS)
+#define K4A_HANDLE_POOL_GENERATION_SHIFT (K4A_HANDLE_POOL_INDEX_BITS + 1)
+#define K4A_HANDLE_POOL_GENERATION_MASK (UINTPTR_MAX >> K4A_HANDLE_POOL_GENERATION_SHIFT)
+#define K4A_DECLARE_POOLED_CONTEXT(_public_handle_name_, _internal_context_type_, _pool_count_)                        \
+    K4A_DECLARE_CONTEXT_WRAPPER(_public_handle_name_, _internal_context_type_)                                         \
+                                                                                                                       \
+    static PUB_HANDLE_TYPE(_public_handle_name_) _public_handle_name_##_pool[_pool_count_];                            \
+    /* Free list links, holding the index + 1 of the next free entry or 0 */                                           \
+    static volatile long _public_handle_name_##_pool_next[_pool_count_];                                               \
+    /* Generation of each entry, part of the handle value */                                                           \
+    static volatile long _public_handle_name_##_pool_generation[_pool_count_];                                         \
+    /* Number of entries that have been handed out at least once */                                                    \
+    static volatile long _public_handle_name_##_pool_used;                                                             \
+    /* Tag in the upper 32 bits and index + 1 of the first free entry in the lower 32 bits */                          \
+    static volatile uint64_t _public_handle_name_##_pool_head;                                                         \
+    /* The entry index must fit in the handle value */                                                                 \
+    typedef char _public_handle_name_##_pool_count_check[(_pool_count_) <= K4A_HANDLE_POOL_MAX_COUNT ? 1 : -1];        \
+                                                                                                                       \
+    static inline PUB_HANDLE_TYPE(_public_handle_name_) * _public_handle_name_##_pool_pop(void)                        \
+    {                                                                                                                  \
+        uint64_t head = k4a_atomic_load_64(&_public_handle_name_##_pool_head);                                         \
+        for (;;)                                                                                                       \
+        {                                                                                                              \
+            uint32_t index = (uint32_t)head;                                                                           \
+            if (index == 0)                                                                                            \
+            {                                                                                                          \
+                break;                                                                                                 \
+            }                                                                                                          \
+            uint64_t next = (((head >> 32) + 1) << 32) |                                                               \
+                            (uint32_t)k4a_atomic_load_long(&_public_handle_name_##_pool_next[index - 1]);              \
+            if (k4a_atomic_compare_exchange_64(&_public_handle_name_##_pool_head, &head, next))                        \
+            {                                                                                                          \
+                return &_public_handle_name_##_pool[index - 1];                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+                                                                                                                       \
+        /* The free list is empty, take an entry that has never been used */                                           \
+        if (k4a_atomic_load_long(&_public_handle_name_##_pool_used) < (_pool_count_))                                  \
+        {                                                                                                              \
+            long used = k4a_atomic_increment_long(&_public_handle_name_##_pool_used);                                  \
+            if (used <= (_pool_count_))                                                                                \
+            {                                                                                                          \
+                return &_public_handle_name_##_pool[used - 1];                                                         \
+            }                                                                                                          \
+        }                                                                                                              \
+        return NULL;                                                                                                   \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline void _public_handle_name_##_pool_push(PUB_HANDLE_TYPE(_public_handle_name_) * pContextWrapper)       \
+    {                                                                                                                  \
+        uint32_t index = (uint32_t)(pContextWrapper - _public_handle_name_##_pool) + 1;                                \
+        uint64_t head = k4a_atomic_load_64(&_public_handle_name_##_pool_head);                                         \
+        for (;;)                                                                                                       \
+        {                                                                                                              \
+            k4a_atomic_store_long(&_public_handle_name_##_pool_next[index - 1], (long)(uint32_t)head);                 \
+            uint64_t next = (((head >> 32) + 1) << 32) | index;                                                        \
+            if (k4a_atomic_compare_exchange_64(&_public_handle_name_##_pool_head, &head, next))                        \
+            {                                                                                                          \
+                return;                                                                                                \
+            }                                                                                                          \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Returns the wrapper a handle refers to, or NULL if it names a pooled entry of an older generation */            \
+    static inline PUB_HANDLE_TYPE(_public_handle_name_) * _public_handle_name_##_wrapper(_public_handle_name_ handle)  \
+    {                                                                                                                  \
+        uintptr_t value = (uintptr_t)handle;                                                                           \
+        if ((value & 1) == 0)                                                                                          \
+        {                                                                                                              \
+            /* NULL or a heap allocated wrapper */                                                                     \
+            return (PUB_HANDLE_TYPE(_public_handle_name_) *)handle;                                                    \
+        }                                                                                                              \
+        uintptr_t index = (value >> 1) & (K4A_HANDLE_POOL_MAX_COUNT - 1);                                              \
+        if (index >= (uintptr_t)(_pool_count_) ||                                                                      \
+            (value >> K4A_HANDLE_POOL_GENERATION_SHIFT) !=                                                             \
+                ((uintptr_t)k4a_atomic_load_long(&_public_handle_name_##_pool_generation[index]) &                     \
+                 K4A_HANDLE_POOL_GENERATION_MASK))                                                                     \
+        {                                                                                                              \
+            return NULL;                                                                                               \
+        }                                                                                                              \
+        return &_public_handle_name_##_pool[index];                                                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Define "context_t* handle_t_get_context(handle_t handle)" function */                                           \
+    static inline _internal_context_type_ *_public_handle_name_##_get_context(_public_handle_name_ handle)             \
+    {                                                                                                                  \
+        PUB_HANDLE_TYPE(_public_handle_name_) *pContextWrapper = _public_handle_name_##_wrapper(handle);               \
+        if (pContextWrapper == NULL || pContextWrapper->handleType != PRIV_HANDLE_TYPE(_public_handle_name_))          \
+        {                                                                                                              \
+            IF_LOGGER(LOG_ERROR("Invalid " #_public_handle_name_ " %p", handle);)                                      \
+            return NULL;                                                                                               \
+        }                                                                                                              \
+        return &pContextWrapper->context;                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Define "context_t* handle_t_create(handle_t* handle)" function */                                               \
+    static inline _internal_context_type_ *_public_handle_name_##_create(_public_handle_name_ *handle)                 \
+    {                                                                                                                  \
+        PUB_HANDLE_TYPE(_public_handle_name_) *pContextWrapper = _public_handle_name_##_pool_pop();                    \
+        if (pContextWrapper != NULL)                                                                                   \
+        {                                                                                                              \
+            uintptr_t index = (uintptr_t)(pContextWrapper - _public_handle_name_##_pool);                              \
+            uintptr_t generation = (uintptr_t)k4a_atomic_load_long(&_public_handle_name_##_pool_generation[index]);    \
+            memset(pContextWrapper, 0, sizeof(*pContextWrapper));                                                      \
+            *handle = (_public_handle_name_)(((generation & K4A_HANDLE_POOL_GENERATION_MASK)                           \
+                                              << K4A_HANDLE_POOL_GENERATION_SHIFT) |                                   \
+                                             (index << 1) | 1);                                                        \
+        }                                                                                                              \
+        else                                                                                                           \
+        {                                                                                                              \
+            pContextWrapper = ALLOCATE(PUB_HANDLE_TYPE(_public_handle_name_));                                         \
+            if (pContextWrapper == NULL)                                                                               \
+            {                                                                                                          \
+                IF_LOGGER(LOG_ERROR("Failed to allocate " #_public_handle_name_, 0);) return NULL;                     \
+            }                                                                                                          \
+            *handle = (_public_handle_name_)pContextWrapper;                                                           \
+        }                                                                                                              \
+        IF_LOGGER(LOG_TRACE("Created   " #_public_handle_name_ " %p", *handle);)                                       \
+        pContextWrapper->handleType = PRIV_HANDLE_TYPE(_public_handle_name_);                                          \
+        return &pContextWrapper->context;                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Define "void handle_t_destroy(handle_t handle) function */                                                      \
+    static inline void _public_handle_name_##_destroy(_public_handle_name_ handle)                                     \
+    {                                                                                                                  \
+        PUB_HANDLE_TYPE(_public_handle_name_) *pContextWrapper = _public_handle_name_##_wrapper(handle);               \
+        if (_public_handle_name_##_get_context(handle) == NULL && pContextWrapper == NULL)                             \
+        {                                                                                                              \
+            /* A pooled handle that was already destroyed, its entry may belong to a live handle again */              \
+            return;                                                                                                    \
+        }                                                                                                              \
+        IF_LOGGER(LOG_TRACE("Destroyed " #_public_handle_name_ " %p", handle);)                                        \
+        pContextWrapper->handleType = NULL;                                                                            \
+        if (pContextWrapper >= _public_handle_name_##_pool &&                                                          \
+            pContextWrapper < _public_handle_name_##_pool + (_pool_count_))                                            \
+        {                                                                                                              \
+            k4a_atomic_increment_long(                                                                                 \
+                &_public_handle_name_##_pool_generation[pContextWrapper - _public_handle_name_##_pool]);               \
+            _public_handle_name_##_pool_push(pContextWrapper);                                                         \
+        }                                                                                                              \
+        else                                                                                                           \
+        {                                                                                                              \
+            DESTROY(pContextWrapper);                                                                                  \
+        }                                                                                                              \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* K4A_INTERNAL_HANDLE_POOL_H */
@@ -47,6 +47,17 @@ image_create(k4a_image_format_t format, int width_pixels, int height_pixels, int
  */
 k4a_result_t image_create_empty_internal(allocation_source_t source, size_t size, k4a_image_t *image);
 
+/** Create a handle to an image object around a caller owned memory blob of 'size'.
+ * internal counterpart of \ref image_create_empty_internal for callers that manage their own buffers, such as the USB
+ * layer recycling its transfer buffers. buffer_destroy_cb is called with buffer and buffer_destroy_cb_context once
+ * the last reference is released. If this function fails, the caller still owns the buffer.
+ */
+k4a_result_t image_create_empty_from_buffer_internal(uint8_t *buffer,
+                                                     size_t size,
+                                                     image_destroy_cb_t *buffer_destroy_cb,
+                                                     void *buffer_destroy_cb_context,
+                                                     k4a_image_t *image);
+
 /** Create a handle to an image object.
  * \param format [IN]
  * format of the image being created.
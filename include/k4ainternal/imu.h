@@ -58,6 +58,32 @@ void imu_destroy(imu_t imu_handle);
 
 k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms);
 
+/** Reads all available IMU samples, up to max_samples
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param imu_samples [OUT]
+ * Location to write the samples to, oldest first.
+ *
+ * \param max_samples [IN]
+ * The number of samples imu_samples can hold.
+ *
+ * \param sample_count [OUT]
+ * Location to write the number of samples read to.
+ *
+ * \param timeout_in_ms [IN]
+ * Time to wait for a sample if none is available. K4A_WAIT_INFINITE waits until a sample arrives or the IMU stops.
+ *
+ * \return ::K4A_WAIT_RESULT_SUCCEEDED if at least one sample was read, ::K4A_WAIT_RESULT_TIMEOUT if no sample arrived
+ * in time, ::K4A_WAIT_RESULT_FAILED if the IMU is not running or an error was encountered.
+ */
+k4a_wait_result_t imu_get_samples(imu_t imu_handle,
+                                  k4a_imu_sample_t *imu_samples,
+                                  size_t max_samples,
+                                  size_t *sample_count,
+                                  int32_t timeout_in_ms);
+
 /** Starts the IMU sensor streaming
  *
  * \param imu_handle [IN]
@@ -38,6 +38,7 @@ K4A_DECLARE_HANDLE(logger_t);
 #define K4A_ENABLE_LOG_TO_A_FILE "K4A_ENABLE_LOG_TO_A_FILE"
 #define K4A_ENABLE_LOG_TO_STDOUT "K4A_ENABLE_LOG_TO_STDOUT"
 #define K4A_LOG_LEVEL "K4A_LOG_LEVEL"
+#define K4A_LOG_ASYNC "K4A_LOG_ASYNC"
 #define K4A_LOG_FILE_NAME "k4a.log"
 #define K4A_LOG_FILE_50MB_MAX_SIZE (1048576 * 50)
 
@@ -50,6 +51,7 @@ typedef struct
     const char *env_var_log_to_a_file; // env var name for logging to a file
     const char *env_var_log_to_stdout; // env var name for logging to stdout
     const char *env_var_log_level;     // env var name for setting the logging level
+    const char *env_var_log_async;     // env var name for writing file or stdout messages on a background thread
     const char *log_file;              // default log file name
     size_t max_log_size;               // max log size before rolling over to a new file.
 } logger_config_t;
@@ -62,6 +64,7 @@ static inline void logger_config_init_default(logger_config_t *config)
     config->env_var_log_to_a_file = K4A_ENABLE_LOG_TO_A_FILE;
     config->env_var_log_to_stdout = K4A_ENABLE_LOG_TO_STDOUT;
     config->env_var_log_level = K4A_LOG_LEVEL;
+    config->env_var_log_async = K4A_LOG_ASYNC;
     config->log_file = NULL;
     config->max_log_size = K4A_LOG_FILE_50MB_MAX_SIZE;
 }
@@ -91,6 +94,13 @@ void logger_destroy(logger_t logger_handle);
  */
 bool logger_is_file_based(void);
 
+/** Number of file or stdout messages dropped because the asynchronous log ring was full.
+ *
+ * \remarks
+ * The count is reset when asynchronous logging starts and kept after it stops.
+ */
+uint64_t logger_get_async_dropped_count(void);
+
 /** Registers a callback function to deliver messages to.
  *
  * \param message_cb [IN]
@@ -89,6 +89,30 @@ constexpr uint64_t operator"" _s(unsigned long long x)
 #define CLUSTER_READ_AHEAD_COUNT 2
 #endif
 
+#ifndef CLUSTER_READ_AHEAD_MAX_COUNT
+#define CLUSTER_READ_AHEAD_MAX_COUNT 64
+#endif
+
+#ifndef COLOR_DECODE_MAX_THREAD_COUNT
+#define COLOR_DECODE_MAX_THREAD_COUNT 32
+#endif
+
+#ifndef COLOR_DECODE_MAX_FRAME_COUNT
+#define COLOR_DECODE_MAX_FRAME_COUNT 64
+#endif
+
+#ifndef FRAME_COMPRESSION_MAX_THREAD_COUNT
+#define FRAME_COMPRESSION_MAX_THREAD_COUNT 16
+#endif
+
+#ifndef FRAME_COMPRESSION_QUEUE_DURATION_NS
+#define FRAME_COMPRESSION_QUEUE_DURATION_NS 1_s
+#endif
+
+#ifndef IMAGE_BUFFER_POOL_MAX_COUNT
+#define IMAGE_BUFFER_POOL_MAX_COUNT 12
+#endif
+
 static_assert(MAX_CLUSTER_LENGTH_NS < INT16_MAX * MATROSKA_TIMESCALE_NS, "Cluster length must fit in a 16 bit int");
 static_assert(CLUSTER_WRITE_DELAY_NS >= MAX_CLUSTER_LENGTH_NS * 2, "Cluster write delay is shorter than 2 clusters");
 
@@ -149,6 +173,85 @@ private:
     std::thread::id m_owner;
 };
 
+/**
+ * Read-only memory mapping of a whole file
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps the file at path, replacing any previous mapping. Returns false if the file can't be opened or is empty.
+    bool open(const char *path);
+    void close();
+
+    // Hints that the given byte range will be read soon, so the OS can start loading it into the page cache.
+    void advise_will_need(uint64_t offset, uint64_t length) const;
+
+    const uint8_t *data() const
+    {
+        return m_data;
+    }
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const uint8_t *m_data = NULL;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = NULL; // HANDLE
+    void *m_mapping = NULL;
+#endif
+};
+
+/**
+ * Moves the file at source_path to target_path, replacing any file already there in a single step, so that a reader of
+ * target_path sees either the old or the new file but never a partly written one. Returns false on failure.
+ */
+bool replace_file(const char *source_path, const char *target_path);
+
+/**
+ * EBML IO handler that reads from a memory mapped file. Reads are copies out of the page cache instead of file system
+ * calls, and the mapping can be shared with images that point straight into the file.
+ */
+class MappedFileIOCallback : public libebml::IOCallback
+{
+public:
+    explicit MappedFileIOCallback(std::shared_ptr<MappedFile> mapping);
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+
+private:
+    std::shared_ptr<MappedFile> m_mapping;
+    uint64_t m_position = 0;
+};
+
+// Copies sample_count 16 bit values from src to dst, switching their byte order. Neither buffer needs to be aligned,
+// and dst may equal src to convert in place.
+void swap_bytes_16_copy(void *dst, const void *src, size_t sample_count);
+
+// Lossless codec for 16 bit depth and IR frames, stored with the KL16 FOURCC. Samples are coded in rows of row_length
+// samples, the last row may be shorter.
+size_t lossless16_max_compressed_size(size_t sample_count);
+
+// Returns the compressed size written to out, which must hold lossless16_max_compressed_size(sample_count) bytes.
+size_t lossless16_compress(const uint16_t *samples, size_t sample_count, uint32_t row_length, uint8_t *out);
+
+// Returns the number of samples in a compressed frame, or 0 if the frame is too short.
+size_t lossless16_sample_count(const uint8_t *data, size_t size);
+
+// Decompresses a frame of sample_count samples, as returned by lossless16_sample_count().
+k4a_result_t lossless16_decompress(const uint8_t *data, size_t size, uint16_t *samples, size_t sample_count);
+
 // Struct matches https://docs.microsoft.com/en-us/windows/desktop/wmdm/-bitmapinfoheader
 struct BITMAPINFOHEADER
 {
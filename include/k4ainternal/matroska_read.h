@@ -8,10 +8,20 @@
 #ifndef RECORD_READ_H
 #define RECORD_READ_H
 
+#include <k4a/k4a.h>
 #include <k4ainternal/matroska_common.h>
 #include <functional>
 #include <mutex>
 #include <future>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <turbojpeg.h>
 
 namespace k4arecord
 {
@@ -37,6 +47,8 @@ typedef struct _cluster_info_t
 // The cluster cache is a sparse linked-list index that may contain gaps until real data has been read from disk.
 // The list is initialized with metadata from the Cues block, which is used as a hint for seeking in the file.
 // Once it is known that no gap is present between indexed clusters, next_known is set to true.
+// Every entry is also listed in the playback context's cluster_index, which is kept in file order so that lookups by
+// timestamp or file offset are a binary search instead of a walk from the start of the list.
 typedef std::unique_ptr<cluster_info_t, std::function<void(cluster_info_t *)>> cluster_cache_t;
 
 // A pointer to a cluster that is still being loaded from disk.
@@ -47,13 +59,101 @@ typedef struct _loaded_cluster_t
     cluster_info_t *cluster_info = NULL;
     std::shared_ptr<libmatroska::KaxCluster> cluster;
 
-#if CLUSTER_READ_AHEAD_COUNT
-    // Pointers to previous and next clusters to keep them preloaded in memory.
-    future_cluster_t previous_clusters[CLUSTER_READ_AHEAD_COUNT];
-    future_cluster_t next_clusters[CLUSTER_READ_AHEAD_COUNT];
-#endif
+    // Pointers to previous and next clusters, nearest first, to keep them preloaded in memory.
+    std::vector<future_cluster_t> previous_clusters;
+    std::vector<future_cluster_t> next_clusters;
+
+    // Mapping of the recording when the cluster was loaded, if any. Images that need no conversion point into it.
+    std::shared_ptr<MappedFile> file_mapping;
 } loaded_cluster_t;
 
+// A cluster held in memory by the cluster LRU cache, along with the color images returned from its blocks.
+typedef struct _cached_cluster_t
+{
+    cluster_info_t *cluster_info = NULL;
+    std::shared_ptr<libmatroska::KaxCluster> cluster;
+    std::vector<std::pair<libmatroska::KaxInternalBlock *, k4a_image_t>> color_images;
+    uint64_t size = 0; // Bytes of cluster data and color images
+
+    _cached_cluster_t() = default;
+    _cached_cluster_t(const _cached_cluster_t &) = delete;
+    _cached_cluster_t &operator=(const _cached_cluster_t &) = delete;
+
+    ~_cached_cluster_t()
+    {
+        for (auto &color_image : color_images)
+        {
+            k4a_image_release(color_image.second);
+        }
+    }
+} cached_cluster_t;
+
+// Keeps the clusters that playback visited most recently loaded within a byte budget, so that seeking back to them
+// does not read the file again. Loaded clusters are otherwise only held by the current cluster and its read-ahead
+// neighbors. Disabled while max_bytes is 0. Only accessed by the playback thread.
+typedef struct _cluster_lru_t
+{
+    uint64_t max_bytes = 0;
+    bool color_images = false;
+
+    uint64_t size = 0;
+    std::list<cached_cluster_t> clusters; // Most recently used first
+    std::unordered_map<cluster_info_t *, std::list<cached_cluster_t>::iterator> lookup;
+    cluster_info_t *last_used = NULL;
+
+    // Stats
+    uint64_t cluster_hits = 0, cluster_misses = 0, color_image_hits = 0, evictions = 0;
+} cluster_lru_t;
+
+// A request for the read-ahead thread to load the cluster a number of steps before or after a known cluster.
+typedef struct _cluster_prefetch_request_t
+{
+    cluster_info_t *cluster_info = NULL;
+    size_t distance = 0;
+    bool next = true;
+    std::promise<std::shared_ptr<libmatroska::KaxCluster>> promise;
+} cluster_prefetch_request_t;
+
+// The read-ahead thread loads clusters from disk in the background so that playback does not wait on file IO.
+// Requests are served in order, nearest clusters first.
+typedef struct _cluster_prefetch_t
+{
+    std::thread thread;
+    std::mutex lock; // Locks requests and stopping
+    std::condition_variable condition;
+    std::deque<cluster_prefetch_request_t> requests;
+    bool stopping = false;
+} cluster_prefetch_t;
+
+// Image buffers handed out by playback are returned to their pool when the image is freed, so that steady state
+// playback does not allocate. Images may outlive the playback handle, so each buffer in use keeps its pool alive.
+typedef struct _pooled_image_buffer_t
+{
+    std::vector<uint8_t> data;
+    std::shared_ptr<struct _image_buffer_pool_t> pool; // Set while the buffer is in use by an image
+} pooled_image_buffer_t;
+
+typedef struct _image_buffer_pool_t
+{
+    std::mutex lock; // Locks free_buffers
+    std::deque<std::unique_ptr<pooled_image_buffer_t>> free_buffers;
+} image_buffer_pool_t;
+
+// Decoder state for converting color images. Each thread that converts images needs its own converter.
+typedef struct _image_converter_t
+{
+    tjhandle turbojpeg_handle = NULL;             // Created on first MJPEG decode
+    std::vector<uint8_t> color_conversion_buffer; // Intermediate BGRA image for conversion to NV12 and YUY2
+
+    ~_image_converter_t()
+    {
+        if (turbojpeg_handle != NULL)
+        {
+            (void)tjDestroy(turbojpeg_handle);
+        }
+    }
+} image_converter_t;
+
 typedef struct _block_info_t
 {
     struct _track_reader_t *reader = NULL;
@@ -66,11 +166,51 @@ typedef struct _block_info_t
     int index = -1;                 // Index of the block element within the cluster.
 } block_info_t;
 
+// A color block being converted by the decode pipeline. The image is released with the job if it is never collected.
+typedef struct _color_decode_job_t
+{
+    std::shared_ptr<block_info_t> block;
+    k4a_image_format_t target_format = K4A_IMAGE_FORMAT_CUSTOM;
+
+    // Guarded by the pipeline lock
+    bool started = false;
+    bool done = false;
+    k4a_result_t result = K4A_RESULT_FAILED;
+    k4a_image_t image = NULL;
+
+    ~_color_decode_job_t()
+    {
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+} color_decode_job_t;
+
+// The color decode pipeline converts the color blocks that follow the playback position on worker threads, so that
+// converting recordings is not limited to a single core. It is disabled when thread_count is 0.
+typedef struct _color_decode_pipeline_t
+{
+    uint32_t thread_count = 0;
+    uint32_t frame_count = 0; // Color blocks decoded ahead of the playback position
+    std::vector<std::thread> threads;
+
+    // Jobs in playback order, accessed only by the playback thread
+    std::deque<std::shared_ptr<color_decode_job_t>> pending;
+
+    std::mutex lock; // Locks queue, stopping, and the job states
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    std::deque<std::shared_ptr<color_decode_job_t>> queue; // Jobs waiting for a worker thread
+    bool stopping = false;
+} color_decode_pipeline_t;
+
 typedef struct _track_reader_t
 {
     libmatroska::KaxTrackEntry *track;
     uint32_t width, height, stride;
     k4a_image_format_t format;
+    bool lossless16; // 16 bit frames are compressed with the KL16 codec
     uint64_t sync_delay_ns;
     BITMAPINFOHEADER *bitmap_header;
 
@@ -79,9 +219,10 @@ typedef struct _track_reader_t
 
 typedef struct _k4a_playback_context_t
 {
-    const char *file_path;
+    std::string file_path;
     std::unique_ptr<IOCallback> ebml_file;
-    std::mutex io_lock; // Locks access to ebml_file
+    std::shared_ptr<MappedFile> file_mapping; // Set while ebml_file reads through a memory mapping of the file
+    std::mutex io_lock;                       // Locks access to ebml_file, file_mapping and stream
     bool file_closing;
 
     logger_t logger_handle;
@@ -89,6 +230,9 @@ typedef struct _k4a_playback_context_t
     uint64_t timecode_scale;
     k4a_record_configuration_t record_config;
     k4a_image_format_t color_format_conversion;
+    image_converter_t image_converter; // Used for conversions on the playback thread
+    color_decode_pipeline_t color_decode;
+    std::shared_ptr<image_buffer_pool_t> image_buffer_pool = std::make_shared<image_buffer_pool_t>();
 
     std::unique_ptr<libebml::EbmlStream> stream;
     std::unique_ptr<libmatroska::KaxSegment> segment;
@@ -107,7 +251,17 @@ typedef struct _k4a_playback_context_t
     std::shared_ptr<loaded_cluster_t> seek_cluster;
 
     cluster_cache_t cluster_cache;
-    std::recursive_mutex cache_lock; // Locks modification of cluster_cache
+    std::vector<cluster_info_t *> cluster_index; // Entries of cluster_cache sorted by file offset and timestamp
+    std::recursive_mutex cache_lock;             // Locks modification of cluster_cache and cluster_index
+
+    // Sidecar file listing every cluster in the recording, disabled if empty. See load_seek_index().
+    std::string seek_index_path;
+    bool seek_index_loaded;
+
+    size_t read_ahead_count = CLUSTER_READ_AHEAD_COUNT; // Clusters kept loaded in each direction
+    uint64_t read_ahead_max_bytes = 0;                  // Limit for background loading in each direction, 0 for none
+    cluster_prefetch_t prefetch;
+    cluster_lru_t cluster_lru;
 
     track_reader_t color_track;
     track_reader_t depth_track;
@@ -125,8 +279,12 @@ typedef struct _k4a_playback_context_t
 
     uint64_t last_timestamp_ns;
 
-    // Stats
-    uint64_t seek_count, load_count, cache_hits;
+    // Stats, the read-ahead thread updates them too
+    std::atomic<uint64_t> seek_count, load_count, load_bytes, cache_hits;
+    uint64_t read_ahead_hits;               // Clusters that were loaded ahead by the time playback reached them
+    uint64_t read_ahead_stalls;             // Clusters that playback had to wait for
+    std::atomic<uint64_t> read_ahead_loads; // Clusters loaded from disk by the read-ahead thread
+    size_t read_ahead_background_count;     // Clusters loaded in the background on each side, after the byte limit
 } k4a_playback_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_playback_t, k4a_playback_context_t);
@@ -138,6 +296,9 @@ void match_ebml_id(k4a_playback_context_t *context, EbmlId &id, uint64_t offset)
 bool seek_info_ready(k4a_playback_context_t *context);
 k4a_result_t parse_mkv(k4a_playback_context_t *context);
 k4a_result_t populate_cluster_cache(k4a_playback_context_t *context);
+k4a_result_t load_seek_index(k4a_playback_context_t *context);
+k4a_result_t index_all_clusters(k4a_playback_context_t *context);
+k4a_result_t write_seek_index(k4a_playback_context_t *context);
 k4a_result_t parse_recording_config(k4a_playback_context_t *context);
 k4a_result_t read_bitmap_info_header(track_reader_t *track);
 void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestamp_ns);
@@ -157,6 +318,9 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
 std::shared_ptr<libmatroska::KaxCluster> load_cluster_internal(k4a_playback_context_t *context,
                                                                cluster_info_t *cluster_info);
 std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info);
+void stop_cluster_prefetch(k4a_playback_context_t *context);
+k4a_result_t set_file_mapping(k4a_playback_context_t *context, bool enabled);
+void set_cluster_lru(k4a_playback_context_t *context, uint64_t max_bytes, bool color_images);
 std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
                                                     loaded_cluster_t *current_cluster,
                                                     bool next);
@@ -170,7 +334,13 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                     block_info_t *in_block,
                                     k4a_image_t *image_out,
                                     k4a_image_format_t target_format);
-k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k4a_capture_t *capture_handle);
+k4a_result_t start_color_decode_pipeline(k4a_playback_context_t *context, uint32_t thread_count, uint32_t frame_count);
+void stop_color_decode_pipeline(k4a_playback_context_t *context);
+void clear_color_decode_pipeline(k4a_playback_context_t *context);
+k4a_result_t new_capture(k4a_playback_context_t *context,
+                         std::shared_ptr<block_info_t> &block,
+                         k4a_capture_t *capture_handle,
+                         bool next);
 k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *capture_handle, bool next);
 k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_sample_t *imu_sample, bool next);
 
@@ -190,7 +360,7 @@ template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElemen
     {
         LOG_ERROR("Failed to read element %s in recording '%s': %s",
                   T::ClassInfos.GetName(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return nullptr;
     }
@@ -255,7 +425,10 @@ template<typename T> std::unique_ptr<T> find_next(k4a_playback_context_t *contex
     }
     catch (std::ios_base::failure &e)
     {
-        LOG_ERROR("Failed to find %s in recording '%s': %s", T::ClassInfos.GetName(), context->file_path, e.what());
+        LOG_ERROR("Failed to find %s in recording '%s': %s",
+                  T::ClassInfos.GetName(),
+                  context->file_path.c_str(),
+                  e.what());
         return nullptr;
     }
 }
@@ -8,10 +8,15 @@
 #ifndef RECORD_WRITE_H
 #define RECORD_WRITE_H
 
+#include <k4a/k4a.h>
 #include <k4ainternal/matroska_common.h>
 #include <set>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <future>
 #include <mutex>
+#include <vector>
 
 namespace k4arecord
 {
@@ -19,6 +24,14 @@ typedef struct _track_data_t
 {
     libmatroska::KaxTrackEntry *track;
     libmatroska::DataBuffer *buffer;
+
+    // Set instead of buffer while the frame is compressed on a worker thread. write_cluster() waits for the result,
+    // which is NULL if compression failed.
+    std::shared_future<libmatroska::DataBuffer *> pending_buffer;
+
+    // Image the frame is written from, referenced until the cluster is written. buffer points into the image, except
+    // for 16 bit depth and IR frames, which write_cluster() converts to big-endian and leaves buffer NULL until then.
+    k4a_image_t image;
 } track_data_t;
 
 typedef struct _cluster_t
@@ -29,6 +42,41 @@ typedef struct _cluster_t
     std::vector<std::pair<uint64_t, track_data_t>> data;
 } cluster_t;
 
+// A depth or IR image waiting to be compressed. The image reference is released once the frame is compressed.
+typedef struct _frame_compression_job_t
+{
+    k4a_image_t image = NULL;
+    std::promise<libmatroska::DataBuffer *> result;
+
+    ~_frame_compression_job_t()
+    {
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+} frame_compression_job_t;
+
+// Compresses depth and IR frames on worker threads, so that k4a_record_write_capture() only queues them. The frames
+// are reserved in their cluster when queued, and the writer thread waits for any that are still being compressed.
+typedef struct _frame_compressor_t
+{
+    k4a_record_compression_t compression = K4A_RECORD_COMPRESSION_NONE;
+    uint32_t thread_count = 0;
+    std::vector<std::thread> threads;
+
+    std::mutex lock; // Locks queue and stopping
+    std::condition_variable job_available;
+    std::deque<std::unique_ptr<frame_compression_job_t>> queue;
+    bool stopping = false;
+
+    std::mutex inline_lock;             // Locks inline_buffer
+    std::vector<uint8_t> inline_buffer; // Output buffer for frames compressed on the calling thread
+
+    // Stats, updated by every thread that compresses frames
+    std::atomic<uint64_t> frame_count, input_bytes, output_bytes, compress_time_ns, inline_count;
+} frame_compressor_t;
+
 typedef struct _k4a_record_context_t
 {
     const char *file_path;
@@ -83,6 +131,15 @@ typedef struct _k4a_record_context_t
     std::unique_ptr<std::condition_variable> writer_notify;
     std::mutex writer_lock;
 
+    frame_compressor_t compressor;
+
+    // Big-endian copies of the 16 bit frames in the cluster being written, reused between clusters.
+    // Locked by writer_lock.
+    std::vector<std::vector<uint8_t>> swap_buffers;
+
+    // Set by k4a_record_set_zero_copy() to reference written images instead of copying them.
+    bool zero_copy;
+
     bool header_written, first_cluster_written;
 } k4a_record_context_t;
 
@@ -98,8 +155,11 @@ enum TagTargetType
 extern std::set<uint64_t> unique_ids;
 uint64_t new_unique_id();
 
-k4a_result_t
-populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t height, k4a_image_format_t format);
+k4a_result_t populate_bitmap_info_header(BITMAPINFOHEADER *header,
+                                         uint64_t width,
+                                         uint64_t height,
+                                         k4a_image_format_t format,
+                                         k4a_record_compression_t compression = K4A_RECORD_COMPRESSION_NONE);
 
 libmatroska::KaxTrackEntry *add_track(k4a_record_context_t *context,
                                       const char *name,
@@ -115,6 +175,18 @@ k4a_result_t write_track_data(k4a_record_context_t *context,
                               uint64_t timestamp_ns,
                               libmatroska::DataBuffer *buffer);
 
+// Reserves a place in the recording for a frame whose buffer is still being produced.
+k4a_result_t write_pending_track_data(k4a_record_context_t *context,
+                                      libmatroska::KaxTrackEntry *track,
+                                      uint64_t timestamp_ns,
+                                      std::shared_future<libmatroska::DataBuffer *> buffer);
+
+// Queues an image without copying its buffer. The recording holds a reference to the image until it is written.
+k4a_result_t write_image_track_data(k4a_record_context_t *context,
+                                    libmatroska::KaxTrackEntry *track,
+                                    uint64_t timestamp_ns,
+                                    k4a_image_t image);
+
 cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t timestamp_ns);
 
 k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, uint64_t *time_end_ns = NULL);
@@ -123,6 +195,23 @@ k4a_result_t start_matroska_writer_thread(k4a_record_context_t *context);
 
 void stop_matroska_writer_thread(k4a_record_context_t *context);
 
+// Compresses a 16 bit depth or IR image for the track format selected by compressor->compression. buffer is scratch
+// space that is reused between calls.
+libmatroska::DataBuffer *
+compress_frame(frame_compressor_t *compressor, k4a_image_t image, std::vector<uint8_t> &buffer);
+
+// Queues image for compression and reserves its place in the recording. When the queue is full, the image is
+// compressed on the calling thread instead.
+k4a_result_t write_compressed_track_data(k4a_record_context_t *context,
+                                         libmatroska::KaxTrackEntry *track,
+                                         uint64_t timestamp_ns,
+                                         k4a_image_t image);
+
+k4a_result_t start_frame_compressor(k4a_record_context_t *context);
+
+// Finishes any queued frames and stops the compression threads.
+void stop_frame_compressor(k4a_record_context_t *context);
+
 libmatroska::KaxTag *add_tag(k4a_record_context_t *context,
                              const char *name,
                              const char *value,
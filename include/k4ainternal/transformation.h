@@ -13,6 +13,9 @@
 extern "C" {
 #endif
 
+// Upper bound for the number of threads a single CPU transformation call is split across
+#define K4A_TRANSFORMATION_MAX_THREAD_COUNT 64
+
 typedef struct _k4a_camera_calibration_mode_info_t
 {
     unsigned int calibration_image_binned_resolution[2];
@@ -35,6 +38,38 @@ typedef struct _k4a_transformation_xy_tables_t
     int height;     // height of x and y tables
 } k4a_transformation_xy_tables_t;
 
+// Projection of one depth pixel into the color camera as a function of its depth d. With u = reference_depth / d:
+//   color pixel        = point2d[0] + u * point2d[1] + u * u * point2d[2]
+//   color camera depth = d * depth_scale + depth_offset
+//   valid              = u_min <= u <= u_max
+typedef struct _k4a_transformation_correspondence_coefficients_t
+{
+    float point2d[3][2]; // quadratic in u for the color pixel coordinates
+    float depth_scale;   // NAN marks a depth pixel without a valid projection at any depth
+    float u_min;         // smallest u with a valid projection
+    float u_max;         // largest u with a valid projection, INFINITY if valid up to u = 1 and beyond
+} k4a_transformation_correspondence_coefficients_t;
+
+typedef struct _k4a_transformation_correspondence_table_t
+{
+    k4a_transformation_correspondence_coefficients_t *coefficients; // one entry per depth pixel
+    float reference_depth;                                          // depth in mm that maps to u = 1
+    float depth_offset;                                             // z of the depth to color translation in mm
+    int width;                                                      // width of the depth camera
+    int height;                                                     // height of the depth camera
+} k4a_transformation_correspondence_table_t;
+
+// Instruction sets the CPU point cloud kernels can be dispatched to, ordered from least to most capable
+typedef enum
+{
+    K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR = 0, // portable C implementation, always available
+    K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41,      // x86 SSE4.1
+    K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2,       // x86 AVX2
+    K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512,     // x86 AVX-512F
+    K4A_TRANSFORMATION_INSTRUCTION_SET_NEON,       // AArch64 NEON
+    K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT,
+} k4a_transformation_instruction_set_t;
+
 typedef struct _k4a_transform_engine_calibration_t
 {
     k4a_calibration_camera_t depth_camera_calibration;                    // depth camera calibration
@@ -81,10 +116,82 @@ k4a_result_t transformation_2d_to_2d(const k4a_calibration_t *calibration,
                                      float target_point2d[2],
                                      int *valid);
 
+// Batch versions of the four functions above for point_count points stored back to back, with one valid flag per
+// point. The calibration is checked once per call and the intrinsic projections run on instruction_set. Output arrays
+// must not overlap input arrays, except that transformation_3d_to_3d_batch() may transform in place.
+k4a_result_t transformation_3d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           size_t point_count);
+
+k4a_result_t transformation_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set);
+
+k4a_result_t transformation_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set);
+
+k4a_result_t transformation_2d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set);
+
+// Returns true if this build contains a kernel for the instruction set and the running CPU supports it
+bool transformation_instruction_set_supported(k4a_transformation_instruction_set_t instruction_set);
+
+// Worker threads and scratch memory a transformation handle reuses for every CPU transformation call
+typedef struct _k4a_transformation_worker_pool_t k4a_transformation_worker_pool_t;
+
+// Builds the correspondence table used by K4A_TRANSFORMATION_MODE_CPU_FAST from the depth camera xy tables. On success
+// the caller owns correspondence_table->coefficients and releases it with free().
+k4a_result_t
+transformation_allocate_correspondence_table(const k4a_calibration_t *calibration,
+                                             const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+                                             k4a_transformation_correspondence_table_t *correspondence_table);
+
+// Returns the most capable instruction set supported by both this build and the running CPU
+k4a_transformation_instruction_set_t transformation_get_best_instruction_set(void);
+
+// Returns a printable name for the instruction set
+const char *transformation_instruction_set_name(k4a_transformation_instruction_set_t instruction_set);
+
+// Key identifying the xy tables of a camera calibration in the xy tables cache. Cache files are named
+// "k4a_xy_tables_<key as 16 lower case hex digits>.bin" inside the directory named by K4A_TRANSFORMATION_CACHE_PATH.
+uint64_t transformation_get_xy_tables_cache_key(const k4a_calibration_camera_t *camera_calibration);
+
 k4a_transformation_t transformation_create(const k4a_calibration_t *calibration, bool gpu_optimization);
 
 void transformation_destroy(k4a_transformation_t transformation_handle);
 
+// Selects the implementation used by the depth to color and color to depth camera transformations
+k4a_result_t transformation_set_mode(k4a_transformation_t transformation_handle, k4a_transformation_mode_t mode);
+
+// Sets how many threads the CPU implementation of the transformation functions may use. Defaults to 1.
+k4a_result_t transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count);
+
+// Selects the kernels used by the CPU implementation. Defaults to transformation_get_best_instruction_set().
+k4a_result_t transformation_set_instruction_set(k4a_transformation_t transformation_handle,
+                                               k4a_transformation_instruction_set_t instruction_set);
+
 k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_parameters(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
@@ -96,10 +203,12 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
 k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
     const uint8_t *depth_image_data,
     const k4a_transformation_image_descriptor_t *depth_image_descriptor,
     uint8_t *transformed_depth_image_data,
-    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor);
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    k4a_transformation_worker_pool_t *worker_pool);
 
 k4a_result_t
 transformation_depth_image_to_color_camera(k4a_transformation_t transformation_handle,
@@ -121,12 +230,15 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_paramete
 k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
     const uint8_t *depth_image_data,
     const k4a_transformation_image_descriptor_t *depth_image_descriptor,
     const uint8_t *color_image_data,
     const k4a_transformation_image_descriptor_t *color_image_descriptor,
     uint8_t *transformed_color_image_data,
-    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor);
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_instruction_set_t instruction_set,
+    k4a_transformation_worker_pool_t *worker_pool);
 
 k4a_result_t
 transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
@@ -137,8 +249,53 @@ transformation_color_image_to_depth_camera(k4a_transformation_t transformation_h
                                            uint8_t *transformed_color_image_data,
                                            k4a_transformation_image_descriptor_t *transformed_color_image_descriptor);
 
+// Returns the number of bytes of one point in the given colored point format, or 0 if the format is unknown
+size_t transformation_get_colored_point_size(k4a_colored_point_format_t point_format);
+
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_colored_point_format_t point_format,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor);
+
+// Writes one point per depth pixel, or only the points with a valid position and color when skip_invalid_points is
+// set, and stores the number of points written in point_count if it is not NULL.
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_colored_point_format_t point_format,
+    bool skip_invalid_points,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+    size_t *point_count,
+    k4a_transformation_instruction_set_t instruction_set,
+    k4a_transformation_worker_pool_t *worker_pool);
+
+k4a_result_t
+transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                  const uint8_t *depth_image_data,
+                                                  const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                  const uint8_t *color_image_data,
+                                                  const k4a_transformation_image_descriptor_t *color_image_descriptor,
+                                                  k4a_colored_point_format_t point_format,
+                                                  bool skip_invalid_points,
+                                                  uint8_t *point_cloud_data,
+                                                  k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+                                                  size_t *point_count);
+
 k4a_buffer_result_t
 transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_t *xy_tables,
+                                                   k4a_transformation_instruction_set_t instruction_set,
                                                    const uint8_t *depth_image_data,
                                                    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
                                                    uint8_t *xyz_image_data,
@@ -152,6 +309,35 @@ transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_ha
                                           uint8_t *xyz_image_data,
                                           k4a_transformation_image_descriptor_t *xyz_image_descriptor);
 
+// Writes one point per depth pixel in the given format, or only the points with a depth when skip_invalid_points is
+// set. pixel_index_data may be NULL, otherwise it receives the depth pixel index of each point. The number of points
+// written is stored in point_count if it is not NULL.
+k4a_buffer_result_t transformation_depth_image_to_formatted_point_cloud_internal(
+    const k4a_transformation_xy_tables_t *xy_tables,
+    k4a_transformation_instruction_set_t instruction_set,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_point_cloud_format_t point_format,
+    bool skip_invalid_points,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+    uint8_t *pixel_index_data,
+    k4a_transformation_image_descriptor_t *pixel_index_descriptor,
+    size_t *point_count);
+
+k4a_result_t
+transformation_depth_image_to_formatted_point_cloud(k4a_transformation_t transformation_handle,
+                                                    const uint8_t *depth_image_data,
+                                                    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                    const k4a_calibration_type_t camera,
+                                                    k4a_point_cloud_format_t point_format,
+                                                    bool skip_invalid_points,
+                                                    uint8_t *point_cloud_data,
+                                                    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+                                                    uint8_t *pixel_index_data,
+                                                    k4a_transformation_image_descriptor_t *pixel_index_descriptor,
+                                                    size_t *point_count);
+
 // Mode specific calibration
 k4a_result_t
 transformation_get_mode_specific_depth_camera_calibration(const k4a_calibration_camera_t *raw_camera_calibration,
@@ -181,6 +367,25 @@ k4a_result_t transformation_project(const k4a_calibration_camera_t *camera_calib
                                     float point2d[2],
                                     int *valid);
 
+// Batch versions of transformation_unproject() and transformation_project() for point_count points stored back to
+// back. The calibration is validated once per call and the lens model is evaluated with the kernels of
+// instruction_set. If source_to_camera is not NULL it is applied to each 3D point before the projection.
+k4a_result_t transformation_unproject_batch(const k4a_calibration_camera_t *camera_calibration,
+                                            const float *points2d,
+                                            const float *depths,
+                                            float *points3d,
+                                            int *valid,
+                                            size_t point_count,
+                                            k4a_transformation_instruction_set_t instruction_set);
+
+k4a_result_t transformation_project_batch(const k4a_calibration_camera_t *camera_calibration,
+                                          const k4a_calibration_extrinsics_t *source_to_camera,
+                                          const float *points3d,
+                                          float *points2d,
+                                          int *valid,
+                                          size_t point_count,
+                                          k4a_transformation_instruction_set_t instruction_set);
+
 // Extrinsic transformations
 k4a_result_t transformation_get_extrinsic_transformation(const k4a_calibration_extrinsics_t *source_camera_calibration,
                                                          const k4a_calibration_extrinsics_t *target_camera_calibration,
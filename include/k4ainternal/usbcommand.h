@@ -54,6 +54,16 @@ K4A_DECLARE_HANDLE(usbcmd_t);
  */
 typedef void(usb_cmd_stream_cb_t)(k4a_result_t result, k4a_image_t image_handle, void *context);
 
+/** Statistics of the buffer pool stream images are read into.
+ */
+typedef struct _usb_cmd_buffer_pool_stats_t
+{
+    uint64_t hit_count;       // stream images backed by a pooled buffer
+    uint64_t miss_count;      // stream images that needed a fresh allocation because no pooled buffer was free
+    uint32_t requested_count; // buffers the pool of the current or last stream was sized for
+    uint32_t buffer_count;    // buffers that pool holds, fewer than requested_count if memory ran out
+} usb_cmd_buffer_pool_stats_t;
+
 //************ Declarations (Statics and globals) ***************
 
 //******************* Function Prototypes ***********************
@@ -120,6 +130,9 @@ k4a_result_t usb_cmd_stream_start(usbcmd_t usb_handle, size_t payload_size);
 
 k4a_result_t usb_cmd_stream_stop(usbcmd_t usb_handle);
 
+// Stream buffer pool statistics since the handle was created
+k4a_result_t usb_cmd_get_buffer_pool_stats(usbcmd_t usb_handle, usb_cmd_buffer_pool_stats_t *stats);
+
 // Get the number of connected devices
 k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count);
 
@@ -40,6 +40,46 @@ extern "C" {
  */
 K4ARECORD_EXPORT k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle);
 
+/** Opens an existing recording file for reading, using a sidecar seek index.
+ *
+ * \param path
+ * Filesystem path of the existing recording.
+ *
+ * \param index_path
+ * Filesystem path of the seek index for the recording. Pass NULL to use \p path with ".k4aidx" appended.
+ *
+ * \param playback_handle
+ * If successful, this contains a pointer to the recording handle. Caller must call k4a_playback_close() when
+ * finished with the recording.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The seek index lists every cluster in the recording. Recordings store seek points (Cues) only once a second, and
+ * recordings that were not closed properly have none, so without an index, opening and seeking may need to read the
+ * file from the start.
+ *
+ * \remarks
+ * If the index file is missing or does not match the recording, the whole recording is scanned once while opening it
+ * and the index is written to \p index_path. Later calls open the recording from the index without scanning it.
+ * Failing to write the index is not an error.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_open_with_seek_index(const char *path,
+                                                                const char *index_path,
+                                                                k4a_playback_t *playback_handle);
+
 /** Get the raw calibration blob for the Azure Kinect device used during recording.
  *
  * \param playback_handle
@@ -202,6 +242,230 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_tag(k4a_playback_t playbac
 K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle,
                                                                 k4a_image_format_t target_format);
 
+/** Configure how much of the recording is read ahead of the playback position.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param cluster_count
+ * The number of clusters to keep loaded on each side of the playback position, at most 64. The default is 2. Pass 0 to
+ * disable read-ahead.
+ *
+ * \param max_bytes
+ * The maximum amount of data to load in the background on each side of the playback position, or 0 for no limit. The
+ * default is no limit.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the configuration was applied. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * Recordings are stored in clusters of up to one second of data. While playing back, the clusters that follow the
+ * playback position are loaded from disk on a background thread, so that k4a_playback_get_next_capture() and
+ * k4a_playback_get_previous_capture() do not wait on file IO once the read-ahead is ahead of playback. Increasing \p
+ * cluster_count absorbs longer disk stalls at the cost of memory.
+ *
+ * \remarks
+ * \p max_bytes limits the background loading using the average size of the clusters read so far. Read-ahead clusters
+ * beyond the limit are loaded when playback reaches them. At least one cluster is always loaded in the background
+ * unless read-ahead is disabled.
+ *
+ * \remarks
+ * The new configuration applies as playback moves to the next cluster or after k4a_playback_seek_timestamp(). Use
+ * k4a_playback_get_read_ahead_stats() to check whether read-ahead keeps up with playback.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_read_ahead(k4a_playback_t playback_handle,
+                                                          uint32_t cluster_count,
+                                                          uint64_t max_bytes);
+
+/** Get the statistics of the playback read-ahead.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param stats
+ * Location to write the statistics to.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the statistics were written. ::K4A_RESULT_FAILED if an argument is invalid.
+ *
+ * \remarks
+ * Statistics are counted from k4a_playback_open(). The read-ahead thread keeps loading clusters while playback is idle,
+ * so \p background_loads may grow between calls.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_get_read_ahead_stats(k4a_playback_t playback_handle,
+                                                                k4a_playback_read_ahead_stats_t *stats);
+
+/** Keep recently used clusters of the recording in memory.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param max_bytes
+ * The number of bytes of recording data to keep in memory. Pass 0 to disable the cache, which is the default.
+ *
+ * \param cache_color_images
+ * True to also keep the color images returned from the cached clusters, including the result of any conversion set
+ * with k4a_playback_set_color_conversion().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the cache was configured. ::K4A_RESULT_FAILED if the playback handle is invalid.
+ *
+ * \remarks
+ * Recordings are stored in clusters of up to one second of data. Without the cache, a cluster is released as soon as
+ * playback and read-ahead have moved away from it, so seeking back to it reads and parses it from disk again. The cache
+ * keeps the clusters that playback visited most recently in memory, removing the least recently used clusters when
+ * \p max_bytes is exceeded. This makes repeatedly playing back the same section of a recording run from memory.
+ *
+ * \remarks
+ * When \p cache_color_images is true, color images count towards \p max_bytes and are returned again without being
+ * converted when playback comes back to the same capture. The same image may then be returned
+ * several times, so color images must not be modified.
+ *
+ * \remarks
+ * Changing the configuration clears the cache but keeps the statistics. Use k4a_playback_get_cluster_cache_stats() to
+ * tune \p max_bytes.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_cluster_cache(k4a_playback_t playback_handle,
+                                                             uint64_t max_bytes,
+                                                             bool cache_color_images);
+
+/** Get the statistics of the playback cluster cache.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param stats
+ * Location to write the statistics to.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the statistics were written. ::K4A_RESULT_FAILED if an argument is invalid.
+ *
+ * \remarks
+ * Statistics are counted from k4a_playback_open(), also while the cache is disabled.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_get_cluster_cache_stats(k4a_playback_t playback_handle,
+                                                                   k4a_playback_cache_stats_t *stats);
+
+/** Read the recording through a memory mapping of the file instead of file streams.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param enabled
+ * True to map the recording into memory, false to go back to reading it with file streams, which is the default.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the recording is now read as requested. ::K4A_RESULT_FAILED if the file could not be
+ * mapped or reopened, in which case the previous mode is kept.
+ *
+ * \remarks
+ * A memory mapped recording is read without a system call per element, and the operating system is asked to page in
+ * the clusters that read-ahead will load next. Images that are returned without a format conversion, such as depth
+ * images stored as YUY2 by early recordings or color images when no conversion is set with
+ * k4a_playback_set_color_conversion(), point directly into the read-only mapping instead of being copied.
+ *
+ * \remarks
+ * Images that point into the mapping must not be modified. They keep the mapping open and remain valid after
+ * k4a_playback_close(). The recording file should not be modified or truncated while it is mapped.
+ *
+ * \remarks
+ * On 32-bit platforms, recordings larger than the available address space cannot be mapped.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_memory_mapped_io(k4a_playback_t playback_handle, bool enabled);
+
+/** Decode color images on worker threads ahead of the playback position.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param thread_count
+ * The number of worker threads to decode color images on, at most 32. Pass 0 to decode color images on the calling
+ * thread, which is the default.
+ *
+ * \param frame_count
+ * The number of color images to decode ahead of the playback position, at most 64. Must be at least \p thread_count
+ * when \p thread_count is not 0.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the worker threads were started. ::K4A_RESULT_FAILED if the recording has no color track,
+ * the arguments are invalid, or the threads could not be created.
+ *
+ * \remarks
+ * Color images are normally converted on the thread that calls k4a_playback_get_next_capture() or
+ * k4a_playback_get_previous_capture(). When a conversion format is set with k4a_playback_set_color_conversion(), this
+ * limits playback to the speed of a single core. With decode threads enabled, the color images of the next \p
+ * frame_count captures in the playback direction are converted in parallel, and captures are returned in order as
+ * their color images complete.
+ *
+ * \remarks
+ * Images decoded ahead are discarded after k4a_playback_seek_timestamp(), a change of playback direction, or a change
+ * of the color conversion format. Each decoded image is held in memory until its capture is read, so memory use grows
+ * with \p frame_count.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_decode_threads(k4a_playback_t playback_handle,
+                                                                   uint32_t thread_count,
+                                                                   uint32_t frame_count);
+
 /** Read the next capture in the recording sequence.
  *
  * \param playback_handle
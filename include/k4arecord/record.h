@@ -114,6 +114,78 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_add_tag(k4a_record_t recording_handle,
  */
 K4ARECORD_EXPORT k4a_result_t k4a_record_add_imu_track(k4a_record_t recording_handle);
 
+/** Selects the compression used for the depth and IR tracks.
+ *
+ * This must be called before the recording header is written.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param compression
+ * The compression to use. The default is ::K4A_RECORD_COMPRESSION_NONE.
+ *
+ * \param thread_count
+ * The number of worker threads that compress frames, at most 16. Pass 0 to compress frames on the thread that calls
+ * k4a_record_write_capture().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * ::K4A_RECORD_COMPRESSION_LOSSLESS stores depth and IR frames with a lossless predictive run-length codec. The size
+ * reduction depends on the scene, and is typically around half. Playback decodes these recordings transparently, but
+ * other tools that read the Matroska file will not recognize the KL16 codec of these tracks.
+ *
+ * \remarks
+ * With worker threads, k4a_record_write_capture() keeps a reference to the depth and IR images and returns once they
+ * are queued. If the workers fall behind by more than a second of frames, frames are compressed on the calling thread
+ * instead so that memory use stays bounded.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_depth_compression(k4a_record_t recording_handle,
+                                                               k4a_record_compression_t compression,
+                                                               uint32_t thread_count);
+
+/** Writes captures without copying their image buffers.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param enabled
+ * True to reference the images of written captures instead of copying them, false to copy them, which is the default.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * The setting applies to captures written after this call. With zero-copy writes, k4a_record_write_capture() keeps a
+ * reference to each image until it is written to disk, which may be several seconds after the call returns. The
+ * contents of a written image must not be modified during that time. Depth and IR images are converted to big-endian
+ * by the writer thread instead of the calling thread.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_zero_copy(k4a_record_t recording_handle, bool enabled);
+
 /** Writes the recording header and metadata to file.
  *
  * This must be called before captures can be written.
@@ -157,6 +229,10 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_header(k4a_record_t recording_han
  * k4a_record_write_capture() will write all images in the capture to the corresponding tracks in the recording file.
  * If any of the images fail to write, other images will still be written before a failure is returned.
  *
+ * \remarks
+ * The image buffers are copied, so the images can be modified or reused once this call returns, unless zero-copy
+ * writes are enabled with k4a_record_set_zero_copy().
+ *
  * \xmlonly
  * <requirements>
  *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
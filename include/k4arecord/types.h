@@ -72,6 +72,22 @@ typedef enum
     K4A_PLAYBACK_SEEK_END    /**< Seek relative to the end of a recording. */
 } k4a_playback_seek_origin_t;
 
+/** Compression used for the depth and IR tracks of a recording.
+ *
+ * \see k4a_record_set_depth_compression()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_COMPRESSION_NONE = 0, /**< Frames are stored as uncompressed 16 bit big-endian samples (b16g). */
+    K4A_RECORD_COMPRESSION_LOSSLESS, /**< Frames are stored with the lossless KL16 codec. */
+} k4a_record_compression_t;
+
 /** Structure containing the device configuration used to record.
  *
  * \see k4a_device_configuration_t
@@ -131,6 +147,65 @@ typedef struct _k4a_record_configuration_t
     uint32_t start_timestamp_offset_usec;
 } k4a_record_configuration_t;
 
+/** Statistics of the playback cluster cache.
+ *
+ * \see k4a_playback_set_cluster_cache()
+ * \see k4a_playback_get_cluster_cache_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_playback_cache_stats_t
+{
+    /** Number of times playback moved to a cluster that was held by the cache. */
+    uint64_t cluster_hits;
+
+    /** Number of times playback moved to a cluster that was not held by the cache. */
+    uint64_t cluster_misses;
+
+    /** Number of color images returned from the cache instead of being converted again. */
+    uint64_t color_image_hits;
+
+    /** Number of clusters removed from the cache to stay within the byte budget. */
+    uint64_t evictions;
+
+    /** Number of clusters currently held by the cache. */
+    uint64_t cached_clusters;
+
+    /** Bytes of cluster data and color images currently held by the cache. */
+    uint64_t cached_bytes;
+} k4a_playback_cache_stats_t;
+
+/** Statistics of the playback read-ahead.
+ *
+ * \see k4a_playback_set_read_ahead()
+ * \see k4a_playback_get_read_ahead_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_playback_read_ahead_stats_t
+{
+    /** Number of times playback moved to a cluster that read-ahead had already loaded. */
+    uint64_t cluster_hits;
+
+    /** Number of times playback moved to a cluster that read-ahead had not loaded yet and had to wait for it. */
+    uint64_t cluster_stalls;
+
+    /** Number of clusters loaded from disk by the read-ahead thread. */
+    uint64_t background_loads;
+
+    /** Number of clusters on each side of the playback position that are loaded in the background, after applying the
+     * byte limit. */
+    uint32_t background_cluster_count;
+} k4a_playback_read_ahead_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
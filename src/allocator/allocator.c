@@ -5,8 +5,10 @@
 #include <k4ainternal/allocator.h>
 
 // Dependent libraries
+#include <k4ainternal/atomic.h>
 #include <k4ainternal/capture.h>
-#include <azure_c_shared_utility/lock.h>
+#include <k4ainternal/handle_pool.h>
+#include <k4ainternal/logging.h>
 #include <azure_c_shared_utility/refcount.h>
 
 // System dependencies
@@ -16,6 +18,12 @@
 #include <assert.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 typedef enum
 {
     IMAGE_TYPE_COLOR = 0,
@@ -45,17 +53,116 @@ static volatile long g_allocated_image_count_usb_imu = 0;
 // Count the number of active sessions for this process. A session maps to k4a_device_open
 static volatile long g_allocator_sessions = 0;
 
+//
+// Pools of fixed size blocks for the large, repeated allocations of the capture path. A pool is reserved for an
+// allocation source and block size by the code that knows the frame size, and serves every allocation of that source
+// larger than half a block and no larger than one block. Freed blocks stay in the pool for the next allocation.
+// Allocations that no pool can serve go to the allocate function directly.
+//
+// Like the counts above, pools are process wide so several devices can share them. Each allocation carries a block
+// descriptor as its context, recording which function frees its memory, so the allocate functions can be swapped
+// while allocations are outstanding.
+//
+#define ALLOCATOR_MAX_POOLS 8
+#define ALLOCATOR_POOL_MAX_BLOCKS 32
+
+typedef enum
+{
+    ALLOCATOR_BLOCK_EMPTY = 0, // descriptor without memory
+    ALLOCATOR_BLOCK_FREE,      // memory cached in the pool
+    ALLOCATOR_BLOCK_IN_USE,    // memory lent out, returns to the pool when freed
+    ALLOCATOR_BLOCK_RETIRED,   // memory lent out, released when freed because the pool shrank
+} allocator_block_state_t;
+
+typedef struct _allocator_pool_t allocator_pool_t;
+
+typedef struct _allocator_block_t
+{
+    allocation_source_t source;
+    allocator_pool_t *pool; // NULL if the allocation was not served by a pool
+    allocator_block_state_t state;
+    uint8_t *buffer;
+    void *buffer_context;                 // context returned by the allocate function
+    k4a_memory_destroy_cb_t *buffer_free; // function that releases buffer
+} allocator_block_t;
+
+struct _allocator_pool_t
+{
+    allocation_source_t source;
+    size_t block_size;
+    uint32_t reservation_count; // the pool is unused when 0
+    allocator_block_t block[ALLOCATOR_POOL_MAX_BLOCKS];
+};
+
+static allocator_pool_t g_allocator_pools[ALLOCATOR_MAX_POOLS];
+
+// NULL selects malloc and free
+static k4a_memory_allocate_cb_t *g_allocator_allocate = NULL;
+static k4a_memory_destroy_cb_t *g_allocator_free = NULL;
+
+// Guards the pools and the allocate functions. The allocator is used before any session exists, so there is no
+// initialization call to create a LOCK_HANDLE in. Critical sections only update a few fields.
+static k4a_spin_lock_t g_allocator_lock = 0;
+
 typedef struct _capture_context_t
 {
     volatile long ref_count;
-    LOCK_HANDLE lock;
+    k4a_spin_lock_t lock; // guards image, see capture_lock()
 
     k4a_image_t image[IMAGE_TYPE_COUNT];
 
     float temperature_c; /** Temperature in Celsius */
+
+    uint64_t stage_timestamp_usec[K4A_CAPTURE_STAGE_COUNT]; /** Host time each pipeline stage was passed, 0 if not */
 } capture_context_t;
 
-K4A_DECLARE_CONTEXT(k4a_capture_t, capture_context_t);
+// Captures are created for every frame and every IMU sample, so their handles are recycled instead of allocated
+#define CAPTURE_HANDLE_POOL_COUNT 256
+
+K4A_DECLARE_POOLED_CONTEXT(k4a_capture_t, capture_context_t, CAPTURE_HANDLE_POOL_COUNT);
+
+// The image slots are only held long enough to swap a pointer and take a reference, so a spin lock in the capture
+// replaces a per capture LOCK_HANDLE and creating a capture makes no system calls.
+static void capture_lock(capture_context_t *capture)
+{
+    k4a_spin_lock(&capture->lock);
+}
+
+static void capture_unlock(capture_context_t *capture)
+{
+    k4a_spin_unlock(&capture->lock);
+}
+
+static k4a_image_t capture_get_image(capture_context_t *capture, image_type_index_t type)
+{
+    capture_lock(capture);
+    k4a_image_t image = capture->image[type];
+    if (image)
+    {
+        image_inc_ref(image);
+    }
+    capture_unlock(capture);
+    return image;
+}
+
+static void capture_set_image(capture_context_t *capture, image_type_index_t type, k4a_image_t image)
+{
+    if (image != NULL)
+    {
+        image_inc_ref(image);
+    }
+
+    capture_lock(capture);
+    k4a_image_t previous = capture->image[type];
+    capture->image[type] = image;
+    capture_unlock(capture);
+
+    // Drop the image that was here outside of the lock, this may run the buffer's free callback
+    if (previous)
+    {
+        image_dec_ref(previous);
+    }
+}
 
 void allocator_initialize(void)
 {
@@ -67,82 +174,318 @@ void allocator_deinitialize(void)
     DEC_REF_VAR(g_allocator_sessions);
 }
 
-uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size, void **context)
+static volatile long *allocator_get_source_count(allocation_source_t source)
 {
-    RETURN_VALUE_IF_ARG(NULL, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
-    RETURN_VALUE_IF_ARG(NULL, alloc_size == 0);
-    RETURN_VALUE_IF_ARG(NULL, context == NULL);
-
-    volatile long *ref = NULL;
     switch (source)
     {
     case ALLOCATION_SOURCE_USER:
-        ref = &g_allocated_image_count_user;
-        break;
+        return &g_allocated_image_count_user;
     case ALLOCATION_SOURCE_DEPTH:
-        ref = &g_allocated_image_count_depth;
-        break;
+        return &g_allocated_image_count_depth;
     case ALLOCATION_SOURCE_COLOR:
-        ref = &g_allocated_image_count_color;
-        break;
+        return &g_allocated_image_count_color;
     case ALLOCATION_SOURCE_IMU:
-        ref = &g_allocated_image_count_imu;
-        break;
+        return &g_allocated_image_count_imu;
     case ALLOCATION_SOURCE_USB_DEPTH:
-        ref = &g_allocated_image_count_usb_depth;
-        break;
+        return &g_allocated_image_count_usb_depth;
     case ALLOCATION_SOURCE_USB_IMU:
-        ref = &g_allocated_image_count_usb_imu;
-        break;
+        return &g_allocated_image_count_usb_imu;
     default:
         assert(0);
-        break;
+        return NULL;
+    }
+}
+
+static void allocator_default_free(void *buffer, void *context)
+{
+    (void)context;
+    free(buffer);
+}
+
+// Allocates memory with the current allocate function and reports the function and context that release it
+static uint8_t *allocator_allocate_memory(size_t size, void **buffer_context, k4a_memory_destroy_cb_t **buffer_free)
+{
+    k4a_spin_lock(&g_allocator_lock);
+    k4a_memory_allocate_cb_t *allocate = g_allocator_allocate;
+    k4a_memory_destroy_cb_t *release = g_allocator_free;
+    k4a_spin_unlock(&g_allocator_lock);
+
+    *buffer_context = NULL;
+    if (allocate == NULL)
+    {
+        *buffer_free = allocator_default_free;
+        return (uint8_t *)malloc(size);
+    }
+
+    if (size > INT32_MAX)
+    {
+        return NULL;
+    }
+    *buffer_free = release;
+    return allocate((int)size, buffer_context);
+}
+
+// Finds the reserved pool for source with the given block size. Requires the allocator lock.
+static allocator_pool_t *allocator_find_pool(allocation_source_t source, size_t block_size)
+{
+    for (int i = 0; i < ALLOCATOR_MAX_POOLS; i++)
+    {
+        allocator_pool_t *pool = &g_allocator_pools[i];
+        if (pool->reservation_count != 0 && pool->source == source && pool->block_size == block_size)
+        {
+            return pool;
+        }
     }
+    return NULL;
+}
+
+// Takes a free block from the tightest pool that serves the allocation, or returns NULL
+static allocator_block_t *allocator_take_pooled_block(allocation_source_t source, size_t alloc_size)
+{
+    allocator_block_t *block = NULL;
 
-    INC_REF_VAR(*ref);
+    k4a_spin_lock(&g_allocator_lock);
+    allocator_pool_t *best_pool = NULL;
+    for (int i = 0; i < ALLOCATOR_MAX_POOLS; i++)
+    {
+        allocator_pool_t *pool = &g_allocator_pools[i];
+        if (pool->reservation_count != 0 && pool->source == source && alloc_size <= pool->block_size &&
+            alloc_size > pool->block_size / 2 && (best_pool == NULL || pool->block_size < best_pool->block_size))
+        {
+            best_pool = pool;
+        }
+    }
 
-    memcpy((uint8_t *)context, &source, sizeof(allocation_source_t));
+    if (best_pool != NULL)
+    {
+        for (int i = 0; i < ALLOCATOR_POOL_MAX_BLOCKS; i++)
+        {
+            if (best_pool->block[i].state == ALLOCATOR_BLOCK_FREE)
+            {
+                block = &best_pool->block[i];
+                block->state = ALLOCATOR_BLOCK_IN_USE;
+                break;
+            }
+        }
+    }
+    k4a_spin_unlock(&g_allocator_lock);
 
-    return malloc(alloc_size);
+    return block;
+}
+
+uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size, void **context)
+{
+    RETURN_VALUE_IF_ARG(NULL, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+    RETURN_VALUE_IF_ARG(NULL, alloc_size == 0);
+    RETURN_VALUE_IF_ARG(NULL, context == NULL);
+
+    allocator_block_t *block = allocator_take_pooled_block(source, alloc_size);
+    if (block == NULL)
+    {
+        block = (allocator_block_t *)calloc(1, sizeof(allocator_block_t));
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        block->source = source;
+        block->buffer = allocator_allocate_memory(alloc_size, &block->buffer_context, &block->buffer_free);
+        if (block->buffer == NULL)
+        {
+            free(block);
+            return NULL;
+        }
+    }
+
+    INC_REF_VAR(*allocator_get_source_count(source));
+
+    *context = block;
+    return block->buffer;
 }
 
 void allocator_free(void *buffer, void *context)
 {
-    allocation_source_t source;
-    memcpy(&source, (uint8_t *)&context, sizeof(allocation_source_t));
+    allocator_block_t *block = (allocator_block_t *)context;
 
-    RETURN_VALUE_IF_ARG(VOID_VALUE, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, block == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE,
+                        block->source < ALLOCATION_SOURCE_USER || block->source > ALLOCATION_SOURCE_USB_IMU);
     RETURN_VALUE_IF_ARG(VOID_VALUE, buffer == NULL);
+    assert(buffer == block->buffer);
 
-    volatile long *ref = NULL;
+    DEC_REF_VAR(*allocator_get_source_count(block->source));
 
-    switch (source)
+    if (block->pool == NULL)
     {
-    case ALLOCATION_SOURCE_USER:
-        ref = &g_allocated_image_count_user;
-        break;
-    case ALLOCATION_SOURCE_DEPTH:
-        ref = &g_allocated_image_count_depth;
-        break;
-    case ALLOCATION_SOURCE_COLOR:
-        ref = &g_allocated_image_count_color;
-        break;
-    case ALLOCATION_SOURCE_IMU:
-        ref = &g_allocated_image_count_imu;
-        break;
-    case ALLOCATION_SOURCE_USB_DEPTH:
-        ref = &g_allocated_image_count_usb_depth;
-        break;
-    case ALLOCATION_SOURCE_USB_IMU:
-        ref = &g_allocated_image_count_usb_imu;
-        break;
-    default:
-        assert(0);
-        break;
+        block->buffer_free(block->buffer, block->buffer_context);
+        free(block);
+        return;
     }
 
-    DEC_REF_VAR(*ref);
-    free(buffer);
+    bool release = false;
+    uint8_t *block_buffer = NULL;
+    void *block_buffer_context = NULL;
+    k4a_memory_destroy_cb_t *block_buffer_free = NULL;
+
+    k4a_spin_lock(&g_allocator_lock);
+    if (block->state == ALLOCATOR_BLOCK_RETIRED)
+    {
+        release = true;
+        block_buffer = block->buffer;
+        block_buffer_context = block->buffer_context;
+        block_buffer_free = block->buffer_free;
+        block->buffer = NULL;
+        block->state = ALLOCATOR_BLOCK_EMPTY;
+    }
+    else
+    {
+        assert(block->state == ALLOCATOR_BLOCK_IN_USE);
+        block->state = ALLOCATOR_BLOCK_FREE;
+    }
+    k4a_spin_unlock(&g_allocator_lock);
+
+    if (release)
+    {
+        block_buffer_free(block_buffer, block_buffer_context);
+    }
+}
+
+k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t *allocate, k4a_memory_destroy_cb_t *free_cb)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, (allocate == NULL) != (free_cb == NULL));
+
+    k4a_spin_lock(&g_allocator_lock);
+    g_allocator_allocate = allocate;
+    g_allocator_free = free_cb;
+    k4a_spin_unlock(&g_allocator_lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t allocator_reserve_pool(allocation_source_t source, size_t block_size, uint32_t block_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block_size == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block_count == 0 || block_count > ALLOCATOR_POOL_MAX_BLOCKS);
+
+    // Allocate outside of the lock, then hand the memory to the pool
+    uint8_t *buffer[ALLOCATOR_POOL_MAX_BLOCKS] = { 0 };
+    void *buffer_context[ALLOCATOR_POOL_MAX_BLOCKS] = { 0 };
+    k4a_memory_destroy_cb_t *buffer_free[ALLOCATOR_POOL_MAX_BLOCKS] = { 0 };
+    uint32_t buffer_count = 0;
+    for (; buffer_count < block_count; buffer_count++)
+    {
+        buffer[buffer_count] = allocator_allocate_memory(block_size,
+                                                         &buffer_context[buffer_count],
+                                                         &buffer_free[buffer_count]);
+        if (buffer[buffer_count] == NULL)
+        {
+            LOG_WARNING("Allocator pool of %llu byte blocks limited to %u of %u blocks",
+                        (unsigned long long)block_size,
+                        buffer_count,
+                        block_count);
+            break;
+        }
+    }
+
+    k4a_spin_lock(&g_allocator_lock);
+    allocator_pool_t *pool = allocator_find_pool(source, block_size);
+    for (int i = 0; i < ALLOCATOR_MAX_POOLS && pool == NULL; i++)
+    {
+        // An unused pool can be taken over once every retired block has come back
+        allocator_pool_t *candidate = &g_allocator_pools[i];
+        bool empty = candidate->reservation_count == 0;
+        for (int j = 0; j < ALLOCATOR_POOL_MAX_BLOCKS && empty; j++)
+        {
+            empty = candidate->block[j].state == ALLOCATOR_BLOCK_EMPTY;
+        }
+        if (empty)
+        {
+            pool = candidate;
+            pool->source = source;
+            pool->block_size = block_size;
+        }
+    }
+
+    if (pool != NULL)
+    {
+        pool->reservation_count++;
+        for (int i = 0; i < ALLOCATOR_POOL_MAX_BLOCKS && buffer_count > 0; i++)
+        {
+            allocator_block_t *block = &pool->block[i];
+            if (block->state == ALLOCATOR_BLOCK_EMPTY)
+            {
+                buffer_count--;
+                block->source = source;
+                block->pool = pool;
+                block->buffer = buffer[buffer_count];
+                block->buffer_context = buffer_context[buffer_count];
+                block->buffer_free = buffer_free[buffer_count];
+                block->state = ALLOCATOR_BLOCK_FREE;
+            }
+        }
+    }
+    k4a_spin_unlock(&g_allocator_lock);
+
+    // Memory that did not fit into the pool
+    for (uint32_t i = 0; i < buffer_count; i++)
+    {
+        buffer_free[i](buffer[i], buffer_context[i]);
+    }
+
+    if (pool == NULL)
+    {
+        LOG_WARNING("No allocator pool available for %llu byte blocks", (unsigned long long)block_size);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void allocator_release_pool(allocation_source_t source, size_t block_size, uint32_t block_count)
+{
+    uint8_t *buffer[ALLOCATOR_POOL_MAX_BLOCKS];
+    void *buffer_context[ALLOCATOR_POOL_MAX_BLOCKS];
+    k4a_memory_destroy_cb_t *buffer_free[ALLOCATOR_POOL_MAX_BLOCKS];
+    uint32_t buffer_count = 0;
+
+    k4a_spin_lock(&g_allocator_lock);
+    allocator_pool_t *pool = allocator_find_pool(source, block_size);
+    if (pool != NULL)
+    {
+        pool->reservation_count--;
+        uint32_t remove_count = pool->reservation_count == 0 ? ALLOCATOR_POOL_MAX_BLOCKS : block_count;
+
+        // Give back cached blocks first, then let blocks still in use go when they are freed
+        for (int i = 0; i < ALLOCATOR_POOL_MAX_BLOCKS && remove_count > 0; i++)
+        {
+            allocator_block_t *block = &pool->block[i];
+            if (block->state == ALLOCATOR_BLOCK_FREE)
+            {
+                buffer[buffer_count] = block->buffer;
+                buffer_context[buffer_count] = block->buffer_context;
+                buffer_free[buffer_count] = block->buffer_free;
+                buffer_count++;
+                block->buffer = NULL;
+                block->state = ALLOCATOR_BLOCK_EMPTY;
+                remove_count--;
+            }
+        }
+        for (int i = 0; i < ALLOCATOR_POOL_MAX_BLOCKS && remove_count > 0; i++)
+        {
+            allocator_block_t *block = &pool->block[i];
+            if (block->state == ALLOCATOR_BLOCK_IN_USE)
+            {
+                block->state = ALLOCATOR_BLOCK_RETIRED;
+                remove_count--;
+            }
+        }
+    }
+    k4a_spin_unlock(&g_allocator_lock);
+
+    for (uint32_t i = 0; i < buffer_count; i++)
+    {
+        buffer_free[i](buffer[i], buffer_context[i]);
+    }
 }
 
 long allocator_test_for_leaks(void)
@@ -189,7 +532,7 @@ void capture_dec_ref(k4a_capture_t capture_handle)
 
     if (new_count == 0)
     {
-        Lock(capture->lock);
+        // This was the last reference, no other thread can be using the image slots
         for (int x = 0; x < IMAGE_TYPE_COUNT; x++)
         {
             if (capture->image[x])
@@ -197,8 +540,6 @@ void capture_dec_ref(k4a_capture_t capture_handle)
                 image_dec_ref(capture->image[x]);
             }
         }
-        Unlock(capture->lock);
-        Lock_Deinit(capture->lock);
         k4a_capture_t_destroy(capture_handle);
     }
 }
@@ -223,14 +564,6 @@ k4a_result_t capture_create(k4a_capture_t *capture_handle)
     {
         capture->ref_count = 1;
         capture->temperature_c = NAN;
-        capture->lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(capture->lock != NULL);
-    }
-
-    if (K4A_FAILED(result) && capture)
-    {
-        capture_dec_ref(*capture_handle);
-        capture_handle = NULL;
     }
 
     return result;
@@ -241,30 +574,14 @@ k4a_image_t capture_get_color_image(k4a_capture_t capture_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_COLOR];
-    if (*image)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
-    return *image;
+    return capture_get_image(capture, IMAGE_TYPE_COLOR);
 }
 k4a_image_t capture_get_depth_image(k4a_capture_t capture_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_DEPTH];
-    if (*image)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
-    return *image;
+    return capture_get_image(capture, IMAGE_TYPE_DEPTH);
 }
 
 k4a_image_t capture_get_ir_image(k4a_capture_t capture_handle)
@@ -272,15 +589,7 @@ k4a_image_t capture_get_ir_image(k4a_capture_t capture_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_IR];
-    if (*image)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
-    return *image;
+    return capture_get_image(capture, IMAGE_TYPE_IR);
 }
 
 k4a_image_t capture_get_imu_image(k4a_capture_t capture_handle)
@@ -294,56 +603,21 @@ void capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_han
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_COLOR];
-    if (*image)
-    {
-        image_dec_ref(*image); // drop the image that was here
-    }
-    *image = image_handle;
-    if (image_handle != NULL)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
+    capture_set_image(capture, IMAGE_TYPE_COLOR, image_handle);
 }
 void capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_DEPTH];
-    if (*image)
-    {
-        image_dec_ref(*image); // drop the image that was here
-    }
-    *image = image_handle;
-    if (image_handle != NULL)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
+    capture_set_image(capture, IMAGE_TYPE_DEPTH, image_handle);
 }
 void capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-    Lock(capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_IR];
-    if (*image)
-    {
-        image_dec_ref(*image); // drop the image that was here
-    }
-    *image = image_handle;
-    if (image_handle != NULL)
-    {
-        image_inc_ref(*image);
-    }
-    Unlock(capture->lock);
+    capture_set_image(capture, IMAGE_TYPE_IR, image_handle);
 }
 void capture_set_imu_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
@@ -367,3 +641,43 @@ float capture_get_temperature_c(k4a_capture_t capture_handle)
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
     return capture->temperature_c;
 }
+
+uint64_t capture_get_host_time_usec(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+
+    // Split the conversion so that the multiplication cannot overflow
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t remainder = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000 + remainder * 1000000 / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#endif
+}
+
+void capture_set_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage, uint64_t timestamp_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, (uint32_t)stage >= K4A_CAPTURE_STAGE_COUNT);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+    capture->stage_timestamp_usec[stage] = timestamp_usec;
+}
+
+uint64_t capture_get_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(0, (uint32_t)stage >= K4A_CAPTURE_STAGE_COUNT);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+    return capture->stage_timestamp_usec[stage];
+}
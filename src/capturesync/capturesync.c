@@ -9,6 +9,7 @@
 #include <k4ainternal/queue.h>
 #include <k4ainternal/logging.h>
 #include <k4ainternal/common.h>
+#include <k4ainternal/atomic.h>
 
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/envvariable.h>
@@ -16,6 +17,7 @@
 // System dependencies
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 typedef k4a_image_t(pfn_get_typed_image_t)(k4a_capture_t capture);
 typedef struct _image_t
@@ -29,6 +31,20 @@ typedef struct _image_t
     uint64_t ts;           // The Timestamp of the image
 } frame_info_t;
 
+// Latencies are counted in 16 buckets per power of two microseconds. Values below 32us get a bucket each, and values
+// of 2^32us (over an hour) and more share the last bucket.
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKET_COUNT (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_USEC_BITS 32
+#define LATENCY_BUCKET_COUNT ((LATENCY_MAX_USEC_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKET_COUNT)
+
+// Updated with atomics by the threads popping captures so that k4a_device_get_capture() never waits for a lock
+typedef struct _latency_histogram_t
+{
+    volatile long bucket[LATENCY_BUCKET_COUNT];
+    volatile uint64_t max_usec;
+} latency_histogram_t;
+
 typedef struct _capturesync_context_t
 {
     queue_t sync_queue;    // Queue for storing synchronized captures in
@@ -48,6 +64,12 @@ typedef struct _capturesync_context_t
     volatile bool running;              // We have received start and should be processing data when true.
     LOCK_HANDLE lock;
 
+    // Latency between the stage timestamps of the captures popped by the user, see k4a_capture_latency_stats_t
+    latency_histogram_t latency_depth_engine;
+    latency_histogram_t latency_sync;
+    latency_histogram_t latency_pop;
+    latency_histogram_t latency_end_to_end;
+
 } capturesync_context_t;
 
 K4A_DECLARE_CONTEXT(capturesync_t, capturesync_context_t);
@@ -60,6 +82,97 @@ K4A_DECLARE_CONTEXT(capturesync_t, capturesync_context_t);
 
 #define MICRO_SECONDS(seconds) (seconds * 1000000)
 
+static uint32_t latency_bucket_index(uint64_t usec)
+{
+    if (usec >= ((uint64_t)1 << LATENCY_MAX_USEC_BITS))
+    {
+        usec = ((uint64_t)1 << LATENCY_MAX_USEC_BITS) - 1;
+    }
+
+    // Drop low bits until the value fits in the 2 * LATENCY_SUB_BUCKET_COUNT buckets of its power of two
+    uint32_t shift = 0;
+    while ((usec >> shift) >= 2 * LATENCY_SUB_BUCKET_COUNT)
+    {
+        shift++;
+    }
+    return shift * LATENCY_SUB_BUCKET_COUNT + (uint32_t)(usec >> shift);
+}
+
+// Returns the largest latency counted in a bucket
+static uint64_t latency_bucket_upper_bound(uint32_t index)
+{
+    if (index < 2 * LATENCY_SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+    uint32_t shift = index / LATENCY_SUB_BUCKET_COUNT - 1;
+    uint64_t value = index - shift * LATENCY_SUB_BUCKET_COUNT;
+    return ((value + 1) << shift) - 1;
+}
+
+// Counts the time between two stage timestamps, unless the capture was not stamped at either stage
+static void latency_histogram_add(latency_histogram_t *histogram, uint64_t begin_usec, uint64_t end_usec)
+{
+    if (begin_usec == 0 || end_usec == 0)
+    {
+        return;
+    }
+
+    uint64_t usec = end_usec > begin_usec ? end_usec - begin_usec : 0;
+    k4a_atomic_increment_long(&histogram->bucket[latency_bucket_index(usec)]);
+
+    uint64_t max_usec = k4a_atomic_load_64(&histogram->max_usec);
+    while (usec > max_usec && !k4a_atomic_compare_exchange_64(&histogram->max_usec, &max_usec, usec))
+    {
+    }
+}
+
+static k4a_capture_latency_t latency_histogram_summarize(latency_histogram_t *histogram)
+{
+    k4a_capture_latency_t latency = { 0 };
+
+    // Take one copy of the counts so that captures popped meanwhile do not skew the percentiles
+    long bucket[LATENCY_BUCKET_COUNT];
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        bucket[i] = k4a_atomic_load_long(&histogram->bucket[i]);
+        latency.count += (uint64_t)bucket[i];
+    }
+    if (latency.count == 0)
+    {
+        return latency;
+    }
+    latency.max_usec = k4a_atomic_load_64(&histogram->max_usec);
+
+    uint64_t p50_rank = (latency.count * 50 + 99) / 100;
+    uint64_t p99_rank = (latency.count * 99 + 99) / 100;
+    uint64_t rank = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT && rank < p99_rank; i++)
+    {
+        rank += (uint64_t)bucket[i];
+        if (latency.p50_usec == 0 && rank >= p50_rank)
+        {
+            latency.p50_usec = latency_bucket_upper_bound(i);
+        }
+        if (rank >= p99_rank)
+        {
+            latency.p99_usec = latency_bucket_upper_bound(i);
+        }
+    }
+
+    // The bucket bounds can exceed the largest latency counted in them
+    latency.p50_usec = latency.p50_usec < latency.max_usec ? latency.p50_usec : latency.max_usec;
+    latency.p99_usec = latency.p99_usec < latency.max_usec ? latency.p99_usec : latency.max_usec;
+    return latency;
+}
+
+// Makes a capture available to the user, stamping the time it became available
+static void publish_capture(capturesync_context_t *sync, k4a_capture_t capture)
+{
+    capture_set_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_SYNC, capture_get_host_time_usec());
+    queue_push(sync->sync_queue, capture);
+}
+
 /**
  * This function is responsible for updating the information in either capturesync_context_t->depth_ir or in
  * capturesync_context_t->color. capturesync_context_t holds the capture, image, and ts for the sample we are currenly
@@ -90,7 +203,7 @@ drop_sample(capturesync_context_t *sync, k4a_wait_result_t *wresult, bool color_
         // drop_into_queue is provided, then it is dropped on the floor
         if (!sync->synchronized_images_only)
         {
-            queue_push(sync->sync_queue, frame_info->capture);
+            publish_capture(sync, frame_info->capture);
         }
     }
 
@@ -144,7 +257,7 @@ static void replace_sample(capturesync_context_t *sync, k4a_capture_t capture_ne
 
     if (!sync->synchronized_images_only)
     {
-        queue_push(sync->sync_queue, frame_info->capture);
+        publish_capture(sync, frame_info->capture);
     }
     capture_dec_ref(frame_info->capture);
     image_dec_ref(frame_info->image);
@@ -254,7 +367,7 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
         if (sync->sync_captures == false || sync->disable_sync == true)
         {
             // we are not synchronizing samples, just copy to the queue
-            queue_push(sync->sync_queue, capture_raw);
+            publish_capture(sync, capture_raw);
             result = K4A_RESULT_FAILED; // Not an error, just a graceful exit
         }
         else if (!color_capture && sync->waiting_for_clean_depth_ts)
@@ -363,7 +476,7 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
                 }
 
                 k4a_capture_t merged = merge_captures(sync->depth_ir.capture, sync->color.capture);
-                queue_push(sync->sync_queue, merged);
+                publish_capture(sync, merged);
                 merged = NULL; // No need to call capture_dec_ref() here.
 
                 // Use drop symantic to get another sample from the queue if present. Synchronized sample is
@@ -486,6 +599,12 @@ k4a_result_t capturesync_start(capturesync_t capturesync_handle, k4a_device_conf
     sync->waiting_for_clean_depth_ts = true;
     sync->synchronized_images_only = config->synchronized_images_only;
 
+    // Latency statistics cover one streaming session
+    memset(&sync->latency_depth_engine, 0, sizeof(sync->latency_depth_engine));
+    memset(&sync->latency_sync, 0, sizeof(sync->latency_sync));
+    memset(&sync->latency_pop, 0, sizeof(sync->latency_pop));
+    memset(&sync->latency_end_to_end, 0, sizeof(sync->latency_end_to_end));
+
     uint32_t camera_fps = k4a_convert_fps_to_uint(config->camera_fps);
 
     result = K4A_RESULT_FROM_BOOL(camera_fps > 0);
@@ -578,7 +697,31 @@ k4a_wait_result_t capturesync_get_capture(capturesync_t capturesync_handle,
     k4a_wait_result_t wresult = queue_pop(sync->sync_queue, timeout_in_ms, &capture_handle);
     if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
     {
+        uint64_t pop_usec = capture_get_host_time_usec();
+        capture_set_stage_timestamp_usec(capture_handle, K4A_CAPTURE_STAGE_POP, pop_usec);
+
+        uint64_t usb_transfer_usec = capture_get_stage_timestamp_usec(capture_handle, K4A_CAPTURE_STAGE_USB_TRANSFER);
+        uint64_t depth_engine_usec = capture_get_stage_timestamp_usec(capture_handle, K4A_CAPTURE_STAGE_DEPTH_ENGINE);
+        uint64_t sync_usec = capture_get_stage_timestamp_usec(capture_handle, K4A_CAPTURE_STAGE_SYNC);
+        latency_histogram_add(&sync->latency_depth_engine, usb_transfer_usec, depth_engine_usec);
+        latency_histogram_add(&sync->latency_sync, depth_engine_usec, sync_usec);
+        latency_histogram_add(&sync->latency_pop, sync_usec, pop_usec);
+        latency_histogram_add(&sync->latency_end_to_end, usb_transfer_usec, pop_usec);
+
         *capture = capture_handle;
     }
     return wresult;
 }
+
+k4a_result_t capturesync_get_latency_stats(capturesync_t capturesync_handle, k4a_capture_latency_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+    stats->depth_engine = latency_histogram_summarize(&sync->latency_depth_engine);
+    stats->sync = latency_histogram_summarize(&sync->latency_sync);
+    stats->pop = latency_histogram_summarize(&sync->latency_pop);
+    stats->end_to_end = latency_histogram_summarize(&sync->latency_end_to_end);
+    return K4A_RESULT_SUCCEEDED;
+}
@@ -143,6 +143,16 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         return K4A_RESULT_FAILED;
     }
 
+    if (m_input_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG && m_output_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        if (K4A_FAILED(StartDecodeThreads()))
+        {
+            m_width_pixels = 0;
+            m_height_pixels = 0;
+            return K4A_RESULT_FAILED;
+        }
+    }
+
     // Set callback
     m_pCallback = pCallback;
     m_pCallbackContext = pCallbackContext;
@@ -153,6 +163,7 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         LOG_ERROR("Failed to start streaming: %s", uvc_strerror(res));
 
         // Clear
+        StopDecodeThreads();
         m_width_pixels = 0;
         m_height_pixels = 0;
         m_pCallback = nullptr;
@@ -180,11 +191,17 @@ void UVCCameraReader::Stop()
         m_pCallback = nullptr;
         m_pCallbackContext = nullptr;
 
+        // Release decode threads waiting for their turn to deliver
+        m_decodeDelivered.notify_all();
+
         // Call uvc_stop_streaming() without lock.
         // uvc_stop_streaming() returns when all callbacks are completed or cancelled.
         // Calling it with lock may cause deadlock.
         lock.unlock();
         uvc_stop_streaming(m_pDeviceHandle);
+
+        // No more frames can be queued, so the decode threads can be joined. Frames still queued are discarded.
+        StopDecodeThreads();
     }
 }
 
@@ -213,13 +230,6 @@ void UVCCameraReader::Shutdown()
         uvc_exit(m_pContext);
         m_pContext = nullptr;
     }
-
-    if (m_decoder)
-    {
-        // Destroy MJPEG decoder
-        (void)tjDestroy(m_decoder);
-        m_decoder = nullptr;
-    }
 }
 
 k4a_result_t UVCCameraReader::GetCameraControl(const k4a_color_control_command_t command,
@@ -621,15 +631,8 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
     if (m_streaming && frame)
     {
         void *context = nullptr;
-        k4a_image_t image = NULL;
         uint8_t *buffer = nullptr;
-        size_t buffer_size = 0;
-        int stride = 0;
-        uint64_t framePTS = 0;
-        uint64_t exposure_time = 0;
-        uint32_t iso_speed = 0;
-        uint32_t white_balance = 0;
-        bool decodeMJPEG = false;
+        FrameMetadata metadata = {};
 
         // Parse metadata
         size_t bufferLeft = (size_t)frame->metadata_bytes;
@@ -644,7 +647,7 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                 {
                     PKSCAMERA_CUSTOM_METADATA_FrameAlignInfo pFrameAlignInfo =
                         (PKSCAMERA_CUSTOM_METADATA_FrameAlignInfo)pItem;
-                    framePTS = pFrameAlignInfo->FramePTS;
+                    metadata.framePTS = pFrameAlignInfo->FramePTS;
                 }
                 break;
                 case MetadataId_CaptureStats:
@@ -652,15 +655,15 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                     PKSCAMERA_METADATA_CAPTURESTATS pCaptureStats = (PKSCAMERA_METADATA_CAPTURESTATS)pItem;
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_EXPOSURETIME)
                     {
-                        exposure_time = pCaptureStats->ExposureTime / 10; // hns to micro-second
+                        metadata.exposure_time = pCaptureStats->ExposureTime / 10; // hns to micro-second
                     }
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_ISOSPEED)
                     {
-                        iso_speed = pCaptureStats->IsoSpeed;
+                        metadata.iso_speed = pCaptureStats->IsoSpeed;
                     }
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_WHITEBALANCE)
                     {
-                        white_balance = pCaptureStats->WhiteBalance;
+                        metadata.white_balance = pCaptureStats->WhiteBalance;
                     }
                 }
                 break;
@@ -684,7 +687,7 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                                                                         pItem->Size);
             }
         }
-        if (framePTS == 0)
+        if (metadata.framePTS == 0)
         {
             // Drop 0 time stamped frame
             return;
@@ -693,103 +696,260 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
         if (m_input_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG &&
             m_output_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
         {
-            stride = (int)frame->width * 4;
-            buffer_size = (size_t)stride * frame->height;
-            decodeMJPEG = true;
-        }
-        else
-        {
-            stride = (int)frame->step;
-            buffer_size = frame->data_bytes;
+            // Decoding a full resolution frame takes a large share of the frame interval, so it is done on the decode
+            // threads to keep this callback short enough for libuvc to service the next transfer.
+            QueueMJPEGDecode(frame, metadata);
+            return;
         }
 
+        int stride = (int)frame->step;
+        size_t buffer_size = frame->data_bytes;
+
         // Allocate K4A Color buffer
         buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, buffer_size, &context);
         k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
 
         if (K4A_SUCCEEDED(result))
         {
-            if (decodeMJPEG)
-            {
-                // Decode MJPG into BRGA32
-                result = DecodeMJPEGtoBGRA32((uint8_t *)frame->data, frame->data_bytes, buffer, buffer_size);
-            }
-            else
-            {
-                // Copy to K4A buffer
-                memcpy(buffer, frame->data, buffer_size);
-            }
+            // Copy to K4A buffer
+            memcpy(buffer, frame->data, buffer_size);
         }
 
-        if (K4A_SUCCEEDED(result))
+        DeliverFrame(result, buffer, buffer_size, stride, context, metadata);
+    }
+}
+
+void UVCCameraReader::DeliverFrame(k4a_result_t result,
+                                   uint8_t *buffer,
+                                   size_t buffer_size,
+                                   int stride,
+                                   void *context,
+                                   const FrameMetadata &metadata)
+{
+    k4a_image_t image = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(image_create_from_buffer(m_output_image_format,
+                                                     (int)m_width_pixels,
+                                                     (int)m_height_pixels,
+                                                     stride,
+                                                     buffer,
+                                                     buffer_size,
+                                                     allocator_free,
+                                                     context,
+                                                     &image));
+    }
+    else if (buffer)
+    {
+        // cleanup if there was an error
+        allocator_free(buffer, context);
+    }
+
+    k4a_capture_t capture = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(capture_create(&capture));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Set metadata
+        image_set_timestamp_usec(image, K4A_90K_HZ_TICK_TO_USEC(metadata.framePTS));
+        image_set_exposure_time_usec(image, metadata.exposure_time);
+        image_set_iso_speed(image, metadata.iso_speed);
+        image_set_white_balance(image, metadata.white_balance);
+
+        // Set image
+        capture_set_color_image(capture, image);
+    }
+
+    // Calback to color
+    m_pCallback(result, capture, m_pCallbackContext);
+
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+
+    if (capture)
+    {
+        // We guarantee that capture is valid for the duration of the callback function, if someone
+        // needs it to live longer, then they need to add a ref
+        capture_dec_ref(capture);
+    }
+}
+
+void UVCCameraReader::QueueMJPEGDecode(uvc_frame_t *frame, const FrameMetadata &metadata)
+{
+    std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+
+    if (m_decodeInFlight >= UVC_DECODE_MAX_IN_FLIGHT)
+    {
+        if (m_decodeDroppedFrames++ == 0)
         {
-            result = TRACE_CALL(image_create_from_buffer(m_output_image_format,
-                                                         (int)m_width_pixels,
-                                                         (int)m_height_pixels,
-                                                         stride,
-                                                         buffer,
-                                                         buffer_size,
-                                                         allocator_free,
-                                                         context,
-                                                         &image));
+            LOG_WARNING("MJPEG decode is falling behind, dropping color frames", 0);
         }
-        else
+        return;
+    }
+
+    DecodeJob job;
+    if (!m_decodeFreeBuffers.empty())
+    {
+        job.mjpeg = std::move(m_decodeFreeBuffers.back());
+        m_decodeFreeBuffers.pop_back();
+    }
+
+    try
+    {
+        const uint8_t *data = (const uint8_t *)frame->data;
+        job.mjpeg.assign(data, data + frame->data_bytes);
+    }
+    catch (std::bad_alloc &)
+    {
+        LOG_ERROR("Failed to allocate %llu bytes for MJPEG frame", (uint64_t)frame->data_bytes);
+        return;
+    }
+
+    job.sequence = m_decodeNextSequence++;
+    job.width = frame->width;
+    job.height = frame->height;
+    job.metadata = metadata;
+
+    m_decodeQueue.push_back(std::move(job));
+    m_decodeInFlight++;
+    m_decodeAvailable.notify_one();
+}
+
+k4a_result_t UVCCameraReader::StartDecodeThreads()
+{
+    m_decodeNextSequence = 0;
+    m_decodeNextDelivery = 0;
+    {
+        std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+        m_decodeStopping = false;
+        m_decodeInFlight = 0;
+        m_decodeDroppedFrames = 0;
+    }
+
+    try
+    {
+        for (uint32_t i = 0; i < UVC_DECODE_THREAD_COUNT; i++)
         {
-            // cleanup if there was an error
-            allocator_free(buffer, context);
+            m_decodeThreads.emplace_back(&UVCCameraReader::DecodeThread, this);
         }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start MJPEG decode thread: %s", e.what());
+        StopDecodeThreads();
+        return K4A_RESULT_FAILED;
+    }
 
-        k4a_capture_t capture = NULL;
-        if (K4A_SUCCEEDED(result))
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void UVCCameraReader::StopDecodeThreads()
+{
+    {
+        std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+        m_decodeStopping = true;
+    }
+    m_decodeAvailable.notify_all();
+
+    for (std::thread &thread : m_decodeThreads)
+    {
+        thread.join();
+    }
+    m_decodeThreads.clear();
+
+    std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+    m_decodeQueue.clear();
+    m_decodeFreeBuffers.clear();
+    m_decodeInFlight = 0;
+    if (m_decodeDroppedFrames > 0)
+    {
+        LOG_WARNING("Dropped %llu color frames while waiting for MJPEG decode", (uint64_t)m_decodeDroppedFrames);
+    }
+}
+
+void UVCCameraReader::DecodeThread()
+{
+    // Each thread owns its decoder, turbojpeg handles are not safe to share between threads
+    tjhandle decoder = tjInitDecompress();
+    if (decoder == nullptr)
+    {
+        LOG_ERROR("MJPEG decoder initialization failed\n", 0);
+    }
+
+    std::unique_lock<std::mutex> decodeLock(m_decodeMutex);
+    while (true)
+    {
+        m_decodeAvailable.wait(decodeLock, [this] { return m_decodeStopping || !m_decodeQueue.empty(); });
+        if (m_decodeStopping)
         {
-            result = TRACE_CALL(capture_create(&capture));
+            break;
         }
 
+        DecodeJob job = std::move(m_decodeQueue.front());
+        m_decodeQueue.pop_front();
+        decodeLock.unlock();
+
+        void *context = nullptr;
+        int stride = (int)job.width * 4;
+        size_t buffer_size = (size_t)stride * job.height;
+
+        // Allocate K4A Color buffer
+        uint8_t *buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, buffer_size, &context);
+        k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL && decoder != nullptr);
+
         if (K4A_SUCCEEDED(result))
         {
-            // Set metadata
-            image_set_timestamp_usec(image, K4A_90K_HZ_TICK_TO_USEC(framePTS));
-            image_set_exposure_time_usec(image, exposure_time);
-            image_set_iso_speed(image, iso_speed);
-            image_set_white_balance(image, white_balance);
-
-            // Set image
-            capture_set_color_image(capture, image);
+            // Decode MJPG into BRGA32
+            result = DecodeMJPEGtoBGRA32(decoder, job.mjpeg.data(), job.mjpeg.size(), buffer, buffer_size);
         }
 
-        // Calback to color
-        m_pCallback(result, capture, m_pCallbackContext);
-
-        if (image)
         {
-            image_dec_ref(image);
+            // Frames are delivered in the order libuvc produced them, regardless of which thread finishes first
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_decodeDelivered.wait(lock, [this, &job] { return !m_streaming || m_decodeNextDelivery == job.sequence; });
+
+            if (m_streaming)
+            {
+                DeliverFrame(result, buffer, buffer_size, stride, context, job.metadata);
+                m_decodeNextDelivery++;
+                m_decodeDelivered.notify_all();
+            }
+            else if (buffer)
+            {
+                allocator_free(buffer, context);
+            }
         }
 
-        if (capture)
+        decodeLock.lock();
+        m_decodeInFlight--;
+        if (m_decodeFreeBuffers.size() < UVC_DECODE_MAX_IN_FLIGHT)
         {
-            // We guarantee that capture is valid for the duration of the callback function, if someone
-            // needs it to live longer, then they need to add a ref
-            capture_dec_ref(capture);
+            m_decodeFreeBuffers.push_back(std::move(job.mjpeg));
         }
     }
+    decodeLock.unlock();
+
+    if (decoder)
+    {
+        (void)tjDestroy(decoder);
+    }
 }
 
-k4a_result_t
-UVCCameraReader::DecodeMJPEGtoBGRA32(uint8_t *in_buf, const size_t in_size, uint8_t *out_buf, const size_t out_size)
+k4a_result_t UVCCameraReader::DecodeMJPEGtoBGRA32(tjhandle decoder,
+                                                  uint8_t *in_buf,
+                                                  const size_t in_size,
+                                                  uint8_t *out_buf,
+                                                  const size_t out_size)
 {
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, decoder == nullptr);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, m_width_pixels * m_height_pixels * 4 > out_size);
 
-    if (m_decoder == nullptr)
-    {
-        m_decoder = tjInitDecompress();
-        if (m_decoder == nullptr)
-        {
-            LOG_ERROR("MJPEG decoder initialization failed\n", 0);
-            return K4A_RESULT_FAILED;
-        }
-    }
-
-    int decompressStatus = tjDecompress2(m_decoder,
+    int decompressStatus = tjDecompress2(decoder,
                                          in_buf,
                                          (unsigned long)in_size,
                                          out_buf,
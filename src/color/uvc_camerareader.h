@@ -7,12 +7,23 @@
 #include "color_priv.h"
 
 // STL
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 // external
 #include <libuvc/libuvc.h>
 #include "turbojpeg.h"
 
+// Number of threads decoding MJPEG into BGRA32
+#define UVC_DECODE_THREAD_COUNT 2
+
+// Maximum number of frames queued or being decoded. Frames arriving while this many are in flight are dropped so the
+// libuvc callback never waits on the decoder.
+#define UVC_DECODE_MAX_IN_FLIGHT 4
+
 class UVCCameraReader
 {
 public:
@@ -43,12 +54,48 @@ public:
     void Callback(uvc_frame_t *frame);
 
 private:
+    struct FrameMetadata
+    {
+        uint64_t framePTS;
+        uint64_t exposure_time;
+        uint32_t iso_speed;
+        uint32_t white_balance;
+    };
+
+    struct DecodeJob
+    {
+        uint64_t sequence;
+        uint32_t width;
+        uint32_t height;
+        FrameMetadata metadata;
+        std::vector<uint8_t> mjpeg;
+    };
+
     bool IsInitialized()
     {
         return m_pContext && m_pDevice && m_pDeviceHandle;
     }
 
-    k4a_result_t DecodeMJPEGtoBGRA32(uint8_t *in_buf, const size_t in_size, uint8_t *out_buf, const size_t out_size);
+    k4a_result_t DecodeMJPEGtoBGRA32(tjhandle decoder,
+                                     uint8_t *in_buf,
+                                     const size_t in_size,
+                                     uint8_t *out_buf,
+                                     const size_t out_size);
+
+    // Must be called with m_mutex held
+    void DeliverFrame(k4a_result_t result,
+                      uint8_t *buffer,
+                      size_t buffer_size,
+                      int stride,
+                      void *context,
+                      const FrameMetadata &metadata);
+
+    // Must be called with m_mutex held
+    void QueueMJPEGDecode(uvc_frame_t *frame, const FrameMetadata &metadata);
+
+    k4a_result_t StartDecodeThreads();
+    void StopDecodeThreads();
+    void DecodeThread();
 
 private:
     // Lock
@@ -70,8 +117,19 @@ private:
     color_cb_stream_t *m_pCallback = nullptr;
     void *m_pCallbackContext = nullptr;
 
-    // MJPEG decoder
-    tjhandle m_decoder = nullptr;
+    // MJPEG decode stage. m_decodeNextSequence and m_decodeNextDelivery are guarded by m_mutex, the rest by
+    // m_decodeMutex. Lock order is m_mutex before m_decodeMutex.
+    std::mutex m_decodeMutex;
+    std::condition_variable m_decodeAvailable;
+    std::condition_variable m_decodeDelivered;
+    std::deque<DecodeJob> m_decodeQueue;
+    std::vector<std::vector<uint8_t>> m_decodeFreeBuffers;
+    std::vector<std::thread> m_decodeThreads;
+    bool m_decodeStopping = false;
+    uint32_t m_decodeInFlight = 0;
+    uint64_t m_decodeDroppedFrames = 0;
+    uint64_t m_decodeNextSequence = 0;
+    uint64_t m_decodeNextDelivery = 0;
 };
 
 #endif // UVC_CAMERAREADER_H
\ No newline at end of file
@@ -286,6 +286,9 @@ void depth_capture_available(k4a_result_t cb_result, k4a_image_t image_raw, void
     depth_context_t *depth = (depth_context_t *)context;
     k4a_capture_t capture_raw = NULL;
 
+    // Called from usb_cmd_libusb_cb() as soon as the transfer of the raw frame completes
+    uint64_t usb_transfer_usec = capture_get_host_time_usec();
+
     if (K4A_SUCCEEDED(cb_result))
     {
         cb_result = TRACE_CALL(capture_create(&capture_raw));
@@ -294,6 +297,7 @@ void depth_capture_available(k4a_result_t cb_result, k4a_image_t image_raw, void
     if (K4A_SUCCEEDED(cb_result))
     {
         capture_set_ir_image(capture_raw, image_raw);
+        capture_set_stage_timestamp_usec(capture_raw, K4A_CAPTURE_STAGE_USB_TRANSFER, usb_transfer_usec);
     }
 
     dewrapper_post_capture(cb_result, capture_raw, depth->dewrapper);
@@ -21,6 +21,9 @@
 
 #define DEWRAPPER_QUEUE_DEPTH ((uint32_t)2) // We should not need to store more than 1
 
+// Output buffers kept in the allocator pool, enough for the captures typically held by capturesync and the user
+#define DEWRAPPER_OUTPUT_POOL_SIZE ((uint32_t)6)
+
 typedef struct _dewrapper_context_t
 {
     queue_t queue;
@@ -182,6 +185,7 @@ static int depth_engine_thread(void *param)
     size_t depth_engine_output_buffer_size;
     int depth_engine_max_compute_time_ms;
     bool received_valid_image = false;
+    bool output_pool_reserved = false;
 
     result = TRACE_CALL(depth_engine_start_helper(dewrapper,
                                                   dewrapper->fps,
@@ -189,6 +193,14 @@ static int depth_engine_thread(void *param)
                                                   &depth_engine_max_compute_time_ms,
                                                   &depth_engine_output_buffer_size));
 
+    if (K4A_SUCCEEDED(result))
+    {
+        // The output size is only known once the depth engine exists. Without a pool the buffers come from the heap.
+        output_pool_reserved = K4A_SUCCEEDED(allocator_reserve_pool(ALLOCATION_SOURCE_DEPTH,
+                                                                   depth_engine_output_buffer_size,
+                                                                   DEWRAPPER_OUTPUT_POOL_SIZE));
+    }
+
     // The Start routine is blocked waiting for this thread to complete startup, so we signal it here and share our
     // startup status.
     Lock(dewrapper->lock);
@@ -212,6 +224,7 @@ static int depth_engine_thread(void *param)
         size_t raw_image_buffer_size = 0;
         void *allocator_context = NULL;
         bool dropped = false;
+        uint64_t depth_engine_usec = 0;
 
         k4a_wait_result_t wresult = queue_pop(dewrapper->queue, K4A_WAIT_INFINITE, &capture_raw);
         if (wresult != K4A_WAIT_RESULT_SUCCEEDED)
@@ -258,6 +271,7 @@ static int depth_engine_thread(void *param)
                                                     &outputCaptureInfo,
                                                     NULL);
             tickcounter_get_current_ms(dewrapper->tick, &stop_time);
+            depth_engine_usec = capture_get_host_time_usec();
             if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
             {
                 LOG_ERROR("Depth engine process frame failed with error code: %d.", deresult);
@@ -357,6 +371,11 @@ static int depth_engine_thread(void *param)
         {
             // set capture attributes
             capture_set_temperature_c(capture, outputCaptureInfo.sensor_temp);
+            capture_set_stage_timestamp_usec(capture,
+                                             K4A_CAPTURE_STAGE_USB_TRANSFER,
+                                             capture_get_stage_timestamp_usec(capture_raw,
+                                                                              K4A_CAPTURE_STAGE_USB_TRANSFER));
+            capture_set_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_DEPTH_ENGINE, depth_engine_usec);
 
             received_valid_image = true;
             dewrapper->capture_ready_cb(result, capture, dewrapper->capture_ready_cb_context);
@@ -401,6 +420,11 @@ static int depth_engine_thread(void *param)
 
     depth_engine_stop_helper(dewrapper);
 
+    if (output_pool_reserved)
+    {
+        allocator_release_pool(ALLOCATION_SOURCE_DEPTH, depth_engine_output_buffer_size, DEWRAPPER_OUTPUT_POOL_SIZE);
+    }
+
     // This will always return failure, because stop is trigged by the queue being disabled
     return (int)result;
 }
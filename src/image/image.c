@@ -4,9 +4,9 @@
 // This library
 #include <k4ainternal/image.h>
 #include <k4ainternal/allocator.h>
+#include <k4ainternal/handle_pool.h>
 
 // Dependent libraries
-#include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/refcount.h>
 
 // System dependencies
@@ -16,7 +16,6 @@
 typedef struct _image_context_t
 {
     volatile long ref_count;
-    LOCK_HANDLE lock;
 
     uint8_t *buffer;
     size_t buffer_size;
@@ -43,7 +42,11 @@ typedef struct _image_context_t
 
 } image_context_t;
 
-K4A_DECLARE_CONTEXT(k4a_image_t, image_context_t);
+// Images are created several times per frame on every stream and once per IMU sample, so their handles are recycled
+// instead of allocated. The count covers the images of every queue at full depth with room for the caller to hold some.
+#define IMAGE_HANDLE_POOL_COUNT 512
+
+K4A_DECLARE_POOLED_CONTEXT(k4a_image_t, image_context_t, IMAGE_HANDLE_POOL_COUNT);
 
 k4a_result_t image_create_from_buffer(k4a_image_format_t format,
                                       int width_pixels,
@@ -78,8 +81,6 @@ k4a_result_t image_create_from_buffer(k4a_image_format_t format,
         image->ref_count = 1;
         image->memory_free_cb = buffer_destroy_cb;
         image->memory_free_cb_context = buffer_destroy_cb_context;
-        image->lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(image->lock != NULL);
     }
 
     //
@@ -123,8 +124,6 @@ static k4a_result_t image_create_empty_image(allocation_source_t source, size_t
         image->buffer_size = size;
         image->memory_free_cb = allocator_free;
         image->memory_free_cb_context = alloc_context;
-        image->lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(image->lock != NULL);
     }
 
     if (K4A_FAILED(result))
@@ -145,6 +144,40 @@ k4a_result_t image_create_empty_internal(allocation_source_t source, size_t size
     return image_create_empty_image(source, size, image_handle);
 }
 
+k4a_result_t image_create_empty_from_buffer_internal(uint8_t *buffer,
+                                                     size_t size,
+                                                     image_destroy_cb_t *buffer_destroy_cb,
+                                                     void *buffer_destroy_cb_context,
+                                                     k4a_image_t *image_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, size == 0);
+
+    image_context_t *image;
+    k4a_result_t result;
+
+    result = K4A_RESULT_FROM_BOOL((image = k4a_image_t_create(image_handle)) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        image->buffer_size = size;
+        image->buffer = buffer;
+        image->ref_count = 1;
+        image->memory_free_cb = buffer_destroy_cb;
+        image->memory_free_cb_context = buffer_destroy_cb_context;
+    }
+
+    // Same contract as image_create_from_buffer, a failure leaves the buffer with the caller
+    if (K4A_FAILED(result) && *image_handle)
+    {
+        k4a_image_t_destroy(*image_handle);
+        *image_handle = NULL;
+    }
+
+    return result;
+}
+
 k4a_result_t image_create(k4a_image_format_t format,
                           int width_pixels,
                           int height_pixels,
@@ -200,7 +233,6 @@ void image_dec_ref(k4a_image_t image_handle)
         {
             image->memory_free_cb(image->buffer, image->memory_free_cb_context);
         }
-        Lock_Deinit(image->lock);
         k4a_image_t_destroy(image_handle);
     }
 }
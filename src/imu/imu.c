@@ -11,6 +11,9 @@
 #include <k4ainternal/math.h>
 #include <k4ainternal/queue.h>
 #include <k4ainternal/calibration.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/threadapi.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -39,6 +42,9 @@ extern "C" {
 // IMU start.
 #define MAX_IMU_TIME_STAMP_MS 1500
 
+// Number of samples the IMU buffers before dropping the oldest
+#define IMU_SAMPLE_RING_DEPTH QUEUE_CALC_DEPTH(K4A_IMU_SAMPLE_RATE, QUEUE_DEFAULT_DEPTH_USEC)
+
 //************************ Typedefs *****************************
 
 // parameters used to compute the calibrated IMU
@@ -50,11 +56,27 @@ typedef struct _imu_calibration_rectifier_t
     float mixing_matrix_accel[3 * 3];
 } imu_calibration_rectifier_t;
 
+// Ring of samples waiting to be read. Samples are stored without the intrinsic calibration, which is applied when they
+// are read. All fields are guarded by lock.
+typedef struct _imu_sample_ring_t
+{
+    LOCK_HANDLE lock;
+    COND_HANDLE condition; // Signaled when samples are added or the ring is disabled
+    k4a_imu_sample_t *samples;
+    uint32_t depth;          // Max samples the ring can hold
+    uint32_t read_index;     // Index of the oldest sample
+    uint32_t count;          // Number of samples in the ring
+    uint32_t overflow_count; // Samples dropped because the ring was full, since the last read
+    uint32_t waiting_count;  // Number of readers waiting on condition
+    uint32_t generation;     // Incremented every time the ring is disabled
+    bool enabled;
+} imu_sample_ring_t;
+
 typedef struct _imu_context_t
 {
     TICK_COUNTER_HANDLE tick;
     colormcu_t color_mcu;
-    queue_t queue;
+    imu_sample_ring_t ring;
     uint32_t dropped_count;
     float temperature;
 
@@ -73,6 +95,54 @@ K4A_DECLARE_CONTEXT(imu_t, imu_context_t);
 usb_cmd_stream_cb_t imu_capture_ready;
 
 //*********************** Functions *****************************
+// Adds a sample to the ring, dropping the oldest sample if the ring is full. The ring lock must be held.
+static void imu_ring_push_locked(imu_sample_ring_t *ring, const k4a_imu_sample_t *sample)
+{
+    if (ring->count == ring->depth)
+    {
+        ring->read_index = (ring->read_index + 1) % ring->depth;
+        ring->count--;
+        ring->overflow_count++;
+    }
+    ring->samples[(ring->read_index + ring->count) % ring->depth] = *sample;
+    ring->count++;
+}
+
+static void imu_ring_enable(imu_sample_ring_t *ring)
+{
+    Lock(ring->lock);
+    ring->read_index = 0;
+    ring->count = 0;
+    ring->overflow_count = 0;
+    ring->enabled = true;
+    Unlock(ring->lock);
+}
+
+// Disables the ring, drops the samples it holds, and fails any readers waiting for samples. Returns once every waiting
+// reader has left its wait, so the ring can be destroyed afterwards.
+static void imu_ring_disable(imu_sample_ring_t *ring)
+{
+    Lock(ring->lock);
+    ring->enabled = false;
+    ring->count = 0;
+    ring->generation++;
+
+    // A post only wakes one waiting reader, so post once per reader. They fail on the new generation even if the ring
+    // is enabled again before they get to run.
+    for (uint32_t i = 0; i < ring->waiting_count; i++)
+    {
+        Condition_Post(ring->condition);
+    }
+    while (ring->waiting_count != 0)
+    {
+        Condition_Post(ring->condition);
+        Unlock(ring->lock);
+        ThreadAPI_Sleep(1);
+        Lock(ring->lock);
+    }
+    Unlock(ring->lock);
+}
+
 /**
  *  Callback function used with the command module to handle received captures from the IMU device
  *
@@ -84,7 +154,7 @@ usb_cmd_stream_cb_t imu_capture_ready;
  *   image resource for IMU. This contains all of the information on the received capture.
  *
  *  @param p_context
- *   Callback context.  In this function, this is the handle to the initiating object that has the queue.
+ *   Callback context.  In this function, this is the handle to the initiating object that has the sample ring.
  *
  * \remarks
  * Capture is safe to use during this callback as the caller ensures a ref is held. If the callback function wants the
@@ -99,12 +169,11 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
     xyz_vector_t *p_accel_data = NULL;
     size_t capture_size;
 
-    // place capture in queue
     if (result != K4A_RESULT_SUCCEEDED)
     {
         LOG_WARNING("A streaming IMU transfer failed", 0);
-        // Notify queue of an error
-        queue_error(p_imu->queue);
+        // Fail readers until the IMU is restarted
+        imu_ring_disable(&p_imu->ring);
     }
 
     if (K4A_SUCCEEDED(result))
@@ -114,7 +183,7 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
 
     if (K4A_SUCCEEDED(result))
     {
-        // Take apart the capture packet data and create captures for each sample
+        // Take apart the capture packet data and add each sample to the ring
         p_packet = image_get_buffer(image);
         capture_size = image_get_size(image);
 
@@ -162,6 +231,8 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                         p_metadata->gyro.sample_count);
         }
 
+        uint32_t pushed_count = 0;
+        Lock(p_imu->ring.lock);
         for (uint32_t i = 0; i < p_metadata->gyro.sample_count && i < p_metadata->accel.sample_count; i++)
         {
             result = K4A_RESULT_SUCCEEDED;
@@ -188,16 +259,7 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                 }
             }
 
-            k4a_capture_t imu_capture = NULL;
-            k4a_image_t imu_image = NULL;
-
-            if (K4A_SUCCEEDED(result))
-            {
-                result = TRACE_CALL(
-                    image_create_empty_internal(ALLOCATION_SOURCE_IMU, sizeof(k4a_imu_sample_t), &imu_image));
-            }
-
-            if (K4A_SUCCEEDED(result))
+            if (K4A_SUCCEEDED(result) && p_imu->ring.enabled)
             {
                 k4a_imu_sample_t sample = { 0 };
                 sample.temperature = ((float)(p_metadata->temperature.value) / IMU_TEMPERATURE_DIVISOR) +
@@ -217,31 +279,16 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                                           IMU_GRAVITATIONAL_CONSTANT / IMU_SCALE_NORMALIZATION;
                 sample.acc_timestamp_usec = K4A_90K_HZ_TICK_TO_USEC(p_accel_data[i].pts);
 
-                memcpy(image_get_buffer(imu_image), &sample, sizeof(k4a_imu_sample_t));
-            }
-
-            if (K4A_SUCCEEDED(result))
-            {
-                result = TRACE_CALL(capture_create(&imu_capture));
-            }
-
-            if (K4A_SUCCEEDED(result))
-            {
-                capture_set_imu_image(imu_capture, imu_image);
-                queue_push(p_imu->queue, imu_capture);
+                imu_ring_push_locked(&p_imu->ring, &sample);
+                pushed_count++;
             }
+        }
 
-            if (imu_image)
-            {
-                // remove local ref on image
-                image_dec_ref(imu_image);
-            }
-            if (imu_capture)
-            {
-                // remove local ref on capture
-                capture_dec_ref(imu_capture); // release our interest in the new capture
-            }
+        if (pushed_count != 0 && p_imu->ring.waiting_count != 0)
+        {
+            Condition_Post(p_imu->ring.condition);
         }
+        Unlock(p_imu->ring.lock);
     }
 }
 
@@ -346,10 +393,21 @@ imu_create(TICK_COUNTER_HANDLE tick_handle, colormcu_t color_mcu, calibration_t
     p_imu->tick = tick_handle;
     p_imu->temperature = 0;
 
-    // Create allocator handle
+    p_imu->ring.depth = IMU_SAMPLE_RING_DEPTH;
+    p_imu->ring.samples = (k4a_imu_sample_t *)malloc(sizeof(k4a_imu_sample_t) * p_imu->ring.depth);
+    result = K4A_RESULT_FROM_BOOL(p_imu->ring.samples != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->ring.lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(p_imu->ring.lock != NULL);
+    }
 
-    result = TRACE_CALL(
-        queue_create(QUEUE_CALC_DEPTH(K4A_IMU_SAMPLE_RATE, QUEUE_DEFAULT_DEPTH_USEC), "Queue_imu", &p_imu->queue));
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->ring.condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(p_imu->ring.condition != NULL);
+    }
 
     if (K4A_SUCCEEDED(result))
     {
@@ -409,11 +467,26 @@ void imu_destroy(imu_t imu_handle)
     // implicit stop
     imu_stop(imu_handle);
 
-    // Destroy queue
-    if (imu->queue != NULL)
+    // Destroy the sample ring. Disabling it again releases any reader still waiting on it, also when the IMU was not
+    // running.
+    if (imu->ring.lock != NULL && imu->ring.condition != NULL)
+    {
+        imu_ring_disable(&imu->ring);
+    }
+    if (imu->ring.condition != NULL)
+    {
+        Condition_Deinit(imu->ring.condition);
+        imu->ring.condition = NULL;
+    }
+    if (imu->ring.lock != NULL)
     {
-        queue_destroy(imu->queue);
-        imu->queue = NULL;
+        Lock_Deinit(imu->ring.lock);
+        imu->ring.lock = NULL;
+    }
+    if (imu->ring.samples != NULL)
+    {
+        free(imu->ring.samples);
+        imu->ring.samples = NULL;
     }
 
     imu_t_destroy(imu_handle);
@@ -444,40 +517,110 @@ static void imu_apply_intrinsic_calibration(k4a_imu_sample_t *p_imu_sample, cons
 }
 
 /**
- *  Function to get the next capture in the stream.  Note, if excessive time has passed since the last call, some
- * captures may have been discarded.
+ *  Function to apply the calibration to a sample read from the ring
+ *
+ *  @param p_imu_sample
+ *   Pointer to this specific imu sample
+ *
+ *  @param p_imu
+ *   Pointer to the imu context, the calibration is refreshed if the temperature of the sample has changed.
+ *
+ */
+static void imu_calibrate_sample(k4a_imu_sample_t *p_imu_sample, imu_context_t *p_imu)
+{
+    // update the calibration when the temperature changes more than 0.25C
+    if ((p_imu_sample->temperature > (p_imu->temperature + 0.25f)) ||
+        (p_imu_sample->temperature < (p_imu->temperature - 0.25f)))
+    {
+        imu_update_calibration_with_temperature(p_imu_sample->temperature, p_imu_sample->temperature, p_imu);
+        p_imu->temperature = p_imu_sample->temperature;
+    }
+    // The application of intrinsic calibration is delayed until the IMU sample is queried.
+    imu_apply_intrinsic_calibration(p_imu_sample, p_imu);
+}
+
+/**
+ *  Function to get the next samples in the stream.  Note, if excessive time has passed since the last call, some
+ * samples may have been discarded.
  *
  *  @param imu_handle
  *   Handle to this specific object
  *
- *  @param imu_sample
- *   Pointer to where the sample will be written to
+ *  @param imu_samples
+ *   Pointer to where the samples will be written to
+ *
+ *  @param max_samples
+ *   Number of samples imu_samples can hold
+ *
+ *  @param sample_count
+ *   Pointer to where the number of samples written will be stored
  *
  *  @param timeout_in_ms
- *   Number of mSecs to wait until timing out for getting a capture
+ *   Number of mSecs to wait for a sample if none is available
  *
  *  @return
  *   K4A_WAIT_RESULT_TIMEOUT     Operation timed out
- *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and a capture was retrieved
+ *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and at least one sample was retrieved
  *   K4A_WAIT_RESULT_FAILED      Operation failed due to invalid input or unknown reason
  */
-k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms)
+k4a_wait_result_t imu_get_samples(imu_t imu_handle,
+                                  k4a_imu_sample_t *imu_samples,
+                                  size_t max_samples,
+                                  size_t *sample_count,
+                                  int32_t timeout_in_ms)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, imu_t, imu_handle);
-    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (imu_sample == NULL));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (imu_samples == NULL));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (max_samples == 0));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (sample_count == NULL));
 
     k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
     imu_context_t *p_imu = imu_t_get_context(imu_handle);
-    k4a_capture_t capture = NULL;
-    k4a_image_t image = NULL;
-    uint8_t *buffer = NULL;
+    imu_sample_ring_t *ring = &p_imu->ring;
+    uint32_t count = 0;
+    uint32_t overflow_count = 0;
 
-    wresult = queue_pop(p_imu->queue, timeout_in_ms, &capture);
+    *sample_count = 0;
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    Lock(ring->lock);
+    uint32_t generation = ring->generation;
+    if (ring->count == 0 && ring->enabled && timeout_in_ms != 0)
     {
-        k4a_result_t result = K4A_RESULT_FROM_BOOL((image = capture_get_imu_image(capture)) != NULL);
-        if (K4A_FAILED(result))
+        // Anything less than 0 is a wait forever condition in the lower level calls.
+        // K4A_WAIT_INFINITE (-1) is defined for the user for this purpose
+        bool infinite = timeout_in_ms < 0;
+        COND_RESULT cond_result = COND_OK;
+        tickcounter_ms_t start_tick = 0;
+        tickcounter_ms_t current_tick = 0;
+
+        if (!infinite && tickcounter_get_current_ms(p_imu->tick, &start_tick) != 0)
+        {
+            cond_result = COND_ERROR;
+        }
+
+        ring->waiting_count++;
+        while (cond_result != COND_ERROR && ring->count == 0 && ring->enabled && ring->generation == generation)
+        {
+            // The wait can return early, so a timed wait continues until the deadline on the monotonic tick counter
+            int wait_ms = 0;
+            if (!infinite)
+            {
+                if (tickcounter_get_current_ms(p_imu->tick, &current_tick) != 0)
+                {
+                    cond_result = COND_ERROR;
+                    break;
+                }
+                if (current_tick - start_tick >= (tickcounter_ms_t)timeout_in_ms)
+                {
+                    break;
+                }
+                wait_ms = (int)((tickcounter_ms_t)timeout_in_ms - (current_tick - start_tick));
+            }
+            cond_result = Condition_Wait(ring->condition, ring->lock, wait_ms);
+        }
+        ring->waiting_count--;
+
+        if (cond_result == COND_ERROR)
         {
             wresult = K4A_WAIT_RESULT_FAILED;
         }
@@ -485,42 +628,84 @@ k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample,
 
     if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
     {
-        buffer = image_get_buffer(image);
-        k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
-        if (K4A_FAILED(result))
+        if (!ring->enabled || ring->generation != generation)
         {
             wresult = K4A_WAIT_RESULT_FAILED;
+            if (ring->waiting_count != 0)
+            {
+                // Pass the wakeup on so the other waiting readers fail too
+                Condition_Post(ring->condition);
+            }
         }
-    }
+        else if (ring->count == 0)
+        {
+            wresult = K4A_WAIT_RESULT_TIMEOUT;
+        }
+        else
+        {
+            count = ring->count < max_samples ? ring->count : (uint32_t)max_samples;
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
-    {
-        assert(sizeof(k4a_imu_sample_t) <= image_get_size(image));
-        memcpy(imu_sample, buffer, sizeof(k4a_imu_sample_t));
+            // Copy out in at most two runs, the second one starting where the ring wraps around
+            uint32_t first_run = ring->depth - ring->read_index;
+            if (first_run > count)
+            {
+                first_run = count;
+            }
+            memcpy(imu_samples, &ring->samples[ring->read_index], first_run * sizeof(k4a_imu_sample_t));
+            memcpy(imu_samples + first_run, ring->samples, (count - first_run) * sizeof(k4a_imu_sample_t));
 
-        // update the calibration when the temperature changes more than 0.25C
-        if ((imu_sample->temperature > (p_imu->temperature + 0.25f)) ||
-            (imu_sample->temperature < (p_imu->temperature - 0.25f)))
-        {
-            imu_update_calibration_with_temperature(imu_sample->temperature, imu_sample->temperature, p_imu);
-            p_imu->temperature = imu_sample->temperature;
+            ring->read_index = (ring->read_index + count) % ring->depth;
+            ring->count -= count;
+            overflow_count = ring->overflow_count;
+            ring->overflow_count = 0;
+
+            if (ring->count != 0 && ring->waiting_count != 0)
+            {
+                // Hand the remaining samples to the next waiting reader
+                Condition_Post(ring->condition);
+            }
         }
-        // The application of intrinsic calibration is delayed until the IMU sample is queried.
-        imu_apply_intrinsic_calibration(imu_sample, p_imu);
     }
+    Unlock(ring->lock);
 
-    if (image)
+    if (overflow_count != 0)
     {
-        image_dec_ref(image);
+        LOG_WARNING("Dropped oldest %u IMU samples", overflow_count);
     }
-    if (capture)
+
+    for (uint32_t i = 0; i < count; i++)
     {
-        capture_dec_ref(capture);
+        imu_calibrate_sample(&imu_samples[i], p_imu);
     }
+    *sample_count = count;
 
     return wresult;
 }
 
+/**
+ *  Function to get the next sample in the stream.  Note, if excessive time has passed since the last call, some
+ * samples may have been discarded.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param imu_sample
+ *   Pointer to where the sample will be written to
+ *
+ *  @param timeout_in_ms
+ *   Number of mSecs to wait until timing out for getting a sample
+ *
+ *  @return
+ *   K4A_WAIT_RESULT_TIMEOUT     Operation timed out
+ *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and a sample was retrieved
+ *   K4A_WAIT_RESULT_FAILED      Operation failed due to invalid input or unknown reason
+ */
+k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms)
+{
+    size_t sample_count = 0;
+    return imu_get_samples(imu_handle, imu_sample, 1, &sample_count, timeout_in_ms);
+}
+
 /**
  *  Function to start the IMU stream.
  *
@@ -540,7 +725,7 @@ k4a_result_t imu_start(imu_t imu_handle, tickcounter_ms_t color_camera_start_tic
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, p_imu == NULL);
 
     p_imu->running = true;
-    queue_enable(p_imu->queue);
+    imu_ring_enable(&p_imu->ring);
 
     p_imu->wait_for_ts_reset = false;
     if (color_camera_start_tick != 0)
@@ -583,7 +768,7 @@ void imu_stop(imu_t imu_handle)
     if (p_imu->running)
     {
         colormcu_imu_stop_streaming(p_imu->color_mcu);
-        queue_disable(p_imu->queue);
+        imu_ring_disable(&p_imu->ring);
     }
     p_imu->running = false;
 }
@@ -4,13 +4,17 @@
 // This library
 #include <k4ainternal/logging.h>
 
+#include <azure_c_shared_utility/condition.h>
 #include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/refcount.h>
 #include <azure_c_shared_utility/threadapi.h>
 
 // System dependencies
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <chrono>
 
 // External dependencies
 
@@ -20,6 +24,7 @@
 #pragma warning(disable : 4702)
 #endif
 #include <spdlog/spdlog.h>
+#include <spdlog/details/os.h>
 #ifdef _MSC_VER
 #pragma warning(default : 4702)
 #endif
@@ -63,10 +68,317 @@ static k4a_log_level_t g_env_log_level = K4A_LOG_LEVEL_OFF;
 
 #define K4A_LOGGER "k4a_logger"
 
+//[2018-08-27 10:44:23.218] [level] [threadID] <message>
+// https://github.com/gabime/spdlog/wiki/3.-Custom-formatting
+#define K4A_LOG_PATTERN "[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [t=%t] %v"
+
+// Asynchronous mode. Threads that log stamp their message with the time and their thread id, copy it into a
+// preallocated ring and return; a background thread formats the records and hands them to spdlog, so a slow file or
+// terminal never blocks the thread that logged. The ring is a bounded multi producer, single consumer ring in the same
+// style as queue.c: each record holds the position it is ready for, a writer of position P waits for sequence P and
+// publishes P + 1, and the reader hands the record back for the next lap with P + depth. When the ring is full the
+// message is dropped and counted rather than waiting.
+#define LOG_ASYNC_RING_DEPTH (256)
+#define LOG_ASYNC_MESSAGE_SIZE (1024)
+
+typedef struct _logger_async_record_t
+{
+    std::atomic<uint64_t> sequence;
+    k4a_log_level_t level;
+    const char *file;
+    int line;
+    size_t thread_id;
+    std::chrono::system_clock::time_point time;
+    char message[LOG_ASYNC_MESSAGE_SIZE];
+} logger_async_record_t;
+
+typedef struct _logger_async_t
+{
+    // The ring is static so a thread still writing a record while the logger is destroyed never touches freed memory
+    logger_async_record_t ring[LOG_ASYNC_RING_DEPTH];
+    std::atomic<uint64_t> write_location;
+    uint64_t read_location;          // only used by the background thread, or by stop once it has been joined
+    uint64_t reported_dropped_count; // same as read_location
+    std::atomic<uint32_t> producers; // threads between checking running and finishing their push
+    std::atomic<bool> running;
+    std::atomic<bool> stopping;
+    std::atomic<bool> parked; // the background thread is waiting on condition
+    std::atomic<uint64_t> dropped_count;
+    std::shared_ptr<spdlog::logger> logger;
+
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    THREAD_HANDLE thread;
+} logger_async_t;
+
+static logger_async_t g_async_logger;
+
 // NOTE, if a sub directory for the log is used, then it needs to be created prior to attempting to create the file
 #define LOG_FILE_MAX_FILES (3)
 #define LOG_FILE_EXTENSION ".log"
 
+static const char *logger_level_name(k4a_log_level_t level)
+{
+    // Matches the level names spdlog writes for the synchronous logger
+    switch (level)
+    {
+    case K4A_LOG_LEVEL_CRITICAL:
+        return "critical";
+    case K4A_LOG_LEVEL_ERROR:
+        return "error";
+    case K4A_LOG_LEVEL_WARNING:
+        return "warning";
+    case K4A_LOG_LEVEL_INFO:
+        return "info";
+    case K4A_LOG_LEVEL_TRACE:
+    default:
+        return "trace";
+    }
+}
+
+static spdlog::level::level_enum logger_spdlog_level(k4a_log_level_t level)
+{
+    switch (level)
+    {
+    case K4A_LOG_LEVEL_CRITICAL:
+        return spdlog::level::critical;
+    case K4A_LOG_LEVEL_ERROR:
+        return spdlog::level::err;
+    case K4A_LOG_LEVEL_WARNING:
+        return spdlog::level::warn;
+    case K4A_LOG_LEVEL_INFO:
+        return spdlog::level::info;
+    case K4A_LOG_LEVEL_TRACE:
+    default:
+        return spdlog::level::trace;
+    }
+}
+
+// Writes a record in the layout of the synchronous logger's pattern, using the time and thread of the original call
+static void logger_async_write(const std::shared_ptr<spdlog::logger> &logger,
+                               k4a_log_level_t level,
+                               std::chrono::system_clock::time_point time,
+                               size_t thread_id,
+                               const char *file,
+                               int line,
+                               const char *message)
+{
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm local_time = spdlog::details::os::localtime(seconds);
+    long long milliseconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+
+    logger->log(logger_spdlog_level(level),
+                "[{:04d}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}.{:03d}] [{}] [t={}] {} ({}): {}",
+                local_time.tm_year + 1900,
+                local_time.tm_mon + 1,
+                local_time.tm_mday,
+                local_time.tm_hour,
+                local_time.tm_min,
+                local_time.tm_sec,
+                milliseconds,
+                logger_level_name(level),
+                thread_id,
+                file,
+                line,
+                message);
+}
+
+static bool logger_async_push(k4a_log_level_t level, const char *file, int line, const char *message)
+{
+    logger_async_t *async = &g_async_logger;
+    uint64_t position = async->write_location.load();
+    for (;;)
+    {
+        logger_async_record_t *record = &async->ring[position % LOG_ASYNC_RING_DEPTH];
+        int64_t diff = (int64_t)(record->sequence.load() - position);
+        if (diff == 0)
+        {
+            if (async->write_location.compare_exchange_weak(position, position + 1))
+            {
+                record->level = level;
+                record->file = file;
+                record->line = line;
+                record->thread_id = spdlog::details::os::thread_id();
+                record->time = std::chrono::system_clock::now();
+                strncpy(record->message, message, sizeof(record->message) - 1);
+                record->message[sizeof(record->message) - 1] = '\0';
+                record->sequence.store(position + 1);
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The record has not been written out since the last lap; the ring is full
+            async->dropped_count++;
+            return false;
+        }
+        else
+        {
+            position = async->write_location.load();
+        }
+    }
+
+    if (async->parked.load())
+    {
+        Lock(async->lock);
+        Condition_Post(async->condition);
+        Unlock(async->lock);
+    }
+    return true;
+}
+
+// Writes out the records that are ready, then reports any messages dropped since the last report
+static void logger_async_drain(logger_async_t *async)
+{
+    for (;;)
+    {
+        logger_async_record_t *record = &async->ring[async->read_location % LOG_ASYNC_RING_DEPTH];
+        if (record->sequence.load() != async->read_location + 1)
+        {
+            break;
+        }
+        logger_async_write(async->logger,
+                           record->level,
+                           record->time,
+                           record->thread_id,
+                           record->file,
+                           record->line,
+                           record->message);
+        record->sequence.store(async->read_location + LOG_ASYNC_RING_DEPTH);
+        async->read_location++;
+    }
+
+    uint64_t dropped_count = async->dropped_count.load();
+    if (dropped_count != async->reported_dropped_count)
+    {
+        char message[128];
+        snprintf(message,
+                 sizeof(message),
+                 "Dropped %llu log messages because the asynchronous log ring was full",
+                 (unsigned long long)(dropped_count - async->reported_dropped_count));
+        logger_async_write(async->logger,
+                           K4A_LOG_LEVEL_WARNING,
+                           std::chrono::system_clock::now(),
+                           spdlog::details::os::thread_id(),
+                           __FILE__,
+                           __LINE__,
+                           message);
+        async->reported_dropped_count = dropped_count;
+    }
+}
+
+static int logger_async_thread(void *param)
+{
+    logger_async_t *async = (logger_async_t *)param;
+
+    for (;;)
+    {
+        logger_async_drain(async);
+        if (async->stopping.load())
+        {
+            break;
+        }
+
+        // Park until a writer posts. Writers check parked after publishing a record, and this thread checks the ring
+        // again after setting parked, so one of the two always sees the other.
+        logger_async_record_t *record = &async->ring[async->read_location % LOG_ASYNC_RING_DEPTH];
+        Lock(async->lock);
+        async->parked = true;
+        if (record->sequence.load() != async->read_location + 1 && !async->stopping.load())
+        {
+            (void)Condition_Wait(async->condition, async->lock, 0);
+        }
+        async->parked = false;
+        Unlock(async->lock);
+    }
+    return 0;
+}
+
+static k4a_result_t logger_async_start(const std::shared_ptr<spdlog::logger> &logger)
+{
+    logger_async_t *async = &g_async_logger;
+
+    for (uint32_t i = 0; i < LOG_ASYNC_RING_DEPTH; i++)
+    {
+        async->ring[i].sequence = i;
+    }
+    async->write_location = 0;
+    async->read_location = 0;
+    async->reported_dropped_count = 0;
+    async->producers = 0;
+    async->stopping = false;
+    async->parked = false;
+    async->dropped_count = 0;
+    async->logger = logger;
+
+    async->lock = Lock_Init();
+    async->condition = Condition_Init();
+    if (async->lock == NULL || async->condition == NULL ||
+        ThreadAPI_Create(&async->thread, logger_async_thread, async) != THREADAPI_OK)
+    {
+        if (async->condition)
+        {
+            Condition_Deinit(async->condition);
+            async->condition = NULL;
+        }
+        if (async->lock)
+        {
+            Lock_Deinit(async->lock);
+            async->lock = NULL;
+        }
+        async->logger = nullptr;
+        return K4A_RESULT_FAILED;
+    }
+
+    async->running = true;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Writes out the records already in the ring and stops the background thread
+static void logger_async_stop(void)
+{
+    logger_async_t *async = &g_async_logger;
+    if (!async->running)
+    {
+        return;
+    }
+
+    // New messages fall back to the synchronous path while the ring drains. Threads that saw running before it was
+    // cleared may still be pushing and posting the condition, so wait for them before tearing anything down.
+    async->running = false;
+    while (async->producers.load() != 0)
+    {
+        ThreadAPI_Sleep(1);
+    }
+
+    async->stopping = true;
+    Lock(async->lock);
+    Condition_Post(async->condition);
+    Unlock(async->lock);
+
+    int thread_result;
+    (void)ThreadAPI_Join(async->thread, &thread_result);
+    async->thread = NULL;
+
+    // The thread may have seen stopping before the last records were published
+    logger_async_drain(async);
+
+    Condition_Deinit(async->condition);
+    async->condition = NULL;
+    Lock_Deinit(async->lock);
+    async->lock = NULL;
+    async->logger = nullptr;
+
+    // spdlog formats messages itself again, undo the "%v" pattern set for the ring
+    spdlog::set_pattern(K4A_LOG_PATTERN);
+}
+
+uint64_t logger_get_async_dropped_count(void)
+{
+    return g_async_logger.dropped_count.load();
+}
+
 k4a_result_t logger_register_message_callback(k4a_logging_message_cb_t *message_cb,
                                               void *message_cb_context,
                                               k4a_log_level_t min_level)
@@ -134,6 +446,7 @@ k4a_result_t logger_create(logger_config_t *config, logger_t *logger_handle)
     const char *enable_file_logging = nullptr;
     const char *enable_stdout_logging = nullptr;
     const char *logging_level = nullptr;
+    const char *enable_async_logging = nullptr;
 
     // environment_get_variable will return null or "\0" if the env var is not set - depends on the OS.
     if (config->env_var_log_to_a_file)
@@ -148,6 +461,10 @@ k4a_result_t logger_create(logger_config_t *config, logger_t *logger_handle)
     {
         logging_level = environment_get_variable(config->env_var_log_level);
     }
+    if (config->env_var_log_async)
+    {
+        enable_async_logging = environment_get_variable(config->env_var_log_async);
+    }
 
 #if defined(REFCOUNT_USE_STD_ATOMIC)
     // Validate implementation of INC_REF_VAR. Documentation for the implementation in this mode indicates the API
@@ -230,9 +547,7 @@ k4a_result_t logger_create(logger_config_t *config, logger_t *logger_handle)
         context->logger = g_env_logger;
         g_env_log_level = K4A_LOG_LEVEL_ERROR;
 
-        //[2018-08-27 10:44:23.218] [level] [threadID] <message>
-        // https://github.com/gabime/spdlog/wiki/3.-Custom-formatting
-        spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [t=%t] %v");
+        spdlog::set_pattern(K4A_LOG_PATTERN);
 
         // Set the default logging level SPD will allow. g_env_log_level will furthar refine this.
         spdlog::set_level(spdlog::level::trace);
@@ -268,6 +583,17 @@ k4a_result_t logger_create(logger_config_t *config, logger_t *logger_handle)
         }
 
         g_env_logger->flush_on(spdlog::level::warn);
+
+        if (enable_async_logging && enable_async_logging[0] != '\0' && enable_async_logging[0] != '0')
+        {
+            // The background thread writes the time, level and thread of the original call itself
+            spdlog::set_pattern("%v");
+            if (K4A_FAILED(logger_async_start(g_env_logger)))
+            {
+                spdlog::set_pattern(K4A_LOG_PATTERN);
+                g_env_logger->warn("Failed to start asynchronous logging, logging synchronously");
+            }
+        }
     }
     return K4A_RESULT_SUCCEEDED;
 }
@@ -281,8 +607,11 @@ void logger_destroy(logger_t logger_handle)
     // Destroy the logger
     if (DEC_REF_VAR(g_env_logger_count) == 0)
     {
+        logger_async_stop();
+
+        // Threads still in logger_log may be copying the pointer on the synchronous path
         bool drop_logger = g_env_logger != NULL;
-        g_env_logger = NULL;
+        std::atomic_store(&g_env_logger, std::shared_ptr<spdlog::logger>());
         if (drop_logger)
         {
             spdlog::drop(K4A_LOGGER);
@@ -335,10 +664,24 @@ void logger_log(k4a_log_level_t level, const char * file, const int line, const
             }
             DEC_REF_VAR(g_user_logger_cb_info_ref);
         }
+        bool pushed = false;
         if ((level <= g_env_log_level) && (g_env_log_level != K4A_LOG_LEVEL_OFF))
+        {
+            // must ++ before checking running, or logger_async_stop can tear down the ring's lock and condition while
+            // this thread is still pushing.
+            g_async_logger.producers++;
+            if (g_async_logger.running)
+            {
+                (void)logger_async_push(level, file, line, buffer);
+                pushed = true;
+            }
+            g_async_logger.producers--;
+        }
+
+        if (!pushed && (level <= g_env_log_level) && (g_env_log_level != K4A_LOG_LEVEL_OFF))
         {
             // Keep a copy of the logger around while we add this entry
-            std::shared_ptr<spdlog::logger> logger = g_env_logger;
+            std::shared_ptr<spdlog::logger> logger = std::atomic_load(&g_env_logger);
             if (logger)
             {
                 switch (level)
@@ -6,9 +6,11 @@
 
 // Dependent libraries
 #include <k4ainternal/allocator.h>
+#include <k4ainternal/atomic.h>
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/condition.h>
 #include <azure_c_shared_utility/threadapi.h>
+#include <azure_c_shared_utility/refcount.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -17,34 +19,29 @@
 
 typedef struct _queue_entry_t
 {
+    volatile uint64_t sequence; // ring position this entry is ready for, see queue_try_push()
     k4a_capture_t capture;
 } queue_entry_t;
 
 typedef struct _queue_context_t
 {
-    bool enabled;
-    bool error;
-    uint32_t queue_pop_blocked; // number of waiting threads for queue_pop so complete
-    uint32_t read_location;     // current location to read frokm
-    uint32_t write_location;    // current location to write to
-    queue_entry_t *queue;       // the queue array
-    uint32_t depth;             // 1 element larger than the max elements the queue can hold.
-    const char *name;           // Queue name in logger
-    uint32_t dropped_count;     // Count of the dropped captures
-
-    LOCK_HANDLE lock;
-    COND_HANDLE condition;
+    volatile long enabled;
+    volatile long error;
+    volatile long active_count;  // number of threads inside queue_pop or queue_push, queue_disable waits for them
+    volatile long waiting_count; // number of threads parked on the condition in queue_pop
+    volatile uint64_t read_location;  // next position to read from
+    volatile uint64_t write_location; // next position to write to
+    queue_entry_t *queue;             // the queue array
+    uint32_t depth;                   // max elements the queue can hold
+    const char *name;                 // Queue name in logger
+    volatile long dropped_count;      // Count of the dropped captures
+
+    LOCK_HANDLE lock;      // only taken to park and wake consumers
+    COND_HANDLE condition; // signaled on push when a consumer is parked
 } queue_context_t;
 
 K4A_DECLARE_CONTEXT(queue_t, queue_context_t);
 
-// This queue is empty if read and write pointers index the same location. The queue is full when the write pointer is
-// one away from pointing at the read location. This means that while we allocate a size of N, we can only hold N-1
-// elements. This allows us to maintain state through the read and write pointers only.
-#define inc_read_write_location(queue, location) (((location) + 1) % (queue)->depth)
-#define is_queue_empty(queue) ((queue)->write_location == (queue)->read_location)
-#define is_queue_full(queue) (inc_read_write_location((queue), (queue)->write_location) == (queue)->read_location)
-
 k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle)
 {
     k4a_result_t result;
@@ -52,7 +49,7 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
 
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth == 0);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth > 10000); // Sanity Check
-    queue->depth = queue_depth + 1;                              // Adding one; see comment on inc_read_write_location()
+    queue->depth = queue_depth;
     queue->name = queue_name;
     if (queue->name == NULL)
     {
@@ -64,6 +61,12 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
 
     if (K4A_SUCCEEDED(result))
     {
+        for (uint32_t i = 0; i < queue->depth; i++)
+        {
+            queue->queue[i].sequence = i;
+            queue->queue[i].capture = NULL;
+        }
+
         queue->lock = Lock_Init();
         result = K4A_RESULT_FROM_BOOL(queue->lock != NULL);
     }
@@ -83,17 +86,66 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
     return result;
 }
 
-static k4a_capture_t queue_pop_internal_locked(queue_context_t *queue)
+// The queue is a bounded ring that any number of threads may push to and pop from without a lock. Positions increase
+// monotonically and map to entry (position % depth); 64 bits do not wrap in the life of a process. Each entry holds
+// the position it is ready for: a writer of position P waits for sequence P, publishes the capture and sets P + 1; a
+// reader of position P waits for sequence P + 1, takes the capture and sets P + depth, handing the entry to the writer
+// one lap later. Claiming a position is a single compare and exchange on the read or write location.
+static bool queue_try_push(queue_context_t *queue, k4a_capture_t capture)
 {
-    if (is_queue_empty(queue) == false)
+    uint64_t position = k4a_atomic_load_64(&queue->write_location);
+    for (;;)
     {
-        queue_entry_t *entry = &queue->queue[queue->read_location];
-
-        queue->read_location = inc_read_write_location(queue, queue->read_location);
+        queue_entry_t *entry = &queue->queue[position % queue->depth];
+        int64_t diff = (int64_t)(k4a_atomic_load_64(&entry->sequence) - position);
+        if (diff == 0)
+        {
+            if (k4a_atomic_compare_exchange_64(&queue->write_location, &position, position + 1))
+            {
+                entry->capture = capture;
+                k4a_atomic_store_64(&entry->sequence, position + 1);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The entry has not been read since the last lap; the queue is full
+            return false;
+        }
+        else
+        {
+            position = k4a_atomic_load_64(&queue->write_location);
+        }
+    }
+}
 
-        return entry->capture;
+static k4a_capture_t queue_try_pop(queue_context_t *queue)
+{
+    uint64_t position = k4a_atomic_load_64(&queue->read_location);
+    for (;;)
+    {
+        queue_entry_t *entry = &queue->queue[position % queue->depth];
+        int64_t diff = (int64_t)(k4a_atomic_load_64(&entry->sequence) - (position + 1));
+        if (diff == 0)
+        {
+            if (k4a_atomic_compare_exchange_64(&queue->read_location, &position, position + 1))
+            {
+                k4a_capture_t capture = entry->capture;
+                entry->capture = NULL;
+                k4a_atomic_store_64(&entry->sequence, position + queue->depth);
+                return capture;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The entry has not been written yet; the queue is empty
+            return NULL;
+        }
+        else
+        {
+            position = k4a_atomic_load_64(&queue->read_location);
+        }
     }
-    return NULL;
 }
 
 k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_capture_t *out_capture)
@@ -105,9 +157,9 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
     k4a_capture_t capture = NULL;
     k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
 
-    Lock(queue->lock);
+    INC_REF_VAR(queue->active_count);
 
-    if (queue->enabled != true)
+    if (k4a_atomic_load_long(&queue->enabled) == 0)
     {
         LOG_ERROR("%s: capture popped from disabled queue", queue->name);
         wresult = K4A_WAIT_RESULT_FAILED;
@@ -116,9 +168,8 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
     if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
     {
         wresult = K4A_WAIT_RESULT_TIMEOUT;
-        queue->queue_pop_blocked++;
 
-        capture = queue_pop_internal_locked(queue);
+        capture = queue_try_pop(queue);
         if (capture != NULL)
         {
             wresult = K4A_WAIT_RESULT_SUCCEEDED;
@@ -127,34 +178,45 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
         {
             // Anything less than 0 is a wait forever condition in the lower level calls.
             // K4A_WAIT_INFINITE (-1) is defined for the user for this purpose
-            if (wait_in_ms < 0)
+            bool infinite = wait_in_ms < 0;
+            COND_RESULT cond_result = COND_OK;
+
+            // Park on the condition. waiting_count is raised before checking the queue again, and producers push
+            // before checking waiting_count, so either we see the capture or the producer sees us and posts. The post
+            // is made holding the lock, which we only release by waiting.
+            Lock(queue->lock);
+            INC_REF_VAR(queue->waiting_count);
+
+            capture = queue_try_pop(queue);
+            while (capture == NULL && k4a_atomic_load_long(&queue->enabled) != 0)
             {
-                wait_in_ms = 0; // infinite to Condition_wait
+                cond_result = Condition_Wait(queue->condition, queue->lock, infinite ? 0 : wait_in_ms);
+                capture = queue_try_pop(queue);
+                if (cond_result != COND_OK || !infinite)
+                {
+                    // Another consumer may have taken the capture we were woken for. A timed wait does not restart
+                    // its timeout, so it only waits once.
+                    break;
+                }
             }
 
-            // NOTE: The event used by Condition_Wait only gets set when a thread is actively
-            // waiting. There is a bit of a race condition between Condition_Post, Condition_Wait
-            // and how waiting_thread_count is used. So the queue may have data in it with no event set.
-            COND_RESULT cond_result = Condition_Wait(queue->condition, queue->lock, wait_in_ms);
-            if (cond_result == COND_OK)
+            DEC_REF_VAR(queue->waiting_count);
+            Unlock(queue->lock);
+
+            if (capture != NULL)
             {
-                capture = queue_pop_internal_locked(queue);
                 wresult = K4A_WAIT_RESULT_SUCCEEDED;
-
-                // Condition_Wait should only return COND_OK if there is data or if we are shutting down.
-                assert(capture != NULL || queue->enabled == false);
             }
-            else if (cond_result != COND_TIMEOUT)
+            else if (cond_result != COND_OK && cond_result != COND_TIMEOUT)
             {
                 K4A_RESULT_FROM_BOOL(cond_result != COND_ERROR);
                 assert(cond_result == COND_TIMEOUT || cond_result == COND_OK);
                 wresult = K4A_WAIT_RESULT_FAILED;
             }
         }
-        queue->queue_pop_blocked--;
     }
 
-    if (queue->enabled == false)
+    if (k4a_atomic_load_long(&queue->enabled) == 0)
     {
         wresult = K4A_WAIT_RESULT_FAILED;
         if (capture)
@@ -165,13 +227,13 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
         }
     }
 
-    if (queue->dropped_count != 0)
+    long dropped_count = k4a_atomic_exchange_long(&queue->dropped_count, 0);
+    if (dropped_count != 0)
     {
-        LOG_WARNING("%s: Dropped oldest %d captures from queue", queue->name, queue->dropped_count);
-        queue->dropped_count = 0;
+        LOG_WARNING("%s: Dropped oldest %ld captures from queue", queue->name, dropped_count);
     }
 
-    Unlock(queue->lock);
+    DEC_REF_VAR(queue->active_count);
 
     // We are transfering the ref we had to the caller.
     // capture_dec_ref(capture);
@@ -180,14 +242,6 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
     return wresult;
 }
 
-static void queue_push_internal_locked(queue_context_t *queue, k4a_capture_t capture)
-{
-    queue_entry_t *entry = &queue->queue[queue->write_location];
-    entry->capture = capture;
-
-    queue->write_location = inc_read_write_location(queue, queue->write_location);
-}
-
 void queue_push_w_dropped(queue_t queue_handle, k4a_capture_t capture, k4a_capture_t *dropped)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_t, queue_handle);
@@ -195,36 +249,50 @@ void queue_push_w_dropped(queue_t queue_handle, k4a_capture_t capture, k4a_captu
 
     queue_context_t *queue = queue_t_get_context(queue_handle);
 
-    Lock(queue->lock);
+    INC_REF_VAR(queue->active_count);
 
-    if (queue->enabled == false)
+    if (k4a_atomic_load_long(&queue->enabled) == 0)
     {
         LOG_WARNING("Capture pushed into disabled queue", queue->name);
     }
     else
     {
-        if (is_queue_full(queue))
+        // We are accepting this into our queue, so add a ref to prevent it
+        // from being freed
+        capture_inc_ref(capture);
+
+        bool dropped_returned = false;
+        while (!queue_try_push(queue, capture))
         {
-            if (dropped == NULL)
+            // Full, drop the oldest capture. Only one can be handed back to the caller; should other producers keep
+            // the queue full, further drops are counted like drops without a caller.
+            k4a_capture_t oldest = queue_try_pop(queue);
+            if (oldest == NULL)
             {
-                queue->dropped_count++;
-                capture_dec_ref(queue_pop_internal_locked(queue));
+                // A consumer is taking the oldest capture, its entry frees up momentarily
+                ThreadAPI_Sleep(0);
+            }
+            else if (dropped != NULL && !dropped_returned)
+            {
+                *dropped = oldest;
+                dropped_returned = true;
             }
             else
             {
-                *dropped = queue_pop_internal_locked(queue);
+                INC_REF_VAR(queue->dropped_count);
+                capture_dec_ref(oldest);
             }
         }
 
-        // We are accepting this into our queue, so add a ref to prevent it
-        // from being freed
-        capture_inc_ref(capture);
-
-        queue_push_internal_locked(queue, capture);
-
-        Condition_Post(queue->condition);
+        if (k4a_atomic_load_long(&queue->waiting_count) != 0)
+        {
+            Lock(queue->lock);
+            Condition_Post(queue->condition);
+            Unlock(queue->lock);
+        }
     }
-    Unlock(queue->lock);
+
+    DEC_REF_VAR(queue->active_count);
 }
 
 void queue_push(queue_t queue_handle, k4a_capture_t capture)
@@ -258,10 +326,8 @@ void queue_enable(queue_t queue_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_t, queue_handle);
     queue_context_t *queue = queue_t_get_context(queue_handle);
-    Lock(queue->lock);
-    queue->enabled = true;
-    queue->error = false;
-    Unlock(queue->lock);
+    k4a_atomic_store_long(&queue->error, 0);
+    k4a_atomic_store_long(&queue->enabled, 1);
 }
 
 void queue_disable(queue_t queue_handle)
@@ -269,33 +335,37 @@ void queue_disable(queue_t queue_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_t, queue_handle);
     queue_context_t *queue = queue_t_get_context(queue_handle);
 
-    Lock(queue->lock);
+    k4a_atomic_store_long(&queue->enabled, 0);
 
-    queue->enabled = false;
-
-    while (queue->queue_pop_blocked != 0)
+    // Threads that entered before the queue was disabled may still push; wait for them before purging
+    while (k4a_atomic_load_long(&queue->active_count) != 0)
     {
-        LOG_WARNING("Waiting for blocking call to complete", 0);
-        Condition_Post(queue->condition);
-        Unlock(queue->lock);
-        ThreadAPI_Sleep(25);
-        Lock(queue->lock);
+        if (k4a_atomic_load_long(&queue->waiting_count) != 0)
+        {
+            LOG_WARNING("Waiting for blocking call to complete", 0);
+            Lock(queue->lock);
+            Condition_Post(queue->condition);
+            Unlock(queue->lock);
+            ThreadAPI_Sleep(25);
+        }
+        else
+        {
+            ThreadAPI_Sleep(0);
+        }
     }
 
-    while (is_queue_empty(queue) == false)
+    k4a_capture_t capture;
+    while (queue->queue != NULL && (capture = queue_try_pop(queue)) != NULL)
     {
-        capture_dec_ref(queue_pop_internal_locked(queue));
+        capture_dec_ref(capture);
     }
-    Unlock(queue->lock);
 }
 
 void queue_error(queue_t queue_handle)
 {
     queue_context_t *queue = queue_t_get_context(queue_handle);
 
-    Lock(queue->lock);
-    queue->error = true;
-    Unlock(queue->lock);
+    k4a_atomic_store_long(&queue->error, 1);
 
     LOG_WARNING("Error detected, shutting down queue and notifying consumers", 0);
     queue_disable(queue_handle);
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "k4ainternal/matroska_common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BYTE_SWAP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BYTE_SWAP_NEON
+#endif
+
+namespace k4arecord
+{
+// SSE2 and NEON are part of the baseline of every 64 bit target we build for, so no runtime dispatch is needed. Both
+// kernels use unaligned loads because block data read from a file has no alignment guarantee.
+void swap_bytes_16_copy(void *dst, const void *src, size_t sample_count)
+{
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    size_t i = 0;
+
+#if defined(BYTE_SWAP_SSE2)
+    for (; i + 16 <= sample_count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 2));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 2 + 16));
+        a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+        b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2 + 16), b);
+    }
+#elif defined(BYTE_SWAP_NEON)
+    for (; i + 16 <= sample_count; i += 16)
+    {
+        uint8x16_t a = vld1q_u8(in + i * 2);
+        uint8x16_t b = vld1q_u8(in + i * 2 + 16);
+        vst1q_u8(out + i * 2, vrev16q_u8(a));
+        vst1q_u8(out + i * 2 + 16, vrev16q_u8(b));
+    }
+#endif
+
+    for (; i < sample_count; i++)
+    {
+        uint8_t low = in[i * 2];
+        out[i * 2] = in[i * 2 + 1];
+        out[i * 2 + 1] = low;
+    }
+}
+
+} // namespace k4arecord
@@ -2,6 +2,17 @@
 // Licensed under the MIT License.
 
 #include "k4ainternal/matroska_common.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace k4arecord;
 
@@ -105,3 +116,194 @@ void LargeFileIOCallback::setOwnerThread()
 {
     m_owner = std::this_thread::get_id();
 }
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char *path)
+{
+    assert(path);
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || (uint64_t)file_size.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void *data = mapping == NULL ? NULL : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        if (mapping != NULL)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_size = (size_t)file_size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0 || (uint64_t)file_stat.st_size > SIZE_MAX)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void *data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_size = (size_t)file_stat.st_size;
+#endif
+
+    m_data = static_cast<const uint8_t *>(data);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data == NULL)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_mapping = NULL;
+    m_file = NULL;
+#else
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+
+    m_data = NULL;
+    m_size = 0;
+}
+
+void MappedFile::advise_will_need(uint64_t offset, uint64_t length) const
+{
+    if (m_data == NULL || offset >= m_size || length == 0)
+    {
+        return;
+    }
+    if (length > m_size - offset)
+    {
+        length = m_size - offset;
+    }
+
+#ifdef _WIN32
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN8
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t *>(m_data) + offset;
+    range.NumberOfBytes = (size_t)length;
+    (void)PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    // madvise() needs a page aligned address.
+    uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t aligned_offset = offset - offset % page_size;
+    (void)madvise(const_cast<uint8_t *>(m_data) + aligned_offset,
+                  (size_t)(length + offset - aligned_offset),
+                  MADV_WILLNEED);
+#endif
+}
+
+bool k4arecord::replace_file(const char *source_path, const char *target_path)
+{
+    assert(source_path && target_path);
+#ifdef _WIN32
+    return MoveFileExA(source_path, target_path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(source_path, target_path) == 0;
+#endif
+}
+
+MappedFileIOCallback::MappedFileIOCallback(std::shared_ptr<MappedFile> mapping) : m_mapping(std::move(mapping))
+{
+    assert(m_mapping && m_mapping->data() != NULL);
+}
+
+uint32 MappedFileIOCallback::read(void *buffer, size_t size)
+{
+    assert(size <= UINT32_MAX); // can't properly return > uint32
+
+    if (m_position >= m_mapping->size())
+    {
+        return 0;
+    }
+    if (size > m_mapping->size() - m_position)
+    {
+        size = (size_t)(m_mapping->size() - m_position);
+    }
+    memcpy(buffer, m_mapping->data() + m_position, size);
+    m_position += size;
+    return (uint32)size;
+}
+
+void MappedFileIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+
+    int64_t base = 0;
+    switch (mode)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        base = (int64_t)m_position;
+        break;
+    case SEEK_END:
+        base = (int64_t)m_mapping->size();
+        break;
+    }
+    if (offset < -base)
+    {
+        throw std::ios_base::failure("Seek before the start of the file");
+    }
+    // Like a file stream, the position may be past the end of the file, where reads return no data.
+    m_position = (uint64_t)(base + offset);
+}
+
+size_t MappedFileIOCallback::write(const void *buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    throw std::ios_base::failure("Memory mapped files are read-only");
+}
+
+uint64 MappedFileIOCallback::getFilePointer()
+{
+    return m_position;
+}
+
+void MappedFileIOCallback::close()
+{
+    // The mapping is released when the last user drops its reference.
+}
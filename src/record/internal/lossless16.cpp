@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "k4ainternal/matroska_common.h"
+#include <k4ainternal/logging.h>
+#include <algorithm>
+
+// Lossless codec for 16 bit depth and IR frames (FOURCC KL16).
+//
+// A compressed frame starts with the number of 16 bit samples and the row length as 32 bit little-endian integers,
+// followed by one token stream covering all samples in row-major order. Each sample is predicted from its already
+// coded neighbours (left on the first row, above in the first column, and the LOCO-I median of left, above and
+// upper-left elsewhere). The difference to the prediction is zigzag encoded so that small positive and negative errors
+// both map to small values, and written as one of these tokens:
+//
+//   0xxxxxxx                   Error 0 to 127
+//   10nnnnnn                   Run of n + 2 samples with error 0
+//   110xxxxx xxxxxxxx          Error 128 to 8319, stored minus 128 with the high bits first
+//   11100000 <16 bit LE>       Any error
+//   11100001 <16 bit LE n>     Run of n + 66 samples with error 0
+//
+// Invalid depth pixels and smooth surfaces give long runs of zero errors, and noise on valid pixels mostly fits in one
+// byte. Frames whose size is not a multiple of the row length (for example a short final row) are supported.
+
+#define LOSSLESS16_HEADER_SIZE 8
+#define LOSSLESS16_SHORT_MAX 128
+#define LOSSLESS16_MEDIUM_MAX (LOSSLESS16_SHORT_MAX + 0x2000)
+#define LOSSLESS16_SHORT_RUN_MIN 2
+#define LOSSLESS16_LONG_RUN_MIN 66
+
+#define LOSSLESS16_TOKEN_RUN 0x80
+#define LOSSLESS16_TOKEN_MEDIUM 0xC0
+#define LOSSLESS16_TOKEN_LITERAL 0xE0
+#define LOSSLESS16_TOKEN_LONG_RUN 0xE1
+
+namespace k4arecord
+{
+static inline uint16_t lossless16_predict(const uint16_t *samples, size_t index, size_t column, size_t row_length)
+{
+    if (index < row_length)
+    {
+        return column == 0 ? 0 : samples[index - 1];
+    }
+    uint16_t above = samples[index - row_length];
+    if (column == 0)
+    {
+        return above;
+    }
+
+    uint16_t left = samples[index - 1];
+    uint16_t above_left = samples[index - row_length - 1];
+    uint16_t low = std::min(left, above);
+    uint16_t high = std::max(left, above);
+    if (above_left >= high)
+    {
+        return low;
+    }
+    if (above_left <= low)
+    {
+        return high;
+    }
+    return (uint16_t)(left + above - above_left);
+}
+
+static inline uint16_t lossless16_zigzag(uint16_t error)
+{
+    return (uint16_t)((uint16_t)(error << 1) ^ ((error & 0x8000) ? 0xFFFF : 0));
+}
+
+static inline uint16_t lossless16_unzigzag(uint16_t value)
+{
+    return (uint16_t)((value >> 1) ^ ((value & 1) ? 0xFFFF : 0));
+}
+
+static inline uint8_t *lossless16_write_uint32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
+
+static inline uint32_t lossless16_read_uint32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static inline uint8_t *lossless16_write_run(uint8_t *out, size_t run)
+{
+    while (run >= LOSSLESS16_LONG_RUN_MIN)
+    {
+        size_t count = std::min(run - LOSSLESS16_LONG_RUN_MIN, (size_t)UINT16_MAX);
+        *out++ = LOSSLESS16_TOKEN_LONG_RUN;
+        *out++ = (uint8_t)(count & 0xFF);
+        *out++ = (uint8_t)(count >> 8);
+        run -= count + LOSSLESS16_LONG_RUN_MIN;
+    }
+    if (run >= LOSSLESS16_SHORT_RUN_MIN)
+    {
+        *out++ = (uint8_t)(LOSSLESS16_TOKEN_RUN | (run - LOSSLESS16_SHORT_RUN_MIN));
+    }
+    else if (run == 1)
+    {
+        *out++ = 0;
+    }
+    return out;
+}
+
+size_t lossless16_max_compressed_size(size_t sample_count)
+{
+    // The worst case is a 3 byte literal for every sample.
+    return LOSSLESS16_HEADER_SIZE + sample_count * 3;
+}
+
+size_t lossless16_compress(const uint16_t *samples, size_t sample_count, uint32_t row_length, uint8_t *out)
+{
+    RETURN_VALUE_IF_ARG(0, samples == NULL && sample_count > 0);
+    RETURN_VALUE_IF_ARG(0, sample_count > UINT32_MAX);
+    RETURN_VALUE_IF_ARG(0, row_length == 0);
+    RETURN_VALUE_IF_ARG(0, out == NULL);
+
+    uint8_t *out_start = out;
+    out = lossless16_write_uint32(out, (uint32_t)sample_count);
+    out = lossless16_write_uint32(out, row_length);
+
+    size_t run = 0;
+    size_t column = 0;
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        uint16_t value = lossless16_zigzag((uint16_t)(samples[i] - lossless16_predict(samples, i, column, row_length)));
+        if (++column == row_length)
+        {
+            column = 0;
+        }
+
+        if (value == 0)
+        {
+            run++;
+            continue;
+        }
+        if (run > 0)
+        {
+            out = lossless16_write_run(out, run);
+            run = 0;
+        }
+
+        if (value < LOSSLESS16_SHORT_MAX)
+        {
+            *out++ = (uint8_t)value;
+        }
+        else if (value < LOSSLESS16_MEDIUM_MAX)
+        {
+            uint16_t medium = (uint16_t)(value - LOSSLESS16_SHORT_MAX);
+            *out++ = (uint8_t)(LOSSLESS16_TOKEN_MEDIUM | (medium >> 8));
+            *out++ = (uint8_t)(medium & 0xFF);
+        }
+        else
+        {
+            *out++ = LOSSLESS16_TOKEN_LITERAL;
+            *out++ = (uint8_t)(value & 0xFF);
+            *out++ = (uint8_t)(value >> 8);
+        }
+    }
+    out = lossless16_write_run(out, run);
+
+    return (size_t)(out - out_start);
+}
+
+size_t lossless16_sample_count(const uint8_t *data, size_t size)
+{
+    RETURN_VALUE_IF_ARG(0, data == NULL);
+    RETURN_VALUE_IF_ARG(0, size < LOSSLESS16_HEADER_SIZE);
+
+    return lossless16_read_uint32(data);
+}
+
+k4a_result_t lossless16_decompress(const uint8_t *data, size_t size, uint16_t *samples, size_t sample_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, samples == NULL && sample_count > 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, size < LOSSLESS16_HEADER_SIZE);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, lossless16_read_uint32(data) != sample_count);
+
+    size_t row_length = lossless16_read_uint32(data + 4);
+    if (row_length == 0)
+    {
+        LOG_ERROR("Compressed 16 bit frame is corrupt: the row length is 0", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    const uint8_t *in = data + LOSSLESS16_HEADER_SIZE;
+    const uint8_t *in_end = data + size;
+    size_t column = 0;
+    size_t i = 0;
+    while (i < sample_count && in < in_end)
+    {
+        uint8_t token = *in++;
+        size_t run = 0;
+        uint16_t value = 0;
+        if (token < LOSSLESS16_TOKEN_RUN)
+        {
+            value = token;
+        }
+        else if (token < LOSSLESS16_TOKEN_MEDIUM)
+        {
+            run = (size_t)(token & 0x3F) + LOSSLESS16_SHORT_RUN_MIN;
+        }
+        else if (token < LOSSLESS16_TOKEN_LITERAL)
+        {
+            if (in == in_end)
+            {
+                break;
+            }
+            value = (uint16_t)((((token & 0x1F) << 8) | *in++) + LOSSLESS16_SHORT_MAX);
+        }
+        else if (token == LOSSLESS16_TOKEN_LITERAL || token == LOSSLESS16_TOKEN_LONG_RUN)
+        {
+            if (in_end - in < 2)
+            {
+                break;
+            }
+            uint16_t operand = (uint16_t)(in[0] | (in[1] << 8));
+            in += 2;
+            if (token == LOSSLESS16_TOKEN_LITERAL)
+            {
+                value = operand;
+            }
+            else
+            {
+                run = (size_t)operand + LOSSLESS16_LONG_RUN_MIN;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        if (run == 0)
+        {
+            samples[i] = (uint16_t)(lossless16_predict(samples, i, column, row_length) + lossless16_unzigzag(value));
+            i++;
+            if (++column == row_length)
+            {
+                column = 0;
+            }
+            continue;
+        }
+
+        if (run > sample_count - i)
+        {
+            break;
+        }
+        for (size_t end = i + run; i < end; i++)
+        {
+            samples[i] = lossless16_predict(samples, i, column, row_length);
+            if (++column == row_length)
+            {
+                column = 0;
+            }
+        }
+    }
+
+    if (i != sample_count || in != in_end)
+    {
+        LOG_ERROR("Compressed 16 bit frame is corrupt: decoded %llu of %llu samples",
+                  (unsigned long long)i,
+                  (unsigned long long)sample_count);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+} // namespace k4arecord
@@ -5,6 +5,9 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
 #include <k4a/k4a.h>
@@ -49,7 +52,7 @@ std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlEle
     {
         LOG_ERROR("Failed to get next child (parent id %x) in recording '%s': %s",
                   EbmlId(*parent).GetValue(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return nullptr;
     }
@@ -69,7 +72,7 @@ k4a_result_t skip_element(k4a_playback_context_t *context, EbmlElement *element)
     {
         LOG_ERROR("Failed seek past element (id %x) in recording '%s': %s",
                   EbmlId(*element).GetValue(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return K4A_RESULT_FAILED;
     }
@@ -228,6 +231,16 @@ k4a_result_t parse_mkv(k4a_playback_context_t *context)
     RETURN_IF_ERROR(parse_recording_config(context));
     RETURN_IF_ERROR(populate_cluster_cache(context));
 
+    if (!context->seek_index_path.empty() && !context->seek_index_loaded)
+    {
+        // Index the whole recording once and save it, so that the next open doesn't need to scan the file. Playback
+        // still works from a partial index if this fails.
+        if (K4A_SUCCEEDED(TRACE_CALL(index_all_clusters(context))))
+        {
+            (void)TRACE_CALL(write_seek_index(context));
+        }
+    }
+
     // Find the last timestamp in the file
     context->last_timestamp_ns = 0;
     cluster_info_t *cluster_info = find_cluster(context, UINT64_MAX);
@@ -302,11 +315,34 @@ static void cluster_cache_deleter(cluster_info_t *cluster_cache)
     }
 }
 
+// Adds a new cluster_cache entry to the index, by its file offset.
+// The caller should currently own the lock for the cluster cache.
+static void add_cluster_index(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    auto position = std::upper_bound(context->cluster_index.begin(),
+                                     context->cluster_index.end(),
+                                     cluster_info->file_offset,
+                                     [](uint64_t file_offset, const cluster_info_t *entry) {
+                                         return file_offset < entry->file_offset;
+                                     });
+    context->cluster_index.insert(position, cluster_info);
+}
+
 k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache != nullptr);
 
+    if (!context->seek_index_path.empty())
+    {
+        // A valid seek index lists every cluster, so neither the Cues nor the first cluster need to be read.
+        context->seek_index_loaded = K4A_SUCCEEDED(load_seek_index(context));
+        if (context->seek_index_loaded)
+        {
+            return K4A_RESULT_SUCCEEDED;
+        }
+    }
+
     // Read the first cluster to use as the cache root.
     if (K4A_FAILED(seek_offset(context, context->first_cluster_offset)))
     {
@@ -326,6 +362,8 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
 
         context->cluster_cache = cluster_cache_t(new cluster_info_t, cluster_cache_deleter);
         populate_cluster_info(context, first_cluster, context->cluster_cache.get());
+        context->cluster_index.clear();
+        context->cluster_index.push_back(context->cluster_cache.get());
 
         // Populate the rest of the cache with the Cue data stored in the file.
         cluster_info_t *cluster_cache_end = context->cluster_cache.get();
@@ -333,6 +371,7 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
         {
             uint64_t last_offset = context->first_cluster_offset;
             uint64_t last_timestamp_ns = context->cluster_cache->timestamp_ns;
+            context->cluster_index.reserve(context->cues->ListSize() + 1);
             KaxCuePoint *cue = NULL;
             for (EbmlElement *e : context->cues->GetElementList())
             {
@@ -360,6 +399,7 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
 
                             cluster_cache_end->next = cluster_info;
                             cluster_cache_end = cluster_info;
+                            context->cluster_index.push_back(cluster_info);
 
                             last_offset = file_offset;
                             last_timestamp_ns = timestamp_ns;
@@ -386,6 +426,275 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
     return K4A_RESULT_SUCCEEDED;
 }
 
+// The seek index is a sidecar file listing the offset, size and start timestamp of every cluster in a recording, so
+// that recordings without Cues, or with only the sparse Cues written every CUE_ENTRY_GAP_NS, can be opened and seeked
+// without scanning the file. All values are little-endian 64 bit integers after an 8 byte magic:
+//
+//   Header:    magic, recording file size, timecode scale, cluster count
+//   Per entry: segment relative cluster offset, cluster size, cluster start timestamp in ns
+//
+// The index is ignored and rebuilt when it doesn't match the recording.
+#define SEEK_INDEX_MAGIC "K4AIDX01"
+#define SEEK_INDEX_HEADER_SIZE 32
+#define SEEK_INDEX_ENTRY_SIZE 24
+
+static uint64_t read_uint64_le(const uint8_t *data)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        value = value << 8 | data[i];
+    }
+    return value;
+}
+
+static void write_uint64_le(std::vector<uint8_t> &out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+static k4a_result_t get_recording_size(k4a_playback_context_t *context, uint64_t *recording_size)
+{
+    try
+    {
+        context->ebml_file->setFilePointer(0, libebml::seek_end);
+        *recording_size = context->ebml_file->getFilePointer();
+        return K4A_RESULT_SUCCEEDED;
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to find the size of '%s': %s", context->file_path.c_str(), e.what());
+        return K4A_RESULT_FAILED;
+    }
+}
+
+// Checks that a cluster of the indexed size starts at the indexed offset.
+static bool verify_seek_index_entry(k4a_playback_context_t *context, const cluster_info_t *cluster_info)
+{
+    if (K4A_FAILED(seek_offset(context, cluster_info->file_offset)))
+    {
+        return false;
+    }
+    std::shared_ptr<KaxCluster> cluster = find_next<KaxCluster>(context);
+    return cluster != nullptr && cluster->HeadSize() + cluster->GetSize() == cluster_info->cluster_size;
+}
+
+// Fills the cluster cache from the seek index. The index file is memory mapped for the duration of the call.
+k4a_result_t load_seek_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->seek_index_path.empty());
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache != nullptr);
+
+    const char *index_path = context->seek_index_path.c_str();
+    MappedFile index_file;
+    if (!index_file.open(index_path))
+    {
+        LOG_INFO("Seek index '%s' not found, the recording will be indexed.", index_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    const uint8_t *data = index_file.data();
+    size_t size = index_file.size();
+    if (size < SEEK_INDEX_HEADER_SIZE || memcmp(data, SEEK_INDEX_MAGIC, 8) != 0 ||
+        read_uint64_le(data + 24) != (size - SEEK_INDEX_HEADER_SIZE) / SEEK_INDEX_ENTRY_SIZE ||
+        (size - SEEK_INDEX_HEADER_SIZE) % SEEK_INDEX_ENTRY_SIZE != 0 || size == SEEK_INDEX_HEADER_SIZE)
+    {
+        LOG_WARNING("Seek index '%s' is not valid, the recording will be indexed again.", index_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    uint64_t recording_size = 0;
+    RETURN_IF_ERROR(get_recording_size(context, &recording_size));
+    if (read_uint64_le(data + 8) != recording_size || read_uint64_le(data + 16) != context->timecode_scale)
+    {
+        LOG_WARNING("Seek index '%s' is out of date, the recording will be indexed again.", index_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    size_t cluster_count = (size - SEEK_INDEX_HEADER_SIZE) / SEEK_INDEX_ENTRY_SIZE;
+    try
+    {
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+        // Every entry is linked to the next, the last one is followed by the end of the file.
+        cluster_cache_t cluster_cache(nullptr, cluster_cache_deleter);
+        std::vector<cluster_info_t *> cluster_index;
+        cluster_index.reserve(cluster_count);
+        cluster_info_t *previous = NULL;
+        const uint8_t *entry = data + SEEK_INDEX_HEADER_SIZE;
+        for (size_t i = 0; i < cluster_count; i++, entry += SEEK_INDEX_ENTRY_SIZE)
+        {
+            uint64_t file_offset = read_uint64_le(entry);
+            uint64_t cluster_size = read_uint64_le(entry + 8);
+            uint64_t timestamp_ns = read_uint64_le(entry + 16);
+
+            // The last cluster of a truncated recording may extend past the end of the file.
+            bool valid = cluster_size > 0 && file_offset < recording_size && cluster_size < recording_size;
+            if (previous == NULL)
+            {
+                valid = valid && file_offset == context->first_cluster_offset;
+            }
+            else
+            {
+                valid = valid && file_offset >= previous->file_offset + previous->cluster_size &&
+                        timestamp_ns >= previous->timestamp_ns;
+            }
+            if (!valid)
+            {
+                LOG_WARNING("Seek index '%s' is corrupt at entry %llu, the recording will be indexed again.",
+                            index_path,
+                            (uint64_t)i);
+                return K4A_RESULT_FAILED;
+            }
+
+            cluster_info_t *cluster_info = new cluster_info_t;
+            cluster_info->file_offset = file_offset;
+            cluster_info->cluster_size = cluster_size;
+            cluster_info->timestamp_ns = timestamp_ns;
+            cluster_info->next_known = true;
+            cluster_info->previous = previous;
+            if (previous == NULL)
+            {
+                cluster_cache.reset(cluster_info);
+            }
+            else
+            {
+                previous->next = cluster_info;
+            }
+            cluster_index.push_back(cluster_info);
+            previous = cluster_info;
+        }
+
+        if (!verify_seek_index_entry(context, cluster_index.front()) ||
+            !verify_seek_index_entry(context, cluster_index.back()))
+        {
+            LOG_WARNING("Seek index '%s' does not match the recording, the recording will be indexed again.",
+                        index_path);
+            return K4A_RESULT_FAILED;
+        }
+
+        context->cluster_cache = std::move(cluster_cache);
+        context->cluster_index = std::move(cluster_index);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to load seek index: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    LOG_INFO("Loaded %llu clusters from seek index '%s'.", (uint64_t)cluster_count, index_path);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Reads the header of every cluster in the recording, so that the cluster cache has no gaps and every entry has its
+// real size and start timestamp.
+k4a_result_t index_all_clusters(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache == nullptr);
+
+    try
+    {
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+        cluster_info_t *cluster_info = context->cluster_cache.get();
+        while (cluster_info != NULL)
+        {
+            if (cluster_info->cluster_size == 0)
+            {
+                // Entries added from the Cues have not been read yet.
+                RETURN_IF_ERROR(seek_offset(context, cluster_info->file_offset));
+                std::shared_ptr<KaxCluster> cluster = find_next<KaxCluster>(context);
+                if (cluster == nullptr)
+                {
+                    LOG_ERROR("Failed to read cluster at offset %llu.", cluster_info->file_offset);
+                    return K4A_RESULT_FAILED;
+                }
+                populate_cluster_info(context, cluster, cluster_info);
+            }
+
+            cluster_info_t *next_cluster_info = next_cluster(context, cluster_info, true);
+            if (next_cluster_info == NULL && !cluster_info->next_known)
+            {
+                LOG_ERROR("Failed to read the cluster after offset %llu.", cluster_info->file_offset);
+                return K4A_RESULT_FAILED;
+            }
+            cluster_info = next_cluster_info;
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to index recording: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Writes the seek index for a cluster cache that has been filled by index_all_clusters().
+k4a_result_t write_seek_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->seek_index_path.empty());
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache == nullptr);
+
+    uint64_t recording_size = 0;
+    RETURN_IF_ERROR(get_recording_size(context, &recording_size));
+
+    const char *index_path = context->seek_index_path.c_str();
+    size_t cluster_count = 0;
+    try
+    {
+        std::vector<uint8_t> index_data;
+        {
+            std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+            cluster_count = context->cluster_index.size();
+            index_data.reserve(SEEK_INDEX_HEADER_SIZE + cluster_count * SEEK_INDEX_ENTRY_SIZE);
+            index_data.insert(index_data.end(), SEEK_INDEX_MAGIC, SEEK_INDEX_MAGIC + 8);
+            write_uint64_le(index_data, recording_size);
+            write_uint64_le(index_data, context->timecode_scale);
+            write_uint64_le(index_data, cluster_count);
+            for (const cluster_info_t *cluster_info : context->cluster_index)
+            {
+                if (cluster_info->cluster_size == 0 || !cluster_info->next_known)
+                {
+                    LOG_ERROR("The recording is not fully indexed, a seek index can't be written.", 0);
+                    return K4A_RESULT_FAILED;
+                }
+                write_uint64_le(index_data, cluster_info->file_offset);
+                write_uint64_le(index_data, cluster_info->cluster_size);
+                write_uint64_le(index_data, cluster_info->timestamp_ns);
+            }
+        }
+
+        // Write a temporary file next to the index and move it into place, so that another playback opening the
+        // recording at the same time never maps a partly written index.
+        std::string temp_path = context->seek_index_path + ".tmp";
+        std::ofstream index_file(temp_path, std::ios::binary | std::ios::trunc);
+        index_file.write(reinterpret_cast<const char *>(index_data.data()), (std::streamsize)index_data.size());
+        index_file.close();
+        if (!index_file || !replace_file(temp_path.c_str(), index_path))
+        {
+            LOG_WARNING("Failed to write seek index '%s'.", index_path);
+            std::remove(temp_path.c_str());
+            return K4A_RESULT_FAILED;
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to write seek index: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    LOG_INFO("Wrote %llu clusters to seek index '%s'.", (uint64_t)cluster_count, index_path);
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t parse_recording_config(k4a_playback_context_t *context)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
@@ -768,6 +1077,11 @@ k4a_result_t read_bitmap_info_header(track_reader_t *track)
             track->format = K4A_IMAGE_FORMAT_DEPTH16;
             track->stride = track->width * 2;
             break;
+        case 0x36314C4B: // KL16
+            track->format = K4A_IMAGE_FORMAT_DEPTH16;
+            track->stride = track->width * 2;
+            track->lossless16 = true;
+            break;
         default:
             LOG_ERROR("Unsupported FOURCC format for track '%s': %x",
                       GetChild<KaxTrackName>(*track->track).GetValueUTF8().c_str(),
@@ -796,6 +1110,7 @@ void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestam
     context->ir_track.current_block.reset();
     context->imu_track.current_block.reset();
     context->imu_sample_index = -1;
+    clear_color_decode_pipeline(context);
 }
 
 KaxTrackEntry *find_track(k4a_playback_context_t *context, const char *name, const char *tag_name)
@@ -974,7 +1289,7 @@ k4a_result_t seek_offset(k4a_playback_context_t *context, uint64_t offset)
         LOG_ERROR("Failed to seek file to %llu (relative %llu) '%s': %s",
                   file_offset,
                   offset,
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return K4A_RESULT_FAILED;
     }
@@ -1046,16 +1361,16 @@ cluster_info_t *find_cluster(k4a_playback_context_t *context, uint64_t timestamp
     {
         std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
 
-        // Find the closest cluster in the cache
-        cluster_info_t *cluster_info = context->cluster_cache.get();
-        while (cluster_info->next)
-        {
-            if (cluster_info->next->timestamp_ns > timestamp_ns)
-            {
-                break;
-            }
-            cluster_info = cluster_info->next;
-        }
+        // Find the last cached cluster starting at or before the timestamp, or the first cluster if there is none.
+        assert(!context->cluster_index.empty());
+        auto closest = std::upper_bound(context->cluster_index.begin(),
+                                        context->cluster_index.end(),
+                                        timestamp_ns,
+                                        [](uint64_t timestamp, const cluster_info_t *entry) {
+                                            return timestamp < entry->timestamp_ns;
+                                        });
+        cluster_info_t *cluster_info = closest == context->cluster_index.begin() ? context->cluster_index.front() :
+                                                                                   *(closest - 1);
 
         // Make sure there are no gaps in the cache and ensure this really is the closest cluster.
         cluster_info_t *next_cluster_info = next_cluster(context, cluster_info, true);
@@ -1141,8 +1456,8 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
                 std::shared_ptr<KaxCluster> next_cluster = find_next<KaxCluster>(context, true);
                 if (next_cluster)
                 {
-                    if (current_cluster->next && current_cluster->next->file_offset ==
-                                                     context->segment->GetRelativePosition(*next_cluster.get()))
+                    uint64_t next_offset = context->segment->GetRelativePosition(*next_cluster.get());
+                    if (current_cluster->next && current_cluster->next->file_offset == next_offset)
                     {
                         // If there is a non-cluster element between these entries, they may not get connected
                         // otherwise.
@@ -1153,6 +1468,7 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
                     {
                         // Add a new entry to the cache for the cluster we just found.
                         cluster_info_t *next_cluster_info = new cluster_info_t;
+                        next_cluster_info->file_offset = next_offset;
                         next_cluster_info->previous = current_cluster;
                         next_cluster_info->next = current_cluster->next;
                         current_cluster->next = next_cluster_info;
@@ -1161,6 +1477,7 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
                         {
                             next_cluster_info->next->previous = next_cluster_info;
                         }
+                        add_cluster_index(context, next_cluster_info);
                         current_cluster = next_cluster_info;
                     }
                     populate_cluster_info(context, next_cluster, current_cluster);
@@ -1207,9 +1524,11 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
     }
 }
 
-// Load a cluster from the cluster cache / disk without any neighbor preloading.
-// This should never fail unless there is a file IO error.
-std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+// Load a cluster from the cluster cache / disk without any neighbor preloading. Background is set when called by the
+// read-ahead thread. This should never fail unless there is a file IO error.
+static std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context,
+                                                         cluster_info_t *cluster_info,
+                                                         bool background)
 {
     RETURN_VALUE_IF_ARG(nullptr, context == NULL);
     RETURN_VALUE_IF_ARG(nullptr, context->ebml_file == nullptr);
@@ -1268,6 +1587,11 @@ std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *contex
                     cluster->InitTimecode(timecode, (int64_t)context->timecode_scale);
 
                     cluster_info->cluster = cluster;
+                    context->load_bytes += cluster->GetSize();
+                    if (background)
+                    {
+                        context->read_ahead_loads++;
+                    }
                 }
             }
         }
@@ -1280,160 +1604,506 @@ std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *contex
     }
 }
 
-// Load the actual block data for a cluster off the disk, and start preloading the neighboring clusters.
-// This should never fail unless there is a file IO error.
-std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context, cluster_info_t *cluster_info)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, cluster_info == NULL);
+    return load_cluster_internal(context, cluster_info, false);
+}
 
-    std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
-    if (cluster == nullptr)
+// Load the cluster the given number of steps before or after a known cluster.
+static std::shared_ptr<KaxCluster> load_cluster_at_distance(k4a_playback_context_t *context,
+                                                            cluster_info_t *cluster_info,
+                                                            size_t distance,
+                                                            bool next,
+                                                            bool background)
+{
+    for (size_t i = 0; i < distance && cluster_info != NULL; i++)
     {
-        return nullptr;
+        cluster_info = next_cluster(context, cluster_info, next);
     }
+    return cluster_info ? load_cluster_internal(context, cluster_info, background) : nullptr;
+}
 
-    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
-    result->cluster_info = cluster_info;
-    result->cluster = cluster;
-
-#if CLUSTER_READ_AHEAD_COUNT
-    try
+static void cluster_prefetch_thread(k4a_playback_context_t *context)
+{
+    cluster_prefetch_t &prefetch = context->prefetch;
+    std::unique_lock<std::mutex> lock(prefetch.lock);
+    while (true)
     {
-        // Preload the neighboring clusters immediately
-        cluster_info_t *previous_cluster_info = cluster_info;
-        cluster_info_t *next_cluster_info = cluster_info;
-        for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT; i++)
+        prefetch.condition.wait(lock, [&prefetch] { return prefetch.stopping || !prefetch.requests.empty(); });
+        if (prefetch.stopping)
         {
-            if (previous_cluster_info != NULL)
-            {
-                previous_cluster_info = next_cluster(context, previous_cluster_info, false);
-            }
-            if (next_cluster_info != NULL)
-            {
-                next_cluster_info = next_cluster(context, next_cluster_info, true);
-            }
-            result->previous_clusters[i] = std::async(std::launch::deferred, [context, previous_cluster_info] {
-                return previous_cluster_info ? load_cluster_internal(context, previous_cluster_info) : nullptr;
-            });
-            result->next_clusters[i] = std::async(std::launch::deferred, [context, next_cluster_info] {
-                return next_cluster_info ? load_cluster_internal(context, next_cluster_info) : nullptr;
-            });
-            result->previous_clusters[i].wait();
-            result->next_clusters[i].wait();
+            break;
+        }
+
+        cluster_prefetch_request_t request = std::move(prefetch.requests.front());
+        prefetch.requests.pop_front();
+        lock.unlock();
+
+        try
+        {
+            request.promise.set_value(
+                load_cluster_at_distance(context, request.cluster_info, request.distance, request.next, true));
+        }
+        catch (...)
+        {
+            // Rethrown to whoever waits for the cluster, the same as a cluster loaded on the playback thread.
+            request.promise.set_exception(std::current_exception());
         }
+
+        lock.lock();
     }
-    catch (std::system_error &e)
+
+    // Playback is closing, nobody waits for the remaining requests.
+    while (!prefetch.requests.empty())
     {
-        LOG_ERROR("Failed to load read-ahead clusters: %s", e.what());
-        return nullptr;
+        prefetch.requests.front().promise.set_value(nullptr);
+        prefetch.requests.pop_front();
     }
-#endif
-
-    return result;
 }
 
-// Load the next or previous cluster off the disk using the existing preloaded neighbors.
-// The next neighbor in sequence will start being preloaded asynchronously.
-std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
-                                                    loaded_cluster_t *current_cluster,
-                                                    bool next)
+// Stop the read-ahead thread. This must be called before the file is closed.
+void stop_cluster_prefetch(k4a_playback_context_t *context)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, current_cluster == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
 
-    cluster_info_t *cluster_info = next_cluster(context, current_cluster->cluster_info, next);
-    if (cluster_info == NULL)
     {
-        // End of file reached.
-        return nullptr;
+        std::lock_guard<std::mutex> lock(context->prefetch.lock);
+        context->prefetch.stopping = true;
     }
+    context->prefetch.condition.notify_all();
 
-    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
-    result->cluster_info = cluster_info;
+    if (context->prefetch.thread.joinable())
+    {
+        context->prefetch.thread.join();
+    }
+}
+
+// Switches between reading the recording through a file stream and through a memory mapping. Clusters that are already
+// loaded, and images that point into a previous mapping, stay valid.
+k4a_result_t set_file_mapping(k4a_playback_context_t *context, bool enabled)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
 
-#if CLUSTER_READ_AHEAD_COUNT
     try
     {
-        // Use the current cluster as one of the neightbors, and then wait for the target cluster to be available.
-        std::shared_ptr<KaxCluster> old_cluster = current_cluster->cluster;
-        if (next)
+        std::lock_guard<std::mutex> lock(context->io_lock);
+        if (enabled == (context->file_mapping != nullptr))
         {
-            result->previous_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+            return K4A_RESULT_SUCCEEDED;
+        }
+
+        std::shared_ptr<MappedFile> file_mapping;
+        std::unique_ptr<IOCallback> ebml_file;
+        if (enabled)
+        {
+            file_mapping = std::make_shared<MappedFile>();
+            if (!file_mapping->open(context->file_path.c_str()))
             {
-                result->previous_clusters[i] = current_cluster->previous_clusters[i - 1];
+                LOG_ERROR("Failed to memory map recording '%s'.", context->file_path.c_str());
+                return K4A_RESULT_FAILED;
             }
-
-            current_cluster->next_clusters[0].wait();
-            result->cluster = current_cluster->next_clusters[0].get();
+            ebml_file = make_unique<MappedFileIOCallback>(file_mapping);
         }
         else
         {
-            result->next_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
-            {
-                result->next_clusters[i] = current_cluster->next_clusters[i - 1];
-            }
-
-            current_cluster->previous_clusters[0].wait();
-            result->cluster = current_cluster->previous_clusters[0].get();
+            ebml_file = make_unique<LargeFileIOCallback>(context->file_path.c_str(), MODE_READ);
         }
 
-        // Spawn a new async task to preload the next cluster in sequence.
-        if (next)
+        // The stream only keeps a reference to the IO handler, everything parsed from the file stays valid.
+        std::unique_ptr<libebml::EbmlStream> stream = make_unique<libebml::EbmlStream>(*ebml_file);
+        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+        if (file_io != NULL)
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
-            {
-                result->next_clusters[i] = current_cluster->next_clusters[i + 1];
-            }
-            result->next_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
-                cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
-                {
-                    new_cluster = next_cluster(context, new_cluster, true);
-                }
-                return new_cluster ? load_cluster_internal(context, new_cluster) : nullptr;
-            });
+            file_io->setOwnerThread();
         }
-        else
+        try
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
-            {
-                result->previous_clusters[i] = current_cluster->previous_clusters[i + 1];
-            }
-            result->previous_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
-                cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
-                {
-                    new_cluster = next_cluster(context, new_cluster, false);
-                }
-                return new_cluster ? load_cluster_internal(context, new_cluster) : nullptr;
-            });
+            context->ebml_file->close();
+        }
+        catch (std::ios_base::failure &)
+        {
+            // The file was opened as read-only, ignore any close failures.
         }
+        context->stream = std::move(stream);
+        context->ebml_file = std::move(ebml_file);
+        context->file_mapping = std::move(file_mapping);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Unable to open file '%s': %s", context->file_path.c_str(), e.what());
+        return K4A_RESULT_FAILED;
     }
     catch (std::system_error &e)
     {
-        LOG_ERROR("Failed to load next cluster: %s", e.what());
-        return nullptr;
+        LOG_ERROR("Failed to change the recording IO: %s", e.what());
+        return K4A_RESULT_FAILED;
     }
-#else
-    result->cluster = load_cluster_internal(context, cluster_info);
-#endif
 
-    return result;
+    return K4A_RESULT_SUCCEEDED;
 }
 
-// Find the first block with a timestamp >= the specified timestamp. If a block group containing the specified timestamp
-// is found, it will be returned. If no blocks are found, a pointer to EOF will be returned, or nullptr if an error
-// occurs.
-std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context, track_reader_t *reader, uint64_t timestamp_ns)
+// Returns a future for the cluster the given number of steps away. If background is set the cluster is loaded by the
+// read-ahead thread, otherwise it is loaded by the first thread waiting for it.
+static future_cluster_t schedule_cluster(k4a_playback_context_t *context,
+                                         cluster_info_t *cluster_info,
+                                         size_t distance,
+                                         bool next,
+                                         bool background)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, reader == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, reader->track == NULL);
+    if (background)
+    {
+        cluster_prefetch_t &prefetch = context->prefetch;
+        std::lock_guard<std::mutex> lock(prefetch.lock);
+        if (!prefetch.stopping)
+        {
+            if (!prefetch.thread.joinable())
+            {
+                prefetch.thread = std::thread(cluster_prefetch_thread, context);
+            }
+
+            prefetch.requests.emplace_back();
+            cluster_prefetch_request_t &request = prefetch.requests.back();
+            request.cluster_info = cluster_info;
+            request.distance = distance;
+            request.next = next;
+            future_cluster_t future = request.promise.get_future().share();
+            prefetch.condition.notify_one();
+            return future;
+        }
+    }
+
+    return std::async(std::launch::deferred, [context, cluster_info, distance, next] {
+        return load_cluster_at_distance(context, cluster_info, distance, next, false);
+    });
+}
+
+static future_cluster_t make_ready_cluster(std::shared_ptr<KaxCluster> cluster)
+{
+    std::promise<std::shared_ptr<KaxCluster>> promise;
+    promise.set_value(cluster);
+    return promise.get_future().share();
+}
+
+// Returns how many of the read-ahead clusters to load in the background. The byte limit is applied using the average
+// size of the clusters loaded so far; at least one cluster is always loaded ahead.
+static size_t get_prefetch_count(k4a_playback_context_t *context)
+{
+    size_t count = context->read_ahead_count;
+    uint64_t load_count = context->load_count;
+    if (context->read_ahead_max_bytes != 0 && load_count != 0)
+    {
+        uint64_t average_size = context->load_bytes / load_count;
+        if (average_size != 0 && context->read_ahead_max_bytes / average_size < count)
+        {
+            count = std::max((size_t)(context->read_ahead_max_bytes / average_size), (size_t)1);
+        }
+    }
+    return count;
+}
+
+// When reading through a file mapping, asks the OS to page in the clusters that read-ahead will load next.
+// Only called by the playback thread, which is the only thread that changes the file mapping.
+static void advise_read_ahead(k4a_playback_context_t *context, cluster_info_t *cluster_info, bool next)
+{
+    if (context->file_mapping == nullptr)
+    {
+        return;
+    }
+
+    uint64_t start = 0;
+    uint64_t end = 0;
+    try
+    {
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+        start = cluster_info->file_offset;
+        end = cluster_info->file_offset + cluster_info->cluster_size;
+        cluster_info_t *edge = cluster_info;
+        for (size_t i = 0; i < context->read_ahead_count; i++)
+        {
+            cluster_info_t *neighbor = next ? edge->next : edge->previous;
+            if (neighbor == NULL)
+            {
+                break;
+            }
+            edge = neighbor;
+        }
+        // Entries that have not been read yet have no size, the range then ends at the start of the last cluster.
+        start = std::min(start, edge->file_offset);
+        end = std::max(end, edge->file_offset + edge->cluster_size);
+    }
+    catch (std::system_error &)
+    {
+        return;
+    }
+
+    context->file_mapping->advise_will_need(context->segment->GetGlobalPosition(start), end - start);
+}
+
+// Removes the least recently used clusters until the cluster LRU cache is within its byte budget.
+static void trim_cluster_lru(cluster_lru_t *lru)
+{
+    while (lru->size > lru->max_bytes && !lru->clusters.empty())
+    {
+        cached_cluster_t &oldest = lru->clusters.back();
+        lru->size -= oldest.size;
+        lru->lookup.erase(oldest.cluster_info);
+        lru->clusters.pop_back();
+        lru->evictions++;
+    }
+}
+
+void set_cluster_lru(k4a_playback_context_t *context, uint64_t max_bytes, bool color_images)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    cluster_lru_t *lru = &context->cluster_lru;
+    lru->lookup.clear();
+    lru->clusters.clear();
+    lru->size = 0;
+    lru->last_used = NULL;
+    lru->max_bytes = max_bytes;
+    lru->color_images = color_images;
+}
+
+// Marks the cluster playback moved to as the most recently used one, adding it to the cluster LRU cache if needed.
+static void use_cached_cluster(k4a_playback_context_t *context, loaded_cluster_t *loaded_cluster)
+{
+    cluster_lru_t *lru = &context->cluster_lru;
+
+    // Each track moves to the next cluster on its own, only count the first one in the stats.
+    bool count = loaded_cluster->cluster_info != lru->last_used;
+    lru->last_used = loaded_cluster->cluster_info;
+
+    auto itr = lru->lookup.find(loaded_cluster->cluster_info);
+    if (itr != lru->lookup.end())
+    {
+        lru->cluster_hits += count ? 1 : 0;
+        lru->clusters.splice(lru->clusters.begin(), lru->clusters, itr->second);
+        return;
+    }
+
+    lru->cluster_misses += count ? 1 : 0;
+    if (lru->max_bytes == 0 || loaded_cluster->cluster == nullptr)
+    {
+        return;
+    }
+
+    lru->clusters.emplace_front();
+    cached_cluster_t &entry = lru->clusters.front();
+    entry.cluster_info = loaded_cluster->cluster_info;
+    entry.cluster = loaded_cluster->cluster;
+    entry.size = loaded_cluster->cluster->GetSize();
+    lru->lookup[entry.cluster_info] = lru->clusters.begin();
+    lru->size += entry.size;
+    trim_cluster_lru(lru);
+}
+
+// Returns a new reference to the color image cached for block in the given format, or NULL if there is none.
+static k4a_image_t find_cached_color_image(k4a_playback_context_t *context,
+                                           block_info_t *block,
+                                           k4a_image_format_t format)
+{
+    cluster_lru_t *lru = &context->cluster_lru;
+    if (!lru->color_images || block->cluster == nullptr)
+    {
+        return NULL;
+    }
+
+    auto itr = lru->lookup.find(block->cluster->cluster_info);
+    if (itr == lru->lookup.end())
+    {
+        return NULL;
+    }
+    for (auto &color_image : itr->second->color_images)
+    {
+        if (color_image.first == block->block && k4a_image_get_format(color_image.second) == format)
+        {
+            lru->color_image_hits++;
+            k4a_image_reference(color_image.second);
+            return color_image.second;
+        }
+    }
+    return NULL;
+}
+
+// Keeps the color image returned for block while its cluster is in the cluster LRU cache.
+static void cache_color_image(k4a_playback_context_t *context, block_info_t *block, k4a_image_t image)
+{
+    cluster_lru_t *lru = &context->cluster_lru;
+    if (!lru->color_images || block->cluster == nullptr)
+    {
+        return;
+    }
+
+    auto itr = lru->lookup.find(block->cluster->cluster_info);
+    if (itr == lru->lookup.end())
+    {
+        return;
+    }
+
+    // Replace the image of a previous color conversion format, if any.
+    cached_cluster_t &entry = *itr->second;
+    auto color_image = std::find_if(entry.color_images.begin(),
+                                    entry.color_images.end(),
+                                    [block](const std::pair<KaxInternalBlock *, k4a_image_t> &cached) {
+                                        return cached.first == block->block;
+                                    });
+    if (color_image != entry.color_images.end())
+    {
+        uint64_t old_size = k4a_image_get_size(color_image->second);
+        entry.size -= old_size;
+        lru->size -= old_size;
+        k4a_image_release(color_image->second);
+        entry.color_images.erase(color_image);
+    }
+
+    k4a_image_reference(image);
+    entry.color_images.emplace_back(block->block, image);
+    entry.size += k4a_image_get_size(image);
+    lru->size += k4a_image_get_size(image);
+    trim_cluster_lru(lru);
+}
+
+// Load the actual block data for a cluster off the disk, and start preloading the neighboring clusters.
+// This should never fail unless there is a file IO error.
+std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, cluster_info == NULL);
+
+    std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
+    if (cluster == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
+    result->cluster_info = cluster_info;
+    result->cluster = cluster;
+    result->file_mapping = context->file_mapping;
+    advise_read_ahead(context, cluster_info, true);
+    use_cached_cluster(context, result.get());
+
+    try
+    {
+        // Start preloading the neighboring clusters in the background, nearest first
+        size_t prefetch_count = get_prefetch_count(context);
+        context->read_ahead_background_count = prefetch_count;
+        for (size_t i = 0; i < context->read_ahead_count; i++)
+        {
+            result->next_clusters.push_back(schedule_cluster(context, cluster_info, i + 1, true, i < prefetch_count));
+        }
+        for (size_t i = 0; i < context->read_ahead_count; i++)
+        {
+            result->previous_clusters.push_back(
+                schedule_cluster(context, cluster_info, i + 1, false, i < prefetch_count));
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to load read-ahead clusters: %s", e.what());
+        return nullptr;
+    }
+
+    return result;
+}
+
+// Load the next or previous cluster off the disk using the existing preloaded neighbors.
+// The next neighbor in sequence will start being preloaded in the background.
+std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
+                                                    loaded_cluster_t *current_cluster,
+                                                    bool next)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, current_cluster == NULL);
+
+    cluster_info_t *cluster_info = next_cluster(context, current_cluster->cluster_info, next);
+    if (cluster_info == NULL)
+    {
+        // End of file reached.
+        return nullptr;
+    }
+
+    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
+    result->cluster_info = cluster_info;
+    result->file_mapping = context->file_mapping;
+    advise_read_ahead(context, cluster_info, next);
+
+    std::vector<future_cluster_t> &ahead = next ? result->next_clusters : result->previous_clusters;
+    std::vector<future_cluster_t> &behind = next ? result->previous_clusters : result->next_clusters;
+    std::vector<future_cluster_t> &current_ahead = next ? current_cluster->next_clusters :
+                                                          current_cluster->previous_clusters;
+    std::vector<future_cluster_t> &current_behind = next ? current_cluster->previous_clusters :
+                                                           current_cluster->next_clusters;
+    size_t count = context->read_ahead_count;
+
+    try
+    {
+        // Use the current cluster as one of the neighbors, and then wait for the target cluster to be available.
+        if (count > 0)
+        {
+            behind.push_back(make_ready_cluster(current_cluster->cluster));
+            for (size_t i = 0; i + 1 < count && i < current_behind.size(); i++)
+            {
+                behind.push_back(current_behind[i]);
+            }
+        }
+
+        if (current_ahead.empty())
+        {
+            result->cluster = load_cluster_internal(context, cluster_info);
+        }
+        else
+        {
+            if (current_ahead[0].wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                context->read_ahead_hits++;
+            }
+            else
+            {
+                context->read_ahead_stalls++;
+            }
+            result->cluster = current_ahead[0].get();
+        }
+        use_cached_cluster(context, result.get());
+
+        // Shift the clusters ahead and start preloading the next cluster in sequence. Clusters that were left to load
+        // on demand because of the byte limit move to the background once they are close enough.
+        size_t prefetch_count = get_prefetch_count(context);
+        context->read_ahead_background_count = prefetch_count;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i + 1 < current_ahead.size() &&
+                (i >= prefetch_count ||
+                 current_ahead[i + 1].wait_for(std::chrono::seconds(0)) != std::future_status::deferred))
+            {
+                ahead.push_back(current_ahead[i + 1]);
+            }
+            else
+            {
+                ahead.push_back(schedule_cluster(context, cluster_info, i + 1, next, i < prefetch_count));
+            }
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to load next cluster: %s", e.what());
+        return nullptr;
+    }
+
+    return result;
+}
+
+// Find the first block with a timestamp >= the specified timestamp. If a block group containing the specified timestamp
+// is found, it will be returned. If no blocks are found, a pointer to EOF will be returned, or nullptr if an error
+// occurs.
+std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context, track_reader_t *reader, uint64_t timestamp_ns)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, reader == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, reader->track == NULL);
 
     // Create a new block pointing to the start of the cluster containing timestamp_ns.
     std::shared_ptr<block_info_t> block = std::make_shared<block_info_t>();
@@ -1553,21 +2223,135 @@ std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_
     return next_block;
 }
 
-static void free_vector_buffer(void *buffer, void *context)
+static void free_pooled_image_buffer(void *buffer, void *context)
 {
     (void)buffer;
     assert(context != nullptr);
-    std::vector<uint8_t> *vector = static_cast<std::vector<uint8_t> *>(context);
-    delete vector;
+    std::unique_ptr<pooled_image_buffer_t> pooled_buffer(static_cast<pooled_image_buffer_t *>(context));
+    std::shared_ptr<image_buffer_pool_t> pool = std::move(pooled_buffer->pool);
+    assert(pool != nullptr);
+
+    std::lock_guard<std::mutex> lock(pool->lock);
+    if (pool->free_buffers.size() >= IMAGE_BUFFER_POOL_MAX_COUNT)
+    {
+        // Drop the oldest buffer, it is most likely a size that is no longer used.
+        pool->free_buffers.pop_front();
+    }
+    pool->free_buffers.push_back(std::move(pooled_buffer));
 }
 
-// Allocates a new image in the specified format from in_block
-k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
-                                    block_info_t *in_block,
-                                    k4a_image_t *image_out,
-                                    k4a_image_format_t target_format)
+// Returns a buffer of exactly buffer_size bytes, reusing a previously freed image buffer if one is available.
+static pooled_image_buffer_t *acquire_image_buffer(const std::shared_ptr<image_buffer_pool_t> &pool, size_t buffer_size)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    std::unique_ptr<pooled_image_buffer_t> pooled_buffer;
+    {
+        std::lock_guard<std::mutex> lock(pool->lock);
+        auto &free_buffers = pool->free_buffers;
+        for (auto itr = free_buffers.rbegin(); itr != free_buffers.rend(); itr++)
+        {
+            if ((*itr)->data.size() == buffer_size)
+            {
+                pooled_buffer = std::move(*itr);
+                free_buffers.erase(std::next(itr).base());
+                break;
+            }
+        }
+    }
+
+    if (pooled_buffer == nullptr)
+    {
+        try
+        {
+            pooled_buffer = make_unique<pooled_image_buffer_t>();
+            pooled_buffer->data.resize(buffer_size);
+        }
+        catch (std::bad_alloc &)
+        {
+            LOG_ERROR("Failed to allocate image buffer of %llu bytes.", (uint64_t)buffer_size);
+            return NULL;
+        }
+    }
+    pooled_buffer->pool = pool;
+    return pooled_buffer.release();
+}
+
+static void release_image_buffer(pooled_image_buffer_t *buffer)
+{
+    free_pooled_image_buffer(buffer->data.data(), buffer);
+}
+
+static void release_file_mapping(void *buffer, void *context)
+{
+    (void)buffer;
+    delete static_cast<std::shared_ptr<MappedFile> *>(context);
+}
+
+// Creates an image that points directly at the block data inside the file mapping of its cluster, without copying it.
+// Returns false if the block was not read through a mapping or its data cannot be located in it, so the caller can
+// fall back to copying the buffer.
+static bool create_image_from_file_mapping(block_info_t *in_block,
+                                           k4a_image_format_t format,
+                                           int width,
+                                           int height,
+                                           int stride,
+                                           k4a_image_t *image_out)
+{
+    if (in_block->cluster == nullptr || in_block->cluster->file_mapping == nullptr)
+    {
+        return false;
+    }
+
+    const std::shared_ptr<MappedFile> &file_mapping = in_block->cluster->file_mapping;
+    DataBuffer &data_buffer = in_block->block->GetBuffer(0);
+    uint64_t position = in_block->block->GetDataPosition(0);
+    size_t size = data_buffer.Size();
+    if (size == 0 || position > file_mapping->size() || size > file_mapping->size() - position)
+    {
+        return false;
+    }
+
+    // The block was parsed from the same file, make sure the position points at the same bytes before handing it out.
+    const uint8_t *data = file_mapping->data() + position;
+    size_t check_size = size < 64 ? size : 64;
+    if (memcmp(data, data_buffer.Buffer(), check_size) != 0 ||
+        memcmp(data + size - check_size, data_buffer.Buffer() + size - check_size, check_size) != 0)
+    {
+        return false;
+    }
+
+    // The image keeps the mapping alive, so it remains valid after the playback handle is closed.
+    std::shared_ptr<MappedFile> *image_mapping = new (std::nothrow) std::shared_ptr<MappedFile>(file_mapping);
+    if (image_mapping == NULL)
+    {
+        return false;
+    }
+    k4a_result_t result = TRACE_CALL(k4a_image_create_from_buffer(format,
+                                                                  width,
+                                                                  height,
+                                                                  stride,
+                                                                  const_cast<uint8_t *>(data),
+                                                                  size,
+                                                                  &release_file_mapping,
+                                                                  image_mapping,
+                                                                  image_out));
+    if (K4A_FAILED(result))
+    {
+        delete image_mapping;
+        return false;
+    }
+    k4a_image_set_timestamp_usec(*image_out, in_block->timestamp_ns / 1000);
+    return true;
+}
+
+// Allocates a new image in the specified format from in_block, using converter for the color conversion.
+// Safe to call from any thread as long as each thread uses its own converter.
+static k4a_result_t convert_block_with_converter(image_converter_t *converter,
+                                                 const std::shared_ptr<image_buffer_pool_t> &buffer_pool,
+                                                 block_info_t *in_block,
+                                                 k4a_image_t *image_out,
+                                                 k4a_image_format_t target_format)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, converter == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, in_block == nullptr);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_out == nullptr);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, in_block->reader == NULL);
@@ -1577,7 +2361,7 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     DataBuffer &data_buffer = in_block->block->GetBuffer(0);
 
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
-    std::vector<uint8_t> *buffer = NULL;
+    pooled_image_buffer_t *buffer = NULL;
     assert(in_block->reader->width <= INT_MAX);
     assert(in_block->reader->height <= INT_MAX);
     assert(in_block->reader->stride <= INT_MAX);
@@ -1590,22 +2374,52 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     {
     case K4A_IMAGE_FORMAT_DEPTH16:
     case K4A_IMAGE_FORMAT_IR16:
-        buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
-        if (in_block->reader->format == K4A_IMAGE_FORMAT_DEPTH16 || in_block->reader->format == K4A_IMAGE_FORMAT_IR16)
+        if (in_block->reader->lossless16)
         {
-            // 16 bit grayscale needs to be converted from big-endian back to little-endian.
-            assert(buffer->size() % sizeof(uint16_t) == 0);
-            uint16_t *buffer_raw = reinterpret_cast<uint16_t *>(buffer->data());
-            size_t buffer_size = buffer->size() / sizeof(uint16_t);
-            for (size_t i = 0; i < buffer_size; i++)
+            size_t sample_count = lossless16_sample_count(data_buffer.Buffer(), data_buffer.Size());
+            if (sample_count == 0 || sample_count > (size_t)out_width * (size_t)out_height)
             {
-                buffer_raw[i] = swap_bytes_16(buffer_raw[i]);
+                LOG_ERROR("Compressed 16 bit frame has an invalid size: %llu samples", (uint64_t)sample_count);
+                result = K4A_RESULT_FAILED;
+                break;
+            }
+
+            buffer = acquire_image_buffer(buffer_pool, sample_count * sizeof(uint16_t));
+            result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+            if (K4A_SUCCEEDED(result))
+            {
+                result = TRACE_CALL(lossless16_decompress(data_buffer.Buffer(),
+                                                          data_buffer.Size(),
+                                                          reinterpret_cast<uint16_t *>(buffer->data.data()),
+                                                          sample_count));
             }
+            break;
+        }
+
+        if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2 &&
+            create_image_from_file_mapping(in_block, target_format, out_width, out_height, out_stride, image_out))
+        {
+            return K4A_RESULT_SUCCEEDED;
+        }
+
+        buffer = acquire_image_buffer(buffer_pool, data_buffer.Size());
+        result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+        if (K4A_FAILED(result))
+        {
+            break;
+        }
+        if (in_block->reader->format == K4A_IMAGE_FORMAT_DEPTH16 || in_block->reader->format == K4A_IMAGE_FORMAT_IR16)
+        {
+            // 16 bit grayscale needs to be converted from big-endian back to little-endian, which is done while
+            // copying out of the block.
+            assert(buffer->data.size() % sizeof(uint16_t) == 0);
+            swap_bytes_16_copy(buffer->data.data(), data_buffer.Buffer(), buffer->data.size() / sizeof(uint16_t));
         }
         else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2)
         {
             // For backward compatibility with early recordings, the YUY2 format was used. The actual data buffer is
             // 16-bit little-endian, so we can just use the buffer as-is.
+            memcpy(buffer->data.data(), data_buffer.Buffer(), data_buffer.Size());
         }
         else
         {
@@ -1619,32 +2433,77 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     case K4A_IMAGE_FORMAT_COLOR_BGRA32:
         if (in_block->reader->format == target_format)
         {
-            // No format conversion is required, just copy the buffer.
-            buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+            // No format conversion is required, use the mapped file data directly or copy the buffer.
+            if (create_image_from_file_mapping(in_block, target_format, out_width, out_height, out_stride, image_out))
+            {
+                return K4A_RESULT_SUCCEEDED;
+            }
+            buffer = acquire_image_buffer(buffer_pool, data_buffer.Size());
+            result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+            if (K4A_SUCCEEDED(result))
+            {
+                memcpy(buffer->data.data(), data_buffer.Buffer(), data_buffer.Size());
+            }
         }
         else
         {
-            // Convert the buffer to BGRA format first
+            // Convert the buffer to BGRA format first. When BGRA is not the target format, the intermediate image is
+            // kept in the converter so that it can be reused for the next frame.
             out_stride = out_width * 4 * (int)sizeof(uint8_t);
-            buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
-
-            if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG)
-            {
-                tjhandle turbojpeg_handle = tjInitDecompress();
-                if (tjDecompress2(turbojpeg_handle,
-                                  data_buffer.Buffer(),
-                                  data_buffer.Size(),
-                                  buffer->data(),
-                                  out_width,
-                                  0, // pitch
-                                  out_height,
-                                  TJPF_BGRA,
-                                  TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+            size_t bgra_size = (size_t)(out_height * out_stride);
+            uint8_t *bgra_buffer = NULL;
+            if (target_format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+            {
+                buffer = acquire_image_buffer(buffer_pool, bgra_size);
+                result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+                if (K4A_SUCCEEDED(result))
+                {
+                    bgra_buffer = buffer->data.data();
+                }
+            }
+            else
+            {
+                try
+                {
+                    converter->color_conversion_buffer.resize(bgra_size);
+                    bgra_buffer = converter->color_conversion_buffer.data();
+                }
+                catch (std::bad_alloc &)
+                {
+                    LOG_ERROR("Failed to allocate color conversion buffer of %llu bytes.", (uint64_t)bgra_size);
+                    result = K4A_RESULT_FAILED;
+                }
+            }
+
+            if (K4A_FAILED(result))
+            {
+                // Allocation failure was already logged.
+            }
+            else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+            {
+                if (converter->turbojpeg_handle == NULL)
+                {
+                    converter->turbojpeg_handle = tjInitDecompress();
+                }
+
+                if (converter->turbojpeg_handle == NULL)
+                {
+                    LOG_ERROR("Failed to initialize jpeg decompressor.", 0);
+                    result = K4A_RESULT_FAILED;
+                }
+                else if (tjDecompress2(converter->turbojpeg_handle,
+                                       data_buffer.Buffer(),
+                                       data_buffer.Size(),
+                                       bgra_buffer,
+                                       out_width,
+                                       0, // pitch
+                                       out_height,
+                                       TJPF_BGRA,
+                                       TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
                 {
                     LOG_ERROR("Failed to decompress jpeg image to BGRA format.", 0);
                     result = K4A_RESULT_FAILED;
                 }
-                (void)tjDestroy(turbojpeg_handle);
             }
             else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_NV12)
             {
@@ -1653,7 +2512,7 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                        (int)in_block->reader->stride,
                                        data_buffer.Buffer() + (out_height * (int)in_block->reader->stride),
                                        (int)in_block->reader->stride,
-                                       buffer->data(),
+                                       bgra_buffer,
                                        out_stride,
                                        out_width,
                                        out_height) != 0)
@@ -1667,7 +2526,7 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                 // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
                 if (libyuv::YUY2ToARGB(data_buffer.Buffer(),
                                        (int)in_block->reader->stride,
-                                       buffer->data(),
+                                       bgra_buffer,
                                        out_stride,
                                        out_width,
                                        out_height) != 0)
@@ -1684,8 +2543,6 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
 
             if (K4A_SUCCEEDED(result) && target_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
             {
-                auto bgra_buffer = buffer;
-                buffer = NULL;
                 int bgra_stride = out_stride;
 
                 if (target_format == K4A_IMAGE_FORMAT_COLOR_NV12)
@@ -1694,16 +2551,17 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                     size_t y_plane_size = (size_t)(out_height * out_stride);
                     // Round up the size of the UV plane in case the resolution is odd.
                     size_t uv_plane_size = (size_t)(out_height * out_stride + 1) / 2;
-                    buffer = new std::vector<uint8_t>(y_plane_size + uv_plane_size);
-
-                    if (libyuv::ARGBToNV12(bgra_buffer->data(),
-                                           bgra_stride,
-                                           buffer->data(),
-                                           out_stride,
-                                           buffer->data() + y_plane_size,
-                                           out_stride,
-                                           out_width,
-                                           out_height) != 0)
+                    buffer = acquire_image_buffer(buffer_pool, y_plane_size + uv_plane_size);
+                    result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+
+                    if (K4A_SUCCEEDED(result) && libyuv::ARGBToNV12(bgra_buffer,
+                                                                    bgra_stride,
+                                                                    buffer->data.data(),
+                                                                    out_stride,
+                                                                    buffer->data.data() + y_plane_size,
+                                                                    out_stride,
+                                                                    out_width,
+                                                                    out_height) != 0)
                     {
                         LOG_ERROR("Failed to convert BGRA image to NV12 format.", 0);
                         result = K4A_RESULT_FAILED;
@@ -1712,10 +2570,12 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                 else if (target_format == K4A_IMAGE_FORMAT_COLOR_YUY2)
                 {
                     out_stride = out_width * 2;
-                    buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
+                    buffer = acquire_image_buffer(buffer_pool, (size_t)(out_height * out_stride));
+                    result = K4A_RESULT_FROM_BOOL(buffer != NULL);
 
-                    if (libyuv::ARGBToYUY2(
-                            bgra_buffer->data(), bgra_stride, buffer->data(), out_stride, out_width, out_height) != 0)
+                    if (K4A_SUCCEEDED(result) &&
+                        libyuv::ARGBToYUY2(
+                            bgra_buffer, bgra_stride, buffer->data.data(), out_stride, out_width, out_height) != 0)
                     {
                         LOG_ERROR("Failed to convert BGRA image to YUY2 format.", 0);
                         result = K4A_RESULT_FAILED;
@@ -1726,11 +2586,6 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                     LOG_ERROR("Unsupported image format conversion: %d to %d", in_block->reader->format, target_format);
                     result = K4A_RESULT_FAILED;
                 }
-
-                if (bgra_buffer != NULL)
-                {
-                    delete bgra_buffer;
-                }
             }
         }
         break;
@@ -1745,23 +2600,212 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                                          out_width,
                                                          out_height,
                                                          out_stride,
-                                                         buffer->data(),
-                                                         buffer->size(),
-                                                         &free_vector_buffer,
+                                                         buffer->data.data(),
+                                                         buffer->data.size(),
+                                                         &free_pooled_image_buffer,
                                                          buffer,
                                                          image_out));
-        k4a_image_set_timestamp_usec(*image_out, in_block->timestamp_ns / 1000);
+        if (K4A_SUCCEEDED(result))
+        {
+            k4a_image_set_timestamp_usec(*image_out, in_block->timestamp_ns / 1000);
+        }
     }
 
     if (K4A_FAILED(result) && buffer != NULL)
     {
-        delete buffer;
+        release_image_buffer(buffer);
     }
 
     return result;
 }
 
-k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k4a_capture_t *capture_handle)
+// Allocates a new image in the specified format from in_block
+k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
+                                    block_info_t *in_block,
+                                    k4a_image_t *image_out,
+                                    k4a_image_format_t target_format)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    return convert_block_with_converter(&context->image_converter,
+                                        context->image_buffer_pool,
+                                        in_block,
+                                        image_out,
+                                        target_format);
+}
+
+static void color_decode_thread(color_decode_pipeline_t *pipeline, std::shared_ptr<image_buffer_pool_t> buffer_pool)
+{
+    image_converter_t converter;
+
+    std::unique_lock<std::mutex> lock(pipeline->lock);
+    while (true)
+    {
+        pipeline->job_available.wait(lock, [pipeline]() { return pipeline->stopping || !pipeline->queue.empty(); });
+        if (pipeline->stopping)
+        {
+            break;
+        }
+
+        std::shared_ptr<color_decode_job_t> job = std::move(pipeline->queue.front());
+        pipeline->queue.pop_front();
+        job->started = true;
+        lock.unlock();
+
+        k4a_image_t image = NULL;
+        k4a_result_t result = TRACE_CALL(
+            convert_block_with_converter(&converter, buffer_pool, job->block.get(), &image, job->target_format));
+
+        lock.lock();
+        job->result = result;
+        job->image = image;
+        job->done = true;
+        pipeline->job_done.notify_all();
+
+        // Drop the job outside of the lock, releasing the image if the job has been cleared from the pipeline.
+        lock.unlock();
+        job.reset();
+        lock.lock();
+    }
+}
+
+k4a_result_t start_color_decode_pipeline(k4a_playback_context_t *context, uint32_t thread_count, uint32_t frame_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > 0 && frame_count < thread_count);
+
+    stop_color_decode_pipeline(context);
+
+    color_decode_pipeline_t *pipeline = &context->color_decode;
+    pipeline->stopping = false;
+    pipeline->thread_count = thread_count;
+    pipeline->frame_count = frame_count;
+    try
+    {
+        for (uint32_t i = 0; i < thread_count; i++)
+        {
+            pipeline->threads.emplace_back(color_decode_thread, pipeline, context->image_buffer_pool);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start color decode thread: %s", e.what());
+        stop_color_decode_pipeline(context);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void stop_color_decode_pipeline(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    color_decode_pipeline_t *pipeline = &context->color_decode;
+    {
+        std::lock_guard<std::mutex> lock(pipeline->lock);
+        pipeline->stopping = true;
+        pipeline->queue.clear();
+    }
+    pipeline->job_available.notify_all();
+    for (std::thread &thread : pipeline->threads)
+    {
+        thread.join();
+    }
+    pipeline->threads.clear();
+    pipeline->pending.clear();
+    pipeline->thread_count = 0;
+    pipeline->frame_count = 0;
+}
+
+void clear_color_decode_pipeline(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    color_decode_pipeline_t *pipeline = &context->color_decode;
+    {
+        std::lock_guard<std::mutex> lock(pipeline->lock);
+        pipeline->queue.clear();
+    }
+    // Jobs already being decoded finish in the background and release their image when the worker drops them.
+    pipeline->pending.clear();
+}
+
+// Returns the color image for block from the decode pipeline and queues the color blocks that follow it.
+static k4a_result_t get_pipelined_color_image(k4a_playback_context_t *context,
+                                              std::shared_ptr<block_info_t> &block,
+                                              k4a_image_t *image_out,
+                                              bool next)
+{
+    color_decode_pipeline_t *pipeline = &context->color_decode;
+    k4a_image_format_t target_format = context->color_format_conversion;
+
+    std::shared_ptr<color_decode_job_t> job;
+    if (!pipeline->pending.empty())
+    {
+        std::shared_ptr<color_decode_job_t> &front = pipeline->pending.front();
+        if (front->block->block == block->block && front->target_format == target_format)
+        {
+            job = std::move(front);
+            pipeline->pending.pop_front();
+        }
+        else
+        {
+            // Playback changed direction, skipped a color block, or changed the conversion format.
+            clear_color_decode_pipeline(context);
+        }
+    }
+
+    // Queue the blocks that follow in the playback direction.
+    std::shared_ptr<block_info_t> last_block = pipeline->pending.empty() ? block : pipeline->pending.back()->block;
+    bool queued = false;
+    while (pipeline->pending.size() < pipeline->frame_count)
+    {
+        last_block = next_block(context, last_block.get(), next);
+        if (last_block == nullptr || last_block->block == NULL)
+        {
+            break;
+        }
+
+        std::shared_ptr<color_decode_job_t> new_job = std::make_shared<color_decode_job_t>();
+        new_job->block = last_block;
+        new_job->target_format = target_format;
+        pipeline->pending.push_back(new_job);
+
+        std::lock_guard<std::mutex> lock(pipeline->lock);
+        pipeline->queue.push_back(std::move(new_job));
+        queued = true;
+    }
+    if (queued)
+    {
+        pipeline->job_available.notify_all();
+    }
+
+    if (job != nullptr)
+    {
+        std::unique_lock<std::mutex> lock(pipeline->lock);
+        if (job->started)
+        {
+            pipeline->job_done.wait(lock, [&job]() { return job->done; });
+            k4a_result_t result = job->result;
+            *image_out = job->image;
+            job->image = NULL;
+            return result;
+        }
+
+        // No worker has picked up this block yet, decode it here instead of waiting.
+        auto itr = std::find(pipeline->queue.begin(), pipeline->queue.end(), job);
+        if (itr != pipeline->queue.end())
+        {
+            pipeline->queue.erase(itr);
+        }
+    }
+
+    return TRACE_CALL(convert_block_to_image(context, block.get(), image_out, target_format));
+}
+
+k4a_result_t new_capture(k4a_playback_context_t *context,
+                         std::shared_ptr<block_info_t> &block,
+                         k4a_capture_t *capture_handle,
+                         bool next)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
@@ -1778,17 +2822,33 @@ k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
     if (block->reader == &context->color_track)
     {
-        result = TRACE_CALL(convert_block_to_image(context, block, &image_handle, context->color_format_conversion));
+        image_handle = find_cached_color_image(context, block.get(), context->color_format_conversion);
+        if (image_handle == NULL)
+        {
+            if (context->color_decode.thread_count > 0)
+            {
+                result = TRACE_CALL(get_pipelined_color_image(context, block, &image_handle, next));
+            }
+            else
+            {
+                result = TRACE_CALL(
+                    convert_block_to_image(context, block.get(), &image_handle, context->color_format_conversion));
+            }
+            if (K4A_SUCCEEDED(result) && image_handle != NULL)
+            {
+                cache_color_image(context, block.get(), image_handle);
+            }
+        }
         k4a_capture_set_color_image(*capture_handle, image_handle);
     }
     else if (block->reader == &context->depth_track)
     {
-        result = TRACE_CALL(convert_block_to_image(context, block, &image_handle, K4A_IMAGE_FORMAT_DEPTH16));
+        result = TRACE_CALL(convert_block_to_image(context, block.get(), &image_handle, K4A_IMAGE_FORMAT_DEPTH16));
         k4a_capture_set_depth_image(*capture_handle, image_handle);
     }
     else if (block->reader == &context->ir_track)
     {
-        result = TRACE_CALL(convert_block_to_image(context, block, &image_handle, K4A_IMAGE_FORMAT_IR16));
+        result = TRACE_CALL(convert_block_to_image(context, block.get(), &image_handle, K4A_IMAGE_FORMAT_IR16));
         k4a_capture_set_ir_image(*capture_handle, image_handle);
     }
     else
@@ -1963,7 +3023,7 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
         if (next_blocks[i] && next_blocks[i]->block)
         {
             blocks[i]->current_block = next_blocks[i];
-            k4a_result_t result = TRACE_CALL(new_capture(context, blocks[i]->current_block.get(), capture_handle));
+            k4a_result_t result = TRACE_CALL(new_capture(context, blocks[i]->current_block, capture_handle, next));
             if (K4A_FAILED(result))
             {
                 if (*capture_handle != NULL)
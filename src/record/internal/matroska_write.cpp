@@ -4,6 +4,7 @@
 #include <ctime>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include <sstream>
 
 #include <k4a/k4a.h>
@@ -56,8 +57,11 @@ uint64_t new_unique_id()
     return result;
 }
 
-k4a_result_t
-populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t height, k4a_image_format_t format)
+k4a_result_t populate_bitmap_info_header(BITMAPINFOHEADER *header,
+                                         uint64_t width,
+                                         uint64_t height,
+                                         k4a_image_format_t format,
+                                         k4a_record_compression_t compression)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, header == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, width > UINT32_MAX);
@@ -91,10 +95,18 @@ populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t h
         break;
     case K4A_IMAGE_FORMAT_DEPTH16:
     case K4A_IMAGE_FORMAT_IR16:
-        // Store depth in b16g format, which is supported by ffmpeg.
         header->biBitCount = 16;
-        header->biCompression = 0x67363162; // b16g (16 bit grayscale, big endian)
-        header->biSizeImage = sizeof(uint8_t) * header->biWidth * header->biHeight * 2;
+        if (compression == K4A_RECORD_COMPRESSION_LOSSLESS)
+        {
+            header->biCompression = 0x36314C4B; // KL16 (16 bit grayscale, lossless16 codec)
+            header->biSizeImage = 0;            // Compressed frames are variable size
+        }
+        else
+        {
+            // Store depth in b16g format, which is supported by ffmpeg.
+            header->biCompression = 0x67363162; // b16g (16 bit grayscale, big endian)
+            header->biSizeImage = sizeof(uint8_t) * header->biWidth * header->biHeight * 2;
+        }
         break;
     default:
         LOG_ERROR("Unsupported color format specified in recording: %d", format);
@@ -147,16 +159,8 @@ void set_track_info_video(KaxTrackEntry *track, uint64_t width, uint64_t height,
     GetChild<KaxVideoPixelHeight>(video_track).SetValue(height);
 }
 
-// Buffer needs to be valid until it is flushed to disk. The DataBuffer free callback can be used to assist with this.
-// If a failure is returned, the caller will need to free the buffer.
-k4a_result_t
-write_track_data(k4a_record_context_t *context, KaxTrackEntry *track, uint64_t timestamp_ns, DataBuffer *buffer)
+static k4a_result_t queue_track_data(k4a_record_context_t *context, uint64_t timestamp_ns, const track_data_t &data)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
-
     try
     {
         std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
@@ -173,7 +177,6 @@ write_track_data(k4a_record_context_t *context, KaxTrackEntry *track, uint64_t t
             return K4A_RESULT_FAILED;
         }
 
-        track_data_t data = { track, buffer };
         cluster->data.push_back(std::make_pair(timestamp_ns, data));
     }
     catch (std::system_error &e)
@@ -190,6 +193,77 @@ write_track_data(k4a_record_context_t *context, KaxTrackEntry *track, uint64_t t
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Buffer needs to be valid until it is flushed to disk. The DataBuffer free callback can be used to assist with this.
+// If a failure is returned, the caller will need to free the buffer.
+k4a_result_t
+write_track_data(k4a_record_context_t *context, KaxTrackEntry *track, uint64_t timestamp_ns, DataBuffer *buffer)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+
+    track_data_t data = { track, buffer, std::shared_future<DataBuffer *>(), NULL };
+    return queue_track_data(context, timestamp_ns, data);
+}
+
+// The recording takes ownership of the buffer returned by the future. If a failure is returned, the future is dropped.
+k4a_result_t write_pending_track_data(k4a_record_context_t *context,
+                                      KaxTrackEntry *track,
+                                      uint64_t timestamp_ns,
+                                      std::shared_future<DataBuffer *> buffer)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !buffer.valid());
+
+    track_data_t data = { track, NULL, buffer, NULL };
+    return queue_track_data(context, timestamp_ns, data);
+}
+
+// The image reference is released once the frame is written, or before returning if a failure is returned.
+k4a_result_t
+write_image_track_data(k4a_record_context_t *context, KaxTrackEntry *track, uint64_t timestamp_ns, k4a_image_t image)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image == NULL);
+
+    uint8_t *image_buffer = k4a_image_get_buffer(image);
+    size_t buffer_size = k4a_image_get_size(image);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_buffer == NULL || buffer_size == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_size > UINT32_MAX);
+
+    DataBuffer *buffer = NULL;
+    k4a_image_format_t image_format = k4a_image_get_format(image);
+    if (image_format == K4A_IMAGE_FORMAT_DEPTH16 || image_format == K4A_IMAGE_FORMAT_IR16)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_size % sizeof(uint16_t) != 0);
+    }
+    else
+    {
+        // Other formats are written as-is, straight from the image buffer.
+        buffer = new (std::nothrow) DataBuffer(image_buffer, (uint32)buffer_size, NULL, false);
+        if (buffer == NULL)
+        {
+            LOG_ERROR("Failed to allocate a data buffer for the image.", 0);
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    k4a_image_reference(image);
+    track_data_t data = { track, buffer, std::shared_future<DataBuffer *>(), image };
+    k4a_result_t result = queue_track_data(context, timestamp_ns, data);
+    if (K4A_FAILED(result))
+    {
+        delete buffer;
+        k4a_image_release(image);
+    }
+    return result;
+}
+
 // Lock(context->pending_cluster_lock) should be active when calling this function
 cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t timestamp_ns)
 {
@@ -263,6 +337,54 @@ k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, ui
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cluster == NULL);
 
+    // Convert 16 bit images to big-endian in a single pass into this cluster's write buffers, and wait for frames that
+    // are still being compressed. Frames that failed to compress are left out of the cluster.
+    size_t swap_count = 0;
+    for (size_t i = 0; i < cluster->data.size();)
+    {
+        track_data_t &data = cluster->data[i].second;
+        if (data.buffer == NULL && data.image != NULL)
+        {
+            if (swap_count == context->swap_buffers.size())
+            {
+                context->swap_buffers.emplace_back();
+            }
+            std::vector<uint8_t> &swap_buffer = context->swap_buffers[swap_count++];
+            size_t buffer_size = k4a_image_get_size(data.image);
+            swap_buffer.resize(buffer_size);
+            swap_bytes_16_copy(swap_buffer.data(), k4a_image_get_buffer(data.image), buffer_size / sizeof(uint16_t));
+
+            data.buffer = new (std::nothrow) DataBuffer(swap_buffer.data(), (uint32)buffer_size, NULL, false);
+            if (data.buffer == NULL)
+            {
+                LOG_ERROR("Dropping frame at %llu ns, failed to allocate a data buffer.", cluster->data[i].first);
+                k4a_image_release(data.image);
+                cluster->data.erase(cluster->data.begin() + (ptrdiff_t)i);
+                continue;
+            }
+        }
+        else if (data.buffer == NULL)
+        {
+            try
+            {
+                data.buffer = data.pending_buffer.get();
+            }
+            catch (std::future_error &)
+            {
+                data.buffer = NULL;
+            }
+            data.pending_buffer = std::shared_future<DataBuffer *>();
+
+            if (data.buffer == NULL)
+            {
+                LOG_ERROR("Dropping frame at %llu ns that could not be compressed.", cluster->data[i].first);
+                cluster->data.erase(cluster->data.begin() + (ptrdiff_t)i);
+                continue;
+            }
+        }
+        i++;
+    }
+
     if (cluster->data.size() == 0)
     {
         LOG_WARNING("Tried to write empty cluster to disk", 0);
@@ -386,6 +508,10 @@ k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, ui
     for (std::pair<uint64_t, track_data_t> data : cluster->data)
     {
         data.second.buffer->FreeBuffer(*data.second.buffer);
+        if (data.second.image != NULL)
+        {
+            k4a_image_release(data.second.image);
+        }
     }
 
     // Both KaxCluster and KaxBlockBlob will try to free the same element due to a bug in libmatroska.
@@ -510,6 +636,203 @@ void stop_matroska_writer_thread(k4a_record_context_t *context)
     }
 }
 
+DataBuffer *compress_frame(frame_compressor_t *compressor, k4a_image_t image, std::vector<uint8_t> &buffer)
+{
+    RETURN_VALUE_IF_ARG(NULL, compressor == NULL);
+    RETURN_VALUE_IF_ARG(NULL, compressor->compression != K4A_RECORD_COMPRESSION_LOSSLESS);
+    RETURN_VALUE_IF_ARG(NULL, image == NULL);
+
+    const uint8_t *image_buffer = k4a_image_get_buffer(image);
+    size_t image_size = k4a_image_get_size(image);
+    int stride = k4a_image_get_stride_bytes(image);
+    if (image_buffer == NULL || image_size % sizeof(uint16_t) != 0 || stride < (int)sizeof(uint16_t) ||
+        (size_t)stride % sizeof(uint16_t) != 0)
+    {
+        LOG_ERROR("Unsupported 16 bit image layout: %llu bytes with a stride of %d", (uint64_t)image_size, stride);
+        return NULL;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t sample_count = image_size / sizeof(uint16_t);
+    try
+    {
+        buffer.resize(lossless16_max_compressed_size(sample_count));
+    }
+    catch (std::bad_alloc &)
+    {
+        LOG_ERROR("Failed to allocate a compression buffer of %llu bytes.", (uint64_t)buffer.size());
+        return NULL;
+    }
+
+    size_t compressed_size = lossless16_compress(reinterpret_cast<const uint16_t *>(image_buffer),
+                                                 sample_count,
+                                                 (uint32_t)((size_t)stride / sizeof(uint16_t)),
+                                                 buffer.data());
+    if (compressed_size == 0 || compressed_size > UINT32_MAX)
+    {
+        LOG_ERROR("Failed to compress a 16 bit image of %llu bytes.", (uint64_t)image_size);
+        return NULL;
+    }
+
+    // The DataBuffer keeps its own copy of the compressed frame, so that buffer can be reused.
+    DataBuffer *data_buffer = new (std::nothrow) DataBuffer(buffer.data(), (uint32)compressed_size, NULL, true);
+    if (data_buffer == NULL)
+    {
+        return NULL;
+    }
+
+    compressor->frame_count++;
+    compressor->input_bytes += image_size;
+    compressor->output_bytes += compressed_size;
+    compressor->compress_time_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start)
+                                        .count();
+    return data_buffer;
+}
+
+static void frame_compression_thread(frame_compressor_t *compressor)
+{
+    std::vector<uint8_t> buffer;
+
+    std::unique_lock<std::mutex> lock(compressor->lock);
+    while (true)
+    {
+        compressor->job_available.wait(lock, [compressor]() {
+            return compressor->stopping || !compressor->queue.empty();
+        });
+        if (compressor->queue.empty())
+        {
+            // Stopping, and every queued frame has been compressed.
+            break;
+        }
+
+        std::unique_ptr<frame_compression_job_t> job = std::move(compressor->queue.front());
+        compressor->queue.pop_front();
+        lock.unlock();
+
+        job->result.set_value(compress_frame(compressor, job->image, buffer));
+        job.reset();
+
+        lock.lock();
+    }
+}
+
+k4a_result_t write_compressed_track_data(k4a_record_context_t *context,
+                                         KaxTrackEntry *track,
+                                         uint64_t timestamp_ns,
+                                         k4a_image_t image)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image == NULL);
+
+    frame_compressor_t *compressor = &context->compressor;
+    std::unique_ptr<frame_compression_job_t> job(new (std::nothrow) frame_compression_job_t());
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, job == nullptr);
+
+    k4a_image_reference(image);
+    job->image = image;
+
+    try
+    {
+        // Reserve the frame's place in its cluster first, so that the cluster cannot be written without it.
+        RETURN_IF_ERROR(write_pending_track_data(context, track, timestamp_ns, job->result.get_future().share()));
+
+        if (compressor->thread_count > 0)
+        {
+            // Two tracks of frames per camera frame
+            size_t max_queued = (size_t)(context->camera_fps * 2 * FRAME_COMPRESSION_QUEUE_DURATION_NS / 1_s);
+
+            std::lock_guard<std::mutex> lock(compressor->lock);
+            if (compressor->queue.size() < max_queued)
+            {
+                compressor->queue.push_back(std::move(job));
+                compressor->job_available.notify_one();
+                return K4A_RESULT_SUCCEEDED;
+            }
+        }
+
+        // There are no worker threads, or they are too far behind.
+        std::lock_guard<std::mutex> lock(compressor->inline_lock);
+        compressor->inline_count++;
+        job->result.set_value(compress_frame(compressor, job->image, compressor->inline_buffer));
+    }
+    catch (std::system_error &e)
+    {
+        // If the frame was reserved, the writer thread drops it when the job is destroyed without a result.
+        LOG_ERROR("Failed to queue frame for compression: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t start_frame_compressor(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    frame_compressor_t *compressor = &context->compressor;
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !compressor->threads.empty());
+    if (compressor->compression == K4A_RECORD_COMPRESSION_NONE)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    try
+    {
+        compressor->stopping = false;
+        for (uint32_t i = 0; i < compressor->thread_count; i++)
+        {
+            compressor->threads.emplace_back(frame_compression_thread, compressor);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start frame compression threads: %s", e.what());
+        stop_frame_compressor(context);
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void stop_frame_compressor(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    frame_compressor_t *compressor = &context->compressor;
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(compressor->lock);
+            compressor->stopping = true;
+        }
+        compressor->job_available.notify_all();
+        for (std::thread &thread : compressor->threads)
+        {
+            thread.join();
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to stop frame compression threads: %s", e.what());
+    }
+    compressor->threads.clear();
+
+    uint64_t frame_count = compressor->frame_count;
+    if (frame_count > 0)
+    {
+        uint64_t input_bytes = compressor->input_bytes;
+        uint64_t compress_time_ns = compressor->compress_time_ns;
+        LOG_INFO("Compressed %llu depth and IR frames to %.1f%% of their size at %.1f MB/s per thread, %llu on the "
+                 "calling thread.",
+                 frame_count,
+                 100.0 * (double)compressor->output_bytes / (double)input_bytes,
+                 compress_time_ns > 0 ? (double)input_bytes * 1000.0 / (double)compress_time_ns : 0.0,
+                 (uint64_t)compressor->inline_count);
+    }
+}
+
 KaxTag *
 add_tag(k4a_record_context_t *context, const char *name, const char *value, TagTargetType target, uint64_t target_uid)
 {
@@ -14,7 +14,8 @@
 using namespace k4arecord;
 using namespace LIBMATROSKA_NAMESPACE;
 
-k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle)
+// index_path may be NULL to open the recording without a seek index.
+static k4a_result_t playback_open(const char *path, const char *index_path, k4a_playback_t *playback_handle)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
@@ -38,6 +39,10 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
         context->logger_handle = logger_handle;
         context->file_path = path;
         context->file_closing = false;
+        if (index_path != NULL)
+        {
+            context->seek_index_path = index_path;
+        }
 
         try
         {
@@ -82,6 +87,11 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
     }
     else
     {
+        if (context)
+        {
+            context->file_closing = true;
+            stop_cluster_prefetch(context);
+        }
         if (context && context->ebml_file)
         {
             try
@@ -105,6 +115,26 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
     return result;
 }
 
+k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle)
+{
+    return playback_open(path, NULL, playback_handle);
+}
+
+k4a_result_t k4a_playback_open_with_seek_index(const char *path,
+                                               const char *index_path,
+                                               k4a_playback_t *playback_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+
+    std::string default_index_path;
+    if (index_path == NULL)
+    {
+        default_index_path = std::string(path) + ".k4aidx";
+        index_path = default_index_path.c_str();
+    }
+    return playback_open(path, index_path, playback_handle);
+}
+
 k4a_buffer_result_t k4a_playback_get_raw_calibration(k4a_playback_t playback_handle, uint8_t *data, size_t *data_size)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_playback_t, playback_handle);
@@ -263,6 +293,93 @@ k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle, k
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_playback_set_read_ahead(k4a_playback_t playback_handle, uint32_t cluster_count, uint64_t max_bytes)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cluster_count > CLUSTER_READ_AHEAD_MAX_COUNT);
+
+    context->read_ahead_count = cluster_count;
+    context->read_ahead_max_bytes = max_bytes;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_get_read_ahead_stats(k4a_playback_t playback_handle, k4a_playback_read_ahead_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    stats->cluster_hits = context->read_ahead_hits;
+    stats->cluster_stalls = context->read_ahead_stalls;
+    stats->background_loads = context->read_ahead_loads;
+    stats->background_cluster_count = (uint32_t)context->read_ahead_background_count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_cluster_cache(k4a_playback_t playback_handle, uint64_t max_bytes, bool cache_color_images)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    set_cluster_lru(context, max_bytes, cache_color_images);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_get_cluster_cache_stats(k4a_playback_t playback_handle, k4a_playback_cache_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    cluster_lru_t *lru = &context->cluster_lru;
+    stats->cluster_hits = lru->cluster_hits;
+    stats->cluster_misses = lru->cluster_misses;
+    stats->color_image_hits = lru->color_image_hits;
+    stats->evictions = lru->evictions;
+    stats->cached_clusters = lru->clusters.size();
+    stats->cached_bytes = lru->size;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_memory_mapped_io(k4a_playback_t playback_handle, bool enabled)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    return TRACE_CALL(set_file_mapping(context, enabled));
+}
+
+k4a_result_t k4a_playback_set_color_decode_threads(k4a_playback_t playback_handle,
+                                                   uint32_t thread_count,
+                                                   uint32_t frame_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > COLOR_DECODE_MAX_THREAD_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, frame_count > COLOR_DECODE_MAX_FRAME_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > 0 && frame_count < thread_count);
+
+    if (context->color_track.track == NULL)
+    {
+        LOG_ERROR("The color track is not enabled in this recording. Color decode threads cannot be started.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (thread_count == 0)
+    {
+        stop_color_decode_pipeline(context);
+        return K4A_RESULT_SUCCEEDED;
+    }
+    return TRACE_CALL(start_color_decode_pipeline(context, thread_count, frame_count));
+}
+
 k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_t playback_handle, k4a_capture_t *capture_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
@@ -380,11 +497,20 @@ void k4a_playback_close(const k4a_playback_t playback_handle)
     if (context != NULL)
     {
         LOG_TRACE("File reading stats:", 0);
-        LOG_TRACE("  Seek count: %llu", context->seek_count);
-        LOG_TRACE("  Cluster load count: %llu", context->load_count);
-        LOG_TRACE("  Cluster cache hits: %llu", context->cache_hits);
+        LOG_TRACE("  Seek count: %llu", context->seek_count.load());
+        LOG_TRACE("  Cluster load count: %llu", context->load_count.load());
+        LOG_TRACE("  Cluster load bytes: %llu", context->load_bytes.load());
+        LOG_TRACE("  Cluster cache hits: %llu", context->cache_hits.load());
+        LOG_TRACE("  Read-ahead hits: %llu", context->read_ahead_hits);
+        LOG_TRACE("  Read-ahead stalls: %llu", context->read_ahead_stalls);
+        LOG_TRACE("  Read-ahead loads: %llu", context->read_ahead_loads.load());
+        LOG_TRACE("  Cluster LRU hits: %llu", context->cluster_lru.cluster_hits);
+        LOG_TRACE("  Cluster LRU misses: %llu", context->cluster_lru.cluster_misses);
+        LOG_TRACE("  Cluster LRU evictions: %llu", context->cluster_lru.evictions);
 
         context->file_closing = true;
+        stop_cluster_prefetch(context);
+        stop_color_decode_pipeline(context);
 
         try
         {
@@ -400,6 +400,66 @@ k4a_result_t k4a_record_add_imu_track(const k4a_record_t recording_handle)
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_record_set_depth_compression(const k4a_record_t recording_handle,
+                                              k4a_record_compression_t compression,
+                                              uint32_t thread_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        compression != K4A_RECORD_COMPRESSION_NONE && compression != K4A_RECORD_COMPRESSION_LOSSLESS);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > FRAME_COMPRESSION_MAX_THREAD_COUNT);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("Depth compression must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    uint32_t depth_width = 0;
+    uint32_t depth_height = 0;
+    if (context->device_config.depth_mode != K4A_DEPTH_MODE_OFF &&
+        !k4a_convert_depth_mode_to_width_height(context->device_config.depth_mode, &depth_width, &depth_height))
+    {
+        LOG_ERROR("Unsupported depth_mode specified in recording: %d", context->device_config.depth_mode);
+        return K4A_RESULT_FAILED;
+    }
+
+    // Update the codec of the depth and IR tracks that were added by k4a_record_create()
+    std::pair<KaxTrackEntry *, k4a_image_format_t> tracks[] = { { context->depth_track, K4A_IMAGE_FORMAT_DEPTH16 },
+                                                                { context->ir_track, K4A_IMAGE_FORMAT_IR16 } };
+    for (size_t i = 0; i < arraysize(tracks); i++)
+    {
+        if (tracks[i].first != NULL)
+        {
+            BITMAPINFOHEADER codec_info = {};
+            RETURN_IF_ERROR(
+                populate_bitmap_info_header(&codec_info, depth_width, depth_height, tracks[i].second, compression));
+            GetChild<KaxCodecPrivate>(*tracks[i].first)
+                .CopyBuffer(reinterpret_cast<uint8_t *>(&codec_info), sizeof(codec_info));
+        }
+    }
+
+    context->compressor.compression = compression;
+    context->compressor.thread_count = thread_count;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_zero_copy(const k4a_record_t recording_handle, bool enabled)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    context->zero_copy = enabled;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
@@ -469,6 +529,13 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
 
     RETURN_IF_ERROR(start_matroska_writer_thread(context));
 
+    k4a_result_t result = TRACE_CALL(start_frame_compressor(context));
+    if (K4A_FAILED(result))
+    {
+        stop_matroska_writer_thread(context);
+        return result;
+    }
+
     context->header_written = true;
 
     return K4A_RESULT_SUCCEEDED;
@@ -510,7 +577,34 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
             if (image_buffer != NULL && buffer_size > 0)
             {
                 k4a_image_format_t image_format = k4a_image_get_format(images[i]);
-                if (image_format == expected_formats[i])
+                bool compressed = context->compressor.compression != K4A_RECORD_COMPRESSION_NONE &&
+                                  (image_format == K4A_IMAGE_FORMAT_DEPTH16 || image_format == K4A_IMAGE_FORMAT_IR16);
+                if (image_format == expected_formats[i] && compressed)
+                {
+                    // The compressed frame is produced by the frame compressor, which keeps its own image reference.
+                    uint64_t timestamp_ns = k4a_image_get_timestamp_usec(images[i]) * 1000;
+                    k4a_result_t tmp_result = TRACE_CALL(
+                        write_compressed_track_data(context, tracks[i], timestamp_ns, images[i]));
+                    if (K4A_FAILED(tmp_result))
+                    {
+                        // Write as many of the image buffers as possible, even if some fail due to timestamp.
+                        result = tmp_result;
+                    }
+                }
+                else if (image_format == expected_formats[i] && context->zero_copy)
+                {
+                    // The image is referenced instead of copied, 16 bit grayscale is converted to big-endian by the
+                    // writer thread when the cluster is written.
+                    uint64_t timestamp_ns = k4a_image_get_timestamp_usec(images[i]) * 1000;
+                    k4a_result_t tmp_result = TRACE_CALL(
+                        write_image_track_data(context, tracks[i], timestamp_ns, images[i]));
+                    if (K4A_FAILED(tmp_result))
+                    {
+                        // Write as many of the image buffers as possible, even if some fail due to timestamp.
+                        result = tmp_result;
+                    }
+                }
+                else if (image_format == expected_formats[i])
                 {
                     // Create a copy of the image buffer for writing to file.
                     assert(buffer_size <= UINT32_MAX);
@@ -520,11 +614,9 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
                     {
                         // 16 bit grayscale needs to be converted to big-endian in the file.
                         assert(data_buffer->Size() % sizeof(uint16_t) == 0);
-                        uint16_t *data_buffer_raw = reinterpret_cast<uint16_t *>(data_buffer->Buffer());
-                        for (size_t j = 0; j < data_buffer->Size() / sizeof(uint16_t); j++)
-                        {
-                            data_buffer_raw[j] = swap_bytes_16(data_buffer_raw[j]);
-                        }
+                        swap_bytes_16_copy(data_buffer->Buffer(),
+                                           data_buffer->Buffer(),
+                                           data_buffer->Size() / sizeof(uint16_t));
                     }
 
                     uint64_t timestamp_ns = k4a_image_get_timestamp_usec(images[i]) * 1000;
@@ -731,6 +823,7 @@ void k4a_record_close(const k4a_record_t recording_handle)
             // If these fail, there's nothing we can do but log.
             (void)TRACE_CALL(k4a_record_flush(recording_handle));
             stop_matroska_writer_thread(context);
+            stop_frame_compressor(context);
         }
 
         try
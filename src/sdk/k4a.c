@@ -47,6 +47,8 @@ typedef struct _k4a_context_t
     bool depth_started;
     bool color_started;
     bool imu_started;
+
+    size_t color_pool_block_size; // 0 if no color buffer pool is reserved
 } k4a_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_device_t, k4a_context_t);
@@ -55,6 +57,9 @@ K4A_DECLARE_CONTEXT(k4a_device_t, k4a_context_t);
 #define COLOR_CAPTURE (true)
 #define TRANSFORM_ENABLE_GPU_OPTIMIZATION (true)
 
+// Color buffers kept in the allocator pool while the color camera runs
+#define COLOR_POOL_SIZE ((uint32_t)6)
+
 uint32_t k4a_device_get_installed_count(void)
 {
     uint32_t device_count = 0;
@@ -69,6 +74,11 @@ k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *message_cb,
     return logger_register_message_callback(message_cb, message_cb_context, min_level);
 }
 
+k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t *allocate, k4a_memory_destroy_cb_t *free)
+{
+    return allocator_set_allocator(allocate, free);
+}
+
 depth_cb_streaming_capture_t depth_capture_ready;
 color_cb_streaming_capture_t color_capture_ready;
 
@@ -271,6 +281,14 @@ k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
     return TRACE_WAIT_CALL(capturesync_get_capture(device->capturesync, capture_handle, timeout_in_ms));
 }
 
+k4a_result_t k4a_device_get_capture_latency_stats(k4a_device_t device_handle, k4a_capture_latency_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_CALL(capturesync_get_latency_stats(device->capturesync, stats));
+}
+
 k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
                                             k4a_imu_sample_t *imu_sample,
                                             int32_t timeout_in_ms)
@@ -281,6 +299,20 @@ k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
     return TRACE_WAIT_CALL(imu_get_sample(device->imu, imu_sample, timeout_in_ms));
 }
 
+k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                             k4a_imu_sample_t *imu_samples,
+                                             size_t max_samples,
+                                             size_t *sample_count,
+                                             int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, max_samples == 0);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, sample_count == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_WAIT_CALL(imu_get_samples(device->imu, imu_samples, max_samples, sample_count, timeout_in_ms));
+}
+
 k4a_result_t k4a_device_start_imu(k4a_device_t device_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
@@ -350,6 +382,11 @@ float k4a_capture_get_temperature_c(k4a_capture_t capture_handle)
     return capture_get_temperature_c(capture_handle);
 }
 
+uint64_t k4a_capture_get_stage_timestamp_usec(k4a_capture_t capture_handle, k4a_capture_stage_t stage)
+{
+    return capture_get_stage_timestamp_usec(capture_handle, stage);
+}
+
 k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
 {
     return capture_get_color_image(capture_handle);
@@ -716,6 +753,37 @@ k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, k4a_device_con
         }
     }
 
+    if (K4A_SUCCEEDED(result) && config->color_resolution != K4A_COLOR_RESOLUTION_OFF)
+    {
+        // Uncompressed color frames all have the same size, so their buffers can be recycled. MJPG frames vary in size
+        // and are allocated from the heap.
+        uint32_t width = 0;
+        uint32_t height = 0;
+        k4a_convert_resolution_to_width_height(config->color_resolution, &width, &height);
+        size_t color_pixels = (size_t)width * height;
+        size_t block_size = 0;
+        switch (config->color_format)
+        {
+        case K4A_IMAGE_FORMAT_COLOR_NV12:
+            block_size = color_pixels * 3 / 2;
+            break;
+        case K4A_IMAGE_FORMAT_COLOR_YUY2:
+            block_size = color_pixels * 2;
+            break;
+        case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+            block_size = color_pixels * 4;
+            break;
+        default:
+            break;
+        }
+
+        if (block_size != 0 &&
+            K4A_SUCCEEDED(allocator_reserve_pool(ALLOCATION_SOURCE_COLOR, block_size, COLOR_POOL_SIZE)))
+        {
+            device->color_pool_block_size = block_size;
+        }
+    }
+
     if (K4A_SUCCEEDED(result))
     {
         if (config->color_resolution != K4A_COLOR_RESOLUTION_OFF)
@@ -765,6 +833,12 @@ void k4a_device_stop_cameras(k4a_device_t device_handle)
         device->color_started = false;
     }
 
+    if (device->color_pool_block_size != 0)
+    {
+        allocator_release_pool(ALLOCATION_SOURCE_COLOR, device->color_pool_block_size, COLOR_POOL_SIZE);
+        device->color_pool_block_size = 0;
+    }
+
     LOG_INFO("k4a_device_stop_cameras stopped", 0);
 }
 
@@ -938,6 +1012,93 @@ k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibration,
         calibration, source_point2d->v, source_depth_mm, source_camera, target_camera, target_point2d->v, valid));
 }
 
+k4a_result_t k4a_calibration_3d_to_3d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float3_t *source_points3d_mm,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float3_t *target_points3d_mm,
+                                            size_t point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points3d_mm == NULL || target_points3d_mm == NULL));
+    return TRACE_CALL(transformation_3d_to_3d_batch(calibration,
+                                                    (const float *)source_points3d_mm,
+                                                    source_camera,
+                                                    target_camera,
+                                                    (float *)target_points3d_mm,
+                                                    point_count));
+}
+
+k4a_result_t k4a_calibration_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float2_t *source_points2d,
+                                            const float *source_depths_mm,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float3_t *target_points3d_mm,
+                                            int *valid,
+                                            size_t point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points2d == NULL || source_depths_mm == NULL ||
+                                            target_points3d_mm == NULL || valid == NULL));
+    return TRACE_CALL(transformation_2d_to_3d_batch(calibration,
+                                                    (const float *)source_points2d,
+                                                    source_depths_mm,
+                                                    source_camera,
+                                                    target_camera,
+                                                    (float *)target_points3d_mm,
+                                                    valid,
+                                                    point_count,
+                                                    transformation_get_best_instruction_set()));
+}
+
+k4a_result_t k4a_calibration_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float3_t *source_points3d_mm,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float2_t *target_points2d,
+                                            int *valid,
+                                            size_t point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points3d_mm == NULL || target_points2d == NULL || valid == NULL));
+    return TRACE_CALL(transformation_3d_to_2d_batch(calibration,
+                                                    (const float *)source_points3d_mm,
+                                                    source_camera,
+                                                    target_camera,
+                                                    (float *)target_points2d,
+                                                    valid,
+                                                    point_count,
+                                                    transformation_get_best_instruction_set()));
+}
+
+k4a_result_t k4a_calibration_2d_to_2d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float2_t *source_points2d,
+                                            const float *source_depths_mm,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float2_t *target_points2d,
+                                            int *valid,
+                                            size_t point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points2d == NULL || source_depths_mm == NULL ||
+                                            target_points2d == NULL || valid == NULL));
+    return TRACE_CALL(transformation_2d_to_2d_batch(calibration,
+                                                    (const float *)source_points2d,
+                                                    source_depths_mm,
+                                                    source_camera,
+                                                    target_camera,
+                                                    (float *)target_points2d,
+                                                    valid,
+                                                    point_count,
+                                                    transformation_get_best_instruction_set()));
+}
+
 k4a_transformation_t k4a_transformation_create(const k4a_calibration_t *calibration)
 {
     return transformation_create(calibration, TRANSFORM_ENABLE_GPU_OPTIMIZATION);
@@ -948,6 +1109,16 @@ void k4a_transformation_destroy(k4a_transformation_t transformation_handle)
     transformation_destroy(transformation_handle);
 }
 
+k4a_result_t k4a_transformation_set_mode(k4a_transformation_t transformation_handle, k4a_transformation_mode_t mode)
+{
+    return TRACE_CALL(transformation_set_mode(transformation_handle, mode));
+}
+
+k4a_result_t k4a_transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count)
+{
+    return TRACE_CALL(transformation_set_thread_count(transformation_handle, thread_count));
+}
+
 static k4a_transformation_image_descriptor_t k4a_image_get_descriptor(const k4a_image_t image)
 {
     k4a_transformation_image_descriptor_t descriptor;
@@ -1026,6 +1197,78 @@ k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transformation_t
                                                                 &xyz_image_descriptor));
 }
 
+k4a_result_t k4a_transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                                   const k4a_image_t depth_image,
+                                                                   const k4a_image_t color_image,
+                                                                   const k4a_colored_point_format_t point_format,
+                                                                   bool skip_invalid_points,
+                                                                   k4a_image_t point_cloud_image,
+                                                                   size_t *point_count)
+{
+    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
+    k4a_transformation_image_descriptor_t color_image_descriptor = k4a_image_get_descriptor(color_image);
+    k4a_transformation_image_descriptor_t point_cloud_image_descriptor = k4a_image_get_descriptor(point_cloud_image);
+
+    if (k4a_image_get_format(color_image) != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        LOG_ERROR("Require color image to have bgra32 format.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
+    uint8_t *color_image_buffer = k4a_image_get_buffer(color_image);
+    uint8_t *point_cloud_image_buffer = k4a_image_get_buffer(point_cloud_image);
+
+    return TRACE_CALL(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                        depth_image_buffer,
+                                                                        &depth_image_descriptor,
+                                                                        color_image_buffer,
+                                                                        &color_image_descriptor,
+                                                                        point_format,
+                                                                        skip_invalid_points,
+                                                                        point_cloud_image_buffer,
+                                                                        &point_cloud_image_descriptor,
+                                                                        point_count));
+}
+
+k4a_result_t k4a_transformation_depth_image_to_formatted_point_cloud(k4a_transformation_t transformation_handle,
+                                                                     const k4a_image_t depth_image,
+                                                                     const k4a_calibration_type_t camera,
+                                                                     const k4a_point_cloud_format_t point_format,
+                                                                     bool skip_invalid_points,
+                                                                     k4a_image_t point_cloud_image,
+                                                                     k4a_image_t pixel_index_image,
+                                                                     size_t *point_count)
+{
+    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
+    k4a_transformation_image_descriptor_t point_cloud_image_descriptor = k4a_image_get_descriptor(point_cloud_image);
+
+    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
+    uint8_t *point_cloud_image_buffer = k4a_image_get_buffer(point_cloud_image);
+
+    // The pixel index image is optional
+    k4a_transformation_image_descriptor_t pixel_index_image_descriptor = { 0, 0, 0 };
+    uint8_t *pixel_index_image_buffer = NULL;
+    if (pixel_index_image != NULL)
+    {
+        pixel_index_image_descriptor = k4a_image_get_descriptor(pixel_index_image);
+        pixel_index_image_buffer = k4a_image_get_buffer(pixel_index_image);
+    }
+
+    return TRACE_CALL(transformation_depth_image_to_formatted_point_cloud(
+        transformation_handle,
+        depth_image_buffer,
+        &depth_image_descriptor,
+        camera,
+        point_format,
+        skip_invalid_points,
+        point_cloud_image_buffer,
+        &point_cloud_image_descriptor,
+        pixel_index_image_buffer,
+        pixel_index_image != NULL ? &pixel_index_image_descriptor : NULL,
+        point_count));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "transformation_priv.h"
+
+#if defined(K4A_TRANSFORMATION_ENABLE_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+#ifdef _MSC_VER
+// XCR0 bits the OS must set before AVX (XMM|YMM) and AVX-512 (XMM|YMM|opmask|ZMM) state may be used
+#define XCR0_AVX_STATE 0x06
+#define XCR0_AVX512_STATE 0xE6
+
+static bool transformation_cpu_os_supports_state(unsigned long long xcr0_mask)
+{
+    int info[4];
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0) // OSXSAVE
+    {
+        return false;
+    }
+    return (_xgetbv(0) & xcr0_mask) == xcr0_mask;
+}
+
+static bool transformation_cpu_supports(k4a_transformation_instruction_set_t instruction_set)
+{
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    switch (instruction_set)
+    {
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        if (max_leaf < 7)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0 && transformation_cpu_os_supports_state(XCR0_AVX_STATE);
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        if (max_leaf < 7)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 16)) != 0 && transformation_cpu_os_supports_state(XCR0_AVX512_STATE);
+    default:
+        return false;
+    }
+}
+#else
+static bool transformation_cpu_supports(k4a_transformation_instruction_set_t instruction_set)
+{
+    // The GCC/Clang builtins also verify that the OS saves the extended register state
+    __builtin_cpu_init();
+    switch (instruction_set)
+    {
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return __builtin_cpu_supports("sse4.1") != 0;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return __builtin_cpu_supports("avx2") != 0;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return __builtin_cpu_supports("avx512f") != 0;
+    default:
+        return false;
+    }
+}
+#endif
+#endif // K4A_TRANSFORMATION_ENABLE_X86_SIMD
+
+bool transformation_instruction_set_supported(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
+    {
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR:
+        return true;
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_cpu_supports(instruction_set);
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+k4a_transformation_instruction_set_t transformation_get_best_instruction_set(void)
+{
+    for (int i = K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT - 1; i > K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR; i--)
+    {
+        if (transformation_instruction_set_supported((k4a_transformation_instruction_set_t)i))
+        {
+            return (k4a_transformation_instruction_set_t)i;
+        }
+    }
+    return K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR;
+}
+
+const char *transformation_instruction_set_name(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
+    {
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR:
+        return "scalar";
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return "sse4.1";
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return "avx2";
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return "avx512";
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+uint32_t transformation_get_processor_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    long count = (long)system_info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (uint32_t)count : 1;
+}
@@ -4,13 +4,15 @@
 #include <k4ainternal/transformation.h>
 #include <k4ainternal/logging.h>
 
+#include "transformation_priv.h"
+
 #include <float.h>
+#include <string.h>
 
-static k4a_result_t transformation_project_internal(const k4a_calibration_camera_t *camera_calibration,
-                                                    const float xy[2],
-                                                    float uv[2],
-                                                    int *valid,
-                                                    float J_xy[2 * 2])
+// Maximum number of Newton iterations used to invert the lens distortion model
+#define TRANSFORMATION_UNPROJECT_MAX_PASSES 20
+
+static k4a_result_t transformation_check_intrinsics(const k4a_calibration_camera_t *camera_calibration)
 {
     if (K4A_FAILED(K4A_RESULT_FROM_BOOL(
             (camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT ||
@@ -32,6 +34,30 @@ static k4a_result_t transformation_project_internal(const k4a_calibration_camera
         return K4A_RESULT_FAILED;
     }
 
+    float fx = camera_calibration->intrinsics.parameters.param.fx;
+    float fy = camera_calibration->intrinsics.parameters.param.fy;
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(fx > 0.f && fy > 0.f)))
+    {
+        LOG_ERROR("Expect both fx and fy are larger than 0, actual values are fx: %lf, fy: %lf.",
+                  (double)fx,
+                  (double)fy);
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t transformation_project_internal(const k4a_calibration_camera_t *camera_calibration,
+                                                    const float xy[2],
+                                                    float uv[2],
+                                                    int *valid,
+                                                    float J_xy[2 * 2])
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_check_intrinsics(camera_calibration))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
     const k4a_calibration_intrinsic_parameters_t *params = &camera_calibration->intrinsics.parameters;
 
     float cx = params->param.cx;
@@ -50,14 +76,6 @@ static k4a_result_t transformation_project_internal(const k4a_calibration_camera
     float p2 = params->param.p2;
     float max_radius_for_projection = camera_calibration->metric_radius;
 
-    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(fx > 0.f && fy > 0.f)))
-    {
-        LOG_ERROR("Expect both fx and fy are larger than 0, actual values are fx: %lf, fy: %lf.",
-                  (double)fx,
-                  (double)fy);
-        return K4A_RESULT_FAILED;
-    }
-
     *valid = 1;
 
     float xp = xy[0] - codx;
@@ -216,55 +234,49 @@ static k4a_result_t transformation_iterative_unproject(const k4a_calibration_cam
     return K4A_RESULT_SUCCEEDED;
 }
 
-static k4a_result_t transformation_unproject_internal(const k4a_calibration_camera_t *camera_calibration,
-                                                      const float uv[2],
-                                                      float xy[2],
-                                                      int *valid)
+static void transformation_get_projection_params(const k4a_calibration_camera_t *camera_calibration,
+                                                 k4a_transformation_projection_params_t *projection_params)
 {
-    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(
-            (camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT ||
-             camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY) &&
-            camera_calibration->intrinsics.parameter_count >= 14)))
-    {
-        LOG_ERROR("Unexpected camera calibration model type %d, should either be "
-                  "K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT (%d) or "
-                  "K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY (%d).",
-                  camera_calibration->intrinsics.type,
-                  K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT,
-                  K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY);
-        if (camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY)
-        {
-            LOG_ERROR("Unexpected parameter count %d, should be %d.",
-                      camera_calibration->intrinsics.parameter_count,
-                      14);
-        }
-        return K4A_RESULT_FAILED;
-    }
-
     const k4a_calibration_intrinsic_parameters_t *params = &camera_calibration->intrinsics.parameters;
 
-    float cx = params->param.cx;
-    float cy = params->param.cy;
-    float fx = params->param.fx;
-    float fy = params->param.fy;
-    float k1 = params->param.k1;
-    float k2 = params->param.k2;
-    float k3 = params->param.k3;
-    float k4 = params->param.k4;
-    float k5 = params->param.k5;
-    float k6 = params->param.k6;
-    float codx = params->param.codx; // center of distortion is set to 0 for Brown Conrady model
-    float cody = params->param.cody;
-    float p1 = params->param.p1;
-    float p2 = params->param.p2;
+    projection_params->cx = params->param.cx;
+    projection_params->cy = params->param.cy;
+    projection_params->fx = params->param.fx;
+    projection_params->fy = params->param.fy;
+    projection_params->k1 = params->param.k1;
+    projection_params->k2 = params->param.k2;
+    projection_params->k3 = params->param.k3;
+    projection_params->k4 = params->param.k4;
+    projection_params->k5 = params->param.k5;
+    projection_params->k6 = params->param.k6;
+    projection_params->codx = params->param.codx; // center of distortion is set to 0 for Brown Conrady model
+    projection_params->cody = params->param.cody;
+    projection_params->p1 = params->param.p1;
+    projection_params->p2 = params->param.p2;
+    projection_params->tangential_scale =
+        camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT ? 1.f : 2.f;
+    projection_params->max_radius_squared = camera_calibration->metric_radius * camera_calibration->metric_radius;
+}
 
-    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(fx > 0.f && fy > 0.f)))
-    {
-        LOG_ERROR("Expect both fx and fy are larger than 0, actual values are fx: %lf, fy: %lf.",
-                  (double)fx,
-                  (double)fy);
-        return K4A_RESULT_FAILED;
-    }
+// Computes the starting point of the iterative unprojection of pixel uv
+static void transformation_unproject_initial_guess(const k4a_transformation_projection_params_t *params,
+                                                   const float uv[2],
+                                                   float xy[2])
+{
+    float cx = params->cx;
+    float cy = params->cy;
+    float fx = params->fx;
+    float fy = params->fy;
+    float k1 = params->k1;
+    float k2 = params->k2;
+    float k3 = params->k3;
+    float k4 = params->k4;
+    float k5 = params->k5;
+    float k6 = params->k6;
+    float codx = params->codx;
+    float cody = params->cody;
+    float p1 = params->p1;
+    float p2 = params->p2;
 
     // correction for radial distortion
     float xp_d = (uv[0] - cx) / fx - codx;
@@ -300,8 +312,23 @@ static k4a_result_t transformation_unproject_internal(const k4a_calibration_came
     // add on center of distortion
     xy[0] += codx;
     xy[1] += cody;
+}
+
+static k4a_result_t transformation_unproject_internal(const k4a_calibration_camera_t *camera_calibration,
+                                                      const float uv[2],
+                                                      float xy[2],
+                                                      int *valid)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_check_intrinsics(camera_calibration))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_projection_params_t params;
+    transformation_get_projection_params(camera_calibration, &params);
+    transformation_unproject_initial_guess(&params, uv, xy);
 
-    return transformation_iterative_unproject(camera_calibration, uv, xy, valid, 20);
+    return transformation_iterative_unproject(camera_calibration, uv, xy, valid, TRANSFORMATION_UNPROJECT_MAX_PASSES);
 }
 
 k4a_result_t transformation_unproject(const k4a_calibration_camera_t *camera_calibration,
@@ -355,3 +382,314 @@ k4a_result_t transformation_project(const k4a_calibration_camera_t *camera_calib
 
     return K4A_RESULT_SUCCEEDED;
 }
+
+void transformation_project_scalar(const k4a_transformation_projection_params_t *params,
+                                   const float *x,
+                                   const float *y,
+                                   float *u,
+                                   float *v,
+                                   float *jacobian,
+                                   int *valid,
+                                   int count)
+{
+    float cx = params->cx;
+    float cy = params->cy;
+    float fx = params->fx;
+    float fy = params->fy;
+    float k1 = params->k1;
+    float k2 = params->k2;
+    float k3 = params->k3;
+    float k4 = params->k4;
+    float k5 = params->k5;
+    float k6 = params->k6;
+    float codx = params->codx;
+    float cody = params->cody;
+    float p1 = params->p1;
+    float p2 = params->p2;
+    float t = params->tangential_scale;
+    float max_radius_squared = params->max_radius_squared;
+
+    // Same operations in the same order as transformation_project_internal(). Multiplying by a tangential scale of 1
+    // is exact, so one formula covers both lens models.
+    for (int i = 0; i < count; i++)
+    {
+        float xp = x[i] - codx;
+        float yp = y[i] - cody;
+
+        float xp2 = xp * xp;
+        float yp2 = yp * yp;
+        float xyp = xp * yp;
+        float rs = xp2 + yp2;
+        valid[i] = rs > max_radius_squared ? 0 : 1;
+
+        float rss = rs * rs;
+        float rsc = rss * rs;
+        float a = 1.f + k1 * rs + k2 * rss + k3 * rsc;
+        float b = 1.f + k4 * rs + k5 * rss + k6 * rsc;
+        float bi = b != 0.f ? 1.f / b : 1.f;
+        float d = a * bi;
+
+        float xp_d = xp * d;
+        float yp_d = yp * d;
+
+        float rs_2xp2 = rs + 2.f * xp2;
+        float rs_2yp2 = rs + 2.f * yp2;
+
+        float t_xyp = t * xyp;
+        xp_d += rs_2xp2 * p2 + t_xyp * p1;
+        yp_d += rs_2yp2 * p1 + t_xyp * p2;
+
+        u[i] = (xp_d + codx) * fx + cx;
+        v[i] = (yp_d + cody) * fy + cy;
+
+        if (jacobian == NULL)
+        {
+            continue;
+        }
+
+        float dudrs = k1 + 2.f * k2 * rs + 3.f * k3 * rss;
+        float dvdrs = k4 + 2.f * k5 * rs + 3.f * k6 * rss;
+        float bis = bi * bi;
+        float dddrs = (dudrs * b - a * dvdrs) * bis;
+
+        float dddrs_2 = dddrs * 2.f;
+        float xp_dddrs_2 = xp * dddrs_2;
+        float yp_xp_dddrs_2 = yp * xp_dddrs_2;
+        float t_xp = t * xp;
+        float t_yp = t * yp;
+
+        jacobian[i] = fx * (d + xp * xp_dddrs_2 + 6.f * xp * p2 + t_yp * p1);
+        jacobian[count + i] = fx * (yp_xp_dddrs_2 + 2.f * yp * p2 + t_xp * p1);
+        jacobian[2 * count + i] = fy * (yp_xp_dddrs_2 + 2.f * xp * p1 + t_yp * p2);
+        jacobian[3 * count + i] = fy * (d + yp * yp * dddrs_2 + 6.f * yp * p1 + t_xp * p2);
+    }
+}
+
+static transformation_project_fn_t *
+transformation_get_project_kernel(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return transformation_project_sse41;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return transformation_project_avx2;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_project_avx512;
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return transformation_project_neon;
+#endif
+    default:
+        return transformation_project_scalar;
+    }
+}
+
+static k4a_result_t transformation_check_batch(const k4a_calibration_camera_t *camera_calibration,
+                                               k4a_transformation_instruction_set_t instruction_set)
+{
+    if (!transformation_instruction_set_supported(instruction_set))
+    {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
+        return K4A_RESULT_FAILED;
+    }
+    return TRACE_CALL(transformation_check_intrinsics(camera_calibration));
+}
+
+k4a_result_t transformation_project_batch(const k4a_calibration_camera_t *camera_calibration,
+                                          const k4a_calibration_extrinsics_t *source_to_camera,
+                                          const float *points3d,
+                                          float *points2d,
+                                          int *valid,
+                                          size_t point_count,
+                                          k4a_transformation_instruction_set_t instruction_set)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_check_batch(camera_calibration, instruction_set))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_projection_params_t params;
+    transformation_get_projection_params(camera_calibration, &params);
+    transformation_project_fn_t *project = transformation_get_project_kernel(instruction_set);
+
+    float x[TRANSFORMATION_BATCH_BLOCK_SIZE], y[TRANSFORMATION_BATCH_BLOCK_SIZE], z[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float u[TRANSFORMATION_BATCH_BLOCK_SIZE], v[TRANSFORMATION_BATCH_BLOCK_SIZE];
+
+    for (size_t begin = 0; begin < point_count; begin += TRANSFORMATION_BATCH_BLOCK_SIZE)
+    {
+        size_t remaining = point_count - begin;
+        int count = remaining < TRANSFORMATION_BATCH_BLOCK_SIZE ? (int)remaining : TRANSFORMATION_BATCH_BLOCK_SIZE;
+        const float *block_points3d = points3d + 3 * begin;
+        float *block_points2d = points2d + 2 * begin;
+        int *block_valid = valid + begin;
+
+        for (int i = 0; i < count; i++)
+        {
+            float point3d[3];
+            if (source_to_camera != NULL)
+            {
+                transformation_apply_extrinsic_transformation(source_to_camera, block_points3d + 3 * i, point3d);
+            }
+            else
+            {
+                memcpy(point3d, block_points3d + 3 * i, sizeof(point3d));
+            }
+
+            z[i] = point3d[2];
+            x[i] = z[i] > 0.f ? point3d[0] / point3d[2] : 0.f;
+            y[i] = z[i] > 0.f ? point3d[1] / point3d[2] : 0.f;
+        }
+
+        project(&params, x, y, u, v, NULL, block_valid, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (z[i] <= 0.f)
+            {
+                block_points2d[2 * i] = 0.f;
+                block_points2d[2 * i + 1] = 0.f;
+                block_valid[i] = 0;
+            }
+            else
+            {
+                block_points2d[2 * i] = u[i];
+                block_points2d[2 * i + 1] = v[i];
+            }
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Runs transformation_unproject() on a block of points. Every pass projects all points that are still iterating with
+// one kernel call; their Newton state is kept packed at the front of the work arrays.
+static void transformation_unproject_block(const k4a_transformation_projection_params_t *params,
+                                           transformation_project_fn_t *project,
+                                           const float *points2d,
+                                           const float *depths,
+                                           float *points3d,
+                                           int *valid,
+                                           int count)
+{
+    int index[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float x[TRANSFORMATION_BATCH_BLOCK_SIZE], y[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float best_x[TRANSFORMATION_BATCH_BLOCK_SIZE], best_y[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float best_err[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float u[TRANSFORMATION_BATCH_BLOCK_SIZE], v[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float jacobian[4 * TRANSFORMATION_BATCH_BLOCK_SIZE];
+    int projection_valid[TRANSFORMATION_BATCH_BLOCK_SIZE];
+
+    int active_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (depths[i] == 0.f)
+        {
+            points3d[3 * i] = 0.f;
+            points3d[3 * i + 1] = 0.f;
+            points3d[3 * i + 2] = 0.f;
+            valid[i] = 0;
+            continue;
+        }
+
+        float xy[2];
+        transformation_unproject_initial_guess(params, points2d + 2 * i, xy);
+        index[active_count] = i;
+        x[active_count] = xy[0];
+        y[active_count] = xy[1];
+        best_x[active_count] = 0.f;
+        best_y[active_count] = 0.f;
+        best_err[active_count] = FLT_MAX;
+        active_count++;
+    }
+
+    for (unsigned int pass = 0; pass < TRANSFORMATION_UNPROJECT_MAX_PASSES && active_count > 0; pass++)
+    {
+        project(params, x, y, u, v, jacobian, projection_valid, active_count);
+
+        int next = 0;
+        for (int k = 0; k < active_count; k++)
+        {
+            int i = index[k];
+            float depth = depths[i];
+            float *point3d = points3d + 3 * i;
+            point3d[2] = depth;
+
+            if (projection_valid[k] == 0)
+            {
+                point3d[0] = x[k] * depth;
+                point3d[1] = y[k] * depth;
+                valid[i] = 0;
+                continue;
+            }
+
+            float err_x = points2d[2 * i] - u[k];
+            float err_y = points2d[2 * i + 1] - v[k];
+            float err = err_x * err_x + err_y * err_y;
+            if (err >= best_err[k])
+            {
+                point3d[0] = best_x[k] * depth;
+                point3d[1] = best_y[k] * depth;
+                valid[i] = best_err[k] > 1e-6f ? 0 : 1;
+                continue;
+            }
+
+            if (pass + 1 == TRANSFORMATION_UNPROJECT_MAX_PASSES || err < 1e-22f)
+            {
+                point3d[0] = x[k] * depth;
+                point3d[1] = y[k] * depth;
+                valid[i] = err > 1e-6f ? 0 : 1;
+                continue;
+            }
+
+            float J[2 * 2] = { jacobian[k],
+                               jacobian[active_count + k],
+                               jacobian[2 * active_count + k],
+                               jacobian[3 * active_count + k] };
+            float Jinv[2 * 2];
+            invert_2x2(J, Jinv);
+
+            float dx = Jinv[0] * err_x + Jinv[1] * err_y;
+            float dy = Jinv[2] * err_x + Jinv[3] * err_y;
+
+            index[next] = i;
+            best_x[next] = x[k];
+            best_y[next] = y[k];
+            best_err[next] = err;
+            x[next] = x[k] + dx;
+            y[next] = y[k] + dy;
+            next++;
+        }
+        active_count = next;
+    }
+}
+
+k4a_result_t transformation_unproject_batch(const k4a_calibration_camera_t *camera_calibration,
+                                            const float *points2d,
+                                            const float *depths,
+                                            float *points3d,
+                                            int *valid,
+                                            size_t point_count,
+                                            k4a_transformation_instruction_set_t instruction_set)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_check_batch(camera_calibration, instruction_set))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_projection_params_t params;
+    transformation_get_projection_params(camera_calibration, &params);
+    transformation_project_fn_t *project = transformation_get_project_kernel(instruction_set);
+
+    for (size_t begin = 0; begin < point_count; begin += TRANSFORMATION_BATCH_BLOCK_SIZE)
+    {
+        size_t remaining = point_count - begin;
+        int count = remaining < TRANSFORMATION_BATCH_BLOCK_SIZE ? (int)remaining : TRANSFORMATION_BATCH_BLOCK_SIZE;
+        transformation_unproject_block(
+            &params, project, points2d + 2 * begin, depths + begin, points3d + 3 * begin, valid + begin, count);
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
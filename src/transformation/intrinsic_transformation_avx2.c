@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with AVX2 code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2).
+
+#include "transformation_priv.h"
+
+#include <immintrin.h> // AVX2
+#include <string.h>
+
+typedef struct
+{
+    __m256 cx, cy, fx, fy;
+    __m256 k1, k2, k3, k4, k5, k6;
+    __m256 codx, cody, p1, p2;
+    __m256 t, max_radius_squared;
+} transformation_projection_params_avx2_t;
+
+// Projects 8 points, doing the same operations in the same order as transformation_project_scalar()
+static inline void transformation_project_8_avx2(const transformation_projection_params_avx2_t *p,
+                                                 const float *x,
+                                                 const float *y,
+                                                 float *u,
+                                                 float *v,
+                                                 float *jacobian,
+                                                 int jacobian_stride,
+                                                 int *valid)
+{
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+    const __m256 three = _mm256_set1_ps(3.f);
+    const __m256 six = _mm256_set1_ps(6.f);
+
+    __m256 xp = _mm256_sub_ps(_mm256_loadu_ps(x), p->codx);
+    __m256 yp = _mm256_sub_ps(_mm256_loadu_ps(y), p->cody);
+
+    __m256 xp2 = _mm256_mul_ps(xp, xp);
+    __m256 yp2 = _mm256_mul_ps(yp, yp);
+    __m256 xyp = _mm256_mul_ps(xp, yp);
+    __m256 rs = _mm256_add_ps(xp2, yp2);
+
+    // Not greater than, so that a NAN radius counts as valid like in the scalar kernel
+    __m256i in_range = _mm256_castps_si256(_mm256_cmp_ps(rs, p->max_radius_squared, _CMP_NGT_UQ));
+    in_range = _mm256_and_si256(in_range, _mm256_set1_epi32(1));
+    _mm256_storeu_si256((__m256i *)(void *)valid, in_range);
+
+    __m256 rss = _mm256_mul_ps(rs, rs);
+    __m256 rsc = _mm256_mul_ps(rss, rs);
+    __m256 a = _mm256_add_ps(one, _mm256_mul_ps(p->k1, rs));
+    __m256 b = _mm256_add_ps(one, _mm256_mul_ps(p->k4, rs));
+    a = _mm256_add_ps(_mm256_add_ps(a, _mm256_mul_ps(p->k2, rss)), _mm256_mul_ps(p->k3, rsc));
+    b = _mm256_add_ps(_mm256_add_ps(b, _mm256_mul_ps(p->k5, rss)), _mm256_mul_ps(p->k6, rsc));
+    __m256 b_is_zero = _mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    __m256 bi = _mm256_blendv_ps(_mm256_div_ps(one, b), one, b_is_zero);
+    __m256 d = _mm256_mul_ps(a, bi);
+
+    __m256 xp_d = _mm256_mul_ps(xp, d);
+    __m256 yp_d = _mm256_mul_ps(yp, d);
+
+    __m256 rs_2xp2 = _mm256_add_ps(rs, _mm256_mul_ps(two, xp2));
+    __m256 rs_2yp2 = _mm256_add_ps(rs, _mm256_mul_ps(two, yp2));
+
+    __m256 t_xyp = _mm256_mul_ps(p->t, xyp);
+    __m256 x_tangential = _mm256_add_ps(_mm256_mul_ps(rs_2xp2, p->p2), _mm256_mul_ps(t_xyp, p->p1));
+    __m256 y_tangential = _mm256_add_ps(_mm256_mul_ps(rs_2yp2, p->p1), _mm256_mul_ps(t_xyp, p->p2));
+    xp_d = _mm256_add_ps(xp_d, x_tangential);
+    yp_d = _mm256_add_ps(yp_d, y_tangential);
+
+    __m256 xp_d_cx = _mm256_add_ps(xp_d, p->codx);
+    __m256 yp_d_cy = _mm256_add_ps(yp_d, p->cody);
+    _mm256_storeu_ps(u, _mm256_add_ps(_mm256_mul_ps(xp_d_cx, p->fx), p->cx));
+    _mm256_storeu_ps(v, _mm256_add_ps(_mm256_mul_ps(yp_d_cy, p->fy), p->cy));
+
+    if (jacobian == NULL)
+    {
+        return;
+    }
+
+    __m256 dudrs = _mm256_add_ps(p->k1, _mm256_mul_ps(_mm256_mul_ps(two, p->k2), rs));
+    __m256 dvdrs = _mm256_add_ps(p->k4, _mm256_mul_ps(_mm256_mul_ps(two, p->k5), rs));
+    dudrs = _mm256_add_ps(dudrs, _mm256_mul_ps(_mm256_mul_ps(three, p->k3), rss));
+    dvdrs = _mm256_add_ps(dvdrs, _mm256_mul_ps(_mm256_mul_ps(three, p->k6), rss));
+    __m256 bis = _mm256_mul_ps(bi, bi);
+    __m256 dddrs = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(dudrs, b), _mm256_mul_ps(a, dvdrs)), bis);
+
+    __m256 dddrs_2 = _mm256_mul_ps(dddrs, two);
+    __m256 xp_dddrs_2 = _mm256_mul_ps(xp, dddrs_2);
+    __m256 yp_xp_dddrs_2 = _mm256_mul_ps(yp, xp_dddrs_2);
+    __m256 t_xp = _mm256_mul_ps(p->t, xp);
+    __m256 t_yp = _mm256_mul_ps(p->t, yp);
+
+    // Accumulate each derivative term by term in the order the scalar kernel adds them
+    __m256 j0 = _mm256_add_ps(d, _mm256_mul_ps(xp, xp_dddrs_2));
+    __m256 j1 = _mm256_add_ps(yp_xp_dddrs_2, _mm256_mul_ps(_mm256_mul_ps(two, yp), p->p2));
+    __m256 j2 = _mm256_add_ps(yp_xp_dddrs_2, _mm256_mul_ps(_mm256_mul_ps(two, xp), p->p1));
+    __m256 j3 = _mm256_add_ps(d, _mm256_mul_ps(yp2, dddrs_2));
+    j0 = _mm256_add_ps(j0, _mm256_mul_ps(_mm256_mul_ps(six, xp), p->p2));
+    j3 = _mm256_add_ps(j3, _mm256_mul_ps(_mm256_mul_ps(six, yp), p->p1));
+    j0 = _mm256_add_ps(j0, _mm256_mul_ps(t_yp, p->p1));
+    j1 = _mm256_add_ps(j1, _mm256_mul_ps(t_xp, p->p1));
+    j2 = _mm256_add_ps(j2, _mm256_mul_ps(t_yp, p->p2));
+    j3 = _mm256_add_ps(j3, _mm256_mul_ps(t_xp, p->p2));
+
+    _mm256_storeu_ps(jacobian, _mm256_mul_ps(p->fx, j0));
+    _mm256_storeu_ps(jacobian + jacobian_stride, _mm256_mul_ps(p->fx, j1));
+    _mm256_storeu_ps(jacobian + 2 * jacobian_stride, _mm256_mul_ps(p->fy, j2));
+    _mm256_storeu_ps(jacobian + 3 * jacobian_stride, _mm256_mul_ps(p->fy, j3));
+}
+
+void transformation_project_avx2(const k4a_transformation_projection_params_t *params,
+                                 const float *x,
+                                 const float *y,
+                                 float *u,
+                                 float *v,
+                                 float *jacobian,
+                                 int *valid,
+                                 int count)
+{
+    transformation_projection_params_avx2_t p;
+    p.cx = _mm256_set1_ps(params->cx);
+    p.cy = _mm256_set1_ps(params->cy);
+    p.fx = _mm256_set1_ps(params->fx);
+    p.fy = _mm256_set1_ps(params->fy);
+    p.k1 = _mm256_set1_ps(params->k1);
+    p.k2 = _mm256_set1_ps(params->k2);
+    p.k3 = _mm256_set1_ps(params->k3);
+    p.k4 = _mm256_set1_ps(params->k4);
+    p.k5 = _mm256_set1_ps(params->k5);
+    p.k6 = _mm256_set1_ps(params->k6);
+    p.codx = _mm256_set1_ps(params->codx);
+    p.cody = _mm256_set1_ps(params->cody);
+    p.p1 = _mm256_set1_ps(params->p1);
+    p.p2 = _mm256_set1_ps(params->p2);
+    p.t = _mm256_set1_ps(params->tangential_scale);
+    p.max_radius_squared = _mm256_set1_ps(params->max_radius_squared);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        float *jacobian_i = jacobian != NULL ? jacobian + i : NULL;
+        transformation_project_8_avx2(&p, x + i, y + i, u + i, v + i, jacobian_i, count, valid + i);
+    }
+
+    if (i < count)
+    {
+        // Run the last partial vector on zero padded copies
+        int tail = count - i;
+        float x_tail[8] = { 0.f }, y_tail[8] = { 0.f }, u_tail[8], v_tail[8], jacobian_tail[4 * 8];
+        int valid_tail[8];
+        memcpy(x_tail, x + i, (size_t)tail * sizeof(float));
+        memcpy(y_tail, y + i, (size_t)tail * sizeof(float));
+
+        float *jacobian_i = jacobian != NULL ? jacobian_tail : NULL;
+        transformation_project_8_avx2(&p, x_tail, y_tail, u_tail, v_tail, jacobian_i, 8, valid_tail);
+
+        memcpy(u + i, u_tail, (size_t)tail * sizeof(float));
+        memcpy(v + i, v_tail, (size_t)tail * sizeof(float));
+        memcpy(valid + i, valid_tail, (size_t)tail * sizeof(int));
+        if (jacobian != NULL)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                memcpy(jacobian + row * count + i, jacobian_tail + row * 8, (size_t)tail * sizeof(float));
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with AVX-512F code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512).
+
+#include "transformation_priv.h"
+
+#include <immintrin.h> // AVX-512F
+
+typedef struct
+{
+    __m512 cx, cy, fx, fy;
+    __m512 k1, k2, k3, k4, k5, k6;
+    __m512 codx, cody, p1, p2;
+    __m512 t, max_radius_squared;
+} transformation_projection_params_avx512_t;
+
+// Projects the up to 16 points selected by mask, doing the same operations in the same order as
+// transformation_project_scalar()
+static inline void transformation_project_16_avx512(const transformation_projection_params_avx512_t *p,
+                                                    const float *x,
+                                                    const float *y,
+                                                    float *u,
+                                                    float *v,
+                                                    float *jacobian,
+                                                    int jacobian_stride,
+                                                    int *valid,
+                                                    __mmask16 mask)
+{
+    const __m512 one = _mm512_set1_ps(1.f);
+    const __m512 two = _mm512_set1_ps(2.f);
+    const __m512 three = _mm512_set1_ps(3.f);
+    const __m512 six = _mm512_set1_ps(6.f);
+
+    __m512 xp = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, x), p->codx);
+    __m512 yp = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, y), p->cody);
+
+    __m512 xp2 = _mm512_mul_ps(xp, xp);
+    __m512 yp2 = _mm512_mul_ps(yp, yp);
+    __m512 xyp = _mm512_mul_ps(xp, yp);
+    __m512 rs = _mm512_add_ps(xp2, yp2);
+
+    // Not greater than, so that a NAN radius counts as valid like in the scalar kernel
+    __mmask16 in_range = _mm512_cmp_ps_mask(rs, p->max_radius_squared, _CMP_NGT_UQ);
+    _mm512_mask_storeu_epi32(valid, mask, _mm512_maskz_mov_epi32(in_range, _mm512_set1_epi32(1)));
+
+    __m512 rss = _mm512_mul_ps(rs, rs);
+    __m512 rsc = _mm512_mul_ps(rss, rs);
+    __m512 a = _mm512_add_ps(one, _mm512_mul_ps(p->k1, rs));
+    __m512 b = _mm512_add_ps(one, _mm512_mul_ps(p->k4, rs));
+    a = _mm512_add_ps(_mm512_add_ps(a, _mm512_mul_ps(p->k2, rss)), _mm512_mul_ps(p->k3, rsc));
+    b = _mm512_add_ps(_mm512_add_ps(b, _mm512_mul_ps(p->k5, rss)), _mm512_mul_ps(p->k6, rsc));
+    __mmask16 b_is_zero = _mm512_cmp_ps_mask(b, _mm512_setzero_ps(), _CMP_EQ_OQ);
+    __m512 bi = _mm512_mask_blend_ps(b_is_zero, _mm512_div_ps(one, b), one);
+    __m512 d = _mm512_mul_ps(a, bi);
+
+    __m512 xp_d = _mm512_mul_ps(xp, d);
+    __m512 yp_d = _mm512_mul_ps(yp, d);
+
+    __m512 rs_2xp2 = _mm512_add_ps(rs, _mm512_mul_ps(two, xp2));
+    __m512 rs_2yp2 = _mm512_add_ps(rs, _mm512_mul_ps(two, yp2));
+
+    __m512 t_xyp = _mm512_mul_ps(p->t, xyp);
+    __m512 x_tangential = _mm512_add_ps(_mm512_mul_ps(rs_2xp2, p->p2), _mm512_mul_ps(t_xyp, p->p1));
+    __m512 y_tangential = _mm512_add_ps(_mm512_mul_ps(rs_2yp2, p->p1), _mm512_mul_ps(t_xyp, p->p2));
+    xp_d = _mm512_add_ps(xp_d, x_tangential);
+    yp_d = _mm512_add_ps(yp_d, y_tangential);
+
+    __m512 xp_d_cx = _mm512_add_ps(xp_d, p->codx);
+    __m512 yp_d_cy = _mm512_add_ps(yp_d, p->cody);
+    _mm512_mask_storeu_ps(u, mask, _mm512_add_ps(_mm512_mul_ps(xp_d_cx, p->fx), p->cx));
+    _mm512_mask_storeu_ps(v, mask, _mm512_add_ps(_mm512_mul_ps(yp_d_cy, p->fy), p->cy));
+
+    if (jacobian == NULL)
+    {
+        return;
+    }
+
+    __m512 dudrs = _mm512_add_ps(p->k1, _mm512_mul_ps(_mm512_mul_ps(two, p->k2), rs));
+    __m512 dvdrs = _mm512_add_ps(p->k4, _mm512_mul_ps(_mm512_mul_ps(two, p->k5), rs));
+    dudrs = _mm512_add_ps(dudrs, _mm512_mul_ps(_mm512_mul_ps(three, p->k3), rss));
+    dvdrs = _mm512_add_ps(dvdrs, _mm512_mul_ps(_mm512_mul_ps(three, p->k6), rss));
+    __m512 bis = _mm512_mul_ps(bi, bi);
+    __m512 dddrs = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(dudrs, b), _mm512_mul_ps(a, dvdrs)), bis);
+
+    __m512 dddrs_2 = _mm512_mul_ps(dddrs, two);
+    __m512 xp_dddrs_2 = _mm512_mul_ps(xp, dddrs_2);
+    __m512 yp_xp_dddrs_2 = _mm512_mul_ps(yp, xp_dddrs_2);
+    __m512 t_xp = _mm512_mul_ps(p->t, xp);
+    __m512 t_yp = _mm512_mul_ps(p->t, yp);
+
+    // Accumulate each derivative term by term in the order the scalar kernel adds them
+    __m512 j0 = _mm512_add_ps(d, _mm512_mul_ps(xp, xp_dddrs_2));
+    __m512 j1 = _mm512_add_ps(yp_xp_dddrs_2, _mm512_mul_ps(_mm512_mul_ps(two, yp), p->p2));
+    __m512 j2 = _mm512_add_ps(yp_xp_dddrs_2, _mm512_mul_ps(_mm512_mul_ps(two, xp), p->p1));
+    __m512 j3 = _mm512_add_ps(d, _mm512_mul_ps(yp2, dddrs_2));
+    j0 = _mm512_add_ps(j0, _mm512_mul_ps(_mm512_mul_ps(six, xp), p->p2));
+    j3 = _mm512_add_ps(j3, _mm512_mul_ps(_mm512_mul_ps(six, yp), p->p1));
+    j0 = _mm512_add_ps(j0, _mm512_mul_ps(t_yp, p->p1));
+    j1 = _mm512_add_ps(j1, _mm512_mul_ps(t_xp, p->p1));
+    j2 = _mm512_add_ps(j2, _mm512_mul_ps(t_yp, p->p2));
+    j3 = _mm512_add_ps(j3, _mm512_mul_ps(t_xp, p->p2));
+
+    _mm512_mask_storeu_ps(jacobian, mask, _mm512_mul_ps(p->fx, j0));
+    _mm512_mask_storeu_ps(jacobian + jacobian_stride, mask, _mm512_mul_ps(p->fx, j1));
+    _mm512_mask_storeu_ps(jacobian + 2 * jacobian_stride, mask, _mm512_mul_ps(p->fy, j2));
+    _mm512_mask_storeu_ps(jacobian + 3 * jacobian_stride, mask, _mm512_mul_ps(p->fy, j3));
+}
+
+void transformation_project_avx512(const k4a_transformation_projection_params_t *params,
+                                   const float *x,
+                                   const float *y,
+                                   float *u,
+                                   float *v,
+                                   float *jacobian,
+                                   int *valid,
+                                   int count)
+{
+    transformation_projection_params_avx512_t p;
+    p.cx = _mm512_set1_ps(params->cx);
+    p.cy = _mm512_set1_ps(params->cy);
+    p.fx = _mm512_set1_ps(params->fx);
+    p.fy = _mm512_set1_ps(params->fy);
+    p.k1 = _mm512_set1_ps(params->k1);
+    p.k2 = _mm512_set1_ps(params->k2);
+    p.k3 = _mm512_set1_ps(params->k3);
+    p.k4 = _mm512_set1_ps(params->k4);
+    p.k5 = _mm512_set1_ps(params->k5);
+    p.k6 = _mm512_set1_ps(params->k6);
+    p.codx = _mm512_set1_ps(params->codx);
+    p.cody = _mm512_set1_ps(params->cody);
+    p.p1 = _mm512_set1_ps(params->p1);
+    p.p2 = _mm512_set1_ps(params->p2);
+    p.t = _mm512_set1_ps(params->tangential_scale);
+    p.max_radius_squared = _mm512_set1_ps(params->max_radius_squared);
+
+    for (int i = 0; i < count; i += 16)
+    {
+        // Masked loads and stores handle the last partial vector
+        __mmask16 mask = count - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        float *jacobian_i = jacobian != NULL ? jacobian + i : NULL;
+        transformation_project_16_avx512(&p, x + i, y + i, u + i, v + i, jacobian_i, count, valid + i, mask);
+    }
+}
@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// NEON is part of the AArch64 baseline, so this kernel needs no runtime check.
+
+#include "transformation_priv.h"
+
+#include <arm_neon.h>
+#include <string.h>
+
+typedef struct
+{
+    float32x4_t cx, cy, fx, fy;
+    float32x4_t k1, k2, k3, k4, k5, k6;
+    float32x4_t codx, cody, p1, p2;
+    float32x4_t t, max_radius_squared;
+} transformation_projection_params_neon_t;
+
+// Projects 4 points, doing the same operations in the same order as transformation_project_scalar()
+static inline void transformation_project_4_neon(const transformation_projection_params_neon_t *p,
+                                                 const float *x,
+                                                 const float *y,
+                                                 float *u,
+                                                 float *v,
+                                                 float *jacobian,
+                                                 int jacobian_stride,
+                                                 int *valid)
+{
+    // Multiply and add separately; a fused multiply-add would not match the scalar kernel
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t two = vdupq_n_f32(2.f);
+    const float32x4_t three = vdupq_n_f32(3.f);
+    const float32x4_t six = vdupq_n_f32(6.f);
+
+    float32x4_t xp = vsubq_f32(vld1q_f32(x), p->codx);
+    float32x4_t yp = vsubq_f32(vld1q_f32(y), p->cody);
+
+    float32x4_t xp2 = vmulq_f32(xp, xp);
+    float32x4_t yp2 = vmulq_f32(yp, yp);
+    float32x4_t xyp = vmulq_f32(xp, yp);
+    float32x4_t rs = vaddq_f32(xp2, yp2);
+
+    // Not greater than, so that a NAN radius counts as valid like in the scalar kernel
+    uint32x4_t in_range = vmvnq_u32(vcgtq_f32(rs, p->max_radius_squared));
+    in_range = vandq_u32(in_range, vdupq_n_u32(1));
+    vst1q_s32(valid, vreinterpretq_s32_u32(in_range));
+
+    float32x4_t rss = vmulq_f32(rs, rs);
+    float32x4_t rsc = vmulq_f32(rss, rs);
+    float32x4_t a = vaddq_f32(one, vmulq_f32(p->k1, rs));
+    float32x4_t b = vaddq_f32(one, vmulq_f32(p->k4, rs));
+    a = vaddq_f32(vaddq_f32(a, vmulq_f32(p->k2, rss)), vmulq_f32(p->k3, rsc));
+    b = vaddq_f32(vaddq_f32(b, vmulq_f32(p->k5, rss)), vmulq_f32(p->k6, rsc));
+    uint32x4_t b_is_zero = vceqq_f32(b, vdupq_n_f32(0.f));
+    float32x4_t bi = vbslq_f32(b_is_zero, one, vdivq_f32(one, b));
+    float32x4_t d = vmulq_f32(a, bi);
+
+    float32x4_t xp_d = vmulq_f32(xp, d);
+    float32x4_t yp_d = vmulq_f32(yp, d);
+
+    float32x4_t rs_2xp2 = vaddq_f32(rs, vmulq_f32(two, xp2));
+    float32x4_t rs_2yp2 = vaddq_f32(rs, vmulq_f32(two, yp2));
+
+    float32x4_t t_xyp = vmulq_f32(p->t, xyp);
+    float32x4_t x_tangential = vaddq_f32(vmulq_f32(rs_2xp2, p->p2), vmulq_f32(t_xyp, p->p1));
+    float32x4_t y_tangential = vaddq_f32(vmulq_f32(rs_2yp2, p->p1), vmulq_f32(t_xyp, p->p2));
+    xp_d = vaddq_f32(xp_d, x_tangential);
+    yp_d = vaddq_f32(yp_d, y_tangential);
+
+    float32x4_t xp_d_cx = vaddq_f32(xp_d, p->codx);
+    float32x4_t yp_d_cy = vaddq_f32(yp_d, p->cody);
+    vst1q_f32(u, vaddq_f32(vmulq_f32(xp_d_cx, p->fx), p->cx));
+    vst1q_f32(v, vaddq_f32(vmulq_f32(yp_d_cy, p->fy), p->cy));
+
+    if (jacobian == NULL)
+    {
+        return;
+    }
+
+    float32x4_t dudrs = vaddq_f32(p->k1, vmulq_f32(vmulq_f32(two, p->k2), rs));
+    float32x4_t dvdrs = vaddq_f32(p->k4, vmulq_f32(vmulq_f32(two, p->k5), rs));
+    dudrs = vaddq_f32(dudrs, vmulq_f32(vmulq_f32(three, p->k3), rss));
+    dvdrs = vaddq_f32(dvdrs, vmulq_f32(vmulq_f32(three, p->k6), rss));
+    float32x4_t bis = vmulq_f32(bi, bi);
+    float32x4_t dddrs = vmulq_f32(vsubq_f32(vmulq_f32(dudrs, b), vmulq_f32(a, dvdrs)), bis);
+
+    float32x4_t dddrs_2 = vmulq_f32(dddrs, two);
+    float32x4_t xp_dddrs_2 = vmulq_f32(xp, dddrs_2);
+    float32x4_t yp_xp_dddrs_2 = vmulq_f32(yp, xp_dddrs_2);
+    float32x4_t t_xp = vmulq_f32(p->t, xp);
+    float32x4_t t_yp = vmulq_f32(p->t, yp);
+
+    // Accumulate each derivative term by term in the order the scalar kernel adds them
+    float32x4_t j0 = vaddq_f32(d, vmulq_f32(xp, xp_dddrs_2));
+    float32x4_t j1 = vaddq_f32(yp_xp_dddrs_2, vmulq_f32(vmulq_f32(two, yp), p->p2));
+    float32x4_t j2 = vaddq_f32(yp_xp_dddrs_2, vmulq_f32(vmulq_f32(two, xp), p->p1));
+    float32x4_t j3 = vaddq_f32(d, vmulq_f32(yp2, dddrs_2));
+    j0 = vaddq_f32(j0, vmulq_f32(vmulq_f32(six, xp), p->p2));
+    j3 = vaddq_f32(j3, vmulq_f32(vmulq_f32(six, yp), p->p1));
+    j0 = vaddq_f32(j0, vmulq_f32(t_yp, p->p1));
+    j1 = vaddq_f32(j1, vmulq_f32(t_xp, p->p1));
+    j2 = vaddq_f32(j2, vmulq_f32(t_yp, p->p2));
+    j3 = vaddq_f32(j3, vmulq_f32(t_xp, p->p2));
+
+    vst1q_f32(jacobian, vmulq_f32(p->fx, j0));
+    vst1q_f32(jacobian + jacobian_stride, vmulq_f32(p->fx, j1));
+    vst1q_f32(jacobian + 2 * jacobian_stride, vmulq_f32(p->fy, j2));
+    vst1q_f32(jacobian + 3 * jacobian_stride, vmulq_f32(p->fy, j3));
+}
+
+void transformation_project_neon(const k4a_transformation_projection_params_t *params,
+                                 const float *x,
+                                 const float *y,
+                                 float *u,
+                                 float *v,
+                                 float *jacobian,
+                                 int *valid,
+                                 int count)
+{
+    transformation_projection_params_neon_t p;
+    p.cx = vdupq_n_f32(params->cx);
+    p.cy = vdupq_n_f32(params->cy);
+    p.fx = vdupq_n_f32(params->fx);
+    p.fy = vdupq_n_f32(params->fy);
+    p.k1 = vdupq_n_f32(params->k1);
+    p.k2 = vdupq_n_f32(params->k2);
+    p.k3 = vdupq_n_f32(params->k3);
+    p.k4 = vdupq_n_f32(params->k4);
+    p.k5 = vdupq_n_f32(params->k5);
+    p.k6 = vdupq_n_f32(params->k6);
+    p.codx = vdupq_n_f32(params->codx);
+    p.cody = vdupq_n_f32(params->cody);
+    p.p1 = vdupq_n_f32(params->p1);
+    p.p2 = vdupq_n_f32(params->p2);
+    p.t = vdupq_n_f32(params->tangential_scale);
+    p.max_radius_squared = vdupq_n_f32(params->max_radius_squared);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float *jacobian_i = jacobian != NULL ? jacobian + i : NULL;
+        transformation_project_4_neon(&p, x + i, y + i, u + i, v + i, jacobian_i, count, valid + i);
+    }
+
+    if (i < count)
+    {
+        // Run the last partial vector on zero padded copies
+        int tail = count - i;
+        float x_tail[4] = { 0.f }, y_tail[4] = { 0.f }, u_tail[4], v_tail[4], jacobian_tail[4 * 4];
+        int valid_tail[4];
+        memcpy(x_tail, x + i, (size_t)tail * sizeof(float));
+        memcpy(y_tail, y + i, (size_t)tail * sizeof(float));
+
+        float *jacobian_i = jacobian != NULL ? jacobian_tail : NULL;
+        transformation_project_4_neon(&p, x_tail, y_tail, u_tail, v_tail, jacobian_i, 4, valid_tail);
+
+        memcpy(u + i, u_tail, (size_t)tail * sizeof(float));
+        memcpy(v + i, v_tail, (size_t)tail * sizeof(float));
+        memcpy(valid + i, valid_tail, (size_t)tail * sizeof(int));
+        if (jacobian != NULL)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                memcpy(jacobian + row * count + i, jacobian_tail + row * 4, (size_t)tail * sizeof(float));
+            }
+        }
+    }
+}
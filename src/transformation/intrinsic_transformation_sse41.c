@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with SSE4.1 code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41).
+
+#include "transformation_priv.h"
+
+#include <smmintrin.h> // SSE4.1
+#include <string.h>
+
+typedef struct
+{
+    __m128 cx, cy, fx, fy;
+    __m128 k1, k2, k3, k4, k5, k6;
+    __m128 codx, cody, p1, p2;
+    __m128 t, max_radius_squared;
+} transformation_projection_params_sse41_t;
+
+// Projects 4 points, doing the same operations in the same order as transformation_project_scalar()
+static inline void transformation_project_4_sse41(const transformation_projection_params_sse41_t *p,
+                                                  const float *x,
+                                                  const float *y,
+                                                  float *u,
+                                                  float *v,
+                                                  float *jacobian,
+                                                  int jacobian_stride,
+                                                  int *valid)
+{
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 three = _mm_set1_ps(3.f);
+    const __m128 six = _mm_set1_ps(6.f);
+
+    __m128 xp = _mm_sub_ps(_mm_loadu_ps(x), p->codx);
+    __m128 yp = _mm_sub_ps(_mm_loadu_ps(y), p->cody);
+
+    __m128 xp2 = _mm_mul_ps(xp, xp);
+    __m128 yp2 = _mm_mul_ps(yp, yp);
+    __m128 xyp = _mm_mul_ps(xp, yp);
+    __m128 rs = _mm_add_ps(xp2, yp2);
+
+    // Not greater than, so that a NAN radius counts as valid like in the scalar kernel
+    __m128i in_range = _mm_castps_si128(_mm_cmpngt_ps(rs, p->max_radius_squared));
+    in_range = _mm_and_si128(in_range, _mm_set1_epi32(1));
+    _mm_storeu_si128((__m128i *)(void *)valid, in_range);
+
+    __m128 rss = _mm_mul_ps(rs, rs);
+    __m128 rsc = _mm_mul_ps(rss, rs);
+    __m128 a = _mm_add_ps(one, _mm_mul_ps(p->k1, rs));
+    __m128 b = _mm_add_ps(one, _mm_mul_ps(p->k4, rs));
+    a = _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(p->k2, rss)), _mm_mul_ps(p->k3, rsc));
+    b = _mm_add_ps(_mm_add_ps(b, _mm_mul_ps(p->k5, rss)), _mm_mul_ps(p->k6, rsc));
+    __m128 b_is_zero = _mm_cmpeq_ps(b, _mm_setzero_ps());
+    __m128 bi = _mm_blendv_ps(_mm_div_ps(one, b), one, b_is_zero);
+    __m128 d = _mm_mul_ps(a, bi);
+
+    __m128 xp_d = _mm_mul_ps(xp, d);
+    __m128 yp_d = _mm_mul_ps(yp, d);
+
+    __m128 rs_2xp2 = _mm_add_ps(rs, _mm_mul_ps(two, xp2));
+    __m128 rs_2yp2 = _mm_add_ps(rs, _mm_mul_ps(two, yp2));
+
+    __m128 t_xyp = _mm_mul_ps(p->t, xyp);
+    __m128 x_tangential = _mm_add_ps(_mm_mul_ps(rs_2xp2, p->p2), _mm_mul_ps(t_xyp, p->p1));
+    __m128 y_tangential = _mm_add_ps(_mm_mul_ps(rs_2yp2, p->p1), _mm_mul_ps(t_xyp, p->p2));
+    xp_d = _mm_add_ps(xp_d, x_tangential);
+    yp_d = _mm_add_ps(yp_d, y_tangential);
+
+    __m128 xp_d_cx = _mm_add_ps(xp_d, p->codx);
+    __m128 yp_d_cy = _mm_add_ps(yp_d, p->cody);
+    _mm_storeu_ps(u, _mm_add_ps(_mm_mul_ps(xp_d_cx, p->fx), p->cx));
+    _mm_storeu_ps(v, _mm_add_ps(_mm_mul_ps(yp_d_cy, p->fy), p->cy));
+
+    if (jacobian == NULL)
+    {
+        return;
+    }
+
+    __m128 dudrs = _mm_add_ps(p->k1, _mm_mul_ps(_mm_mul_ps(two, p->k2), rs));
+    __m128 dvdrs = _mm_add_ps(p->k4, _mm_mul_ps(_mm_mul_ps(two, p->k5), rs));
+    dudrs = _mm_add_ps(dudrs, _mm_mul_ps(_mm_mul_ps(three, p->k3), rss));
+    dvdrs = _mm_add_ps(dvdrs, _mm_mul_ps(_mm_mul_ps(three, p->k6), rss));
+    __m128 bis = _mm_mul_ps(bi, bi);
+    __m128 dddrs = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dudrs, b), _mm_mul_ps(a, dvdrs)), bis);
+
+    __m128 dddrs_2 = _mm_mul_ps(dddrs, two);
+    __m128 xp_dddrs_2 = _mm_mul_ps(xp, dddrs_2);
+    __m128 yp_xp_dddrs_2 = _mm_mul_ps(yp, xp_dddrs_2);
+    __m128 t_xp = _mm_mul_ps(p->t, xp);
+    __m128 t_yp = _mm_mul_ps(p->t, yp);
+
+    // Accumulate each derivative term by term in the order the scalar kernel adds them
+    __m128 j0 = _mm_add_ps(d, _mm_mul_ps(xp, xp_dddrs_2));
+    __m128 j1 = _mm_add_ps(yp_xp_dddrs_2, _mm_mul_ps(_mm_mul_ps(two, yp), p->p2));
+    __m128 j2 = _mm_add_ps(yp_xp_dddrs_2, _mm_mul_ps(_mm_mul_ps(two, xp), p->p1));
+    __m128 j3 = _mm_add_ps(d, _mm_mul_ps(yp2, dddrs_2));
+    j0 = _mm_add_ps(j0, _mm_mul_ps(_mm_mul_ps(six, xp), p->p2));
+    j3 = _mm_add_ps(j3, _mm_mul_ps(_mm_mul_ps(six, yp), p->p1));
+    j0 = _mm_add_ps(j0, _mm_mul_ps(t_yp, p->p1));
+    j1 = _mm_add_ps(j1, _mm_mul_ps(t_xp, p->p1));
+    j2 = _mm_add_ps(j2, _mm_mul_ps(t_yp, p->p2));
+    j3 = _mm_add_ps(j3, _mm_mul_ps(t_xp, p->p2));
+
+    _mm_storeu_ps(jacobian, _mm_mul_ps(p->fx, j0));
+    _mm_storeu_ps(jacobian + jacobian_stride, _mm_mul_ps(p->fx, j1));
+    _mm_storeu_ps(jacobian + 2 * jacobian_stride, _mm_mul_ps(p->fy, j2));
+    _mm_storeu_ps(jacobian + 3 * jacobian_stride, _mm_mul_ps(p->fy, j3));
+}
+
+void transformation_project_sse41(const k4a_transformation_projection_params_t *params,
+                                  const float *x,
+                                  const float *y,
+                                  float *u,
+                                  float *v,
+                                  float *jacobian,
+                                  int *valid,
+                                  int count)
+{
+    transformation_projection_params_sse41_t p;
+    p.cx = _mm_set1_ps(params->cx);
+    p.cy = _mm_set1_ps(params->cy);
+    p.fx = _mm_set1_ps(params->fx);
+    p.fy = _mm_set1_ps(params->fy);
+    p.k1 = _mm_set1_ps(params->k1);
+    p.k2 = _mm_set1_ps(params->k2);
+    p.k3 = _mm_set1_ps(params->k3);
+    p.k4 = _mm_set1_ps(params->k4);
+    p.k5 = _mm_set1_ps(params->k5);
+    p.k6 = _mm_set1_ps(params->k6);
+    p.codx = _mm_set1_ps(params->codx);
+    p.cody = _mm_set1_ps(params->cody);
+    p.p1 = _mm_set1_ps(params->p1);
+    p.p2 = _mm_set1_ps(params->p2);
+    p.t = _mm_set1_ps(params->tangential_scale);
+    p.max_radius_squared = _mm_set1_ps(params->max_radius_squared);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float *jacobian_i = jacobian != NULL ? jacobian + i : NULL;
+        transformation_project_4_sse41(&p, x + i, y + i, u + i, v + i, jacobian_i, count, valid + i);
+    }
+
+    if (i < count)
+    {
+        // Run the last partial vector on zero padded copies
+        int tail = count - i;
+        float x_tail[4] = { 0.f }, y_tail[4] = { 0.f }, u_tail[4], v_tail[4], jacobian_tail[4 * 4];
+        int valid_tail[4];
+        memcpy(x_tail, x + i, (size_t)tail * sizeof(float));
+        memcpy(y_tail, y + i, (size_t)tail * sizeof(float));
+
+        float *jacobian_i = jacobian != NULL ? jacobian_tail : NULL;
+        transformation_project_4_sse41(&p, x_tail, y_tail, u_tail, v_tail, jacobian_i, 4, valid_tail);
+
+        memcpy(u + i, u_tail, (size_t)tail * sizeof(float));
+        memcpy(v + i, v_tail, (size_t)tail * sizeof(float));
+        memcpy(valid + i, valid_tail, (size_t)tail * sizeof(int));
+        if (jacobian != NULL)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                memcpy(jacobian + row * count + i, jacobian_tail + row * 4, (size_t)tail * sizeof(float));
+            }
+        }
+    }
+}
@@ -1,19 +1,13 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
-#include <k4ainternal/transformation.h>
+#include "transformation_priv.h"
 #include <k4ainternal/logging.h>
 
 #include <stdlib.h>
 #include <limits.h>
 #include <math.h>
 
-#ifdef _M_X64
-#include <emmintrin.h> // SSE2
-#include <tmmintrin.h> // SSE3
-#include <smmintrin.h> // SSE4.1
-#endif
-
 typedef struct _k4a_transformation_input_image_t
 {
     const k4a_transformation_image_descriptor_t *descriptor;
@@ -32,6 +26,7 @@ typedef struct _k4a_transformation_rgbz_context_t
 {
     const k4a_calibration_t *calibration;
     const k4a_transformation_xy_tables_t *xy_tables;
+    const k4a_transformation_correspondence_table_t *correspondence_table; // NULL to compute exact correspondences
     k4a_transformation_input_image_t depth_image;
     k4a_transformation_input_image_t color_image;
     k4a_transformation_output_image_t transformed_image;
@@ -50,6 +45,23 @@ typedef struct _k4a_bounding_box_t
     int bottom_right[2];
 } k4a_bounding_box_t;
 
+size_t transformation_get_frame_scratch_size(int depth_width, int depth_height)
+{
+    // The correspondence of every depth pixel followed by the color y range of every depth row
+    return (size_t)depth_width * (size_t)depth_height * sizeof(k4a_correspondence_t) +
+           2 * (size_t)depth_height * sizeof(float);
+}
+
+size_t transformation_get_band_scratch_size(int depth_width)
+{
+    // A row of correspondences for the single threaded depth to color transformation, or a row of color image
+    // coordinates, colors and positions for the color to depth and colored point cloud transformations
+    size_t correspondence_row_size = (size_t)depth_width * sizeof(k4a_correspondence_t);
+    size_t color_row_size = 2 * (size_t)depth_width * sizeof(float) + 4 * (size_t)depth_width * sizeof(uint8_t) +
+                            3 * (size_t)depth_width * sizeof(int16_t);
+    return correspondence_row_size > color_row_size ? correspondence_row_size : color_row_size;
+}
+
 static k4a_transformation_image_descriptor_t transformation_init_image_descriptor(int width, int height, int stride)
 {
     k4a_transformation_image_descriptor_t descriptor;
@@ -99,11 +111,40 @@ transformation_init_output_image(k4a_transformation_image_descriptor_t *descript
     return image;
 }
 
+static inline void
+transformation_lookup_correspondence(const int depth_index,
+                                     const uint16_t depth,
+                                     const k4a_transformation_correspondence_table_t *correspondence_table,
+                                     k4a_correspondence_t *correspondence)
+{
+    const k4a_transformation_correspondence_coefficients_t *coefficients = correspondence_table->coefficients +
+                                                                            depth_index;
+    if (depth == 0 || isnan(coefficients->depth_scale))
+    {
+        memset(correspondence, 0, sizeof(k4a_correspondence_t));
+        return;
+    }
+
+    float u = correspondence_table->reference_depth / (float)depth;
+    correspondence->point2d.xy.x = coefficients->point2d[0][0] +
+                                   u * (coefficients->point2d[1][0] + u * coefficients->point2d[2][0]);
+    correspondence->point2d.xy.y = coefficients->point2d[0][1] +
+                                   u * (coefficients->point2d[1][1] + u * coefficients->point2d[2][1]);
+    correspondence->depth = (float)depth * coefficients->depth_scale + correspondence_table->depth_offset;
+    correspondence->valid = u >= coefficients->u_min && u <= coefficients->u_max;
+}
+
 static k4a_result_t transformation_compute_correspondence(const int depth_index,
                                                           const uint16_t depth,
                                                           const k4a_transformation_rgbz_context_t *context,
                                                           k4a_correspondence_t *correspondence)
 {
+    if (context->correspondence_table != NULL)
+    {
+        transformation_lookup_correspondence(depth_index, depth, context->correspondence_table, correspondence);
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     if (depth == 0 || isnan(context->xy_tables->x_table[depth_index]))
     {
         memset(correspondence, 0, sizeof(k4a_correspondence_t));
@@ -379,15 +420,21 @@ static void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box
     }
 }
 
-static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_context_t *context)
+static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_context_t *context,
+                                                  k4a_transformation_worker_pool_t *worker_pool)
 {
     memset(context->transformed_image.data_uint8,
            0,
            (size_t)(context->transformed_image.descriptor->stride_bytes *
                     context->transformed_image.descriptor->height_pixels));
 
-    k4a_correspondence_t *vertex_row = (k4a_correspondence_t *)malloc(
-        (size_t)context->depth_image.descriptor->width_pixels * sizeof(k4a_correspondence_t));
+    k4a_correspondence_t *vertex_row = (k4a_correspondence_t *)transformation_worker_pool_get_band_scratch(
+        worker_pool, 0, (size_t)context->depth_image.descriptor->width_pixels * sizeof(k4a_correspondence_t));
+    if (vertex_row == NULL)
+    {
+        LOG_ERROR("Depth to color correspondences do not fit the scratch memory of the transformation.", 0);
+        return K4A_RESULT_FAILED;
+    }
 
     int idx = 0;
     for (; idx < context->depth_image.descriptor->width_pixels; idx++)
@@ -395,7 +442,6 @@ static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_contex
         if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
                 idx, context->depth_image.data_uint16[idx], context, vertex_row + idx))))
         {
-            free(vertex_row);
             return K4A_RESULT_FAILED;
         }
     }
@@ -407,7 +453,6 @@ static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_contex
         if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
                 idx, context->depth_image.data_uint16[idx], context, &bottom_left))))
         {
-            free(vertex_row);
             return K4A_RESULT_FAILED;
         }
         idx++;
@@ -420,7 +465,6 @@ static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_contex
             if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
                     idx, context->depth_image.data_uint16[idx], context, &bottom_right))))
             {
-                free(vertex_row);
                 return K4A_RESULT_FAILED;
             }
 
@@ -455,10 +499,192 @@ static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_contex
             bottom_left = bottom_right;
         }
     }
-    free(vertex_row);
     return K4A_RESULT_SUCCEEDED;
 }
 
+typedef struct _k4a_transformation_depth_to_color_band_t
+{
+    const k4a_transformation_rgbz_context_t *context;
+    k4a_correspondence_t *correspondences; // correspondence of every depth pixel
+    float *row_min_y;                      // smallest color y of the valid correspondences in each depth row
+    float *row_max_y;                      // largest color y of the valid correspondences in each depth row
+    int depth_row_begin;                   // first depth row whose correspondences this band computes
+    int depth_row_end;                     // one past the last depth row whose correspondences this band computes
+    int color_row_begin;                   // first color row this band rasterizes
+    int color_row_end;                     // one past the last color row this band rasterizes
+    k4a_result_t result;
+} k4a_transformation_depth_to_color_band_t;
+
+static int transformation_depth_to_color_correspondence_band(void *param)
+{
+    k4a_transformation_depth_to_color_band_t *band = (k4a_transformation_depth_to_color_band_t *)param;
+    const k4a_transformation_rgbz_context_t *context = band->context;
+    int width = context->depth_image.descriptor->width_pixels;
+
+    band->result = K4A_RESULT_SUCCEEDED;
+    for (int y = band->depth_row_begin; y < band->depth_row_end; y++)
+    {
+        float min_y = INFINITY;
+        float max_y = -INFINITY;
+        for (int x = 0, idx = y * width; x < width; x++, idx++)
+        {
+            k4a_correspondence_t *correspondence = band->correspondences + idx;
+            if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
+                    idx, context->depth_image.data_uint16[idx], context, correspondence))))
+            {
+                band->result = K4A_RESULT_FAILED;
+                return 0;
+            }
+
+            if (correspondence->valid)
+            {
+                min_y = transformation_min2f(min_y, correspondence->point2d.xy.y);
+                max_y = transformation_max2f(max_y, correspondence->point2d.xy.y);
+            }
+        }
+        band->row_min_y[y] = min_y;
+        band->row_max_y[y] = max_y;
+    }
+    return 0;
+}
+
+static int transformation_depth_to_color_rasterize_band(void *param)
+{
+    k4a_transformation_depth_to_color_band_t *band = (k4a_transformation_depth_to_color_band_t *)param;
+    const k4a_transformation_rgbz_context_t *context = band->context;
+    k4a_transformation_output_image_t transformed_image = context->transformed_image;
+    int width = context->depth_image.descriptor->width_pixels;
+
+    // Quads are visited in the same order as the single threaded path and each band only writes its own color rows,
+    // so every output pixel sees the same sequence of z-tests and the result is identical.
+    for (int y = 1; y < context->depth_image.descriptor->height_pixels; y++)
+    {
+        // Any quad drawn from these two depth rows lies within the color rows spanned by their valid correspondences.
+        // Vertices replaced in transformation_check_valid_correspondences() are averages of valid ones, so they stay
+        // within that span too.
+        float min_y = transformation_min2f(band->row_min_y[y - 1], band->row_min_y[y]);
+        float max_y = transformation_max2f(band->row_max_y[y - 1], band->row_max_y[y]);
+        if (!(min_y <= max_y) || (int)ceilf(max_y) <= band->color_row_begin ||
+            (int)ceilf(min_y) >= band->color_row_end)
+        {
+            continue;
+        }
+
+        const k4a_correspondence_t *top_row = band->correspondences + (y - 1) * width;
+        const k4a_correspondence_t *bottom_row = band->correspondences + y * width;
+        for (int x = 1; x < width; x++)
+        {
+            k4a_correspondence_t valid_top_left, valid_top_right, valid_bottom_right, valid_bottom_left;
+            if (transformation_check_valid_correspondences(&top_row[x - 1],
+                                                           &top_row[x],
+                                                           &bottom_row[x],
+                                                           &bottom_row[x - 1],
+                                                           &valid_top_left,
+                                                           &valid_top_right,
+                                                           &valid_bottom_right,
+                                                           &valid_bottom_left))
+            {
+                k4a_bounding_box_t bounding_box =
+                    transformation_compute_bounding_box(&valid_top_left,
+                                                        &valid_top_right,
+                                                        &valid_bottom_right,
+                                                        &valid_bottom_left,
+                                                        transformed_image.descriptor->width_pixels,
+                                                        transformed_image.descriptor->height_pixels);
+
+                bounding_box.top_left[1] = transformation_max2(bounding_box.top_left[1], band->color_row_begin);
+                bounding_box.bottom_right[1] = transformation_min2(bounding_box.bottom_right[1], band->color_row_end);
+
+                transformation_draw_rectangle(&bounding_box,
+                                              &valid_top_left,
+                                              &valid_top_right,
+                                              &valid_bottom_right,
+                                              &valid_bottom_left,
+                                              &transformed_image);
+            }
+        }
+    }
+    return 0;
+}
+
+static k4a_result_t transformation_depth_to_color_parallel(k4a_transformation_rgbz_context_t *context,
+                                                           k4a_transformation_worker_pool_t *worker_pool,
+                                                           uint32_t thread_count)
+{
+    int depth_width = context->depth_image.descriptor->width_pixels;
+    int depth_height = context->depth_image.descriptor->height_pixels;
+    int color_height = context->transformed_image.descriptor->height_pixels;
+
+    memset(context->transformed_image.data_uint8,
+           0,
+           (size_t)(context->transformed_image.descriptor->stride_bytes * color_height));
+
+    k4a_correspondence_t *correspondences = (k4a_correspondence_t *)transformation_worker_pool_get_frame_scratch(
+        worker_pool, transformation_get_frame_scratch_size(depth_width, depth_height));
+    if (correspondences == NULL)
+    {
+        LOG_ERROR("Depth to color correspondences do not fit the scratch memory of the transformation.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    float *row_range_y = (float *)(void *)(correspondences + (size_t)depth_width * (size_t)depth_height);
+
+    k4a_transformation_depth_to_color_band_t bands[K4A_TRANSFORMATION_MAX_THREAD_COUNT];
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        bands[i].context = context;
+        bands[i].correspondences = correspondences;
+        bands[i].row_min_y = row_range_y;
+        bands[i].row_max_y = row_range_y + depth_height;
+        bands[i].depth_row_begin = (int)((int64_t)depth_height * i / thread_count);
+        bands[i].depth_row_end = (int)((int64_t)depth_height * (i + 1) / thread_count);
+        bands[i].result = K4A_RESULT_SUCCEEDED;
+    }
+
+    // Pass 1: compute the correspondence of every depth pixel
+    transformation_worker_pool_run(worker_pool,
+                                   transformation_depth_to_color_correspondence_band,
+                                   bands,
+                                   sizeof(k4a_transformation_depth_to_color_band_t),
+                                   thread_count);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    float min_y = INFINITY;
+    float max_y = -INFINITY;
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        if (K4A_FAILED(bands[i].result))
+        {
+            result = K4A_RESULT_FAILED;
+        }
+    }
+    for (int y = 0; y < depth_height; y++)
+    {
+        min_y = transformation_min2f(min_y, bands[0].row_min_y[y]);
+        max_y = transformation_max2f(max_y, bands[0].row_max_y[y]);
+    }
+
+    // Pass 2: split the color rows covered by the depth image into bands and rasterize them in parallel
+    if (K4A_SUCCEEDED(result) && min_y <= max_y)
+    {
+        int covered_begin = transformation_max2((int)ceilf(min_y), 0);
+        int covered_end = transformation_min2((int)ceilf(max_y), color_height);
+        int covered_rows = transformation_max2(covered_end - covered_begin, 0);
+        for (uint32_t i = 0; i < thread_count; i++)
+        {
+            bands[i].color_row_begin = covered_begin + (int)((int64_t)covered_rows * i / thread_count);
+            bands[i].color_row_end = covered_begin + (int)((int64_t)covered_rows * (i + 1) / thread_count);
+        }
+
+        transformation_worker_pool_run(worker_pool,
+                                       transformation_depth_to_color_rasterize_band,
+                                       bands,
+                                       sizeof(k4a_transformation_depth_to_color_band_t),
+                                       thread_count);
+    }
+
+    return result;
+}
+
 k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_parameters(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
@@ -533,10 +759,12 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
 k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
     const uint8_t *depth_image_data,
     const k4a_transformation_image_descriptor_t *depth_image_descriptor,
     uint8_t *transformed_depth_image_data,
-    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor)
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    k4a_transformation_worker_pool_t *worker_pool)
 {
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
         TRACE_BUFFER_CALL(
@@ -554,6 +782,7 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
 
     context.xy_tables = xy_tables_depth_camera;
+    context.correspondence_table = correspondence_table;
     context.calibration = calibration;
 
     context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
@@ -561,11 +790,18 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     context.transformed_image = transformation_init_output_image(transformed_depth_image_descriptor,
                                                                  transformed_depth_image_data);
 
-    if (K4A_FAILED(TRACE_CALL(transformation_depth_to_color(&context))))
+    k4a_result_t result;
+    uint32_t thread_count = transformation_worker_pool_acquire(worker_pool);
+    if (thread_count > 1)
     {
-        return K4A_BUFFER_RESULT_FAILED;
+        result = TRACE_CALL(transformation_depth_to_color_parallel(&context, worker_pool, thread_count));
     }
-    return K4A_BUFFER_RESULT_SUCCEEDED;
+    else
+    {
+        result = TRACE_CALL(transformation_depth_to_color(&context, worker_pool));
+    }
+    transformation_worker_pool_release(worker_pool);
+    return K4A_SUCCEEDED(result) ? K4A_BUFFER_RESULT_SUCCEEDED : K4A_BUFFER_RESULT_FAILED;
 }
 
 static inline int transformation_point_inside_image(int width, int height, k4a_float2_t *point2d)
@@ -580,42 +816,91 @@ static inline int transformation_point_inside_image(int width, int height, k4a_f
     return 1;
 }
 
-static inline uint8_t transformation_bilinear_interpolation(const uint8_t *image, int stride, k4a_float2_t *point2d)
+void transformation_interpolate_bgra_scalar(const uint8_t *color,
+                                            int color_stride,
+                                            const float *points,
+                                            uint8_t *bgra,
+                                            int count)
 {
-    int point_floor[2];
-    point_floor[0] = (int)(floorf(point2d->xy.x));
-    point_floor[1] = (int)(floorf(point2d->xy.y));
+    for (int i = 0; i < count; i++, points += 2, bgra += 4)
+    {
+        if (isnan(points[0]))
+        {
+            continue;
+        }
+
+        int point_floor[2];
+        point_floor[0] = (int)(floorf(points[0]));
+        point_floor[1] = (int)(floorf(points[1]));
 
-    float fractional[2];
-    fractional[0] = point2d->xy.x - point_floor[0];
-    fractional[1] = point2d->xy.y - point_floor[1];
+        float fractional[2];
+        fractional[0] = points[0] - point_floor[0];
+        fractional[1] = points[1] - point_floor[1];
 
-    float vals[4];
-    int idx = point_floor[1] * stride + 4 * point_floor[0];
-    vals[0] = (float)image[idx];
-    vals[1] = (float)image[idx + 4];
-    idx += stride;
-    vals[2] = (float)image[idx];
-    vals[3] = (float)image[idx + 4];
+        const uint8_t *top = color + point_floor[1] * color_stride + 4 * point_floor[0];
+        const uint8_t *bottom = top + color_stride;
+        uint8_t value[4];
+        for (int channel = 0; channel < 4; channel++)
+        {
+            float interpol_x[2];
+            interpol_x[0] = (1.f - fractional[0]) * (float)top[channel] + fractional[0] * (float)top[channel + 4];
+            interpol_x[1] = (1.f - fractional[0]) * (float)bottom[channel] + fractional[0] * (float)bottom[channel + 4];
 
-    float interpol_x[2];
-    interpol_x[0] = (1.f - fractional[0]) * vals[0] + fractional[0] * vals[1];
-    interpol_x[1] = (1.f - fractional[0]) * vals[2] + fractional[0] * vals[3];
+            float interpol_y = (1.f - fractional[1]) * interpol_x[0] + fractional[1] * interpol_x[1];
+            value[channel] = (uint8_t)(interpol_y + 0.5f);
+        }
 
-    float interpol_y = (1.f - fractional[1]) * interpol_x[0] + fractional[1] * interpol_x[1];
-    return (uint8_t)(interpol_y + 0.5f);
+        // bgra = (0,0,0,0) is used to indicate that the bgra pixel is invalid. A valid bgra pixel with values
+        // (0,0,0,0) is mapped to (1,0,0,0) to express that it is valid and very close to black.
+        if (value[0] == 0 && value[1] == 0 && value[2] == 0 && value[3] == 0)
+        {
+            value[0] = 1;
+        }
+        memcpy(bgra, value, sizeof(value));
+    }
 }
 
-static k4a_result_t transformation_color_to_depth(k4a_transformation_rgbz_context_t *context)
+static transformation_interpolate_bgra_fn_t *
+transformation_get_interpolate_bgra_kernel(k4a_transformation_instruction_set_t instruction_set)
 {
-    memset(context->transformed_image.data_uint8,
-           0,
-           (size_t)(context->transformed_image.descriptor->stride_bytes *
-                    context->transformed_image.descriptor->height_pixels));
+    switch (instruction_set)
+    {
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    // The interpolation is bound by the gather of the four neighbors, wider vectors do not help
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_interpolate_bgra_sse41;
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return transformation_interpolate_bgra_neon;
+#endif
+    default:
+        return transformation_interpolate_bgra_scalar;
+    }
+}
 
-    for (int idx = 0;
-         idx < context->depth_image.descriptor->width_pixels * context->depth_image.descriptor->height_pixels;
-         idx++)
+typedef struct _k4a_transformation_color_to_depth_band_t
+{
+    const k4a_transformation_rgbz_context_t *context;
+    transformation_interpolate_bgra_fn_t *interpolate_bgra;
+    float *points; // color image coordinates of one depth row, as x, y pairs
+    int row_begin; // first depth row of the band
+    int row_end;   // one past the last depth row of the band
+    k4a_result_t result;
+} k4a_transformation_color_to_depth_band_t;
+
+// Finds the color image coordinates of every depth pixel in row y, stored as NAN for pixels without a color
+static k4a_result_t transformation_color_to_depth_row_points(const k4a_transformation_rgbz_context_t *context,
+                                                            int y,
+                                                            float *points)
+{
+    int width = context->depth_image.descriptor->width_pixels;
+    int color_width = context->color_image.descriptor->width_pixels;
+    int color_height = context->color_image.descriptor->height_pixels;
+
+    for (int x = 0, idx = y * width; x < width; x++, idx++)
     {
         k4a_correspondence_t correspondence;
         if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
@@ -624,84 +909,111 @@ static k4a_result_t transformation_color_to_depth(k4a_transformation_rgbz_contex
             return K4A_RESULT_FAILED;
         }
 
-        if (correspondence.valid && transformation_point_inside_image(context->color_image.descriptor->width_pixels,
-                                                                      context->color_image.descriptor->height_pixels,
-                                                                      &correspondence.point2d))
+        if (correspondence.valid &&
+            transformation_point_inside_image(color_width, color_height, &correspondence.point2d))
         {
-            uint8_t b = transformation_bilinear_interpolation(context->color_image.data_uint8,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
-
-            uint8_t g = transformation_bilinear_interpolation(context->color_image.data_uint8 + 1,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
-
-            uint8_t r = transformation_bilinear_interpolation(context->color_image.data_uint8 + 2,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
-
-            uint8_t alpha = transformation_bilinear_interpolation(context->color_image.data_uint8 + 3,
-                                                                  context->color_image.descriptor->stride_bytes,
-                                                                  &correspondence.point2d);
-
-            // bgra = (0,0,0,0) is used to indicate that the bgra pixel is invalid. A valid bgra pixel with values
-            // (0,0,0,0) is mapped to (1,0,0,0) to express that it is valid and very close to black.
-            if (b == 0 && g == 0 && r == 0 && alpha == 0)
-            {
-                b++;
-            }
-
-            context->transformed_image.data_uint8[4 * idx + 0] = b;
-            context->transformed_image.data_uint8[4 * idx + 1] = g;
-            context->transformed_image.data_uint8[4 * idx + 2] = r;
-            context->transformed_image.data_uint8[4 * idx + 3] = alpha;
+            points[2 * x] = correspondence.point2d.xy.x;
+            points[2 * x + 1] = correspondence.point2d.xy.y;
+        }
+        else
+        {
+            points[2 * x] = NAN;
+            points[2 * x + 1] = NAN;
         }
     }
     return K4A_RESULT_SUCCEEDED;
 }
 
-k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_parameters(
-    const k4a_calibration_t *calibration,
-    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
-    const uint8_t *depth_image_data,
-    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-    const uint8_t *color_image_data,
-    const k4a_transformation_image_descriptor_t *color_image_descriptor,
-    uint8_t *transformed_color_image_data,
-    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+static int transformation_color_to_depth_band(void *param)
 {
-    if (transformed_color_image_descriptor == 0 || calibration == 0)
+    k4a_transformation_color_to_depth_band_t *band = (k4a_transformation_color_to_depth_band_t *)param;
+    const k4a_transformation_rgbz_context_t *context = band->context;
+    int width = context->depth_image.descriptor->width_pixels;
+    int transformed_stride = context->transformed_image.descriptor->stride_bytes;
+
+    band->result = K4A_RESULT_SUCCEEDED;
+    for (int y = band->row_begin; y < band->row_end; y++)
     {
-        if (calibration == 0)
+        // Find the color of every depth pixel in the row first, then interpolate the whole row at once
+        if (K4A_FAILED(TRACE_CALL(transformation_color_to_depth_row_points(context, y, band->points))))
         {
-            LOG_ERROR("Calibration is null.", 0);
+            band->result = K4A_RESULT_FAILED;
+            return 0;
         }
-        return K4A_BUFFER_RESULT_FAILED;
+
+        uint8_t *row = context->transformed_image.data_uint8 + (size_t)y * (size_t)transformed_stride;
+        memset(row, 0, (size_t)transformed_stride);
+        band->interpolate_bgra(context->color_image.data_uint8,
+                               context->color_image.descriptor->stride_bytes,
+                               band->points,
+                               row,
+                               width);
     }
+    return 0;
+}
 
-    k4a_transformation_image_descriptor_t expected_transformed_color_image_descriptor =
-        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
-                                             calibration->depth_camera_calibration.resolution_height,
-                                             calibration->depth_camera_calibration.resolution_width * 4 *
-                                                 (int)sizeof(uint8_t));
+static k4a_result_t transformation_color_to_depth(k4a_transformation_rgbz_context_t *context,
+                                                  k4a_transformation_instruction_set_t instruction_set,
+                                                  k4a_transformation_worker_pool_t *worker_pool,
+                                                  uint32_t thread_count)
+{
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
+    if (thread_count > (uint32_t)height)
+    {
+        thread_count = (uint32_t)height;
+    }
+    if (thread_count == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
 
-    if (transformed_color_image_data == 0 ||
-        transformation_compare_image_descriptors(transformed_color_image_descriptor,
-                                                 &expected_transformed_color_image_descriptor) == false)
+    k4a_transformation_color_to_depth_band_t bands[K4A_TRANSFORMATION_MAX_THREAD_COUNT];
+    for (uint32_t i = 0; i < thread_count; i++)
     {
-        if (transformed_color_image_data == 0)
+        bands[i].context = context;
+        bands[i].interpolate_bgra = transformation_get_interpolate_bgra_kernel(instruction_set);
+        bands[i].points = (float *)transformation_worker_pool_get_band_scratch(worker_pool,
+                                                                               i,
+                                                                               2 * (size_t)width * sizeof(float));
+        bands[i].row_begin = (int)((int64_t)height * i / thread_count);
+        bands[i].row_end = (int)((int64_t)height * (i + 1) / thread_count);
+        bands[i].result = K4A_RESULT_SUCCEEDED;
+        if (bands[i].points == NULL)
         {
-            LOG_ERROR("Transformed color image data is null.", 0);
+            LOG_ERROR("Color to depth correspondences do not fit the scratch memory of the transformation.", 0);
+            return K4A_RESULT_FAILED;
         }
-        else
+    }
+
+    transformation_worker_pool_run(worker_pool,
+                                   transformation_color_to_depth_band,
+                                   bands,
+                                   sizeof(k4a_transformation_color_to_depth_band_t),
+                                   thread_count);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        if (K4A_FAILED(bands[i].result))
         {
-            LOG_ERROR("Unexpected transformed color image descriptor, see details above.", 0);
+            result = K4A_RESULT_FAILED;
         }
-        return K4A_BUFFER_RESULT_TOO_SMALL;
     }
+    return result;
+}
 
+// Checks the depth and color images shared by the transformations that color depth pixels
+static k4a_buffer_result_t
+transformation_validate_depth_and_color_images(const k4a_calibration_t *calibration,
+                                               const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+                                               const uint8_t *depth_image_data,
+                                               const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                               const uint8_t *color_image_data,
+                                               const k4a_transformation_image_descriptor_t *color_image_descriptor)
+{
     if (xy_tables_depth_camera == 0 || depth_image_data == 0 || depth_image_descriptor == 0 || color_image_data == 0 ||
-        color_image_descriptor == 0 || transformed_color_image_data == 0)
+        color_image_descriptor == 0)
     {
         if (xy_tables_depth_camera == 0)
         {
@@ -715,10 +1027,6 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_paramete
         {
             LOG_ERROR("Color image data is null.", 0);
         }
-        if (transformed_color_image_data == 0)
-        {
-            LOG_ERROR("Transformed color image data is null.", 0);
-        }
         return K4A_BUFFER_RESULT_FAILED;
     }
 
@@ -749,7 +1057,7 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_paramete
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
 
-k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
+k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_parameters(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
     const uint8_t *depth_image_data,
@@ -758,6 +1066,57 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     const k4a_transformation_image_descriptor_t *color_image_descriptor,
     uint8_t *transformed_color_image_data,
     k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+{
+    if (transformed_color_image_descriptor == 0 || calibration == 0)
+    {
+        if (calibration == 0)
+        {
+            LOG_ERROR("Calibration is null.", 0);
+        }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_transformed_color_image_descriptor =
+        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
+                                             calibration->depth_camera_calibration.resolution_height,
+                                             calibration->depth_camera_calibration.resolution_width * 4 *
+                                                 (int)sizeof(uint8_t));
+
+    if (transformed_color_image_data == 0 ||
+        transformation_compare_image_descriptors(transformed_color_image_descriptor,
+                                                 &expected_transformed_color_image_descriptor) == false)
+    {
+        if (transformed_color_image_data == 0)
+        {
+            LOG_ERROR("Transformed color image data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected transformed color image descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    return TRACE_BUFFER_CALL(transformation_validate_depth_and_color_images(calibration,
+                                                                            xy_tables_depth_camera,
+                                                                            depth_image_data,
+                                                                            depth_image_descriptor,
+                                                                            color_image_data,
+                                                                            color_image_descriptor));
+}
+
+k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *transformed_color_image_data,
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_instruction_set_t instruction_set,
+    k4a_transformation_worker_pool_t *worker_pool)
 {
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
         TRACE_BUFFER_CALL(
@@ -777,6 +1136,7 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
 
     context.xy_tables = xy_tables_depth_camera;
+    context.correspondence_table = correspondence_table;
     context.calibration = calibration;
 
     context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
@@ -786,31 +1146,36 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     context.transformed_image = transformation_init_output_image(transformed_color_image_descriptor,
                                                                  transformed_color_image_data);
 
-    if (K4A_FAILED(TRACE_CALL(transformation_color_to_depth(&context))))
+    if (!transformation_instruction_set_supported(instruction_set))
     {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
         return K4A_BUFFER_RESULT_FAILED;
     }
-    return K4A_BUFFER_RESULT_SUCCEEDED;
+
+    uint32_t thread_count = transformation_worker_pool_acquire(worker_pool);
+    k4a_result_t result = TRACE_CALL(
+        transformation_color_to_depth(&context, instruction_set, worker_pool, thread_count));
+    transformation_worker_pool_release(worker_pool);
+    return K4A_SUCCEEDED(result) ? K4A_BUFFER_RESULT_SUCCEEDED : K4A_BUFFER_RESULT_FAILED;
 }
 
-#ifndef _M_X64
-static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_tables,
-                                        const void *depth_image_data,
-                                        void *xyz_image_data)
+void transformation_depth_to_xyz_scalar(const float *x_table,
+                                        const float *y_table,
+                                        const uint16_t *depth,
+                                        int16_t *xyz,
+                                        int count)
 {
-    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
-    int16_t *xyz_data_int16 = (int16_t *)xyz_image_data;
     int16_t x, y, z;
 
-    for (int i = 0; i < xy_tables->width * xy_tables->height; i++)
+    for (int i = 0; i < count; i++)
     {
-        float x_tab = xy_tables->x_table[i];
+        float x_tab = x_table[i];
 
         if (!isnan(x_tab))
         {
-            z = (int16_t)depth_image_data_uint16[i];
+            z = (int16_t)depth[i];
             x = (int16_t)(floorf(x_tab * (float)z + 0.5f));
-            y = (int16_t)(floorf(xy_tables->y_table[i] * (float)z + 0.5f));
+            y = (int16_t)(floorf(y_table[i] * (float)z + 0.5f));
         }
         else
         {
@@ -819,80 +1184,134 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
             z = 0;
         }
 
-        xyz_data_int16[3 * i + 0] = x;
-        xyz_data_int16[3 * i + 1] = y;
-        xyz_data_int16[3 * i + 2] = z;
+        xyz[3 * i + 0] = x;
+        xyz[3 * i + 1] = y;
+        xyz[3 * i + 2] = z;
     }
 }
-#else
-static void transformation_depth_to_xyz_sse(k4a_transformation_xy_tables_t *xy_tables,
-                                            const void *depth_image_data,
-                                            void *xyz_image_data)
-{
-    const __m128i *depth_image_data_m128i = (const __m128i *)depth_image_data;
-    __m128 *x_table_m128 = (__m128 *)xy_tables->x_table;
-    __m128 *y_table_m128 = (__m128 *)xy_tables->y_table;
-    __m128i *xyz_data_m128i = (__m128i *)xyz_image_data;
-
-    const int16_t pos0 = 0x0100;
-    const int16_t pos1 = 0x0302;
-    const int16_t pos2 = 0x0504;
-    const int16_t pos3 = 0x0706;
-    const int16_t pos4 = 0x0908;
-    const int16_t pos5 = 0x0B0A;
-    const int16_t pos6 = 0x0D0C;
-    const int16_t pos7 = 0x0F0E;
-
-    // x0, x3, x6, x1, x4, x7, x2, x5
-    __m128i x_shuffle = _mm_setr_epi16(pos0, pos3, pos6, pos1, pos4, pos7, pos2, pos5);
-    // y5, y0, y3, y6, y1, y4, y7, y2
-    __m128i y_shuffle = _mm_setr_epi16(pos5, pos0, pos3, pos6, pos1, pos4, pos7, pos2);
-    // z2, z5, z0, z3, z6, z1, z4, z7
-    __m128i z_shuffle = _mm_setr_epi16(pos2, pos5, pos0, pos3, pos6, pos1, pos4, pos7);
 
-    __m128i valid_shuffle = _mm_setr_epi16(pos0, pos2, pos4, pos6, pos0, pos2, pos4, pos6);
-
-    for (int i = 0; i < xy_tables->width * xy_tables->height / 8; i++)
+static transformation_depth_to_xyz_fn_t *
+transformation_get_depth_to_xyz_kernel(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
     {
-        __m128i z = *depth_image_data_m128i++;
-
-        __m128 x_tab_lo = *x_table_m128++;
-        __m128 x_tab_hi = *x_table_m128++;
-        __m128 valid_lo = _mm_cmpeq_ps(x_tab_lo, x_tab_lo);
-        __m128 valid_hi = _mm_cmpeq_ps(x_tab_hi, x_tab_hi);
-        __m128i valid_shuffle_lo = _mm_shuffle_epi8(*((__m128i *)&valid_lo), valid_shuffle);
-        __m128i valid_shuffle_hi = _mm_shuffle_epi8(*((__m128i *)&valid_hi), valid_shuffle);
-        __m128i valid = _mm_blend_epi16(valid_shuffle_lo, valid_shuffle_hi, 0xF0);
-        z = _mm_blendv_epi8(_mm_setzero_si128(), z, valid);
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return transformation_depth_to_xyz_sse41;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return transformation_depth_to_xyz_avx2;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_depth_to_xyz_avx512;
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return transformation_depth_to_xyz_neon;
+#endif
+    default:
+        return transformation_depth_to_xyz_scalar;
+    }
+}
 
-        __m128 depth_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(z, _mm_setzero_si128()));
-        __m128 depth_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(z, _mm_setzero_si128()));
+void transformation_depth_to_xyz_f32_scalar(const float *x_table,
+                                            const float *y_table,
+                                            const uint16_t *depth,
+                                            float *xyz,
+                                            int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float x_tab = x_table[i];
 
-        __m128i x_lo = _mm_cvtps_epi32(_mm_mul_ps(depth_lo, x_tab_lo));
-        __m128i x_hi = _mm_cvtps_epi32(_mm_mul_ps(depth_hi, x_tab_hi));
-        __m128i x = _mm_packs_epi32(x_lo, x_hi);
-        x = _mm_blendv_epi8(_mm_setzero_si128(), x, valid);
-        x = _mm_shuffle_epi8(x, x_shuffle);
+        if (!isnan(x_tab) && depth[i] != 0)
+        {
+            float z = (float)depth[i];
+            xyz[3 * i + 0] = x_tab * z;
+            xyz[3 * i + 1] = y_table[i] * z;
+            xyz[3 * i + 2] = z;
+        }
+        else
+        {
+            xyz[3 * i + 0] = 0.f;
+            xyz[3 * i + 1] = 0.f;
+            xyz[3 * i + 2] = 0.f;
+        }
+    }
+}
 
-        __m128i y_lo = _mm_cvtps_epi32(_mm_mul_ps(depth_lo, *y_table_m128++));
-        __m128i y_hi = _mm_cvtps_epi32(_mm_mul_ps(depth_hi, *y_table_m128++));
-        __m128i y = _mm_packs_epi32(y_lo, y_hi);
-        y = _mm_shuffle_epi8(y, y_shuffle);
+void transformation_depth_to_xyz_planar_f32_scalar(const float *x_table,
+                                                   const float *y_table,
+                                                   const uint16_t *depth,
+                                                   float *x,
+                                                   float *y,
+                                                   float *z,
+                                                   int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float x_tab = x_table[i];
 
-        z = _mm_shuffle_epi8(z, z_shuffle);
+        if (!isnan(x_tab) && depth[i] != 0)
+        {
+            z[i] = (float)depth[i];
+            x[i] = x_tab * z[i];
+            y[i] = y_table[i] * z[i];
+        }
+        else
+        {
+            x[i] = 0.f;
+            y[i] = 0.f;
+            z[i] = 0.f;
+        }
+    }
+}
 
-        // x0, y0, z0, x1, y1, z1, x2, y2
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x92), z, 0x24);
-        // z2, x3, y3, z3, x4, y4, z4, x5
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x24), z, 0x49);
-        // y5, z5, x6, y6, z6, x7, y7, z7
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x49), z, 0x92);
+static transformation_depth_to_xyz_f32_fn_t *
+transformation_get_depth_to_xyz_f32_kernel(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return transformation_depth_to_xyz_f32_sse41;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return transformation_depth_to_xyz_f32_avx2;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_depth_to_xyz_f32_avx512;
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return transformation_depth_to_xyz_f32_neon;
+#endif
+    default:
+        return transformation_depth_to_xyz_f32_scalar;
     }
 }
+
+static transformation_depth_to_xyz_planar_f32_fn_t *
+transformation_get_depth_to_xyz_planar_f32_kernel(k4a_transformation_instruction_set_t instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41:
+        return transformation_depth_to_xyz_planar_f32_sse41;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2:
+        return transformation_depth_to_xyz_planar_f32_avx2;
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512:
+        return transformation_depth_to_xyz_planar_f32_avx512;
+#endif
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+    case K4A_TRANSFORMATION_INSTRUCTION_SET_NEON:
+        return transformation_depth_to_xyz_planar_f32_neon;
 #endif
+    default:
+        return transformation_depth_to_xyz_planar_f32_scalar;
+    }
+}
 
 k4a_buffer_result_t
 transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_t *xy_tables,
+                                                   k4a_transformation_instruction_set_t instruction_set,
                                                    const uint8_t *depth_image_data,
                                                    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
                                                    uint8_t *xyz_image_data,
@@ -942,11 +1361,577 @@ transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_
         return K4A_BUFFER_RESULT_FAILED;
     }
 
-#ifdef _M_X64
-    transformation_depth_to_xyz_sse(xy_tables, (const void *)depth_image_data, (void *)xyz_image_data);
-#else
-    transformation_depth_to_xyz(xy_tables, (const void *)depth_image_data, (void *)xyz_image_data);
-#endif
+    if (!transformation_instruction_set_supported(instruction_set))
+    {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    transformation_depth_to_xyz_fn_t *depth_to_xyz = transformation_get_depth_to_xyz_kernel(instruction_set);
+    depth_to_xyz(xy_tables->x_table,
+                 xy_tables->y_table,
+                 (const uint16_t *)(const void *)depth_image_data,
+                 (int16_t *)(void *)xyz_image_data,
+                 xy_tables->width * xy_tables->height);
+
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+// Writes the points of a run of pixels that have a depth to the start of the output and returns their number.
+// Every point is stored before the count is advanced, which is safe because a point never lands past its own pixel.
+static size_t transformation_compact_xyz16_points(const int16_t *xyz,
+                                                  uint32_t first_index,
+                                                  int count,
+                                                  int16_t *points,
+                                                  uint32_t *pixel_indices)
+{
+    size_t n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        points[3 * n + 0] = xyz[3 * i + 0];
+        points[3 * n + 1] = xyz[3 * i + 1];
+        points[3 * n + 2] = xyz[3 * i + 2];
+        if (pixel_indices != NULL)
+        {
+            pixel_indices[n] = first_index + (uint32_t)i;
+        }
+        n += xyz[3 * i + 2] != 0;
+    }
+    return n;
+}
+
+// Same as transformation_compact_xyz16_points() for float coordinates, storing points as triplets if y_points and
+// z_points are NULL and as separate planes otherwise
+static size_t transformation_compact_xyz32f_points(const float *x,
+                                                   const float *y,
+                                                   const float *z,
+                                                   uint32_t first_index,
+                                                   int count,
+                                                   float *x_points,
+                                                   float *y_points,
+                                                   float *z_points,
+                                                   uint32_t *pixel_indices)
+{
+    size_t n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (y_points == NULL)
+        {
+            x_points[3 * n + 0] = x[i];
+            x_points[3 * n + 1] = y[i];
+            x_points[3 * n + 2] = z[i];
+        }
+        else
+        {
+            x_points[n] = x[i];
+            y_points[n] = y[i];
+            z_points[n] = z[i];
+        }
+        if (pixel_indices != NULL)
+        {
+            pixel_indices[n] = first_index + (uint32_t)i;
+        }
+        n += z[i] != 0.f;
+    }
+    return n;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_formatted_point_cloud_internal(
+    const k4a_transformation_xy_tables_t *xy_tables,
+    k4a_transformation_instruction_set_t instruction_set,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_point_cloud_format_t point_format,
+    bool skip_invalid_points,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+    uint8_t *pixel_index_data,
+    k4a_transformation_image_descriptor_t *pixel_index_descriptor,
+    size_t *point_count)
+{
+    if (point_cloud_descriptor == 0)
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    int width = xy_tables->width;
+    int height = xy_tables->height;
+    k4a_transformation_image_descriptor_t expected_point_cloud_descriptor;
+    switch (point_format)
+    {
+    case K4A_POINT_CLOUD_FORMAT_XYZ16:
+        expected_point_cloud_descriptor =
+            transformation_init_image_descriptor(width, height, width * 3 * (int)sizeof(int16_t));
+        break;
+    case K4A_POINT_CLOUD_FORMAT_XYZ32F:
+        expected_point_cloud_descriptor =
+            transformation_init_image_descriptor(width, height, width * 3 * (int)sizeof(float));
+        break;
+    case K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR:
+        expected_point_cloud_descriptor =
+            transformation_init_image_descriptor(width, 3 * height, width * (int)sizeof(float));
+        break;
+    default:
+        LOG_ERROR("Unexpected point cloud format %d.", point_format);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (point_cloud_data == 0 ||
+        transformation_compare_image_descriptors(point_cloud_descriptor, &expected_point_cloud_descriptor) == false)
+    {
+        if (point_cloud_data == 0)
+        {
+            LOG_ERROR("Point cloud data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected point cloud descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    if (pixel_index_data != 0 || pixel_index_descriptor != 0)
+    {
+        k4a_transformation_image_descriptor_t expected_pixel_index_descriptor =
+            transformation_init_image_descriptor(width, height, width * (int)sizeof(uint32_t));
+
+        if (pixel_index_data == 0 || pixel_index_descriptor == 0 ||
+            transformation_compare_image_descriptors(pixel_index_descriptor, &expected_pixel_index_descriptor) ==
+                false)
+        {
+            if (pixel_index_data == 0 || pixel_index_descriptor == 0)
+            {
+                LOG_ERROR("Pixel index data and descriptor must both be set or both be null.", 0);
+            }
+            else
+            {
+                LOG_ERROR("Unexpected pixel index descriptor, see details above.", 0);
+            }
+            return K4A_BUFFER_RESULT_TOO_SMALL;
+        }
+    }
+
+    if (depth_image_data == 0 || depth_image_descriptor == 0)
+    {
+        if (depth_image_data == 0)
+        {
+            LOG_ERROR("Depth image data is null.", 0);
+        }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_depth_image_descriptor =
+        transformation_init_image_descriptor(width, height, width * (int)sizeof(uint16_t));
+
+    if (transformation_compare_image_descriptors(depth_image_descriptor, &expected_depth_image_descriptor) == false)
+    {
+        LOG_ERROR("Unexpected depth image descriptor, see details above.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (!transformation_instruction_set_supported(instruction_set))
+    {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    int pixel_count = width * height;
+    const uint16_t *depth = (const uint16_t *)(const void *)depth_image_data;
+    uint32_t *pixel_indices = (uint32_t *)(void *)pixel_index_data;
+    int16_t *xyz16 = (int16_t *)(void *)point_cloud_data;
+    float *xyz32f = (float *)(void *)point_cloud_data;
+    float *y_plane = point_format == K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR ? xyz32f + pixel_count : NULL;
+    float *z_plane = point_format == K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR ? xyz32f + 2 * pixel_count : NULL;
+
+    if (!skip_invalid_points)
+    {
+        switch (point_format)
+        {
+        case K4A_POINT_CLOUD_FORMAT_XYZ16:
+            transformation_get_depth_to_xyz_kernel(instruction_set)(
+                xy_tables->x_table, xy_tables->y_table, depth, xyz16, pixel_count);
+            break;
+        case K4A_POINT_CLOUD_FORMAT_XYZ32F:
+            transformation_get_depth_to_xyz_f32_kernel(instruction_set)(
+                xy_tables->x_table, xy_tables->y_table, depth, xyz32f, pixel_count);
+            break;
+        default:
+            transformation_get_depth_to_xyz_planar_f32_kernel(instruction_set)(
+                xy_tables->x_table, xy_tables->y_table, depth, xyz32f, y_plane, z_plane, pixel_count);
+            break;
+        }
+
+        if (pixel_indices != NULL)
+        {
+            for (int i = 0; i < pixel_count; i++)
+            {
+                pixel_indices[i] = (uint32_t)i;
+            }
+        }
+
+        if (point_count != NULL)
+        {
+            *point_count = (size_t)pixel_count;
+        }
+        return K4A_BUFFER_RESULT_SUCCEEDED;
+    }
+
+    // Blocks of pixels are converted by the dense kernels into buffers on the stack and then compacted into the output
+    transformation_depth_to_xyz_fn_t *depth_to_xyz = transformation_get_depth_to_xyz_kernel(instruction_set);
+    transformation_depth_to_xyz_planar_f32_fn_t *depth_to_xyz_planar_f32 =
+        transformation_get_depth_to_xyz_planar_f32_kernel(instruction_set);
+    int16_t block_xyz16[3 * TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float block_x[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float block_y[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    float block_z[TRANSFORMATION_BATCH_BLOCK_SIZE];
+
+    size_t n = 0;
+    for (int i = 0; i < pixel_count; i += TRANSFORMATION_BATCH_BLOCK_SIZE)
+    {
+        int count = transformation_min2(pixel_count - i, TRANSFORMATION_BATCH_BLOCK_SIZE);
+        uint32_t *block_pixel_indices = pixel_indices != NULL ? pixel_indices + n : NULL;
+
+        if (point_format == K4A_POINT_CLOUD_FORMAT_XYZ16)
+        {
+            depth_to_xyz(xy_tables->x_table + i, xy_tables->y_table + i, depth + i, block_xyz16, count);
+            n += transformation_compact_xyz16_points(
+                block_xyz16, (uint32_t)i, count, xyz16 + 3 * n, block_pixel_indices);
+        }
+        else
+        {
+            depth_to_xyz_planar_f32(
+                xy_tables->x_table + i, xy_tables->y_table + i, depth + i, block_x, block_y, block_z, count);
+            if (y_plane == NULL)
+            {
+                n += transformation_compact_xyz32f_points(
+                    block_x, block_y, block_z, (uint32_t)i, count, xyz32f + 3 * n, NULL, NULL, block_pixel_indices);
+            }
+            else
+            {
+                n += transformation_compact_xyz32f_points(block_x,
+                                                          block_y,
+                                                          block_z,
+                                                          (uint32_t)i,
+                                                          count,
+                                                          xyz32f + n,
+                                                          y_plane + n,
+                                                          z_plane + n,
+                                                          block_pixel_indices);
+            }
+        }
+    }
 
+    if (point_count != NULL)
+    {
+        *point_count = n;
+    }
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
+
+size_t transformation_get_colored_point_size(k4a_colored_point_format_t point_format)
+{
+    switch (point_format)
+    {
+    case K4A_COLORED_POINT_FORMAT_XYZ16_BGRA32:
+        return 3 * sizeof(int16_t) + 4 * sizeof(uint8_t);
+    case K4A_COLORED_POINT_FORMAT_XYZ16_RGB24:
+        return 3 * sizeof(int16_t) + 3 * sizeof(uint8_t);
+    case K4A_COLORED_POINT_FORMAT_XYZ16_PAD16_BGRA32:
+        return 4 * sizeof(int16_t) + 4 * sizeof(uint8_t);
+    default:
+        return 0;
+    }
+}
+
+// Packs the positions and colors of a run of depth pixels into points and returns the number of points written
+static size_t transformation_pack_colored_points(const int16_t *xyz,
+                                                 const uint8_t *bgra,
+                                                 int count,
+                                                 k4a_colored_point_format_t point_format,
+                                                 bool skip_invalid_points,
+                                                 uint8_t *points)
+{
+    size_t point_size = transformation_get_colored_point_size(point_format);
+    uint8_t *point = points;
+    for (int i = 0; i < count; i++, xyz += 3, bgra += 4)
+    {
+        // Pixels without a position have z = 0 and pixels without a color are (0, 0, 0, 0)
+        if (skip_invalid_points && (xyz[2] == 0 || (bgra[0] == 0 && bgra[1] == 0 && bgra[2] == 0 && bgra[3] == 0)))
+        {
+            continue;
+        }
+
+        memcpy(point, xyz, 3 * sizeof(int16_t));
+        switch (point_format)
+        {
+        case K4A_COLORED_POINT_FORMAT_XYZ16_RGB24:
+            point[6] = bgra[2];
+            point[7] = bgra[1];
+            point[8] = bgra[0];
+            break;
+        case K4A_COLORED_POINT_FORMAT_XYZ16_PAD16_BGRA32:
+            point[6] = 0;
+            point[7] = 0;
+            memcpy(point + 8, bgra, 4);
+            break;
+        default:
+            memcpy(point + 6, bgra, 4);
+            break;
+        }
+        point += point_size;
+    }
+    return (size_t)(point - points) / point_size;
+}
+
+typedef struct _k4a_transformation_colored_point_cloud_band_t
+{
+    const k4a_transformation_rgbz_context_t *context;
+    transformation_interpolate_bgra_fn_t *interpolate_bgra;
+    transformation_depth_to_xyz_fn_t *depth_to_xyz;
+    k4a_colored_point_format_t point_format;
+    bool skip_invalid_points;
+    float *points;      // color image coordinates of one depth row, as x, y pairs
+    uint8_t *bgra;      // colors of one depth row
+    int16_t *xyz;       // positions of one depth row
+    int row_begin;      // first depth row of the band
+    int row_end;        // one past the last depth row of the band
+    uint8_t *output;    // location of the first point of the band
+    size_t point_count; // number of points written by the band
+    k4a_result_t result;
+} k4a_transformation_colored_point_cloud_band_t;
+
+static int transformation_colored_point_cloud_band(void *param)
+{
+    k4a_transformation_colored_point_cloud_band_t *band = (k4a_transformation_colored_point_cloud_band_t *)param;
+    const k4a_transformation_rgbz_context_t *context = band->context;
+    int width = context->depth_image.descriptor->width_pixels;
+    size_t point_size = transformation_get_colored_point_size(band->point_format);
+    uint8_t *output = band->output;
+
+    band->point_count = 0;
+    band->result = K4A_RESULT_SUCCEEDED;
+    for (int y = band->row_begin; y < band->row_end; y++)
+    {
+        // Colors and positions of a row stay in the cache until they are packed, so the frame is only written once
+        if (K4A_FAILED(TRACE_CALL(transformation_color_to_depth_row_points(context, y, band->points))))
+        {
+            band->result = K4A_RESULT_FAILED;
+            return 0;
+        }
+
+        memset(band->bgra, 0, 4 * (size_t)width);
+        band->interpolate_bgra(context->color_image.data_uint8,
+                               context->color_image.descriptor->stride_bytes,
+                               band->points,
+                               band->bgra,
+                               width);
+
+        size_t row_offset = (size_t)y * (size_t)width;
+        band->depth_to_xyz(context->xy_tables->x_table + row_offset,
+                           context->xy_tables->y_table + row_offset,
+                           context->depth_image.data_uint16 + row_offset,
+                           band->xyz,
+                           width);
+
+        size_t count = transformation_pack_colored_points(
+            band->xyz, band->bgra, width, band->point_format, band->skip_invalid_points, output);
+        output += count * point_size;
+        band->point_count += count;
+    }
+    return 0;
+}
+
+static k4a_result_t transformation_colored_point_cloud(k4a_transformation_rgbz_context_t *context,
+                                                       k4a_colored_point_format_t point_format,
+                                                       bool skip_invalid_points,
+                                                       size_t *point_count,
+                                                       k4a_transformation_instruction_set_t instruction_set,
+                                                       k4a_transformation_worker_pool_t *worker_pool,
+                                                       uint32_t thread_count)
+{
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
+    size_t point_size = transformation_get_colored_point_size(point_format);
+    if (thread_count > (uint32_t)height)
+    {
+        thread_count = (uint32_t)height;
+    }
+    if (thread_count == 0)
+    {
+        if (point_count != NULL)
+        {
+            *point_count = 0;
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    k4a_transformation_colored_point_cloud_band_t bands[K4A_TRANSFORMATION_MAX_THREAD_COUNT];
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        // One row of color image coordinates, colors and positions per band
+        uint8_t *row = (uint8_t *)transformation_worker_pool_get_band_scratch(worker_pool,
+                                                                               i,
+                                                                               transformation_get_band_scratch_size(
+                                                                                   width));
+        if (row == NULL)
+        {
+            LOG_ERROR("Colored point cloud rows do not fit the scratch memory of the transformation.", 0);
+            return K4A_RESULT_FAILED;
+        }
+        bands[i].context = context;
+        bands[i].interpolate_bgra = transformation_get_interpolate_bgra_kernel(instruction_set);
+        bands[i].depth_to_xyz = transformation_get_depth_to_xyz_kernel(instruction_set);
+        bands[i].point_format = point_format;
+        bands[i].skip_invalid_points = skip_invalid_points;
+        bands[i].points = (float *)(void *)row;
+        bands[i].bgra = row + 2 * (size_t)width * sizeof(float);
+        bands[i].xyz = (int16_t *)(void *)(bands[i].bgra + 4 * (size_t)width);
+        bands[i].row_begin = (int)((int64_t)height * i / thread_count);
+        bands[i].row_end = (int)((int64_t)height * (i + 1) / thread_count);
+        bands[i].output = context->transformed_image.data_uint8 +
+                          (size_t)bands[i].row_begin * (size_t)width * point_size;
+        bands[i].point_count = 0;
+        bands[i].result = K4A_RESULT_SUCCEEDED;
+    }
+
+    transformation_worker_pool_run(worker_pool,
+                                   transformation_colored_point_cloud_band,
+                                   bands,
+                                   sizeof(k4a_transformation_colored_point_cloud_band_t),
+                                   thread_count);
+
+    // Each band starts writing at its first row, so skipped points leave gaps between the bands that are closed here
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    uint8_t *output = context->transformed_image.data_uint8;
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        if (K4A_FAILED(bands[i].result))
+        {
+            result = K4A_RESULT_FAILED;
+            continue;
+        }
+        if (output != bands[i].output)
+        {
+            memmove(output, bands[i].output, bands[i].point_count * point_size);
+        }
+        output += bands[i].point_count * point_size;
+    }
+
+    if (point_count != NULL)
+    {
+        *point_count = (size_t)(output - context->transformed_image.data_uint8) / point_size;
+    }
+    return result;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_colored_point_format_t point_format,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor)
+{
+    if (point_cloud_descriptor == 0 || calibration == 0)
+    {
+        if (calibration == 0)
+        {
+            LOG_ERROR("Calibration is null.", 0);
+        }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    size_t point_size = transformation_get_colored_point_size(point_format);
+    if (point_size == 0)
+    {
+        LOG_ERROR("Unexpected colored point format %d.", point_format);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_point_cloud_descriptor =
+        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
+                                             calibration->depth_camera_calibration.resolution_height,
+                                             calibration->depth_camera_calibration.resolution_width *
+                                                 (int)point_size);
+
+    if (point_cloud_data == 0 ||
+        transformation_compare_image_descriptors(point_cloud_descriptor, &expected_point_cloud_descriptor) == false)
+    {
+        if (point_cloud_data == 0)
+        {
+            LOG_ERROR("Point cloud data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected point cloud descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    return TRACE_BUFFER_CALL(transformation_validate_depth_and_color_images(calibration,
+                                                                            xy_tables_depth_camera,
+                                                                            depth_image_data,
+                                                                            depth_image_descriptor,
+                                                                            color_image_data,
+                                                                            color_image_descriptor));
+}
+
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const k4a_transformation_correspondence_table_t *correspondence_table,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_colored_point_format_t point_format,
+    bool skip_invalid_points,
+    uint8_t *point_cloud_data,
+    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+    size_t *point_count,
+    k4a_transformation_instruction_set_t instruction_set,
+    k4a_transformation_worker_pool_t *worker_pool)
+{
+    if (K4A_BUFFER_RESULT_SUCCEEDED !=
+        TRACE_BUFFER_CALL(
+            transformation_depth_image_to_colored_point_cloud_validate_parameters(calibration,
+                                                                                  xy_tables_depth_camera,
+                                                                                  depth_image_data,
+                                                                                  depth_image_descriptor,
+                                                                                  color_image_data,
+                                                                                  color_image_descriptor,
+                                                                                  point_format,
+                                                                                  point_cloud_data,
+                                                                                  point_cloud_descriptor)))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_rgbz_context_t context;
+    memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
+
+    context.xy_tables = xy_tables_depth_camera;
+    context.correspondence_table = correspondence_table;
+    context.calibration = calibration;
+
+    context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
+
+    context.color_image = transformation_init_input_image(color_image_descriptor, color_image_data);
+
+    context.transformed_image = transformation_init_output_image(point_cloud_descriptor, point_cloud_data);
+
+    if (!transformation_instruction_set_supported(instruction_set))
+    {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    uint32_t thread_count = transformation_worker_pool_acquire(worker_pool);
+    k4a_result_t result = TRACE_CALL(transformation_colored_point_cloud(
+        &context, point_format, skip_invalid_points, point_count, instruction_set, worker_pool, thread_count));
+    transformation_worker_pool_release(worker_pool);
+    return K4A_SUCCEEDED(result) ? K4A_BUFFER_RESULT_SUCCEEDED : K4A_BUFFER_RESULT_FAILED;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with AVX2 code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_AVX2).
+
+#include "transformation_priv.h"
+#include "rgbz_x86.h"
+
+#include <immintrin.h> // AVX2
+
+// Computes floor(table * depth + 0.5) for 8 pixels and returns the results truncated to int16
+static inline __m128i transformation_round_xyz_avx2(__m256 table, __m256 depth)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256i v = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(table, depth), half)));
+    return transformation_pack_truncate_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+static inline void transformation_depth_to_xyz_8_avx2(const float *x_table,
+                                                      const float *y_table,
+                                                      const uint16_t *depth,
+                                                      int16_t *xyz)
+{
+    __m256 x_tab = _mm256_loadu_ps(x_table);
+    __m256 y_tab = _mm256_loadu_ps(y_table);
+
+    // A NAN x table entry marks an invalid pixel
+    __m256i valid_epi32 = _mm256_castps_si256(_mm256_cmp_ps(x_tab, x_tab, _CMP_ORD_Q));
+    __m128i valid = _mm_packs_epi32(_mm256_castsi256_si128(valid_epi32), _mm256_extracti128_si256(valid_epi32, 1));
+
+    __m128i z = _mm_and_si128(_mm_loadu_si128((const __m128i *)(const void *)depth), valid);
+
+    // The scalar kernel interprets depth as int16_t, so sign extend to match
+    __m256 depth_ps = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(z));
+
+    __m128i x = _mm_and_si128(transformation_round_xyz_avx2(x_tab, depth_ps), valid);
+    __m128i y = _mm_and_si128(transformation_round_xyz_avx2(y_tab, depth_ps), valid);
+
+    transformation_store_xyz_sse41(xyz, x, y, z);
+}
+
+void transformation_depth_to_xyz_avx2(const float *x_table,
+                                      const float *y_table,
+                                      const uint16_t *depth,
+                                      int16_t *xyz,
+                                      int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        transformation_depth_to_xyz_8_avx2(x_table + i, y_table + i, depth + i, xyz + 3 * i);
+        transformation_depth_to_xyz_8_avx2(x_table + i + 8, y_table + i + 8, depth + i + 8, xyz + 3 * (i + 8));
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+// Computes the float coordinates of 8 pixels, zeroing pixels with a NAN x table entry or a depth of 0
+static inline void transformation_depth_to_xyz_f32_8_avx2(const float *x_table,
+                                                          const float *y_table,
+                                                          const uint16_t *depth,
+                                                          __m256 *x,
+                                                          __m256 *y,
+                                                          __m256 *z)
+{
+    __m256 x_tab = _mm256_loadu_ps(x_table);
+    __m256 y_tab = _mm256_loadu_ps(y_table);
+    __m256i depth_epi32 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(const void *)depth));
+    __m256 depth_ps = _mm256_cvtepi32_ps(depth_epi32);
+
+    __m256 valid = _mm256_and_ps(_mm256_cmp_ps(x_tab, x_tab, _CMP_ORD_Q),
+                                 _mm256_cmp_ps(depth_ps, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+    *x = _mm256_and_ps(_mm256_mul_ps(x_tab, depth_ps), valid);
+    *y = _mm256_and_ps(_mm256_mul_ps(y_tab, depth_ps), valid);
+    *z = _mm256_and_ps(depth_ps, valid);
+}
+
+void transformation_depth_to_xyz_f32_avx2(const float *x_table,
+                                          const float *y_table,
+                                          const uint16_t *depth,
+                                          float *xyz,
+                                          int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x, y, z;
+        transformation_depth_to_xyz_f32_8_avx2(x_table + i, y_table + i, depth + i, &x, &y, &z);
+        transformation_store_xyz_f32_sse41(xyz + 3 * i,
+                                           _mm256_castps256_ps128(x),
+                                           _mm256_castps256_ps128(y),
+                                           _mm256_castps256_ps128(z));
+        transformation_store_xyz_f32_sse41(xyz + 3 * (i + 4),
+                                           _mm256_extractf128_ps(x, 1),
+                                           _mm256_extractf128_ps(y, 1),
+                                           _mm256_extractf128_ps(z, 1));
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_f32_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+void transformation_depth_to_xyz_planar_f32_avx2(const float *x_table,
+                                                 const float *y_table,
+                                                 const uint16_t *depth,
+                                                 float *x,
+                                                 float *y,
+                                                 float *z,
+                                                 int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x_ps, y_ps, z_ps;
+        transformation_depth_to_xyz_f32_8_avx2(x_table + i, y_table + i, depth + i, &x_ps, &y_ps, &z_ps);
+        _mm256_storeu_ps(x + i, x_ps);
+        _mm256_storeu_ps(y + i, y_ps);
+        _mm256_storeu_ps(z + i, z_ps);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_planar_f32_scalar(
+            x_table + i, y_table + i, depth + i, x + i, y + i, z + i, count - i);
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with AVX-512F code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_AVX512).
+
+#include "transformation_priv.h"
+#include "rgbz_x86.h"
+
+#include <immintrin.h> // AVX-512F
+
+// Computes floor(table * depth + 0.5) for 16 pixels, zeroes invalid pixels and truncates the results to int16
+static inline __m256i transformation_round_xyz_avx512(__m512 table, __m512 depth, __mmask16 valid)
+{
+    const __m512 half = _mm512_set1_ps(0.5f);
+    __m512 v = _mm512_roundscale_ps(_mm512_add_ps(_mm512_mul_ps(table, depth), half),
+                                    _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    return _mm512_cvtepi32_epi16(_mm512_maskz_mov_epi32(valid, _mm512_cvttps_epi32(v)));
+}
+
+void transformation_depth_to_xyz_avx512(const float *x_table,
+                                        const float *y_table,
+                                        const uint16_t *depth,
+                                        int16_t *xyz,
+                                        int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x_tab = _mm512_loadu_ps(x_table + i);
+        __m512 y_tab = _mm512_loadu_ps(y_table + i);
+
+        // A NAN x table entry marks an invalid pixel
+        __mmask16 valid = _mm512_cmp_ps_mask(x_tab, x_tab, _CMP_ORD_Q);
+
+        // The scalar kernel interprets depth as int16_t, so sign extend to match
+        __m256i depth_epi16 = _mm256_loadu_si256((const __m256i *)(const void *)(depth + i));
+        __m512i z_epi32 = _mm512_maskz_mov_epi32(valid, _mm512_cvtepi16_epi32(depth_epi16));
+        __m512 depth_ps = _mm512_cvtepi32_ps(z_epi32);
+
+        __m256i x = transformation_round_xyz_avx512(x_tab, depth_ps, valid);
+        __m256i y = transformation_round_xyz_avx512(y_tab, depth_ps, valid);
+        __m256i z = _mm512_cvtepi32_epi16(z_epi32);
+
+        transformation_store_xyz_sse41(xyz + 3 * i,
+                                       _mm256_castsi256_si128(x),
+                                       _mm256_castsi256_si128(y),
+                                       _mm256_castsi256_si128(z));
+        transformation_store_xyz_sse41(xyz + 3 * (i + 8),
+                                       _mm256_extracti128_si256(x, 1),
+                                       _mm256_extracti128_si256(y, 1),
+                                       _mm256_extracti128_si256(z, 1));
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+// Computes the float coordinates of 16 pixels, zeroing pixels with a NAN x table entry or a depth of 0
+static inline void transformation_depth_to_xyz_f32_16_avx512(const float *x_table,
+                                                             const float *y_table,
+                                                             const uint16_t *depth,
+                                                             __m512 *x,
+                                                             __m512 *y,
+                                                             __m512 *z)
+{
+    __m512 x_tab = _mm512_loadu_ps(x_table);
+    __m512 y_tab = _mm512_loadu_ps(y_table);
+    __m512i depth_epi32 = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)(const void *)depth));
+    __m512 depth_ps = _mm512_cvtepi32_ps(depth_epi32);
+
+    __mmask16 valid = _mm512_cmp_ps_mask(x_tab, x_tab, _CMP_ORD_Q) &
+                      _mm512_cmp_ps_mask(depth_ps, _mm512_setzero_ps(), _CMP_NEQ_OQ);
+    *x = _mm512_maskz_mul_ps(valid, x_tab, depth_ps);
+    *y = _mm512_maskz_mul_ps(valid, y_tab, depth_ps);
+    *z = _mm512_maskz_mov_ps(valid, depth_ps);
+}
+
+void transformation_depth_to_xyz_f32_avx512(const float *x_table,
+                                            const float *y_table,
+                                            const uint16_t *depth,
+                                            float *xyz,
+                                            int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x, y, z;
+        transformation_depth_to_xyz_f32_16_avx512(x_table + i, y_table + i, depth + i, &x, &y, &z);
+        transformation_store_xyz_f32_sse41(xyz + 3 * i,
+                                           _mm512_extractf32x4_ps(x, 0),
+                                           _mm512_extractf32x4_ps(y, 0),
+                                           _mm512_extractf32x4_ps(z, 0));
+        transformation_store_xyz_f32_sse41(xyz + 3 * (i + 4),
+                                           _mm512_extractf32x4_ps(x, 1),
+                                           _mm512_extractf32x4_ps(y, 1),
+                                           _mm512_extractf32x4_ps(z, 1));
+        transformation_store_xyz_f32_sse41(xyz + 3 * (i + 8),
+                                           _mm512_extractf32x4_ps(x, 2),
+                                           _mm512_extractf32x4_ps(y, 2),
+                                           _mm512_extractf32x4_ps(z, 2));
+        transformation_store_xyz_f32_sse41(xyz + 3 * (i + 12),
+                                           _mm512_extractf32x4_ps(x, 3),
+                                           _mm512_extractf32x4_ps(y, 3),
+                                           _mm512_extractf32x4_ps(z, 3));
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_f32_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+void transformation_depth_to_xyz_planar_f32_avx512(const float *x_table,
+                                                   const float *y_table,
+                                                   const uint16_t *depth,
+                                                   float *x,
+                                                   float *y,
+                                                   float *z,
+                                                   int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x_ps, y_ps, z_ps;
+        transformation_depth_to_xyz_f32_16_avx512(x_table + i, y_table + i, depth + i, &x_ps, &y_ps, &z_ps);
+        _mm512_storeu_ps(x + i, x_ps);
+        _mm512_storeu_ps(y + i, y_ps);
+        _mm512_storeu_ps(z + i, z_ps);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_planar_f32_scalar(
+            x_table + i, y_table + i, depth + i, x + i, y + i, z + i, count - i);
+    }
+}
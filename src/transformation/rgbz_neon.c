@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// NEON is part of the AArch64 baseline, so this kernel needs no runtime check.
+
+#include "transformation_priv.h"
+
+#include <arm_neon.h>
+#include <math.h>
+#include <string.h>
+
+// Computes floor(table * depth + 0.5) for 4 pixels and returns the results truncated to int16
+static inline int16x4_t transformation_round_xyz_neon(float32x4_t table, float32x4_t depth)
+{
+    // Multiply and add separately; a fused multiply-add would not match the scalar kernel
+    float32x4_t v = vaddq_f32(vmulq_f32(table, depth), vdupq_n_f32(0.5f));
+    return vmovn_s32(vcvtq_s32_f32(vrndmq_f32(v)));
+}
+
+void transformation_depth_to_xyz_neon(const float *x_table,
+                                      const float *y_table,
+                                      const uint16_t *depth,
+                                      int16_t *xyz,
+                                      int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t x_tab_lo = vld1q_f32(x_table + i);
+        float32x4_t x_tab_hi = vld1q_f32(x_table + i + 4);
+        float32x4_t y_tab_lo = vld1q_f32(y_table + i);
+        float32x4_t y_tab_hi = vld1q_f32(y_table + i + 4);
+
+        // A NAN x table entry marks an invalid pixel
+        int16x8_t valid = vreinterpretq_s16_u16(
+            vcombine_u16(vmovn_u32(vceqq_f32(x_tab_lo, x_tab_lo)), vmovn_u32(vceqq_f32(x_tab_hi, x_tab_hi))));
+
+        // The scalar kernel interprets depth as int16_t
+        int16x8_t z = vandq_s16(vreinterpretq_s16_u16(vld1q_u16(depth + i)), valid);
+        float32x4_t depth_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(z)));
+        float32x4_t depth_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(z)));
+
+        int16x8x3_t out;
+        out.val[0] = vandq_s16(vcombine_s16(transformation_round_xyz_neon(x_tab_lo, depth_lo),
+                                            transformation_round_xyz_neon(x_tab_hi, depth_hi)),
+                               valid);
+        out.val[1] = vandq_s16(vcombine_s16(transformation_round_xyz_neon(y_tab_lo, depth_lo),
+                                            transformation_round_xyz_neon(y_tab_hi, depth_hi)),
+                               valid);
+        out.val[2] = z;
+        vst3q_s16(xyz + 3 * i, out);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+// Computes the float coordinates of 4 pixels, zeroing pixels with a NAN x table entry or a depth of 0
+static inline float32x4x3_t transformation_depth_to_xyz_f32_4_neon(const float *x_table,
+                                                                   const float *y_table,
+                                                                   const uint16_t *depth)
+{
+    float32x4_t x_tab = vld1q_f32(x_table);
+    float32x4_t y_tab = vld1q_f32(y_table);
+    float32x4_t depth_f32 = vcvtq_f32_u32(vmovl_u16(vld1_u16(depth)));
+
+    uint32x4_t valid = vandq_u32(vceqq_f32(x_tab, x_tab), vmvnq_u32(vceqq_f32(depth_f32, vdupq_n_f32(0.f))));
+
+    float32x4x3_t xyz;
+    xyz.val[0] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(x_tab, depth_f32)), valid));
+    xyz.val[1] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(y_tab, depth_f32)), valid));
+    xyz.val[2] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(depth_f32), valid));
+    return xyz;
+}
+
+void transformation_depth_to_xyz_f32_neon(const float *x_table,
+                                          const float *y_table,
+                                          const uint16_t *depth,
+                                          float *xyz,
+                                          int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        vst3q_f32(xyz + 3 * i, transformation_depth_to_xyz_f32_4_neon(x_table + i, y_table + i, depth + i));
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_f32_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+void transformation_depth_to_xyz_planar_f32_neon(const float *x_table,
+                                                 const float *y_table,
+                                                 const uint16_t *depth,
+                                                 float *x,
+                                                 float *y,
+                                                 float *z,
+                                                 int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4x3_t xyz = transformation_depth_to_xyz_f32_4_neon(x_table + i, y_table + i, depth + i);
+        vst1q_f32(x + i, xyz.val[0]);
+        vst1q_f32(y + i, xyz.val[1]);
+        vst1q_f32(z + i, xyz.val[2]);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_planar_f32_scalar(
+            x_table + i, y_table + i, depth + i, x + i, y + i, z + i, count - i);
+    }
+}
+
+void transformation_interpolate_bgra_neon(const uint8_t *color,
+                                          int color_stride,
+                                          const float *points,
+                                          uint8_t *bgra,
+                                          int count)
+{
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+
+    for (int i = 0; i < count; i++, points += 2, bgra += 4)
+    {
+        if (isnan(points[0]))
+        {
+            continue;
+        }
+
+        int x_floor = (int)floorf(points[0]);
+        int y_floor = (int)floorf(points[1]);
+        float32x4_t weight_x = vdupq_n_f32(points[0] - x_floor);
+        float32x4_t weight_y = vdupq_n_f32(points[1] - y_floor);
+
+        // Each load holds the left and right neighbor of one row
+        const uint8_t *top = color + y_floor * color_stride + 4 * x_floor;
+        uint16x8_t top_pixels = vmovl_u8(vld1_u8(top));
+        uint16x8_t bottom_pixels = vmovl_u8(vld1_u8(top + color_stride));
+        float32x4_t top_left = vcvtq_f32_u32(vmovl_u16(vget_low_u16(top_pixels)));
+        float32x4_t top_right = vcvtq_f32_u32(vmovl_u16(vget_high_u16(top_pixels)));
+        float32x4_t bottom_left = vcvtq_f32_u32(vmovl_u16(vget_low_u16(bottom_pixels)));
+        float32x4_t bottom_right = vcvtq_f32_u32(vmovl_u16(vget_high_u16(bottom_pixels)));
+
+        // Multiply and add separately in the scalar kernel's order; a fused multiply-add would not match it
+        float32x4_t inverse_weight_x = vsubq_f32(one, weight_x);
+        float32x4_t interpol_top = vaddq_f32(vmulq_f32(inverse_weight_x, top_left), vmulq_f32(weight_x, top_right));
+        float32x4_t interpol_bottom = vaddq_f32(vmulq_f32(inverse_weight_x, bottom_left),
+                                                vmulq_f32(weight_x, bottom_right));
+        float32x4_t interpol = vaddq_f32(vmulq_f32(vsubq_f32(one, weight_y), interpol_top),
+                                         vmulq_f32(weight_y, interpol_bottom));
+
+        uint16x4_t value_u16 = vmovn_u32(vcvtq_u32_f32(vaddq_f32(interpol, half)));
+        uint32_t value = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(value_u16, value_u16))), 0);
+
+        // (0,0,0,0) marks an invalid pixel, a valid black pixel is written as (1,0,0,0)
+        value = value == 0 ? 1 : value;
+        memcpy(bgra, &value, sizeof(value));
+    }
+}
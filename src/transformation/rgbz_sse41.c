@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This file is built with SSE4.1 code generation enabled and must only be called after checking
+// transformation_instruction_set_supported(K4A_TRANSFORMATION_INSTRUCTION_SET_SSE41).
+
+#include "transformation_priv.h"
+#include "rgbz_x86.h"
+
+#include <string.h>
+
+// Computes floor(table * depth + 0.5) for 8 pixels and returns the results truncated to int16
+static inline __m128i transformation_round_xyz_sse41(__m128 table_lo, __m128 table_hi, __m128 depth_lo, __m128 depth_hi)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128i lo = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(_mm_mul_ps(table_lo, depth_lo), half)));
+    __m128i hi = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(_mm_mul_ps(table_hi, depth_hi), half)));
+    return transformation_pack_truncate_epi32(lo, hi);
+}
+
+void transformation_depth_to_xyz_sse41(const float *x_table,
+                                       const float *y_table,
+                                       const uint16_t *depth,
+                                       int16_t *xyz,
+                                       int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 x_tab_lo = _mm_loadu_ps(x_table + i);
+        __m128 x_tab_hi = _mm_loadu_ps(x_table + i + 4);
+        __m128 y_tab_lo = _mm_loadu_ps(y_table + i);
+        __m128 y_tab_hi = _mm_loadu_ps(y_table + i + 4);
+
+        // A NAN x table entry marks an invalid pixel
+        __m128i valid = _mm_packs_epi32(_mm_castps_si128(_mm_cmpord_ps(x_tab_lo, x_tab_lo)),
+                                        _mm_castps_si128(_mm_cmpord_ps(x_tab_hi, x_tab_hi)));
+
+        __m128i z = _mm_and_si128(_mm_loadu_si128((const __m128i *)(const void *)(depth + i)), valid);
+
+        // The scalar kernel interprets depth as int16_t, so sign extend to match
+        __m128 depth_lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(z));
+        __m128 depth_hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(z, 8)));
+
+        __m128i x = _mm_and_si128(transformation_round_xyz_sse41(x_tab_lo, x_tab_hi, depth_lo, depth_hi), valid);
+        __m128i y = _mm_and_si128(transformation_round_xyz_sse41(y_tab_lo, y_tab_hi, depth_lo, depth_hi), valid);
+
+        transformation_store_xyz_sse41(xyz + 3 * i, x, y, z);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+// Computes the float coordinates of 4 pixels, zeroing pixels with a NAN x table entry or a depth of 0
+static inline void transformation_depth_to_xyz_f32_4_sse41(const float *x_table,
+                                                           const float *y_table,
+                                                           const uint16_t *depth,
+                                                           __m128 *x,
+                                                           __m128 *y,
+                                                           __m128 *z)
+{
+    __m128 x_tab = _mm_loadu_ps(x_table);
+    __m128 y_tab = _mm_loadu_ps(y_table);
+    __m128i depth_epi32 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(const void *)depth));
+    __m128 depth_ps = _mm_cvtepi32_ps(depth_epi32);
+
+    __m128 valid = _mm_and_ps(_mm_cmpord_ps(x_tab, x_tab), _mm_cmpneq_ps(depth_ps, _mm_setzero_ps()));
+    *x = _mm_and_ps(_mm_mul_ps(x_tab, depth_ps), valid);
+    *y = _mm_and_ps(_mm_mul_ps(y_tab, depth_ps), valid);
+    *z = _mm_and_ps(depth_ps, valid);
+}
+
+void transformation_depth_to_xyz_f32_sse41(const float *x_table,
+                                           const float *y_table,
+                                           const uint16_t *depth,
+                                           float *xyz,
+                                           int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x, y, z;
+        transformation_depth_to_xyz_f32_4_sse41(x_table + i, y_table + i, depth + i, &x, &y, &z);
+        transformation_store_xyz_f32_sse41(xyz + 3 * i, x, y, z);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_f32_scalar(x_table + i, y_table + i, depth + i, xyz + 3 * i, count - i);
+    }
+}
+
+void transformation_depth_to_xyz_planar_f32_sse41(const float *x_table,
+                                                  const float *y_table,
+                                                  const uint16_t *depth,
+                                                  float *x,
+                                                  float *y,
+                                                  float *z,
+                                                  int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x_ps, y_ps, z_ps;
+        transformation_depth_to_xyz_f32_4_sse41(x_table + i, y_table + i, depth + i, &x_ps, &y_ps, &z_ps);
+        _mm_storeu_ps(x + i, x_ps);
+        _mm_storeu_ps(y + i, y_ps);
+        _mm_storeu_ps(z + i, z_ps);
+    }
+
+    if (i < count)
+    {
+        transformation_depth_to_xyz_planar_f32_scalar(
+            x_table + i, y_table + i, depth + i, x + i, y + i, z + i, count - i);
+    }
+}
+
+// Interpolates all four channels of one BGRA pixel from its top left neighbor at top and the fractional offsets fx, fy
+static inline int transformation_interpolate_bgra_pixel_sse41(const uint8_t *top, int color_stride, float fx, float fy)
+{
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    // Each load holds the left and right neighbor of one row
+    __m128i top_pixels = _mm_loadl_epi64((const __m128i *)(const void *)top);
+    __m128i bottom_pixels = _mm_loadl_epi64((const __m128i *)(const void *)(top + color_stride));
+    __m128 top_left = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(top_pixels));
+    __m128 top_right = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(top_pixels, 4)));
+    __m128 bottom_left = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bottom_pixels));
+    __m128 bottom_right = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bottom_pixels, 4)));
+
+    // Same operation order as the scalar kernel so that the results are bit-identical
+    __m128 weight_x = _mm_set1_ps(fx);
+    __m128 weight_y = _mm_set1_ps(fy);
+    __m128 inverse_weight_x = _mm_sub_ps(one, weight_x);
+    __m128 interpol_top = _mm_add_ps(_mm_mul_ps(inverse_weight_x, top_left), _mm_mul_ps(weight_x, top_right));
+    __m128 interpol_bottom = _mm_add_ps(_mm_mul_ps(inverse_weight_x, bottom_left), _mm_mul_ps(weight_x, bottom_right));
+    __m128 interpol = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, weight_y), interpol_top),
+                                 _mm_mul_ps(weight_y, interpol_bottom));
+
+    __m128i value = _mm_cvttps_epi32(_mm_add_ps(interpol, half));
+    value = _mm_packus_epi16(_mm_packus_epi32(value, value), value);
+    return _mm_cvtsi128_si32(value);
+}
+
+void transformation_interpolate_bgra_sse41(const uint8_t *color,
+                                           int color_stride,
+                                           const float *points,
+                                           uint8_t *bgra,
+                                           int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Split 4 x, y pairs into x and y vectors and compute the neighbor offsets and weights of all 4 pixels
+        __m128 xy_lo = _mm_loadu_ps(points + 2 * i);
+        __m128 xy_hi = _mm_loadu_ps(points + 2 * i + 4);
+        __m128 x = _mm_shuffle_ps(xy_lo, xy_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(xy_lo, xy_hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+        int valid = _mm_movemask_ps(_mm_cmpord_ps(x, x));
+        if (valid == 0)
+        {
+            continue;
+        }
+
+        __m128i x_floor = _mm_cvttps_epi32(_mm_floor_ps(x));
+        __m128i y_floor = _mm_cvttps_epi32(_mm_floor_ps(y));
+
+        float fx[4], fy[4];
+        int32_t offset[4];
+        _mm_storeu_ps(fx, _mm_sub_ps(x, _mm_cvtepi32_ps(x_floor)));
+        _mm_storeu_ps(fy, _mm_sub_ps(y, _mm_cvtepi32_ps(y_floor)));
+        _mm_storeu_si128((__m128i *)(void *)offset,
+                         _mm_add_epi32(_mm_mullo_epi32(y_floor, _mm_set1_epi32(color_stride)),
+                                       _mm_slli_epi32(x_floor, 2)));
+
+        for (int j = 0; j < 4; j++)
+        {
+            if (valid & (1 << j))
+            {
+                int value = transformation_interpolate_bgra_pixel_sse41(color + offset[j], color_stride, fx[j], fy[j]);
+
+                // (0,0,0,0) marks an invalid pixel, a valid black pixel is written as (1,0,0,0)
+                value = value == 0 ? 1 : value;
+                memcpy(bgra + 4 * (i + j), &value, sizeof(value));
+            }
+        }
+    }
+
+    if (i < count)
+    {
+        transformation_interpolate_bgra_scalar(color, color_stride, points + 2 * i, bgra + 4 * i, count - i);
+    }
+}
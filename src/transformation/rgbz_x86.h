@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef RGBZ_X86_H
+#define RGBZ_X86_H
+
+// Shared helpers for the x86 point cloud kernels. Only include from a translation unit compiled with SSE4.1 or better.
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <smmintrin.h> // SSE4.1
+
+#include <stdint.h>
+
+// Packs the low 16 bits of each 32-bit lane, matching the (int16_t) cast done by the scalar kernel
+static inline __m128i transformation_pack_truncate_epi32(__m128i lo, __m128i hi)
+{
+    const __m128i low_16_bits = _mm_set1_epi32(0xFFFF);
+    return _mm_packus_epi32(_mm_and_si128(lo, low_16_bits), _mm_and_si128(hi, low_16_bits));
+}
+
+// Interleaves 8 x, y and z values into 8 XYZ triplets (24 int16 values)
+static inline void transformation_store_xyz_sse41(int16_t *xyz, __m128i x, __m128i y, __m128i z)
+{
+    const int16_t pos0 = 0x0100;
+    const int16_t pos1 = 0x0302;
+    const int16_t pos2 = 0x0504;
+    const int16_t pos3 = 0x0706;
+    const int16_t pos4 = 0x0908;
+    const int16_t pos5 = 0x0B0A;
+    const int16_t pos6 = 0x0D0C;
+    const int16_t pos7 = 0x0F0E;
+
+    // x0, x3, x6, x1, x4, x7, x2, x5
+    const __m128i x_shuffle = _mm_setr_epi16(pos0, pos3, pos6, pos1, pos4, pos7, pos2, pos5);
+    // y5, y0, y3, y6, y1, y4, y7, y2
+    const __m128i y_shuffle = _mm_setr_epi16(pos5, pos0, pos3, pos6, pos1, pos4, pos7, pos2);
+    // z2, z5, z0, z3, z6, z1, z4, z7
+    const __m128i z_shuffle = _mm_setr_epi16(pos2, pos5, pos0, pos3, pos6, pos1, pos4, pos7);
+
+    x = _mm_shuffle_epi8(x, x_shuffle);
+    y = _mm_shuffle_epi8(y, y_shuffle);
+    z = _mm_shuffle_epi8(z, z_shuffle);
+
+    __m128i *xyz_m128i = (__m128i *)(void *)xyz;
+    // x0, y0, z0, x1, y1, z1, x2, y2
+    _mm_storeu_si128(xyz_m128i + 0, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x92), z, 0x24));
+    // z2, x3, y3, z3, x4, y4, z4, x5
+    _mm_storeu_si128(xyz_m128i + 1, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x24), z, 0x49));
+    // y5, z5, x6, y6, z6, x7, y7, z7
+    _mm_storeu_si128(xyz_m128i + 2, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x49), z, 0x92));
+}
+
+// Interleaves 4 x, y and z values into 4 XYZ triplets (12 float values)
+static inline void transformation_store_xyz_f32_sse41(float *xyz, __m128 x, __m128 y, __m128 z)
+{
+    // x0, y0, x1, y1 and x2, y2, x3, y3
+    __m128 xy_lo = _mm_unpacklo_ps(x, y);
+    __m128 xy_hi = _mm_unpackhi_ps(x, y);
+
+    // z0, z0, x1, x1
+    __m128 z0_x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    // y1, y1, z1, z1
+    __m128 y1_z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    // z2, z2, x3, x3
+    __m128 z2_x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+    // y3, y3, z3, z3
+    __m128 y3_z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+    // x0, y0, z0, x1
+    _mm_storeu_ps(xyz, _mm_shuffle_ps(xy_lo, z0_x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    // y1, z1, x2, y2
+    _mm_storeu_ps(xyz + 4, _mm_shuffle_ps(y1_z1, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+    // z2, x3, y3, z3
+    _mm_storeu_ps(xyz + 8, _mm_shuffle_ps(z2_x3, y3_z3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+#endif // RGBZ_X86_H
@@ -4,11 +4,26 @@
 #include <k4ainternal/logging.h>
 #include <k4ainternal/deloader.h>
 #include <k4ainternal/tewrapper.h>
+#include <k4ainternal/math.h>
+#include <k4ainternal/atomic.h>
+#include "transformation_priv.h"
+
+// Dependent libraries
+#include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/lock.h>
 
 // System dependencies
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 k4a_result_t transformation_get_mode_specific_calibration(const k4a_calibration_camera_t *depth_camera_calibration,
                                                           const k4a_calibration_camera_t *color_camera_calibration,
                                                           const k4a_calibration_extrinsics_t *gyro_extrinsics,
@@ -254,23 +269,427 @@ k4a_result_t transformation_2d_to_2d(const k4a_calibration_t *calibration,
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t transformation_3d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           size_t point_count)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))) ||
+        K4A_FAILED(TRACE_CALL(transformation_possible(calibration, target_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (source_camera == target_camera)
+    {
+        if (target_points3d != source_points3d)
+        {
+            memcpy(target_points3d, source_points3d, 3 * point_count * sizeof(float));
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    const k4a_calibration_extrinsics_t *source_to_target = &calibration->extrinsics[source_camera][target_camera];
+    for (size_t i = 0; i < point_count; i++)
+    {
+        transformation_apply_extrinsic_transformation(source_to_target,
+                                                      source_points3d + 3 * i,
+                                                      target_points3d + 3 * i);
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_camera_t *camera_calibration;
+    if (source_camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        camera_calibration = &calibration->depth_camera_calibration;
+    }
+    else if (source_camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        camera_calibration = &calibration->color_camera_calibration;
+    }
+    else
+    {
+        LOG_ERROR("Unexpected source camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  source_camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return K4A_RESULT_FAILED; // unproject only supported for depth and color cameras
+    }
+
+    if (K4A_FAILED(TRACE_CALL(transformation_unproject_batch(
+            camera_calibration, source_points2d, source_depths, target_points3d, valid, point_count, instruction_set))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (source_camera == target_camera)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+    return TRACE_CALL(transformation_3d_to_3d_batch(
+        calibration, target_points3d, source_camera, target_camera, target_points3d, point_count));
+}
+
+k4a_result_t transformation_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, target_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // The extrinsics are applied point by point inside the projection loop instead of in a separate pass
+    const k4a_calibration_extrinsics_t *source_to_target = NULL;
+    if (source_camera != target_camera)
+    {
+        if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        source_to_target = &calibration->extrinsics[source_camera][target_camera];
+    }
+
+    const k4a_calibration_camera_t *camera_calibration;
+    if (target_camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        camera_calibration = &calibration->depth_camera_calibration;
+    }
+    else if (target_camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        camera_calibration = &calibration->color_camera_calibration;
+    }
+    else
+    {
+        LOG_ERROR("Unexpected target camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  target_camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return K4A_RESULT_FAILED; // project only supported for depth and color cameras
+    }
+
+    return TRACE_CALL(transformation_project_batch(
+        camera_calibration, source_to_target, source_points3d, target_points2d, valid, point_count, instruction_set));
+}
+
+k4a_result_t transformation_2d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid,
+                                           size_t point_count,
+                                           k4a_transformation_instruction_set_t instruction_set)
+{
+    if (source_camera == target_camera)
+    {
+        if (target_points2d != source_points2d)
+        {
+            memcpy(target_points2d, source_points2d, 2 * point_count * sizeof(float));
+        }
+        for (size_t i = 0; i < point_count; i++)
+        {
+            valid[i] = 1;
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))) ||
+        K4A_FAILED(TRACE_CALL(transformation_possible(calibration, target_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // Go through 3D one block at a time so the intermediate points stay in cache
+    float points3d[3 * TRANSFORMATION_BATCH_BLOCK_SIZE];
+    int projection_valid[TRANSFORMATION_BATCH_BLOCK_SIZE];
+    for (size_t begin = 0; begin < point_count; begin += TRANSFORMATION_BATCH_BLOCK_SIZE)
+    {
+        size_t remaining = point_count - begin;
+        size_t count = remaining < TRANSFORMATION_BATCH_BLOCK_SIZE ? remaining : TRANSFORMATION_BATCH_BLOCK_SIZE;
+        int *block_valid = valid + begin;
+
+        if (K4A_FAILED(TRACE_CALL(transformation_2d_to_3d_batch(calibration,
+                                                                source_points2d + 2 * begin,
+                                                                source_depths + begin,
+                                                                source_camera,
+                                                                target_camera,
+                                                                points3d,
+                                                                block_valid,
+                                                                count,
+                                                                instruction_set))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        if (K4A_FAILED(TRACE_CALL(transformation_3d_to_2d_batch(calibration,
+                                                                points3d,
+                                                                target_camera,
+                                                                target_camera,
+                                                                target_points2d + 2 * begin,
+                                                                projection_valid,
+                                                                count,
+                                                                instruction_set))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            block_valid[i] = block_valid[i] && projection_valid[i];
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Environment variable naming a directory where xy tables are stored and reloaded across processes
+#define TRANSFORMATION_XY_TABLES_CACHE_PATH_ENV_VAR "K4A_TRANSFORMATION_CACHE_PATH"
+// Bump whenever the content of the xy tables changes, so tables written by older versions are rebuilt
+#define TRANSFORMATION_XY_TABLES_CACHE_VERSION 1
+#define TRANSFORMATION_XY_TABLES_CACHE_MAGIC 0x5459344B // "K4YT"
+
+typedef struct _k4a_transformation_xy_tables_cache_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+} k4a_transformation_xy_tables_cache_header_t;
+
+static uint64_t transformation_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+    // 64 bit FNV-1a
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+uint64_t transformation_get_xy_tables_cache_key(const k4a_calibration_camera_t *camera_calibration)
+{
+    // Hash field by field so padding bytes never contribute
+    uint32_t version = TRANSFORMATION_XY_TABLES_CACHE_VERSION;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = transformation_hash_bytes(hash, &version, sizeof(version));
+    hash = transformation_hash_bytes(hash,
+                                     &camera_calibration->intrinsics.type,
+                                     sizeof(camera_calibration->intrinsics.type));
+    hash = transformation_hash_bytes(hash,
+                                     &camera_calibration->intrinsics.parameter_count,
+                                     sizeof(camera_calibration->intrinsics.parameter_count));
+    hash = transformation_hash_bytes(hash,
+                                     camera_calibration->intrinsics.parameters.v,
+                                     sizeof(camera_calibration->intrinsics.parameters.v));
+    hash = transformation_hash_bytes(hash,
+                                     &camera_calibration->resolution_width,
+                                     sizeof(camera_calibration->resolution_width));
+    hash = transformation_hash_bytes(hash,
+                                     &camera_calibration->resolution_height,
+                                     sizeof(camera_calibration->resolution_height));
+    hash = transformation_hash_bytes(hash,
+                                     &camera_calibration->metric_radius,
+                                     sizeof(camera_calibration->metric_radius));
+    return hash;
+}
+
+// Returns the cache file name for the given key, which must be freed by the caller, or NULL
+static char *transformation_get_xy_tables_cache_file(const char *cache_path, uint64_t key)
+{
+    size_t file_size = strlen(cache_path) + 64;
+    char *file = (char *)malloc(file_size);
+    if (file != NULL)
+    {
+        snprintf(file, file_size, "%s/k4a_xy_tables_%016llx.bin", cache_path, (unsigned long long)key);
+    }
+    return file;
+}
+
+static bool transformation_read_xy_tables_cache(const char *file,
+                                                uint64_t key,
+                                                k4a_transformation_xy_tables_t *xy_tables)
+{
+    FILE *stream = fopen(file, "rb");
+    if (stream == NULL)
+    {
+        return false;
+    }
+
+    size_t table_size = (size_t)(xy_tables->width * xy_tables->height);
+    k4a_transformation_xy_tables_cache_header_t header;
+    bool loaded = fread(&header, sizeof(header), 1, stream) == 1 &&
+                  header.magic == TRANSFORMATION_XY_TABLES_CACHE_MAGIC &&
+                  header.version == TRANSFORMATION_XY_TABLES_CACHE_VERSION && header.key == key &&
+                  header.width == xy_tables->width && header.height == xy_tables->height &&
+                  fread(xy_tables->x_table, sizeof(float), table_size, stream) == table_size &&
+                  fread(xy_tables->y_table, sizeof(float), table_size, stream) == table_size;
+    fclose(stream);
+
+    if (!loaded)
+    {
+        LOG_WARNING("Ignoring invalid xy tables cache file %s.", file);
+    }
+    return loaded;
+}
+
+// Replaces target with source, also when target already exists
+static bool transformation_replace_file(const char *source, const char *target)
+{
+#ifdef _WIN32
+    return MoveFileExA(source, target, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(source, target) == 0;
+#endif
+}
+
+// Counts the cache files written by this process, so threads writing the same cache file use different temporary files
+static volatile long g_xy_tables_cache_write_count = 0;
+
+static void transformation_write_xy_tables_cache(const char *file,
+                                                 uint64_t key,
+                                                 const k4a_transformation_xy_tables_t *xy_tables)
+{
+    // Write to a temporary file and move it into place, so a concurrent reader never sees a partially written file.
+    // The temporary file is unique to this process and call, so concurrent writers never write to the same file.
+#ifdef _WIN32
+    unsigned long process_id = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long process_id = (unsigned long)getpid();
+#endif
+    long write_count = k4a_atomic_increment_long(&g_xy_tables_cache_write_count);
+
+    size_t temp_file_size = strlen(file) + 64;
+    char *temp_file = (char *)malloc(temp_file_size);
+    if (temp_file == NULL)
+    {
+        return;
+    }
+    snprintf(temp_file, temp_file_size, "%s.%lu.%ld.tmp", file, process_id, write_count);
+
+    FILE *stream = fopen(temp_file, "wb");
+    if (stream == NULL)
+    {
+        LOG_WARNING("Unable to create xy tables cache file %s.", temp_file);
+        free(temp_file);
+        return;
+    }
+
+    size_t table_size = (size_t)(xy_tables->width * xy_tables->height);
+    k4a_transformation_xy_tables_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TRANSFORMATION_XY_TABLES_CACHE_MAGIC;
+    header.version = TRANSFORMATION_XY_TABLES_CACHE_VERSION;
+    header.key = key;
+    header.width = xy_tables->width;
+    header.height = xy_tables->height;
+    bool written = fwrite(&header, sizeof(header), 1, stream) == 1 &&
+                   fwrite(xy_tables->x_table, sizeof(float), table_size, stream) == table_size &&
+                   fwrite(xy_tables->y_table, sizeof(float), table_size, stream) == table_size;
+    written = fclose(stream) == 0 && written;
+
+    if (!written || !transformation_replace_file(temp_file, file))
+    {
+        LOG_WARNING("Unable to write xy tables cache file %s.", file);
+        remove(temp_file);
+    }
+    free(temp_file);
+}
+
+typedef struct _k4a_transformation_xy_tables_band_t
+{
+    const k4a_calibration_t *calibration;
+    k4a_calibration_type_t camera;
+    k4a_transformation_xy_tables_t *xy_tables;
+    int row_begin; // first table row this band computes
+    int row_end;   // one past the last table row this band computes
+    k4a_result_t result;
+} k4a_transformation_xy_tables_band_t;
+
+static int transformation_init_xy_tables_band(void *param)
+{
+    k4a_transformation_xy_tables_band_t *band = (k4a_transformation_xy_tables_band_t *)param;
+    k4a_transformation_xy_tables_t *xy_tables = band->xy_tables;
+
+    float point2d[2], point3d[3];
+    int valid = 1;
+
+    band->result = K4A_RESULT_SUCCEEDED;
+    for (int y = band->row_begin, idx = band->row_begin * xy_tables->width; y < band->row_end; y++)
+    {
+        point2d[1] = (float)y;
+        for (int x = 0; x < xy_tables->width; x++, idx++)
+        {
+            point2d[0] = (float)x;
+            if (K4A_FAILED(TRACE_CALL(transformation_2d_to_3d(
+                    band->calibration, point2d, 1.f, band->camera, band->camera, point3d, &valid))))
+            {
+                band->result = K4A_RESULT_FAILED;
+                return 0;
+            }
+
+            if (valid == 0)
+            {
+                // x table value of NAN marks invalid
+                xy_tables->x_table[idx] = NAN;
+                // set y table value to 0 to speed up SSE implementation
+                xy_tables->y_table[idx] = 0.f;
+            }
+            else
+            {
+                xy_tables->x_table[idx] = point3d[0];
+                xy_tables->y_table[idx] = point3d[1];
+            }
+        }
+    }
+    return 0;
+}
+
 static k4a_buffer_result_t transformation_init_xy_tables(const k4a_calibration_t *calibration,
                                                          const k4a_calibration_type_t camera,
+                                                         const char *cache_path,
                                                          float *data,
                                                          size_t *data_size,
                                                          k4a_transformation_xy_tables_t *xy_tables)
 {
-    int width = 0;
-    int height = 0;
+    const k4a_calibration_camera_t *camera_calibration = NULL;
     switch (camera)
     {
     case K4A_CALIBRATION_TYPE_DEPTH:
-        width = calibration->depth_camera_calibration.resolution_width;
-        height = calibration->depth_camera_calibration.resolution_height;
+        camera_calibration = &calibration->depth_camera_calibration;
         break;
     case K4A_CALIBRATION_TYPE_COLOR:
-        width = calibration->color_camera_calibration.resolution_width;
-        height = calibration->color_camera_calibration.resolution_height;
+        camera_calibration = &calibration->color_camera_calibration;
         break;
     default:
         LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
@@ -280,6 +699,8 @@ static k4a_buffer_result_t transformation_init_xy_tables(const k4a_calibration_t
                   K4A_CALIBRATION_TYPE_COLOR);
         return K4A_BUFFER_RESULT_FAILED;
     }
+    int width = camera_calibration->resolution_width;
+    int height = camera_calibration->resolution_height;
 
     size_t table_size = (size_t)(width * height);
     if (data == NULL)
@@ -299,64 +720,288 @@ static k4a_buffer_result_t transformation_init_xy_tables(const k4a_calibration_t
         xy_tables->height = height;
         xy_tables->x_table = data;
         xy_tables->y_table = data + table_size;
+        (*data_size) = 2 * table_size;
+
+        uint64_t cache_key = transformation_get_xy_tables_cache_key(camera_calibration);
+        char *cache_file = cache_path != NULL ? transformation_get_xy_tables_cache_file(cache_path, cache_key) : NULL;
+        if (cache_file != NULL && transformation_read_xy_tables_cache(cache_file, cache_key, xy_tables))
+        {
+            free(cache_file);
+            return K4A_BUFFER_RESULT_SUCCEEDED;
+        }
+
+        // Every pixel is an independent iterative unprojection, so split the rows across all processors
+        uint32_t band_count = transformation_get_processor_count();
+        if (band_count > K4A_TRANSFORMATION_MAX_THREAD_COUNT)
+        {
+            band_count = K4A_TRANSFORMATION_MAX_THREAD_COUNT;
+        }
+        if (band_count > (uint32_t)height)
+        {
+            band_count = height > 0 ? (uint32_t)height : 1;
+        }
+
+        k4a_transformation_xy_tables_band_t bands[K4A_TRANSFORMATION_MAX_THREAD_COUNT];
+        for (uint32_t i = 0; i < band_count; i++)
+        {
+            bands[i].calibration = calibration;
+            bands[i].camera = camera;
+            bands[i].xy_tables = xy_tables;
+            bands[i].row_begin = (int)((uint64_t)height * i / band_count);
+            bands[i].row_end = (int)((uint64_t)height * (i + 1) / band_count);
+            bands[i].result = K4A_RESULT_FAILED;
+        }
 
-        float point2d[2], point3d[3];
-        int valid = 1;
+        transformation_run_bands(transformation_init_xy_tables_band,
+                                 bands,
+                                 sizeof(k4a_transformation_xy_tables_band_t),
+                                 band_count);
 
-        for (int y = 0, idx = 0; y < height; y++)
+        k4a_buffer_result_t result = K4A_BUFFER_RESULT_SUCCEEDED;
+        for (uint32_t i = 0; i < band_count; i++)
         {
-            point2d[1] = (float)y;
-            for (int x = 0; x < width; x++, idx++)
+            if (K4A_FAILED(bands[i].result))
             {
-                point2d[0] = (float)x;
-                if (K4A_FAILED(TRACE_CALL(
-                        transformation_2d_to_3d(calibration, point2d, 1.f, camera, camera, point3d, &valid))))
-                {
-                    return K4A_BUFFER_RESULT_FAILED;
-                }
-
-                if (valid == 0)
-                {
-                    // x table value of NAN marks invalid
-                    xy_tables->x_table[idx] = NAN;
-                    // set y table value to 0 to speed up SSE implementation
-                    xy_tables->y_table[idx] = 0.f;
-                }
-                else
-                {
-                    xy_tables->x_table[idx] = point3d[0];
-                    xy_tables->y_table[idx] = point3d[1];
-                }
+                result = K4A_BUFFER_RESULT_FAILED;
             }
         }
-        (*data_size) = 2 * table_size;
-        return K4A_BUFFER_RESULT_SUCCEEDED;
+
+        if (cache_file != NULL)
+        {
+            if (result == K4A_BUFFER_RESULT_SUCCEEDED)
+            {
+                transformation_write_xy_tables_cache(cache_file, cache_key, xy_tables);
+            }
+            free(cache_file);
+        }
+        return result;
     }
 }
 
 static k4a_result_t transformation_allocate_xy_tables(const k4a_calibration_t *calibration,
                                                       k4a_calibration_type_t camera,
+                                                      const char *cache_path,
                                                       float **buffer,
                                                       k4a_transformation_xy_tables_t *xy_tables)
 {
     *buffer = 0;
     size_t xy_tables_data_size = 0;
     if (K4A_BUFFER_RESULT_TOO_SMALL !=
-        TRACE_BUFFER_CALL(transformation_init_xy_tables(calibration, camera, *buffer, &xy_tables_data_size, xy_tables)))
+        TRACE_BUFFER_CALL(
+            transformation_init_xy_tables(calibration, camera, cache_path, *buffer, &xy_tables_data_size, xy_tables)))
     {
         return K4A_RESULT_FAILED;
     }
 
     *buffer = malloc(xy_tables_data_size * sizeof(float));
+    if (*buffer == NULL && xy_tables_data_size > 0)
+    {
+        LOG_ERROR("Failed to allocate %zu bytes for xy tables.", xy_tables_data_size * sizeof(float));
+        return K4A_RESULT_FAILED;
+    }
 
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
-        TRACE_BUFFER_CALL(transformation_init_xy_tables(calibration, camera, *buffer, &xy_tables_data_size, xy_tables)))
+        TRACE_BUFFER_CALL(
+            transformation_init_xy_tables(calibration, camera, cache_path, *buffer, &xy_tables_data_size, xy_tables)))
     {
         return K4A_RESULT_FAILED;
     }
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Depth in mm at which the correspondence polynomials are anchored (u = 1). Depths closer than this extrapolate.
+#define TRANSFORMATION_CORRESPONDENCE_REFERENCE_DEPTH 200.f
+// Number of equally spaced u values used to find where a projection is valid, and bisection steps to refine the ends
+#define TRANSFORMATION_CORRESPONDENCE_VALIDITY_SAMPLES 17
+#define TRANSFORMATION_CORRESPONDENCE_VALIDITY_BISECTIONS 12
+
+// Projects the color camera point direction + u * translation / reference_depth, i.e. a depth pixel at depth
+// reference_depth / u scaled down by its depth. Projection does not depend on that scale.
+static k4a_result_t transformation_project_correspondence(const k4a_calibration_t *calibration,
+                                                          const float direction[3],
+                                                          const float translation[3],
+                                                          float u,
+                                                          float point2d[2],
+                                                          int *valid)
+{
+    float point3d[3];
+    for (int i = 0; i < 3; i++)
+    {
+        point3d[i] = direction[i] + u * translation[i] / TRANSFORMATION_CORRESPONDENCE_REFERENCE_DEPTH;
+    }
+    return TRACE_CALL(transformation_3d_to_2d(
+        calibration, point3d, K4A_CALIBRATION_TYPE_COLOR, K4A_CALIBRATION_TYPE_COLOR, point2d, valid));
+}
+
+// Moves the boundary between a valid u and an invalid u towards the valid side and returns the closest valid u found
+static k4a_result_t transformation_refine_correspondence_validity(const k4a_calibration_t *calibration,
+                                                                  const float direction[3],
+                                                                  const float translation[3],
+                                                                  float valid_u,
+                                                                  float invalid_u,
+                                                                  float *refined_u)
+{
+    for (int i = 0; i < TRANSFORMATION_CORRESPONDENCE_VALIDITY_BISECTIONS; i++)
+    {
+        float u = 0.5f * (valid_u + invalid_u);
+        float point2d[2];
+        int valid = 0;
+        if (K4A_FAILED(TRACE_CALL(
+                transformation_project_correspondence(calibration, direction, translation, u, point2d, &valid))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        if (valid)
+        {
+            valid_u = u;
+        }
+        else
+        {
+            invalid_u = u;
+        }
+    }
+    *refined_u = valid_u;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t
+transformation_init_correspondence_coefficients(const k4a_calibration_t *calibration,
+                                                const float direction[3],
+                                                const float translation[3],
+                                                k4a_transformation_correspondence_coefficients_t *coefficients)
+{
+    memset(coefficients, 0, sizeof(k4a_transformation_correspondence_coefficients_t));
+    coefficients->depth_scale = NAN;
+
+    // The projection is valid while the undistorted point stays within the maximum radius of the lens model. The
+    // undistorted point moves along a straight line as u changes, so the valid u values form a single interval.
+    const int sample_count = TRANSFORMATION_CORRESPONDENCE_VALIDITY_SAMPLES;
+    int first_valid = -1;
+    int last_valid = -1;
+    for (int i = 0; i < sample_count; i++)
+    {
+        float point2d[2];
+        int valid = 0;
+        float u = (float)i / (float)(sample_count - 1);
+        if (K4A_FAILED(TRACE_CALL(
+                transformation_project_correspondence(calibration, direction, translation, u, point2d, &valid))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        if (valid)
+        {
+            first_valid = first_valid < 0 ? i : first_valid;
+            last_valid = i;
+        }
+    }
+
+    if (first_valid < 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    float u_min = (float)first_valid / (float)(sample_count - 1);
+    float u_max = (float)last_valid / (float)(sample_count - 1);
+    float sample_step = 1.f / (float)(sample_count - 1);
+    if (first_valid > 0 && K4A_FAILED(TRACE_CALL(transformation_refine_correspondence_validity(
+                               calibration, direction, translation, u_min, u_min - sample_step, &u_min))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    if (last_valid < sample_count - 1 && K4A_FAILED(TRACE_CALL(transformation_refine_correspondence_validity(
+                                             calibration, direction, translation, u_max, u_max + sample_step, &u_max))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // Fit the quadratic through three valid samples spanning the valid interval
+    float u_samples[3] = { u_min, 0.5f * (u_min + u_max), u_max };
+    float samples[3][2];
+    for (int i = 0; i < 3; i++)
+    {
+        int valid = 0;
+        if (K4A_FAILED(TRACE_CALL(transformation_project_correspondence(
+                calibration, direction, translation, u_samples[i], samples[i], &valid))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    for (int j = 0; j < 2; j++)
+    {
+        if (u_max - u_min > 0.f)
+        {
+            // Newton form of the interpolating quadratic, expanded into powers of u
+            float d01 = (samples[1][j] - samples[0][j]) / (u_samples[1] - u_samples[0]);
+            float d12 = (samples[2][j] - samples[1][j]) / (u_samples[2] - u_samples[1]);
+            float d012 = (d12 - d01) / (u_samples[2] - u_samples[0]);
+            coefficients->point2d[2][j] = d012;
+            coefficients->point2d[1][j] = d01 - d012 * (u_samples[0] + u_samples[1]);
+            coefficients->point2d[0][j] = samples[0][j] - d01 * u_samples[0] + d012 * u_samples[0] * u_samples[1];
+        }
+        else
+        {
+            coefficients->point2d[0][j] = samples[0][j];
+        }
+    }
+
+    coefficients->depth_scale = direction[2];
+    coefficients->u_min = u_min;
+    coefficients->u_max = last_valid == sample_count - 1 ? INFINITY : u_max;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t
+transformation_allocate_correspondence_table(const k4a_calibration_t *calibration,
+                                             const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+                                             k4a_transformation_correspondence_table_t *correspondence_table)
+{
+    const k4a_calibration_extrinsics_t *depth_to_color =
+        &calibration->extrinsics[K4A_CALIBRATION_TYPE_DEPTH][K4A_CALIBRATION_TYPE_COLOR];
+    size_t table_size = (size_t)(xy_tables_depth_camera->width * xy_tables_depth_camera->height);
+
+    correspondence_table->coefficients = (k4a_transformation_correspondence_coefficients_t *)malloc(
+        table_size * sizeof(k4a_transformation_correspondence_coefficients_t));
+    if (correspondence_table->coefficients == NULL)
+    {
+        LOG_ERROR("Failed to allocate correspondence table.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    correspondence_table->reference_depth = TRANSFORMATION_CORRESPONDENCE_REFERENCE_DEPTH;
+    correspondence_table->depth_offset = depth_to_color->translation[2];
+    correspondence_table->width = xy_tables_depth_camera->width;
+    correspondence_table->height = xy_tables_depth_camera->height;
+
+    // A depth pixel at depth d maps to the color camera point d * (R * ray + u * t / reference_depth) with
+    // u = reference_depth / d, so its color pixel is an exact function of u alone.
+    for (size_t idx = 0; idx < table_size; idx++)
+    {
+        k4a_transformation_correspondence_coefficients_t *coefficients = &correspondence_table->coefficients[idx];
+        if (isnan(xy_tables_depth_camera->x_table[idx]))
+        {
+            memset(coefficients, 0, sizeof(k4a_transformation_correspondence_coefficients_t));
+            coefficients->depth_scale = NAN;
+            continue;
+        }
+
+        float ray[3] = { xy_tables_depth_camera->x_table[idx], xy_tables_depth_camera->y_table[idx], 1.f };
+        float direction[3];
+        math_mult_Ax_3x3(depth_to_color->rotation, ray, direction);
+
+        if (K4A_FAILED(TRACE_CALL(transformation_init_correspondence_coefficients(calibration,
+                                                                                  direction,
+                                                                                  depth_to_color->translation,
+                                                                                  coefficients))))
+        {
+            free(correspondence_table->coefficients);
+            correspondence_table->coefficients = NULL;
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 typedef struct _k4a_transformation_context_t
 {
     k4a_calibration_t calibration;
@@ -364,13 +1009,66 @@ typedef struct _k4a_transformation_context_t
     float *memory_depth_camera_xy_tables;
     k4a_transformation_xy_tables_t color_camera_xy_tables;
     float *memory_color_camera_xy_tables;
+    LOCK_HANDLE xy_tables_lock; // guards building the xy tables and correspondence table on first use, and mode
+    char *xy_tables_cache_path;
     bool enable_gpu_optimization;
     bool enable_depth_color_transform;
     tewrapper_t tewrapper;
+    k4a_transformation_instruction_set_t instruction_set;
+    k4a_transformation_worker_pool_t *worker_pool; // threads and scratch memory of the CPU transformations
+    k4a_transformation_mode_t mode;
+    k4a_transformation_correspondence_table_t correspondence_table;
 } k4a_transformation_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_transformation_t, k4a_transformation_context_t);
 
+// Returns the xy tables of the camera, building them on first use, or NULL on failure
+static k4a_transformation_xy_tables_t *
+transformation_get_xy_tables(k4a_transformation_context_t *transformation_context, const k4a_calibration_type_t camera)
+{
+    k4a_transformation_xy_tables_t *xy_tables;
+    float **memory_xy_tables;
+    if (camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        xy_tables = &transformation_context->depth_camera_xy_tables;
+        memory_xy_tables = &transformation_context->memory_depth_camera_xy_tables;
+    }
+    else if (camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        xy_tables = &transformation_context->color_camera_xy_tables;
+        memory_xy_tables = &transformation_context->memory_color_camera_xy_tables;
+    }
+    else
+    {
+        LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return NULL;
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    Lock(transformation_context->xy_tables_lock);
+    if (*memory_xy_tables == NULL)
+    {
+        result = TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
+                                                              camera,
+                                                              transformation_context->xy_tables_cache_path,
+                                                              memory_xy_tables,
+                                                              xy_tables));
+        if (K4A_FAILED(result) && *memory_xy_tables != NULL)
+        {
+            // Leave the tables unbuilt so the next call tries again
+            free(*memory_xy_tables);
+            *memory_xy_tables = NULL;
+        }
+    }
+    Unlock(transformation_context->xy_tables_lock);
+
+    return K4A_SUCCEEDED(result) ? xy_tables : NULL;
+}
+
 k4a_transformation_t transformation_create(const k4a_calibration_t *calibration, bool gpu_optimization)
 {
     k4a_transformation_t transformation_handle = NULL;
@@ -378,24 +1076,43 @@ k4a_transformation_t transformation_create(const k4a_calibration_t *calibration,
 
     memcpy(&transformation_context->calibration, calibration, sizeof(k4a_calibration_t));
 
-    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
-                                                                K4A_CALIBRATION_TYPE_DEPTH,
-                                                                &transformation_context->memory_depth_camera_xy_tables,
-                                                                &transformation_context->depth_camera_xy_tables))))
+    // Pick the CPU kernels once so each call does not need to query the CPU
+    transformation_context->instruction_set = transformation_get_best_instruction_set();
+    LOG_INFO("Transformation CPU kernels use instruction set %s.",
+             transformation_instruction_set_name(transformation_context->instruction_set));
+
+    // Scratch memory is sized for the depth camera so that the transformation calls never allocate
+    transformation_context->worker_pool = transformation_worker_pool_create(
+        transformation_get_frame_scratch_size(calibration->depth_camera_calibration.resolution_width,
+                                              calibration->depth_camera_calibration.resolution_height),
+        transformation_get_band_scratch_size(calibration->depth_camera_calibration.resolution_width));
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->worker_pool != NULL)))
     {
         transformation_destroy(transformation_handle);
         return 0;
     }
 
-    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
-                                                                K4A_CALIBRATION_TYPE_COLOR,
-                                                                &transformation_context->memory_color_camera_xy_tables,
-                                                                &transformation_context->color_camera_xy_tables))))
+    // The xy tables are built by the first function that needs them, see transformation_get_xy_tables()
+    transformation_context->xy_tables_lock = Lock_Init();
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->xy_tables_lock != NULL)))
     {
         transformation_destroy(transformation_handle);
         return 0;
     }
 
+    const char *cache_path = environment_get_variable(TRANSFORMATION_XY_TABLES_CACHE_PATH_ENV_VAR);
+    if (cache_path != NULL && cache_path[0] != '\0')
+    {
+        size_t cache_path_size = strlen(cache_path) + 1;
+        transformation_context->xy_tables_cache_path = (char *)malloc(cache_path_size);
+        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->xy_tables_cache_path != NULL)))
+        {
+            transformation_destroy(transformation_handle);
+            return 0;
+        }
+        memcpy(transformation_context->xy_tables_cache_path, cache_path, cache_path_size);
+    }
+
     transformation_context->enable_gpu_optimization = gpu_optimization;
     transformation_context->enable_depth_color_transform = transformation_context->calibration.color_resolution !=
                                                                K4A_COLOR_RESOLUTION_OFF &&
@@ -403,6 +1120,15 @@ k4a_transformation_t transformation_create(const k4a_calibration_t *calibration,
                                                                K4A_DEPTH_MODE_OFF;
     if (transformation_context->enable_gpu_optimization && transformation_context->enable_depth_color_transform)
     {
+        // The transform engine is initialized with the depth camera xy tables, so they cannot be deferred
+        k4a_transformation_xy_tables_t *xy_tables_depth_camera =
+            transformation_get_xy_tables(transformation_context, K4A_CALIBRATION_TYPE_DEPTH);
+        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(xy_tables_depth_camera != NULL)))
+        {
+            transformation_destroy(transformation_handle);
+            return 0;
+        }
+
         // Set up transform engine expected calibration struct
         k4a_transform_engine_calibration_t transform_engine_calibration;
         memcpy(&transform_engine_calibration.depth_camera_calibration,
@@ -418,7 +1144,7 @@ k4a_transformation_t transformation_create(const k4a_calibration_t *calibration,
                &transformation_context->calibration.extrinsics[K4A_CALIBRATION_TYPE_COLOR][K4A_CALIBRATION_TYPE_DEPTH],
                sizeof(k4a_calibration_extrinsics_t));
         memcpy(&transform_engine_calibration.depth_camera_xy_tables,
-               &transformation_context->depth_camera_xy_tables,
+               xy_tables_depth_camera,
                sizeof(k4a_transformation_xy_tables_t));
 
         transformation_context->tewrapper = tewrapper_create(&transform_engine_calibration);
@@ -449,9 +1175,133 @@ void transformation_destroy(k4a_transformation_t transformation_handle)
     {
         tewrapper_destroy(transformation_context->tewrapper);
     }
+    if (transformation_context->correspondence_table.coefficients != NULL)
+    {
+        free(transformation_context->correspondence_table.coefficients);
+    }
+    if (transformation_context->xy_tables_cache_path != NULL)
+    {
+        free(transformation_context->xy_tables_cache_path);
+    }
+    if (transformation_context->xy_tables_lock != NULL)
+    {
+        Lock_Deinit(transformation_context->xy_tables_lock);
+    }
+    transformation_worker_pool_destroy(transformation_context->worker_pool);
     k4a_transformation_t_destroy(transformation_handle);
 }
 
+k4a_result_t transformation_set_mode(k4a_transformation_t transformation_handle, k4a_transformation_mode_t mode)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (mode != K4A_TRANSFORMATION_MODE_DEFAULT && mode != K4A_TRANSFORMATION_MODE_CPU &&
+        mode != K4A_TRANSFORMATION_MODE_CPU_FAST)
+    {
+        LOG_ERROR("Unexpected transformation mode %d.", mode);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The correspondence table maps depth pixels into the color camera, so the fast mode needs both cameras
+    if (mode == K4A_TRANSFORMATION_MODE_CPU_FAST && !transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("The fast transformation mode requires both the depth mode and the color resolution to be enabled. "
+                  "Depth mode: %d, color resolution: %d.",
+                  transformation_context->calibration.depth_mode,
+                  transformation_context->calibration.color_resolution);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The correspondence table is built the first time the fast mode is selected and kept until the handle is
+    // destroyed. It is built from the depth camera xy tables, which take the lock themselves, so get them first.
+    k4a_transformation_xy_tables_t *xy_tables_depth_camera = NULL;
+    if (mode == K4A_TRANSFORMATION_MODE_CPU_FAST)
+    {
+        xy_tables_depth_camera = transformation_get_xy_tables(transformation_context, K4A_CALIBRATION_TYPE_DEPTH);
+        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(xy_tables_depth_camera != NULL)))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    // Build the table and publish the mode under the lock, so a concurrent call never sees the fast mode before its
+    // table is complete
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    Lock(transformation_context->xy_tables_lock);
+    if (mode == K4A_TRANSFORMATION_MODE_CPU_FAST && transformation_context->correspondence_table.coefficients == NULL)
+    {
+        result = TRACE_CALL(
+            transformation_allocate_correspondence_table(&transformation_context->calibration,
+                                                         xy_tables_depth_camera,
+                                                         &transformation_context->correspondence_table));
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        transformation_context->mode = mode;
+    }
+    Unlock(transformation_context->xy_tables_lock);
+
+    return result;
+}
+
+static k4a_transformation_mode_t transformation_get_mode(const k4a_transformation_context_t *transformation_context)
+{
+    Lock(transformation_context->xy_tables_lock);
+    k4a_transformation_mode_t mode = transformation_context->mode;
+    Unlock(transformation_context->xy_tables_lock);
+    return mode;
+}
+
+static bool transformation_use_gpu(const k4a_transformation_context_t *transformation_context)
+{
+    return transformation_context->enable_gpu_optimization &&
+           transformation_get_mode(transformation_context) == K4A_TRANSFORMATION_MODE_DEFAULT;
+}
+
+// The table is complete whenever the fast mode is set, and is never changed or freed while the handle exists
+static const k4a_transformation_correspondence_table_t *
+transformation_get_correspondence_table(const k4a_transformation_context_t *transformation_context)
+{
+    if (transformation_get_mode(transformation_context) == K4A_TRANSFORMATION_MODE_CPU_FAST)
+    {
+        return &transformation_context->correspondence_table;
+    }
+    return NULL;
+}
+
+k4a_result_t transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (thread_count == 0 || thread_count > K4A_TRANSFORMATION_MAX_THREAD_COUNT)
+    {
+        LOG_ERROR("Unexpected thread count %u, should be between 1 and %u.",
+                  thread_count,
+                  K4A_TRANSFORMATION_MAX_THREAD_COUNT);
+        return K4A_RESULT_FAILED;
+    }
+
+    return TRACE_CALL(transformation_worker_pool_set_thread_count(transformation_context->worker_pool, thread_count));
+}
+
+k4a_result_t transformation_set_instruction_set(k4a_transformation_t transformation_handle,
+                                               k4a_transformation_instruction_set_t instruction_set)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (!transformation_instruction_set_supported(instruction_set))
+    {
+        LOG_ERROR("Instruction set %d is not supported on this CPU.", instruction_set);
+        return K4A_RESULT_FAILED;
+    }
+
+    transformation_context->instruction_set = instruction_set;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t
 transformation_depth_image_to_color_camera(k4a_transformation_t transformation_handle,
                                            const uint8_t *depth_image_data,
@@ -468,12 +1318,19 @@ transformation_depth_image_to_color_camera(k4a_transformation_t transformation_h
         return K4A_RESULT_FAILED;
     }
 
-    if (transformation_context->enable_gpu_optimization)
+    k4a_transformation_xy_tables_t *xy_tables_depth_camera = transformation_get_xy_tables(transformation_context,
+                                                                                          K4A_CALIBRATION_TYPE_DEPTH);
+    if (xy_tables_depth_camera == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (transformation_use_gpu(transformation_context))
     {
         if (K4A_BUFFER_RESULT_SUCCEEDED !=
             TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_validate_parameters(
                 &transformation_context->calibration,
-                &transformation_context->depth_camera_xy_tables,
+                xy_tables_depth_camera,
                 depth_image_data,
                 depth_image_descriptor,
                 transformed_depth_image_data,
@@ -505,11 +1362,14 @@ transformation_depth_image_to_color_camera(k4a_transformation_t transformation_h
         if (K4A_BUFFER_RESULT_SUCCEEDED !=
             TRACE_BUFFER_CALL(
                 transformation_depth_image_to_color_camera_internal(&transformation_context->calibration,
-                                                                    &transformation_context->depth_camera_xy_tables,
+                                                                    xy_tables_depth_camera,
+                                                                    transformation_get_correspondence_table(
+                                                                        transformation_context),
                                                                     depth_image_data,
                                                                     depth_image_descriptor,
                                                                     transformed_depth_image_data,
-                                                                    transformed_depth_image_descriptor)))
+                                                                    transformed_depth_image_descriptor,
+                                                                    transformation_context->worker_pool)))
         {
             return K4A_RESULT_FAILED;
         }
@@ -535,12 +1395,19 @@ transformation_color_image_to_depth_camera(k4a_transformation_t transformation_h
         return K4A_RESULT_FAILED;
     }
 
-    if (transformation_context->enable_gpu_optimization)
+    k4a_transformation_xy_tables_t *xy_tables_depth_camera = transformation_get_xy_tables(transformation_context,
+                                                                                          K4A_CALIBRATION_TYPE_DEPTH);
+    if (xy_tables_depth_camera == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (transformation_use_gpu(transformation_context))
     {
         if (K4A_BUFFER_RESULT_SUCCEEDED !=
             TRACE_BUFFER_CALL(transformation_color_image_to_depth_camera_validate_parameters(
                 &transformation_context->calibration,
-                &transformation_context->depth_camera_xy_tables,
+                xy_tables_depth_camera,
                 depth_image_data,
                 depth_image_descriptor,
                 color_image_data,
@@ -575,13 +1442,17 @@ transformation_color_image_to_depth_camera(k4a_transformation_t transformation_h
         if (K4A_BUFFER_RESULT_SUCCEEDED !=
             TRACE_BUFFER_CALL(
                 transformation_color_image_to_depth_camera_internal(&transformation_context->calibration,
-                                                                    &transformation_context->depth_camera_xy_tables,
+                                                                    xy_tables_depth_camera,
+                                                                    transformation_get_correspondence_table(
+                                                                        transformation_context),
                                                                     depth_image_data,
                                                                     depth_image_descriptor,
                                                                     color_image_data,
                                                                     color_image_descriptor,
                                                                     transformed_color_image_data,
-                                                                    transformed_color_image_descriptor)))
+                                                                    transformed_color_image_descriptor,
+                                                                    transformation_context->instruction_set,
+                                                                    transformation_context->worker_pool)))
         {
             return K4A_RESULT_FAILED;
         }
@@ -589,6 +1460,57 @@ transformation_color_image_to_depth_camera(k4a_transformation_t transformation_h
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t
+transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                  const uint8_t *depth_image_data,
+                                                  const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                  const uint8_t *color_image_data,
+                                                  const k4a_transformation_image_descriptor_t *color_image_descriptor,
+                                                  k4a_colored_point_format_t point_format,
+                                                  bool skip_invalid_points,
+                                                  uint8_t *point_cloud_data,
+                                                  k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+                                                  size_t *point_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to compute a colored point cloud.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_xy_tables_t *xy_tables_depth_camera = transformation_get_xy_tables(transformation_context,
+                                                                                          K4A_CALIBRATION_TYPE_DEPTH);
+    if (xy_tables_depth_camera == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // There is no GPU implementation, handles that would use the GPU compute exact correspondences on the CPU instead
+    if (K4A_BUFFER_RESULT_SUCCEEDED !=
+        TRACE_BUFFER_CALL(transformation_depth_image_to_colored_point_cloud_internal(
+            &transformation_context->calibration,
+            xy_tables_depth_camera,
+            transformation_get_correspondence_table(transformation_context),
+            depth_image_data,
+            depth_image_descriptor,
+            color_image_data,
+            color_image_descriptor,
+            point_format,
+            skip_invalid_points,
+            point_cloud_data,
+            point_cloud_descriptor,
+            point_count,
+            transformation_context->instruction_set,
+            transformation_context->worker_pool)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t
 transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
                                           const uint8_t *depth_image_data,
@@ -600,28 +1522,60 @@ transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_ha
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
     k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
 
-    k4a_transformation_xy_tables_t *xy_tables;
-    if (camera == K4A_CALIBRATION_TYPE_DEPTH)
+    k4a_transformation_xy_tables_t *xy_tables = transformation_get_xy_tables(transformation_context, camera);
+    if (xy_tables == NULL)
     {
-        xy_tables = &transformation_context->depth_camera_xy_tables;
+        return K4A_RESULT_FAILED;
     }
-    else if (camera == K4A_CALIBRATION_TYPE_COLOR)
+
+    if (K4A_BUFFER_RESULT_SUCCEEDED !=
+        TRACE_BUFFER_CALL(transformation_depth_image_to_point_cloud_internal(xy_tables,
+                                                                             transformation_context->instruction_set,
+                                                                             depth_image_data,
+                                                                             depth_image_descriptor,
+                                                                             xyz_image_data,
+                                                                             xyz_image_descriptor)))
     {
-        xy_tables = &transformation_context->color_camera_xy_tables;
+        return K4A_RESULT_FAILED;
     }
-    else
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t
+transformation_depth_image_to_formatted_point_cloud(k4a_transformation_t transformation_handle,
+                                                    const uint8_t *depth_image_data,
+                                                    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                    const k4a_calibration_type_t camera,
+                                                    k4a_point_cloud_format_t point_format,
+                                                    bool skip_invalid_points,
+                                                    uint8_t *point_cloud_data,
+                                                    k4a_transformation_image_descriptor_t *point_cloud_descriptor,
+                                                    uint8_t *pixel_index_data,
+                                                    k4a_transformation_image_descriptor_t *pixel_index_descriptor,
+                                                    size_t *point_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    k4a_transformation_xy_tables_t *xy_tables = transformation_get_xy_tables(transformation_context, camera);
+    if (xy_tables == NULL)
     {
-        LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
-                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
-                  camera,
-                  K4A_CALIBRATION_TYPE_DEPTH,
-                  K4A_CALIBRATION_TYPE_COLOR);
         return K4A_RESULT_FAILED;
     }
 
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
-        TRACE_BUFFER_CALL(transformation_depth_image_to_point_cloud_internal(
-            xy_tables, depth_image_data, depth_image_descriptor, xyz_image_data, xyz_image_descriptor)))
+        TRACE_BUFFER_CALL(
+            transformation_depth_image_to_formatted_point_cloud_internal(xy_tables,
+                                                                         transformation_context->instruction_set,
+                                                                         depth_image_data,
+                                                                         depth_image_descriptor,
+                                                                         point_format,
+                                                                         skip_invalid_points,
+                                                                         point_cloud_data,
+                                                                         point_cloud_descriptor,
+                                                                         pixel_index_data,
+                                                                         pixel_index_descriptor,
+                                                                         point_count)))
     {
         return K4A_RESULT_FAILED;
     }
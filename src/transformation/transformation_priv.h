@@ -0,0 +1,296 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef TRANSFORMATION_PRIV_H
+#define TRANSFORMATION_PRIV_H
+
+#include <k4ainternal/transformation.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Converts a run of depth pixels to int16 XYZ triplets.
+ *
+ * \param x_table
+ * X table entries for the first pixel of the run. A NAN entry marks a pixel without a valid unprojection.
+ *
+ * \param y_table
+ * Y table entries for the first pixel of the run.
+ *
+ * \param depth
+ * Depth values for the first pixel of the run.
+ *
+ * \param xyz
+ * Output location for the first XYZ triplet of the run.
+ *
+ * \param count
+ * Number of pixels in the run.
+ *
+ * \remarks
+ * Every implementation must produce output bit-identical to transformation_depth_to_xyz_scalar(). Coordinates are
+ * rounded with floor(v + 0.5) and truncated to 16 bits; invalid pixels are written as (0, 0, 0). Buffers do not need to
+ * be aligned.
+ */
+typedef void(transformation_depth_to_xyz_fn_t)(const float *x_table,
+                                               const float *y_table,
+                                               const uint16_t *depth,
+                                               int16_t *xyz,
+                                               int count);
+
+transformation_depth_to_xyz_fn_t transformation_depth_to_xyz_scalar;
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+transformation_depth_to_xyz_fn_t transformation_depth_to_xyz_sse41;
+transformation_depth_to_xyz_fn_t transformation_depth_to_xyz_avx2;
+transformation_depth_to_xyz_fn_t transformation_depth_to_xyz_avx512;
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+transformation_depth_to_xyz_fn_t transformation_depth_to_xyz_neon;
+#endif
+
+/** Converts a run of depth pixels to float XYZ triplets.
+ *
+ * \remarks
+ * Takes the same arguments as transformation_depth_to_xyz_fn_t. Every implementation must produce output
+ * bit-identical to transformation_depth_to_xyz_f32_scalar(). Coordinates are x_table * depth, y_table * depth and
+ * depth without rounding, with depth read as uint16_t. Pixels with a NAN x table entry or a depth of 0 are written as
+ * (0, 0, 0).
+ */
+typedef void(transformation_depth_to_xyz_f32_fn_t)(const float *x_table,
+                                                   const float *y_table,
+                                                   const uint16_t *depth,
+                                                   float *xyz,
+                                                   int count);
+
+transformation_depth_to_xyz_f32_fn_t transformation_depth_to_xyz_f32_scalar;
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+transformation_depth_to_xyz_f32_fn_t transformation_depth_to_xyz_f32_sse41;
+transformation_depth_to_xyz_f32_fn_t transformation_depth_to_xyz_f32_avx2;
+transformation_depth_to_xyz_f32_fn_t transformation_depth_to_xyz_f32_avx512;
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+transformation_depth_to_xyz_f32_fn_t transformation_depth_to_xyz_f32_neon;
+#endif
+
+/** Converts a run of depth pixels to separate runs of float X, Y and Z values.
+ *
+ * \remarks
+ * Computes the same values as transformation_depth_to_xyz_f32_fn_t, but stores them in \p x, \p y and \p z instead of
+ * as triplets. Every implementation must produce output bit-identical to
+ * transformation_depth_to_xyz_planar_f32_scalar().
+ */
+typedef void(transformation_depth_to_xyz_planar_f32_fn_t)(const float *x_table,
+                                                          const float *y_table,
+                                                          const uint16_t *depth,
+                                                          float *x,
+                                                          float *y,
+                                                          float *z,
+                                                          int count);
+
+transformation_depth_to_xyz_planar_f32_fn_t transformation_depth_to_xyz_planar_f32_scalar;
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+transformation_depth_to_xyz_planar_f32_fn_t transformation_depth_to_xyz_planar_f32_sse41;
+transformation_depth_to_xyz_planar_f32_fn_t transformation_depth_to_xyz_planar_f32_avx2;
+transformation_depth_to_xyz_planar_f32_fn_t transformation_depth_to_xyz_planar_f32_avx512;
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+transformation_depth_to_xyz_planar_f32_fn_t transformation_depth_to_xyz_planar_f32_neon;
+#endif
+
+/** Bilinearly interpolates the BGRA color of a run of depth pixels.
+ *
+ * \param color
+ * BGRA color image.
+ *
+ * \param color_stride
+ * Stride of the color image in bytes.
+ *
+ * \param points
+ * Color image coordinates of the first depth pixel of the run, stored as x, y pairs. A NAN x marks a depth pixel
+ * without a color.
+ *
+ * \param bgra
+ * Output location for the BGRA color of the first depth pixel of the run.
+ *
+ * \param count
+ * Number of pixels in the run.
+ *
+ * \remarks
+ * Every implementation must produce output bit-identical to transformation_interpolate_bgra_scalar(). The four channels
+ * are rounded with (uint8_t)(v + 0.5f), and an interpolated color of (0, 0, 0, 0) is written as (1, 0, 0, 0) because
+ * (0, 0, 0, 0) marks pixels without a color. Pixels without a color are left unchanged. Every other point must satisfy
+ * 0 <= floor(x) < width - 1 and 0 <= floor(y) < height - 1 so that all four neighbors are inside the color image.
+ */
+typedef void(transformation_interpolate_bgra_fn_t)(const uint8_t *color,
+                                                   int color_stride,
+                                                   const float *points,
+                                                   uint8_t *bgra,
+                                                   int count);
+
+transformation_interpolate_bgra_fn_t transformation_interpolate_bgra_scalar;
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+transformation_interpolate_bgra_fn_t transformation_interpolate_bgra_sse41;
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+transformation_interpolate_bgra_fn_t transformation_interpolate_bgra_neon;
+#endif
+
+// Intrinsic parameters of a camera as used by the projection kernels, extracted once per batch
+typedef struct _k4a_transformation_projection_params_t
+{
+    float cx, cy;             // principal point in pixels
+    float fx, fy;             // focal length in pixels
+    float k1, k2, k3;         // radial distortion numerator coefficients
+    float k4, k5, k6;         // radial distortion denominator coefficients
+    float codx, cody;         // center of distortion
+    float p1, p2;             // tangential distortion coefficients
+    float tangential_scale;   // 1 for the Rational 6KT model, 2 for the Brown Conrady model
+    float max_radius_squared; // square of the metric radius beyond which a projection is invalid
+} k4a_transformation_projection_params_t;
+
+// Number of points the batch projection functions process at a time using buffers on the stack
+#define TRANSFORMATION_BATCH_BLOCK_SIZE 256
+
+/** Projects a run of points on the normalized image plane to pixel coordinates using the lens distortion model.
+ *
+ * \param params
+ * Intrinsic parameters of the camera.
+ *
+ * \param x
+ * X coordinates of the points on the normalized image plane.
+ *
+ * \param y
+ * Y coordinates of the points on the normalized image plane.
+ *
+ * \param u
+ * Output location for the x pixel coordinates.
+ *
+ * \param v
+ * Output location for the y pixel coordinates.
+ *
+ * \param jacobian
+ * NULL, or output location for the Jacobian of (u, v) with respect to (x, y). The partial derivatives du/dx, du/dy,
+ * dv/dx and dv/dy are stored as four consecutive arrays of \p count values each.
+ *
+ * \param valid
+ * Output location for 1 if a point lies within the valid radius of the model, 0 otherwise.
+ *
+ * \param count
+ * Number of points in the run.
+ *
+ * \remarks
+ * Every implementation must produce output bit-identical to transformation_project_scalar(), which matches the single
+ * point projection. Coordinates and derivatives are computed for invalid points too and should be ignored.
+ */
+typedef void(transformation_project_fn_t)(const k4a_transformation_projection_params_t *params,
+                                          const float *x,
+                                          const float *y,
+                                          float *u,
+                                          float *v,
+                                          float *jacobian,
+                                          int *valid,
+                                          int count);
+
+transformation_project_fn_t transformation_project_scalar;
+
+#ifdef K4A_TRANSFORMATION_ENABLE_X86_SIMD
+transformation_project_fn_t transformation_project_sse41;
+transformation_project_fn_t transformation_project_avx2;
+transformation_project_fn_t transformation_project_avx512;
+#endif
+
+#ifdef K4A_TRANSFORMATION_ENABLE_NEON
+transformation_project_fn_t transformation_project_neon;
+#endif
+
+typedef int(transformation_band_fn_t)(void *band);
+
+/** Runs \p band_fn on each of \p band_count bands of \p band_size bytes stored back to back at \p bands.
+ *
+ * \remarks
+ * One band runs on the calling thread and the rest on threads created for this call and joined before returning. If a
+ * thread cannot be created its band is run on the calling thread instead. \p band_count must not exceed
+ * K4A_TRANSFORMATION_MAX_THREAD_COUNT. Only meant for one time work such as building the xy tables, per frame work
+ * runs on the worker pool of the transformation handle.
+ */
+void transformation_run_bands(transformation_band_fn_t *band_fn, void *bands, size_t band_size, uint32_t band_count);
+
+/** Creates the worker pool of a transformation handle.
+ *
+ * \param frame_scratch_size
+ * Bytes of scratch memory shared by all bands of a multi-threaded call.
+ *
+ * \param band_scratch_size
+ * Bytes of scratch memory used by each band of a call.
+ *
+ * \remarks
+ * The pool starts with a thread count of 1, no threads and the scratch memory of one band.
+ * transformation_worker_pool_set_thread_count() starts the threads and allocates the rest of the scratch memory, so
+ * the transformation calls themselves never create threads or allocate memory.
+ */
+k4a_transformation_worker_pool_t *transformation_worker_pool_create(size_t frame_scratch_size,
+                                                                    size_t band_scratch_size);
+
+/** Stops the threads of a worker pool and frees it. Accepts NULL.
+ */
+void transformation_worker_pool_destroy(k4a_transformation_worker_pool_t *pool);
+
+/** Sets the number of bands a call may split its work across, starting or stopping threads as needed.
+ *
+ * \remarks
+ * On failure the pool keeps its previous thread count.
+ */
+k4a_result_t transformation_worker_pool_set_thread_count(k4a_transformation_worker_pool_t *pool,
+                                                         uint32_t thread_count);
+
+/** Takes exclusive use of the pool and its scratch memory for one call and returns its thread count.
+ *
+ * \remarks
+ * Concurrent calls on the same transformation handle are serialized here. Every call must be matched by
+ * transformation_worker_pool_release().
+ */
+uint32_t transformation_worker_pool_acquire(k4a_transformation_worker_pool_t *pool);
+
+void transformation_worker_pool_release(k4a_transformation_worker_pool_t *pool);
+
+/** Returns the scratch memory shared by the bands of a multi-threaded call, or NULL if it is smaller than \p size.
+ */
+void *transformation_worker_pool_get_frame_scratch(k4a_transformation_worker_pool_t *pool, size_t size);
+
+/** Returns the 16 byte aligned scratch memory of \p band, or NULL if it is smaller than \p size.
+ */
+void *transformation_worker_pool_get_band_scratch(k4a_transformation_worker_pool_t *pool, uint32_t band, size_t size);
+
+/** Runs \p band_fn on each of \p band_count bands like transformation_run_bands(), but on the threads of the pool.
+ *
+ * \remarks
+ * Must be called between transformation_worker_pool_acquire() and transformation_worker_pool_release(), with
+ * \p band_count no larger than the thread count acquire returned.
+ */
+void transformation_worker_pool_run(k4a_transformation_worker_pool_t *pool,
+                                    transformation_band_fn_t *band_fn,
+                                    void *bands,
+                                    size_t band_size,
+                                    uint32_t band_count);
+
+// Scratch memory sizes the rgbz transformations need from the worker pool for a depth camera of the given size
+size_t transformation_get_frame_scratch_size(int depth_width, int depth_height);
+size_t transformation_get_band_scratch_size(int depth_width);
+
+/** Returns the number of logical processors available to the process, at least 1.
+ */
+uint32_t transformation_get_processor_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRANSFORMATION_PRIV_H
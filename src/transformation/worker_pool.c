@@ -0,0 +1,327 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "transformation_priv.h"
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+#include <stdlib.h>
+
+typedef struct _k4a_transformation_worker_t
+{
+    k4a_transformation_worker_pool_t *pool;
+    uint32_t index;      // band this thread runs, band 0 runs on the calling thread
+    uint32_t generation; // last job this thread has seen
+    THREAD_HANDLE thread;
+} k4a_transformation_worker_t;
+
+struct _k4a_transformation_worker_pool_t
+{
+    LOCK_HANDLE call_lock;       // held by the transformation call or configuration change using the pool
+    LOCK_HANDLE lock;            // guards the job and thread fields below
+    COND_HANDLE start_condition; // posted when a job is published or threads should exit
+    COND_HANDLE done_condition;  // posted when the last band of a job completes
+    k4a_transformation_worker_t workers[K4A_TRANSFORMATION_MAX_THREAD_COUNT];
+    uint32_t thread_count;       // workers with an index at or above this exit
+    uint32_t generation;         // incremented for every job
+    uint32_t pending;            // bands of the current job that have not completed
+    transformation_band_fn_t *band_fn;
+    uint8_t *bands;
+    size_t band_size;
+    uint32_t band_count;
+    uint8_t *frame_scratch;
+    size_t frame_scratch_size;
+    bool frame_scratch_allocated;
+    uint8_t *band_scratch;
+    size_t band_scratch_size;
+    uint32_t band_scratch_count; // number of bands band_scratch has room for
+};
+
+static int transformation_worker_thread(void *param)
+{
+    k4a_transformation_worker_t *worker = (k4a_transformation_worker_t *)param;
+    k4a_transformation_worker_pool_t *pool = worker->pool;
+
+    Lock(pool->lock);
+    while (worker->index < pool->thread_count)
+    {
+        if (worker->generation == pool->generation)
+        {
+            Condition_Wait(pool->start_condition, pool->lock, 0);
+            continue;
+        }
+
+        worker->generation = pool->generation;
+        if (worker->index < pool->band_count)
+        {
+            Unlock(pool->lock);
+            pool->band_fn(pool->bands + worker->index * pool->band_size);
+            Lock(pool->lock);
+            if (--pool->pending == 0)
+            {
+                Condition_Post(pool->done_condition);
+            }
+        }
+    }
+    Unlock(pool->lock);
+    return 0;
+}
+
+// Wakes every worker thread waiting on start_condition. Called with lock held. A post only wakes one waiting thread,
+// so post once for every worker that may be waiting; workers that are busy check the job again before they wait.
+static void transformation_worker_pool_wake_all(k4a_transformation_worker_pool_t *pool, uint32_t thread_count)
+{
+    for (uint32_t i = 1; i < thread_count; i++)
+    {
+        Condition_Post(pool->start_condition);
+    }
+}
+
+// Makes the threads at or above first_index exit and waits for them. Called with the call lock held, first_index must
+// be at least 1.
+static void transformation_worker_pool_stop_threads(k4a_transformation_worker_pool_t *pool, uint32_t first_index)
+{
+    Lock(pool->lock);
+    uint32_t thread_count = pool->thread_count;
+    pool->thread_count = first_index;
+    transformation_worker_pool_wake_all(pool, thread_count);
+    Unlock(pool->lock);
+
+    for (uint32_t i = first_index; i < thread_count; i++)
+    {
+        int thread_result;
+        (void)ThreadAPI_Join(pool->workers[i].thread, &thread_result);
+        pool->workers[i].thread = NULL;
+    }
+}
+
+k4a_transformation_worker_pool_t *transformation_worker_pool_create(size_t frame_scratch_size,
+                                                                    size_t band_scratch_size)
+{
+    k4a_transformation_worker_pool_t *pool = (k4a_transformation_worker_pool_t *)calloc(
+        1, sizeof(k4a_transformation_worker_pool_t));
+    if (pool == NULL)
+    {
+        LOG_ERROR("Failed to allocate transformation worker pool.", 0);
+        return NULL;
+    }
+
+    pool->thread_count = 1;
+    pool->frame_scratch_size = frame_scratch_size;
+    pool->band_scratch_size = (band_scratch_size + 15) & ~(size_t)15;
+    for (uint32_t i = 0; i < K4A_TRANSFORMATION_MAX_THREAD_COUNT; i++)
+    {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+
+    pool->call_lock = Lock_Init();
+    pool->lock = Lock_Init();
+    pool->start_condition = Condition_Init();
+    pool->done_condition = Condition_Init();
+    pool->band_scratch_count = 1;
+    pool->band_scratch = pool->band_scratch_size > 0 ? (uint8_t *)malloc(pool->band_scratch_size) : NULL;
+    if (pool->call_lock == NULL || pool->lock == NULL || pool->start_condition == NULL ||
+        pool->done_condition == NULL || (pool->band_scratch_size > 0 && pool->band_scratch == NULL))
+    {
+        LOG_ERROR("Failed to initialize transformation worker pool.", 0);
+        transformation_worker_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void transformation_worker_pool_destroy(k4a_transformation_worker_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    if (pool->call_lock != NULL && pool->lock != NULL && pool->start_condition != NULL)
+    {
+        Lock(pool->call_lock);
+        transformation_worker_pool_stop_threads(pool, 1);
+        Unlock(pool->call_lock);
+    }
+
+    if (pool->done_condition != NULL)
+    {
+        Condition_Deinit(pool->done_condition);
+    }
+    if (pool->start_condition != NULL)
+    {
+        Condition_Deinit(pool->start_condition);
+    }
+    if (pool->lock != NULL)
+    {
+        Lock_Deinit(pool->lock);
+    }
+    if (pool->call_lock != NULL)
+    {
+        Lock_Deinit(pool->call_lock);
+    }
+    free(pool->frame_scratch);
+    free(pool->band_scratch);
+    free(pool);
+}
+
+k4a_result_t transformation_worker_pool_set_thread_count(k4a_transformation_worker_pool_t *pool,
+                                                         uint32_t thread_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, pool == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count == 0 || thread_count > K4A_TRANSFORMATION_MAX_THREAD_COUNT);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    Lock(pool->call_lock);
+
+    // Scratch memory is only ever grown, so a call never needs to allocate
+    if (thread_count > 1 && !pool->frame_scratch_allocated && pool->frame_scratch_size > 0)
+    {
+        pool->frame_scratch = (uint8_t *)malloc(pool->frame_scratch_size);
+        pool->frame_scratch_allocated = pool->frame_scratch != NULL;
+        result = K4A_RESULT_FROM_BOOL(pool->frame_scratch_allocated);
+    }
+    if (K4A_SUCCEEDED(result) && thread_count > pool->band_scratch_count && pool->band_scratch_size > 0)
+    {
+        uint8_t *band_scratch = (uint8_t *)realloc(pool->band_scratch, pool->band_scratch_size * thread_count);
+        result = K4A_RESULT_FROM_BOOL(band_scratch != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            pool->band_scratch = band_scratch;
+            pool->band_scratch_count = thread_count;
+        }
+    }
+
+    uint32_t previous_thread_count = pool->thread_count;
+    if (K4A_SUCCEEDED(result) && thread_count < previous_thread_count)
+    {
+        transformation_worker_pool_stop_threads(pool, thread_count);
+    }
+    else if (K4A_SUCCEEDED(result) && thread_count > previous_thread_count)
+    {
+        Lock(pool->lock);
+        pool->thread_count = thread_count;
+        for (uint32_t i = previous_thread_count; i < thread_count; i++)
+        {
+            pool->workers[i].generation = pool->generation;
+        }
+        Unlock(pool->lock);
+
+        for (uint32_t i = previous_thread_count; i < thread_count && K4A_SUCCEEDED(result); i++)
+        {
+            if (ThreadAPI_Create(&pool->workers[i].thread, transformation_worker_thread, &pool->workers[i]) !=
+                THREADAPI_OK)
+            {
+                LOG_ERROR("Failed to create transformation worker thread %u.", i);
+                pool->workers[i].thread = NULL;
+
+                // Thread i never started, so only the threads created before it need to be stopped again
+                Lock(pool->lock);
+                pool->thread_count = i;
+                Unlock(pool->lock);
+                transformation_worker_pool_stop_threads(pool, previous_thread_count);
+                result = K4A_RESULT_FAILED;
+            }
+        }
+    }
+
+    Unlock(pool->call_lock);
+    return result;
+}
+
+uint32_t transformation_worker_pool_acquire(k4a_transformation_worker_pool_t *pool)
+{
+    Lock(pool->call_lock);
+    return pool->thread_count;
+}
+
+void transformation_worker_pool_release(k4a_transformation_worker_pool_t *pool)
+{
+    Unlock(pool->call_lock);
+}
+
+void *transformation_worker_pool_get_frame_scratch(k4a_transformation_worker_pool_t *pool, size_t size)
+{
+    if (!pool->frame_scratch_allocated || size > pool->frame_scratch_size)
+    {
+        LOG_ERROR("Transformation frame scratch of %llu bytes requested, %llu bytes available.",
+                  (unsigned long long)size,
+                  (unsigned long long)(pool->frame_scratch_allocated ? pool->frame_scratch_size : 0));
+        return NULL;
+    }
+    return pool->frame_scratch;
+}
+
+void *transformation_worker_pool_get_band_scratch(k4a_transformation_worker_pool_t *pool, uint32_t band, size_t size)
+{
+    if (band >= pool->band_scratch_count || size > pool->band_scratch_size)
+    {
+        LOG_ERROR("Transformation band scratch of %llu bytes requested for band %u, %llu bytes available for %u bands.",
+                  (unsigned long long)size,
+                  band,
+                  (unsigned long long)pool->band_scratch_size,
+                  pool->band_scratch_count);
+        return NULL;
+    }
+    return pool->band_scratch + pool->band_scratch_size * band;
+}
+
+void transformation_worker_pool_run(k4a_transformation_worker_pool_t *pool,
+                                    transformation_band_fn_t *band_fn,
+                                    void *bands,
+                                    size_t band_size,
+                                    uint32_t band_count)
+{
+    if (band_count > 1)
+    {
+        Lock(pool->lock);
+        pool->band_fn = band_fn;
+        pool->bands = (uint8_t *)bands;
+        pool->band_size = band_size;
+        pool->band_count = band_count;
+        pool->pending = band_count - 1;
+        pool->generation++;
+        transformation_worker_pool_wake_all(pool, pool->thread_count);
+        Unlock(pool->lock);
+    }
+
+    band_fn(bands);
+
+    if (band_count > 1)
+    {
+        Lock(pool->lock);
+        while (pool->pending > 0)
+        {
+            Condition_Wait(pool->done_condition, pool->lock, 0);
+        }
+        Unlock(pool->lock);
+    }
+}
+
+void transformation_run_bands(transformation_band_fn_t *band_fn, void *bands, size_t band_size, uint32_t band_count)
+{
+    THREAD_HANDLE threads[K4A_TRANSFORMATION_MAX_THREAD_COUNT] = { 0 };
+
+    for (uint32_t i = 1; i < band_count; i++)
+    {
+        if (ThreadAPI_Create(&threads[i], band_fn, (uint8_t *)bands + i * band_size) != THREADAPI_OK)
+        {
+            threads[i] = NULL;
+            band_fn((uint8_t *)bands + i * band_size);
+        }
+    }
+
+    band_fn(bands);
+
+    for (uint32_t i = 1; i < band_count; i++)
+    {
+        if (threads[i] != NULL)
+        {
+            int thread_result;
+            (void)ThreadAPI_Join(threads[i], &thread_result);
+        }
+    }
+}
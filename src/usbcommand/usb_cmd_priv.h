@@ -41,6 +41,11 @@ extern "C" {
 #endif
 #define USB_CMD_PORT_DEPTH 8
 
+// Stream buffers held downstream of the stream callback on top of the ones owned by outstanding transfers: the
+// dewrapper queue (2), the image being processed by the depth engine and one in flight through the callback
+#define USB_CMD_BUFFER_POOL_DOWNSTREAM_DEPTH 4
+#define USB_CMD_BUFFER_POOL_MAX_SIZE (USB_CMD_MAX_XFR_COUNT + USB_CMD_BUFFER_POOL_DOWNSTREAM_DEPTH)
+
 #define USB_CMD_EVENT_WAIT_TIME 1
 #define USB_MAX_TX_DATA 128
 #define USB_CMD_PACKET_TYPE 0x06022009
@@ -61,6 +66,19 @@ extern "C" {
 #define USB_CMD_IMU_STREAM_ENDPOINT 0x82
 
 //************************ Typedefs *****************************
+// Fixed set of stream sized buffers that stream images are backed by. Images return their buffer to the pool when
+// their last reference is released, so the pool lives until both the stream and every image lent out are done with it.
+typedef struct _usb_cmd_buffer_pool_t
+{
+    LOCK_HANDLE lock;
+    volatile long ref_count; // one for the stream plus one per buffer lent out
+    size_t buffer_size;
+    uint32_t buffer_count;
+    uint8_t *buffer[USB_CMD_BUFFER_POOL_MAX_SIZE];
+    void *buffer_context[USB_CMD_BUFFER_POOL_MAX_SIZE]; // allocator context of each buffer
+    bool buffer_free[USB_CMD_BUFFER_POOL_MAX_SIZE];
+} usb_cmd_buffer_pool_t;
+
 typedef struct _usbcmd_context_t
 {
     allocation_source_t source;
@@ -86,6 +104,8 @@ typedef struct _usbcmd_context_t
     struct libusb_transfer *p_bulk_transfer[USB_CMD_MAX_XFR_COUNT];
     k4a_image_t image[USB_CMD_MAX_XFR_COUNT];
     size_t stream_size;
+    usb_cmd_buffer_pool_t *buffer_pool;
+    usb_cmd_buffer_pool_stats_t buffer_pool_stats;
     LOCK_HANDLE lock;
     THREAD_HANDLE stream_handle;
 } usbcmd_context_t;
@@ -97,6 +117,14 @@ K4A_DECLARE_CONTEXT(usbcmd_t, usbcmd_context_t);
 //******************* Function Prototypes ***********************
 void LIBUSB_CALL usb_cmd_libusb_cb(struct libusb_transfer *p_bulk_transfer);
 
+k4a_result_t usb_cmd_create_stream_image(usbcmd_context_t *usbcmd, k4a_image_t *image);
+
+usb_cmd_buffer_pool_t *usb_cmd_buffer_pool_create(allocation_source_t source,
+                                                  size_t buffer_size,
+                                                  uint32_t buffer_count);
+void usb_cmd_buffer_pool_release(usb_cmd_buffer_pool_t *pool);
+k4a_result_t usb_cmd_buffer_pool_create_image(usb_cmd_buffer_pool_t *pool, k4a_image_t *image);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+//************************ Includes *****************************
+// This library
+#include "usb_cmd_priv.h"
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <azure_c_shared_utility/refcount.h>
+
+//*********************** Functions *****************************
+/**
+ *  Creates a pool of stream buffers. Every buffer is written once so its pages are faulted in here rather than on
+ *  the libusb event thread. If not every buffer can be allocated the pool is created with the ones that could.
+ *
+ *  @param source
+ *   Allocation source the buffers are accounted to
+ *
+ *  @param buffer_size
+ *   Size of each buffer
+ *
+ *  @param buffer_count
+ *   Number of buffers, up to USB_CMD_BUFFER_POOL_MAX_SIZE
+ *
+ *  @return
+ *   The pool holding one reference for the caller, or NULL on failure
+ *
+ */
+usb_cmd_buffer_pool_t *usb_cmd_buffer_pool_create(allocation_source_t source, size_t buffer_size, uint32_t buffer_count)
+{
+    usb_cmd_buffer_pool_t *pool = (usb_cmd_buffer_pool_t *)calloc(1, sizeof(usb_cmd_buffer_pool_t));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    pool->lock = Lock_Init();
+    if (pool->lock == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    pool->ref_count = 1;
+    pool->buffer_size = buffer_size;
+    for (uint32_t i = 0; i < buffer_count && i < USB_CMD_BUFFER_POOL_MAX_SIZE; i++)
+    {
+        pool->buffer[i] = allocator_alloc(source, buffer_size, &pool->buffer_context[i]);
+        if (pool->buffer[i] == NULL)
+        {
+            LOG_WARNING("Stream buffer pool limited to %u of %u buffers", i, buffer_count);
+            break;
+        }
+        memset(pool->buffer[i], 0, buffer_size);
+        pool->buffer_free[i] = true;
+        pool->buffer_count++;
+    }
+
+    return pool;
+}
+
+/**
+ *  Drops one reference on the pool and frees it with all its buffers when the last one is gone
+ *
+ *  @param pool
+ *   Pool to release
+ *
+ */
+void usb_cmd_buffer_pool_release(usb_cmd_buffer_pool_t *pool)
+{
+    if (DEC_REF_VAR(pool->ref_count) == 0)
+    {
+        for (uint32_t i = 0; i < pool->buffer_count; i++)
+        {
+            allocator_free(pool->buffer[i], pool->buffer_context[i]);
+        }
+        Lock_Deinit(pool->lock);
+        free(pool);
+    }
+}
+
+/**
+ *  Image destroy callback returning a pooled buffer to its pool
+ *
+ *  @param buffer
+ *   Buffer of the image being destroyed
+ *
+ *  @param context
+ *   Pool the buffer belongs to
+ *
+ */
+static void usb_cmd_buffer_pool_return(void *buffer, void *context)
+{
+    usb_cmd_buffer_pool_t *pool = (usb_cmd_buffer_pool_t *)context;
+
+    Lock(pool->lock);
+    for (uint32_t i = 0; i < pool->buffer_count; i++)
+    {
+        if (pool->buffer[i] == buffer)
+        {
+            pool->buffer_free[i] = true;
+            break;
+        }
+    }
+    Unlock(pool->lock);
+
+    usb_cmd_buffer_pool_release(pool);
+}
+
+/**
+ *  Creates an image of the pool's buffer size backed by a free pooled buffer. The buffer goes back to the pool when
+ *  the last reference to the image is released.
+ *
+ *  @param pool
+ *   Pool to take the buffer from
+ *
+ *  @param image
+ *   Location to write the image to
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Every buffer is in use or the image could not be created
+ *
+ */
+k4a_result_t usb_cmd_buffer_pool_create_image(usb_cmd_buffer_pool_t *pool, k4a_image_t *image)
+{
+    uint8_t *buffer = NULL;
+
+    Lock(pool->lock);
+    for (uint32_t i = 0; i < pool->buffer_count; i++)
+    {
+        if (pool->buffer_free[i])
+        {
+            pool->buffer_free[i] = false;
+            buffer = pool->buffer[i];
+            break;
+        }
+    }
+    Unlock(pool->lock);
+
+    if (buffer == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // The image holds a reference on the pool until its buffer is returned
+    INC_REF_VAR(pool->ref_count);
+    if (K4A_FAILED(TRACE_CALL(image_create_empty_from_buffer_internal(
+            buffer, pool->buffer_size, usb_cmd_buffer_pool_return, pool, image))))
+    {
+        usb_cmd_buffer_pool_return(buffer, pool);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
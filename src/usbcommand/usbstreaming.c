@@ -23,6 +23,32 @@
 //******************* Function Prototypes ***********************
 
 //*********************** Functions *****************************
+/**
+ *  Creates the image the next stream transfer reads into, backed by a pooled buffer when one is free
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ *  @param image
+ *   Location to write the image to
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+k4a_result_t usb_cmd_create_stream_image(usbcmd_context_t *usbcmd, k4a_image_t *image)
+{
+    if (usbcmd->buffer_pool != NULL && K4A_SUCCEEDED(usb_cmd_buffer_pool_create_image(usbcmd->buffer_pool, image)))
+    {
+        usbcmd->buffer_pool_stats.hit_count++;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    usbcmd->buffer_pool_stats.miss_count++;
+    return TRACE_CALL(image_create_empty_internal(usbcmd->source, usbcmd->stream_size, image));
+}
+
 /**
  *  Utility function for releasing the transfer resources
  *
@@ -98,9 +124,8 @@ void LIBUSB_CALL usb_cmd_libusb_cb(struct libusb_transfer *p_bulk_transfer)
         image_dec_ref(usbcmd->image[image_index]);
         usbcmd->image[image_index] = NULL;
 
-        // allocate next buffer and re-use transfer
-        result = TRACE_CALL(
-            image_create_empty_internal(usbcmd->source, usbcmd->stream_size, &usbcmd->image[image_index]));
+        // get the next buffer and re-use transfer
+        result = TRACE_CALL(usb_cmd_create_stream_image(usbcmd, &usbcmd->image[image_index]));
         if (K4A_SUCCEEDED(result))
         {
             int err = LIBUSB_ERROR_OTHER;
@@ -182,6 +207,23 @@ static int usb_cmd_lib_usb_thread(void *var)
     }
     else
     {
+        // Back the transfers, and the images downstream still holds on to, with recycled buffers. Size the pool from
+        // the number of transfers the loop below will set up.
+        uint32_t xfr_count = 0;
+        for (size_t pool_size = usbcmd->stream_size; (xfr_count < USB_CMD_MAX_XFR_COUNT) && (pool_size < max_xfr_pool);
+             pool_size += usbcmd->stream_size)
+        {
+            xfr_count++;
+        }
+        uint32_t pool_size = xfr_count + USB_CMD_BUFFER_POOL_DOWNSTREAM_DEPTH;
+        usbcmd->buffer_pool = usb_cmd_buffer_pool_create(usbcmd->source, usbcmd->stream_size, pool_size);
+        usbcmd->buffer_pool_stats.requested_count = pool_size;
+        usbcmd->buffer_pool_stats.buffer_count = usbcmd->buffer_pool == NULL ? 0 : usbcmd->buffer_pool->buffer_count;
+        if (usbcmd->buffer_pool == NULL)
+        {
+            LOG_WARNING("Stream buffer pool could not be created, allocating stream buffers per transfer", 0);
+        }
+
         // set up the transfers.  Limit the overall amount of resources to a predefined amount
         for (uint32_t i = 0; (i < USB_CMD_MAX_XFR_COUNT) && (xfer_pool < max_xfr_pool); i++)
         {
@@ -194,7 +236,7 @@ static int usb_cmd_lib_usb_thread(void *var)
                 break;
             }
 
-            result = TRACE_CALL(image_create_empty_internal(usbcmd->source, usbcmd->stream_size, &usbcmd->image[i]));
+            result = TRACE_CALL(usb_cmd_create_stream_image(usbcmd, &usbcmd->image[i]));
 
             if (K4A_FAILED(result))
             {
@@ -270,6 +312,18 @@ static int usb_cmd_lib_usb_thread(void *var)
         }
     }
 
+    // Buffers still held by images are returned to the pool, which is freed once the last one is released
+    if (usbcmd->buffer_pool != NULL)
+    {
+        LOG_INFO("Stream buffer pool buffers:%u/%u hits:%llu misses:%llu",
+                 usbcmd->buffer_pool_stats.buffer_count,
+                 usbcmd->buffer_pool_stats.requested_count,
+                 (unsigned long long)usbcmd->buffer_pool_stats.hit_count,
+                 (unsigned long long)usbcmd->buffer_pool_stats.miss_count);
+        usb_cmd_buffer_pool_release(usbcmd->buffer_pool);
+        usbcmd->buffer_pool = NULL;
+    }
+
     ThreadAPI_Exit((int)result);
     return 0;
 }
@@ -375,3 +429,30 @@ k4a_result_t usb_cmd_stream_stop(usbcmd_t usbcmd_handle)
 
     return result;
 }
+
+/**
+ *  Function for reading the stream buffer pool statistics of a handle
+ *
+ *  @param usbcmd_handle
+ *   Handle that contains the stream.
+ *
+ *  @param stats
+ *   Location to write the statistics to
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+k4a_result_t usb_cmd_get_buffer_pool_stats(usbcmd_t usbcmd_handle, usb_cmd_buffer_pool_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usbcmd_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+
+    // The statistics are only written by the stream thread, so a read while streaming may be slightly behind
+    *stats = usbcmd->buffer_pool_stats;
+
+    return K4A_RESULT_SUCCEEDED;
+}
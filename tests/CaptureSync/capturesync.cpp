@@ -74,6 +74,81 @@ TEST(capturesync_ut, capturesync)
     capturesync_destroy(NULL);
 }
 
+TEST(capturesync_ut, latency_stats)
+{
+    k4a_capture_t capture;
+    k4a_image_t image;
+    capturesync_t sync;
+    k4a_capture_latency_stats_t stats;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    // Only depth is running, so captures are queued as soon as they are added
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_get_latency_stats(NULL, &stats), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_get_latency_stats(sync, NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+
+    ASSERT_EQ(capturesync_get_latency_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.end_to_end.count, 0u);
+
+    const uint64_t capture_count = 10;
+    for (uint64_t i = 0; i < capture_count; i++)
+    {
+        ASSERT_EQ(capture_create(&capture), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(image_create_empty_internal(ALLOCATION_SOURCE_DEPTH, 10, &image), K4A_RESULT_SUCCEEDED);
+        image_set_timestamp_usec(image, FPS_30_US(i, 0));
+        capture_set_ir_image(capture, image);
+        capture_set_depth_image(capture, image);
+        image_dec_ref(image);
+
+        // Pretend the capture left USB 2ms ago and the depth engine 1ms ago
+        uint64_t usb_transfer_usec = capture_get_host_time_usec() - 2000;
+        capture_set_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_USB_TRANSFER, usb_transfer_usec);
+        capture_set_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_DEPTH_ENGINE, usb_transfer_usec + 1000);
+        capturesync_add_capture(sync, K4A_RESULT_SUCCEEDED, capture, DEPTH_CAPTURE);
+        capture_dec_ref(capture);
+
+        ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+        uint64_t depth_engine_usec = capture_get_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_DEPTH_ENGINE);
+        uint64_t sync_usec = capture_get_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_SYNC);
+        uint64_t pop_usec = capture_get_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_POP);
+        ASSERT_EQ(capture_get_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_USB_TRANSFER), usb_transfer_usec);
+        ASSERT_EQ(depth_engine_usec, usb_transfer_usec + 1000);
+        ASSERT_GE(sync_usec, depth_engine_usec + 1000);
+        ASSERT_LE(sync_usec, pop_usec);
+        ASSERT_EQ(capture_get_stage_timestamp_usec(capture, K4A_CAPTURE_STAGE_COUNT), 0u);
+        capture_dec_ref(capture);
+    }
+
+    ASSERT_EQ(capturesync_get_latency_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.depth_engine.count, capture_count);
+    ASSERT_EQ(stats.sync.count, capture_count);
+    ASSERT_EQ(stats.pop.count, capture_count);
+    ASSERT_EQ(stats.end_to_end.count, capture_count);
+
+    // 1000us falls in a bucket of 32us, and percentiles never exceed the largest latency
+    ASSERT_EQ(stats.depth_engine.max_usec, 1000u);
+    ASSERT_EQ(stats.depth_engine.p50_usec, 1000u);
+    ASSERT_EQ(stats.depth_engine.p99_usec, 1000u);
+    ASSERT_GE(stats.sync.p50_usec, 1000u);
+    ASSERT_GE(stats.end_to_end.p50_usec, 2000u);
+    ASSERT_LE(stats.end_to_end.p50_usec, stats.end_to_end.p99_usec);
+    ASSERT_LE(stats.end_to_end.p99_usec, stats.end_to_end.max_usec);
+
+    // Restarting the streams clears the statistics
+    capturesync_stop(sync);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_get_latency_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.end_to_end.count, 0u);
+    ASSERT_EQ(stats.end_to_end.max_usec, 0u);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
+
 typedef struct _capturesync_test_timing_t
 {
     uint64_t timestamp_usec;
@@ -14,6 +14,8 @@ static uvc_device_handle_t *g_uvc_device_handle = (uvc_device_handle_t *)0x0004;
 
 static bool g_opened = false;
 static bool g_streaming = false;
+static uvc_frame_callback_t *g_frame_cb = nullptr;
+static void *g_frame_cb_user_ptr = nullptr;
 static int g_device_ref_count = 0;
 
 static uint8_t g_ae_mode = 8; // default is UVC_AUTO_EXPOSURE_MODE_APERTURE_PRIORITY
@@ -215,6 +217,8 @@ void EXPECT_uvc_start_streaming(MockLibUVC &mockLibUVC)
             {
                 (void)flags;
                 g_streaming = true;
+                g_frame_cb = cb;
+                g_frame_cb_user_ptr = user_ptr;
             }
             else
             {
@@ -238,9 +242,19 @@ void EXPECT_uvc_stop_streaming(MockLibUVC &mockLibUVC)
         .WillRepeatedly(Invoke([](uvc_device_handle_t *devh) {
             ASSERT_EQ(devh, g_uvc_device_handle);
             g_streaming = false;
+            g_frame_cb = nullptr;
+            g_frame_cb_user_ptr = nullptr;
         }));
 }
 
+void uvc_mock_stream_frame(uvc_frame_t *frame)
+{
+    if (g_streaming && g_frame_cb != nullptr)
+    {
+        g_frame_cb(frame, g_frame_cb_user_ptr);
+    }
+}
+
 void uvc_close(uvc_device_handle_t *devh)
 {
     return g_mockLibUVC->uvc_close(devh);
@@ -84,6 +84,9 @@ void EXPECT_uvc_close(MockLibUVC &mockLibUVC);
 void EXPECT_uvc_unref_device(MockLibUVC &mockLibUVC);
 void EXPECT_uvc_exit(MockLibUVC &mockLibUVC);
 
+// Hands a frame to the callback of the stream started with uvc_start_streaming
+void uvc_mock_stream_frame(uvc_frame_t *frame);
+
 void EXPECT_uvc_get_ae_mode(MockLibUVC &mockLibUVC);
 void EXPECT_uvc_get_exposure_abs(MockLibUVC &mockLibUVC);
 void EXPECT_uvc_get_ae_priority(MockLibUVC &mockLibUVC);
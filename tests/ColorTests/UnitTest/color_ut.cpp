@@ -12,6 +12,14 @@
 #include "color_mock_windows.h"
 #else
 #include "color_mock_libuvc.h"
+#include <k4ainternal/capture.h>
+#include <k4ainternal/image.h>
+#include <azure_c_shared_utility/threadapi.h>
+#include <../src/color/ksmetadata.h>
+#include <../src/color/uvc_camerareader.h> // include the private decode queue limits for testing
+#include <cstdlib>
+#include <mutex>
+#include <vector>
 #endif // _WIN32
 
 // Fake container ID
@@ -176,6 +184,180 @@ TEST_F(color_ut, streaming)
     tickcounter_destroy(tick);
 }
 
+#ifndef _WIN32
+#define DECODE_TEST_FRAME_COUNT 30
+#define DECODE_TEST_WIDTH 1280
+#define DECODE_TEST_HEIGHT 720
+
+// Gray level of every pixel in test frame i
+#define DECODE_TEST_GRAY(i) (40 + 5 * (i))
+
+typedef struct _decode_test_context_t
+{
+    std::mutex lock;
+    std::vector<int> frames; // Index of every frame delivered, in delivery order
+    int failures;
+} decode_test_context_t;
+
+static void decode_test_capture_ready(k4a_result_t result, k4a_capture_t capture, void *context)
+{
+    decode_test_context_t *test = (decode_test_context_t *)context;
+    std::lock_guard<std::mutex> lock(test->lock);
+
+    k4a_image_t image = K4A_SUCCEEDED(result) ? capture_get_color_image(capture) : NULL;
+    if (image == NULL)
+    {
+        test->failures++;
+        return;
+    }
+
+    // Frame i was sent with a PTS of (i + 1) * 3000 ticks of the 90kHz clock
+    int frame = -1;
+    for (int i = 0; i <= DECODE_TEST_FRAME_COUNT; i++)
+    {
+        if (image_get_timestamp_usec(image) == K4A_90K_HZ_TICK_TO_USEC((uint64_t)(i + 1) * 3000))
+        {
+            frame = i;
+        }
+    }
+
+    // The decoded pixels must come from the frame the timestamp belongs to
+    const uint8_t *buffer = image_get_buffer(image);
+    size_t pixel_offset = ((size_t)DECODE_TEST_HEIGHT / 2 * DECODE_TEST_WIDTH + DECODE_TEST_WIDTH / 2) * 4;
+    if (frame < 0 || image_get_width_pixels(image) != DECODE_TEST_WIDTH ||
+        abs((int)buffer[pixel_offset] - DECODE_TEST_GRAY(frame)) > 3)
+    {
+        test->failures++;
+    }
+    else
+    {
+        test->frames.push_back(frame);
+    }
+    image_dec_ref(image);
+}
+
+static void decode_test_stream_frame(int frame, const std::vector<uint8_t> &jpeg)
+{
+    CUSTOM_METADATA_FrameAlignInfo frame_align_info = {};
+    frame_align_info.Header.MetadataId = MetadataId_FrameAlignInfo;
+    frame_align_info.Header.Size = sizeof(frame_align_info);
+    frame_align_info.FramePTS = (uint64_t)(frame + 1) * 3000;
+
+    uvc_frame_t uvc_frame = {};
+    uvc_frame.data = (void *)jpeg.data();
+    uvc_frame.data_bytes = jpeg.size();
+    uvc_frame.width = DECODE_TEST_WIDTH;
+    uvc_frame.height = DECODE_TEST_HEIGHT;
+    uvc_frame.metadata = &frame_align_info;
+    uvc_frame.metadata_bytes = sizeof(frame_align_info);
+    uvc_mock_stream_frame(&uvc_frame);
+}
+
+// Waits until no frame has been delivered for 200ms and returns the number of frames delivered
+static size_t decode_test_wait_idle(decode_test_context_t *test)
+{
+    size_t count = 0;
+    for (int idle = 0, i = 0; idle < 10 && i < 500; i++)
+    {
+        ThreadAPI_Sleep(20);
+        std::lock_guard<std::mutex> lock(test->lock);
+        idle = test->frames.size() == count ? idle + 1 : 0;
+        count = test->frames.size();
+    }
+    return count;
+}
+
+TEST_F(color_ut, mjpeg_decode_queue)
+{
+    // Encode every test frame as a solid gray JPEG
+    std::vector<std::vector<uint8_t>> jpegs(DECODE_TEST_FRAME_COUNT + 1);
+    std::vector<uint8_t> bgra((size_t)DECODE_TEST_WIDTH * DECODE_TEST_HEIGHT * 4);
+    tjhandle encoder = tjInitCompress();
+    ASSERT_NE(encoder, (tjhandle)NULL);
+    for (int i = 0; i <= DECODE_TEST_FRAME_COUNT; i++)
+    {
+        memset(bgra.data(), DECODE_TEST_GRAY(i), bgra.size());
+        unsigned char *jpeg = NULL;
+        unsigned long jpeg_size = 0;
+        ASSERT_EQ(0,
+                  tjCompress2(encoder,
+                              bgra.data(),
+                              DECODE_TEST_WIDTH,
+                              0, // pitch
+                              DECODE_TEST_HEIGHT,
+                              TJPF_BGRA,
+                              &jpeg,
+                              &jpeg_size,
+                              TJSAMP_422,
+                              90,
+                              0));
+        jpegs[(size_t)i].assign(jpeg, jpeg + jpeg_size);
+        tjFree(jpeg);
+    }
+    tjDestroy(encoder);
+
+    color_t color_handle = NULL;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    decode_test_context_t test;
+    test.failures = 0;
+    TICK_COUNTER_HANDLE tick;
+
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              color_create(tick,
+                           &guid_FakeGoodContainerId,
+                           str_FakeGoodSerialNumber,
+                           decode_test_capture_ready,
+                           &test,
+                           &color_handle));
+
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+    config.color_resolution = K4A_COLOR_RESOLUTION_720P;
+    config.depth_mode = K4A_DEPTH_MODE_OFF;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, color_start(color_handle, &config));
+
+    // Frames arrive much faster than they can be decoded. The first UVC_DECODE_MAX_IN_FLIGHT frames are always
+    // accepted, later ones are dropped while the queue is full.
+    for (int i = 0; i < DECODE_TEST_FRAME_COUNT; i++)
+    {
+        decode_test_stream_frame(i, jpegs[(size_t)i]);
+    }
+    size_t delivered = decode_test_wait_idle(&test);
+    {
+        std::lock_guard<std::mutex> lock(test.lock);
+        ASSERT_EQ(test.failures, 0);
+        ASSERT_GE(delivered, (size_t)UVC_DECODE_MAX_IN_FLIGHT);
+        ASSERT_LT(delivered, (size_t)DECODE_TEST_FRAME_COUNT);
+        for (size_t i = 0; i < delivered; i++)
+        {
+            // Frames are delivered in the order they arrived, whichever decode thread finished first
+            if (i < UVC_DECODE_MAX_IN_FLIGHT)
+            {
+                ASSERT_EQ(test.frames[i], (int)i);
+            }
+            else
+            {
+                ASSERT_GT(test.frames[i], test.frames[i - 1]);
+            }
+        }
+    }
+
+    // Once the queue drains, new frames are decoded again
+    decode_test_stream_frame(DECODE_TEST_FRAME_COUNT, jpegs[DECODE_TEST_FRAME_COUNT]);
+    ASSERT_EQ(decode_test_wait_idle(&test), delivered + 1);
+    {
+        std::lock_guard<std::mutex> lock(test.lock);
+        ASSERT_EQ(test.failures, 0);
+        ASSERT_EQ(test.frames.back(), DECODE_TEST_FRAME_COUNT);
+    }
+
+    color_stop(color_handle);
+    color_destroy(color_handle);
+    tickcounter_destroy(tick);
+}
+#endif // _WIN32
+
 // color_ut exposure control testing
 TEST_F(color_ut, exposure_control)
 {
@@ -10,6 +10,7 @@
 #include <k4ainternal/color_mcu.h>
 #include <k4ainternal/depth_mcu.h>
 #include <k4ainternal/calibration.h>
+#include <azure_c_shared_utility/threadapi.h>
 
 using namespace testing;
 
@@ -350,6 +351,214 @@ TEST_F(imu_ut, get_sample)
     calibration_destroy(calibration_handle);
 }
 
+static void imu_push_payload(uint32_t sample_count, uint64_t first_pts)
+{
+    uint32_t imu_alloc_size = sizeof(imu_payload_metadata_t) + sizeof(xyz_vector_t) * sample_count * 2;
+    k4a_capture_t cb_capture = capture_manufacture(imu_alloc_size);
+    ASSERT_NE(cb_capture, (k4a_capture_t)NULL);
+    k4a_image_t image = capture_get_imu_image(cb_capture);
+    uint8_t *buffer = image_get_buffer(image);
+    memset(buffer, 0, imu_alloc_size);
+
+    imu_payload_metadata_t *p_imu_packet = (imu_payload_metadata_t *)buffer;
+    p_imu_packet->gyro.sample_count = sample_count;
+    p_imu_packet->accel.sample_count = sample_count;
+    xyz_vector_t *p_gyro = (xyz_vector_t *)(buffer + sizeof(imu_payload_metadata_t));
+    xyz_vector_t *p_accel = p_gyro + sample_count;
+    for (uint32_t i = 0; i < sample_count; i++)
+    {
+        p_gyro[i].pts = first_pts + i;
+        p_accel[i].pts = first_pts + i;
+    }
+
+    g_MockColorMcu->frame_ready_cb(K4A_RESULT_SUCCEEDED, image, g_MockColorMcu->cb_context);
+    image_dec_ref(image);
+    capture_dec_ref(cb_capture);
+}
+
+TEST_F(imu_ut, get_samples)
+{
+    imu_t imu_handle = NULL;
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_DEPTH_MCU, &calibration_handle));
+    TICK_COUNTER_HANDLE tick;
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, FAKE_COLOR_MCU, calibration_handle, &imu_handle));
+    ASSERT_NE(imu_handle, (imu_t)NULL);
+
+    k4a_imu_sample_t samples[1000];
+    size_t sample_count = 0;
+
+    // Fail if not started
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, samples, 10, &sample_count, 10));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+
+    // Parameter validation
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, NULL, 10, &sample_count, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, samples, 0, &sample_count, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, samples, 10, NULL, 0));
+
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imu_get_samples(imu_handle, samples, 10, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)0);
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imu_get_samples(imu_handle, samples, 10, &sample_count, 10));
+
+    // Samples from several payloads are returned together, in order, up to max_samples
+    imu_push_payload(3, 90);
+    imu_push_payload(4, 93 * 2);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, samples, 5, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)5);
+    uint64_t expected_pts[] = { 90, 91, 92, 186, 187, 188, 189 };
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_EQ(samples[i].acc_timestamp_usec, K4A_90K_HZ_TICK_TO_USEC(expected_pts[i]));
+        ASSERT_EQ(samples[i].gyro_timestamp_usec, K4A_90K_HZ_TICK_TO_USEC(expected_pts[i]));
+    }
+
+    k4a_imu_sample_t sample;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_sample(imu_handle, &sample, 0));
+    ASSERT_EQ(sample.acc_timestamp_usec, K4A_90K_HZ_TICK_TO_USEC(expected_pts[5]));
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, samples, 1000, &sample_count, K4A_WAIT_INFINITE));
+    ASSERT_EQ(sample_count, (size_t)1);
+    ASSERT_EQ(samples[0].acc_timestamp_usec, K4A_90K_HZ_TICK_TO_USEC(expected_pts[6]));
+
+    // When more samples arrive than are buffered, the oldest are dropped
+    for (uint32_t i = 0; i < 1000; i += 8)
+    {
+        imu_push_payload(8, 1000 + i);
+    }
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, samples, 1000, &sample_count, 0));
+    ASSERT_GT(sample_count, (size_t)0);
+    ASSERT_LT(sample_count, (size_t)1000);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_EQ(samples[i].acc_timestamp_usec, K4A_90K_HZ_TICK_TO_USEC(2000 - sample_count + i));
+    }
+
+    // Stopping the IMU fails the reader
+    imu_stop(imu_handle);
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, samples, 1000, &sample_count, 0));
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+    imu_destroy(imu_handle);
+    tickcounter_destroy(tick);
+    calibration_destroy(calibration_handle);
+}
+
+typedef struct _imu_reader_t
+{
+    imu_t imu_handle;
+    k4a_wait_result_t result;
+} imu_reader_t;
+
+static int imu_reader_thread(void *param)
+{
+    imu_reader_t *reader = (imu_reader_t *)param;
+    k4a_imu_sample_t samples[10];
+    size_t sample_count = 0;
+    reader->result = imu_get_samples(reader->imu_handle, samples, 10, &sample_count, K4A_WAIT_INFINITE);
+    return 0;
+}
+
+TEST_F(imu_ut, get_samples_wait)
+{
+    imu_t imu_handle = NULL;
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_DEPTH_MCU, &calibration_handle));
+    TICK_COUNTER_HANDLE tick;
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, FAKE_COLOR_MCU, calibration_handle, &imu_handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+
+    // A timed wait lasts its whole timeout
+    k4a_imu_sample_t samples[10];
+    size_t sample_count = 0;
+    tickcounter_ms_t start_tick = 0;
+    tickcounter_ms_t end_tick = 0;
+    ASSERT_EQ(0, tickcounter_get_current_ms(tick, &start_tick));
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imu_get_samples(imu_handle, samples, 10, &sample_count, 50));
+    ASSERT_EQ(0, tickcounter_get_current_ms(tick, &end_tick));
+    ASSERT_GE(end_tick - start_tick, (tickcounter_ms_t)50);
+
+    // Stopping the IMU fails every waiting reader, even if it is started again before they wake up
+    for (int restart = 0; restart < 2; restart++)
+    {
+        imu_reader_t readers[3];
+        THREAD_HANDLE threads[3];
+        for (int i = 0; i < 3; i++)
+        {
+            readers[i].imu_handle = imu_handle;
+            readers[i].result = K4A_WAIT_RESULT_SUCCEEDED;
+            ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&threads[i], imu_reader_thread, &readers[i]));
+        }
+        ThreadAPI_Sleep(50);
+
+        imu_stop(imu_handle);
+        if (restart)
+        {
+            ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            int thread_result;
+            ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(threads[i], &thread_result));
+            ASSERT_EQ(K4A_WAIT_RESULT_FAILED, readers[i].result);
+        }
+        if (!restart)
+        {
+            ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+        }
+    }
+
+    // A restarted IMU delivers samples again
+    imu_push_payload(2, 90);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, samples, 10, &sample_count, 50));
+    ASSERT_EQ(sample_count, (size_t)2);
+
+    imu_stop(imu_handle);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+    imu_destroy(imu_handle);
+    tickcounter_destroy(tick);
+    calibration_destroy(calibration_handle);
+}
+
+TEST_F(imu_ut, get_samples_wait_destroy)
+{
+    imu_t imu_handle = NULL;
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_DEPTH_MCU, &calibration_handle));
+    TICK_COUNTER_HANDLE tick;
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, FAKE_COLOR_MCU, calibration_handle, &imu_handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+
+    // Destroying the IMU fails every waiting reader before the sample ring goes away
+    imu_reader_t readers[4];
+    THREAD_HANDLE threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        readers[i].imu_handle = imu_handle;
+        readers[i].result = K4A_WAIT_RESULT_SUCCEEDED;
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&threads[i], imu_reader_thread, &readers[i]));
+    }
+    ThreadAPI_Sleep(50);
+
+    imu_destroy(imu_handle);
+    for (int i = 0; i < 4; i++)
+    {
+        int thread_result;
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(threads[i], &thread_result));
+        ASSERT_EQ(K4A_WAIT_RESULT_FAILED, readers[i].result);
+    }
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+    tickcounter_destroy(tick);
+    calibration_destroy(calibration_handle);
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_commmon_main(argc, argv);
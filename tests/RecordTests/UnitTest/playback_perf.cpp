@@ -7,10 +7,15 @@
 #include <k4ainternal/matroska_common.h>
 
 #include "test_helpers.h"
+#include <cstring>
 #include <fstream>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 // Module being tested
 #include <k4arecord/playback.h>
+#include <k4arecord/record.h>
 
 using namespace testing;
 
@@ -328,6 +333,216 @@ TEST_F(playback_perf, test_read_latency_30fps_bgra_conversion)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_perf, test_read_throughput_bgra_conversion)
+{
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> thread_counts = { 0, 1, 2, 4 };
+    if (max_threads > 4)
+    {
+        thread_counts.push_back(max_threads);
+    }
+
+    for (uint32_t thread_count : thread_counts)
+    {
+        k4a_playback_t handle = NULL;
+        k4a_result_t result = k4a_playback_open(g_test_file_name.c_str(), &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_configuration_t config;
+        result = k4a_playback_get_record_configuration(handle, &config);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        if (!config.color_track_enabled)
+        {
+            std::cout << "    Warning: Input file has no color track." << std::endl;
+            k4a_playback_close(handle);
+            return;
+        }
+
+        result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        result = k4a_playback_set_color_decode_threads(handle, thread_count, thread_count * 2);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        int capture_count = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            k4a_capture_t capture = NULL;
+            k4a_stream_result_t playback_result = K4A_STREAM_RESULT_FAILED;
+            Timer t("Next capture x1000, " + std::to_string(thread_count) + " decode threads");
+            for (; capture_count < 1000; capture_count++)
+            {
+                playback_result = k4a_playback_get_next_capture(handle, &capture);
+                if (playback_result == K4A_STREAM_RESULT_EOF)
+                {
+                    std::cout << "    Warning: Input file is too short, only read " << capture_count << " captures."
+                              << std::endl;
+                    break;
+                }
+                ASSERT_EQ(playback_result, K4A_STREAM_RESULT_SUCCEEDED);
+                ASSERT_NE(capture, nullptr);
+                k4a_capture_release(capture);
+            }
+        }
+        auto delta = std::chrono::high_resolution_clock::now() - start;
+        double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(delta).count();
+        std::cout << "    Throughput: " << ((double)capture_count / seconds) << " captures/sec" << std::endl;
+
+        k4a_playback_close(handle);
+    }
+}
+
+TEST_F(playback_perf, test_depth_compression)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open(g_test_file_name.c_str(), &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    if (!config.depth_track_enabled && !config.ir_track_enabled)
+    {
+        std::cout << "    Warning: Input file has no depth or IR track." << std::endl;
+        k4a_playback_close(handle);
+        return;
+    }
+
+    // Keep only the depth and IR images of the first 300 captures in memory.
+    std::vector<k4a_capture_t> captures;
+    while (captures.size() < 300)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t playback_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_NE(playback_result, K4A_STREAM_RESULT_FAILED);
+        if (playback_result == K4A_STREAM_RESULT_EOF)
+        {
+            break;
+        }
+
+        k4a_capture_t depth_capture = NULL;
+        ASSERT_EQ(k4a_capture_create(&depth_capture), K4A_RESULT_SUCCEEDED);
+        k4a_image_t depth = k4a_capture_get_depth_image(capture);
+        k4a_image_t ir = k4a_capture_get_ir_image(capture);
+        if (depth != NULL)
+        {
+            k4a_capture_set_depth_image(depth_capture, depth);
+            k4a_image_release(depth);
+        }
+        if (ir != NULL)
+        {
+            k4a_capture_set_ir_image(depth_capture, ir);
+            k4a_image_release(ir);
+        }
+        k4a_capture_release(capture);
+        captures.push_back(depth_capture);
+    }
+    k4a_playback_close(handle);
+
+    // Codec throughput and ratio for each track
+    std::vector<uint8_t> compressed;
+    std::vector<uint16_t> decompressed;
+    for (int track = 0; track < 2; track++)
+    {
+        uint64_t input_bytes = 0, output_bytes = 0, frame_count = 0;
+        std::chrono::high_resolution_clock::duration compress_time(0), decompress_time(0);
+        for (k4a_capture_t capture : captures)
+        {
+            k4a_image_t image = track == 0 ? k4a_capture_get_depth_image(capture) : k4a_capture_get_ir_image(capture);
+            if (image == NULL)
+            {
+                continue;
+            }
+            const uint16_t *samples = reinterpret_cast<const uint16_t *>(k4a_image_get_buffer(image));
+            size_t sample_count = k4a_image_get_size(image) / sizeof(uint16_t);
+            uint32_t row_length = (uint32_t)k4a_image_get_stride_bytes(image) / sizeof(uint16_t);
+            compressed.resize(k4arecord::lossless16_max_compressed_size(sample_count));
+            decompressed.resize(sample_count);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            size_t compressed_size =
+                k4arecord::lossless16_compress(samples, sample_count, row_length, compressed.data());
+            auto middle = std::chrono::high_resolution_clock::now();
+            result = k4arecord::lossless16_decompress(compressed.data(),
+                                                      compressed_size,
+                                                      decompressed.data(),
+                                                      sample_count);
+            auto end = std::chrono::high_resolution_clock::now();
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(memcmp(decompressed.data(), samples, sample_count * sizeof(uint16_t)), 0);
+
+            compress_time += middle - start;
+            decompress_time += end - middle;
+            input_bytes += sample_count * sizeof(uint16_t);
+            output_bytes += compressed_size;
+            frame_count++;
+            k4a_image_release(image);
+        }
+        if (frame_count == 0)
+        {
+            continue;
+        }
+
+        double compress_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(compress_time).count();
+        double decompress_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(decompress_time).count();
+        std::cout << (track == 0 ? "Depth" : "IR") << " frames: " << frame_count << std::endl;
+        std::cout << "    Compression ratio: " << ((double)input_bytes / (double)output_bytes) << std::endl;
+        std::cout << "    Compress: " << ((double)input_bytes / 1000000.0 / compress_seconds) << " MB/s" << std::endl;
+        std::cout << "    Decompress: " << ((double)input_bytes / 1000000.0 / decompress_seconds) << " MB/s"
+                  << std::endl;
+    }
+
+    // Recording throughput without compression, and with compression on the calling thread and on worker threads
+    k4a_device_configuration_t device_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    device_config.depth_mode = config.depth_mode;
+    device_config.camera_fps = config.camera_fps;
+    std::pair<k4a_record_compression_t, uint32_t> modes[] = { { K4A_RECORD_COMPRESSION_NONE, 0 },
+                                                              { K4A_RECORD_COMPRESSION_LOSSLESS, 0 },
+                                                              { K4A_RECORD_COMPRESSION_LOSSLESS, 2 },
+                                                              { K4A_RECORD_COMPRESSION_LOSSLESS, 4 } };
+    const char *output_file_name = "playback_perf_compression.mkv";
+    for (auto mode : modes)
+    {
+        k4a_record_t recording = NULL;
+        ASSERT_EQ(k4a_record_create(output_file_name, NULL, device_config, &recording), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_set_depth_compression(recording, mode.first, mode.second), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_write_header(recording), K4A_RESULT_SUCCEEDED);
+
+        std::string name = mode.first == K4A_RECORD_COMPRESSION_NONE ?
+                               std::string("uncompressed") :
+                               "lossless, " + std::to_string(mode.second) + " compression threads";
+        auto start = std::chrono::high_resolution_clock::now();
+        double write_seconds = 0;
+        {
+            Timer t("Record " + std::to_string(captures.size()) + " captures, " + name);
+            for (k4a_capture_t capture : captures)
+            {
+                ASSERT_EQ(k4a_record_write_capture(recording, capture), K4A_RESULT_SUCCEEDED);
+            }
+            write_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+                                std::chrono::high_resolution_clock::now() - start)
+                                .count();
+            k4a_record_close(recording);
+        }
+        double total_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+                                   std::chrono::high_resolution_clock::now() - start)
+                                   .count();
+
+        std::ifstream output_file(output_file_name, std::ios::binary | std::ios::ate);
+        std::cout << "    File size: " << (double)output_file.tellg() / 1000000.0 << " MB" << std::endl;
+        output_file.close();
+        std::cout << "    Write capture: " << ((double)captures.size() / write_seconds) << " captures/sec"
+                  << std::endl;
+        std::cout << "    Including close: " << ((double)captures.size() / total_seconds) << " captures/sec"
+                  << std::endl;
+        ASSERT_EQ(std::remove(output_file_name), 0);
+    }
+
+    for (k4a_capture_t capture : captures)
+    {
+        k4a_capture_release(capture);
+    }
+}
+
 int main(int argc, char **argv)
 {
     k4a_unittest_init();
@@ -4,15 +4,23 @@
 #include <utcommon.h>
 #include <k4a/k4a.h>
 #include <k4ainternal/common.h>
-#include <k4ainternal/matroska_common.h>
+#include <k4ainternal/matroska_read.h>
+#include <k4ainternal/matroska_write.h>
 
 #include "test_helpers.h"
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <string>
 #include <thread>
 #include <chrono>
+#include <utility>
+#include <vector>
 
 // Module being tested
 #include <k4arecord/playback.h>
+#include <k4arecord/record.h>
 
 using namespace testing;
 
@@ -151,6 +159,118 @@ TEST_F(playback_ut, open_large_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, open_compressed_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_compressed.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.depth_track_enabled);
+    ASSERT_TRUE(config.ir_track_enabled);
+    ASSERT_EQ(config.depth_mode, K4A_DEPTH_MODE_NFOV_UNBINNED);
+
+    // Compressed depth and IR frames are decoded to the original images.
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = K4A_STREAM_RESULT_FAILED;
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+    for (int i = 0; i < 100; i++)
+    {
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    // Seeking works the same as for uncompressed tracks.
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, (int64_t)(timestamp_delta * 50 - 250), K4A_PLAYBACK_SEEK_BEGIN),
+              K4A_RESULT_SUCCEEDED);
+    timestamps[0] = timestamp_delta * 50;
+    timestamps[1] = timestamps[0] + 1000;
+    timestamps[2] = timestamps[0] + 1000;
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, record_copy_and_zero_copy)
+{
+    k4a_device_configuration_t record_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    record_config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(record_config.camera_fps);
+    const char *file_names[] = { "record_test_copy.mkv", "record_test_zero_copy.mkv" };
+
+    for (int zero_copy = 0; zero_copy < 2; zero_copy++)
+    {
+        k4a_record_t recording = NULL;
+        ASSERT_EQ(k4a_record_create(file_names[zero_copy], NULL, record_config, &recording), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_set_zero_copy(recording, zero_copy != 0), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_write_header(recording), K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        for (int i = 0; i < 20; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config.color_format,
+                                                        record_config.color_resolution,
+                                                        record_config.depth_mode);
+            ASSERT_EQ(k4a_record_write_capture(recording, capture), K4A_RESULT_SUCCEEDED);
+            if (!zero_copy)
+            {
+                // Written images are copied by default, so they can be reused right away.
+                k4a_image_t images[] = { k4a_capture_get_depth_image(capture), k4a_capture_get_ir_image(capture) };
+                for (k4a_image_t image : images)
+                {
+                    memset(k4a_image_get_buffer(image), 0xAB, k4a_image_get_size(image));
+                    k4a_image_release(image);
+                }
+            }
+            k4a_capture_release(capture);
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+        k4a_record_close(recording);
+
+        k4a_playback_t handle = NULL;
+        ASSERT_EQ(k4a_playback_open(file_names[zero_copy], &handle), K4A_RESULT_SUCCEEDED);
+        timestamps[1] = 1000;
+        timestamps[2] = 1000;
+        for (int i = 0; i < 20; i++)
+        {
+            k4a_capture_t capture = NULL;
+            ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              record_config.color_format,
+                                              record_config.color_resolution,
+                                              record_config.depth_mode))
+                << "Capture " << i << (zero_copy ? " with zero-copy writes" : "");
+            k4a_capture_release(capture);
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+        k4a_playback_close(handle);
+        ASSERT_EQ(std::remove(file_names[zero_copy]), 0);
+    }
+}
+
 TEST_F(playback_ut, open_delay_offset_file)
 {
     k4a_playback_t handle = NULL;
@@ -514,6 +634,189 @@ TEST_F(playback_ut, playback_seek_test)
     k4a_playback_close(handle);
 }
 
+// Seeks to just before a capture of a recording written like record_test_full.mkv and checks that it is the next
+// capture returned.
+static void seek_and_validate_capture(k4a_playback_t handle, const k4a_record_configuration_t &config, int frame)
+{
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+    uint64_t timestamps[3] = { timestamp_delta * (uint64_t)frame,
+                               timestamp_delta * (uint64_t)frame + 1000,
+                               timestamp_delta * (uint64_t)frame + 1000 };
+    int64_t seek_usec = frame == 0 ? 0 : (int64_t)(timestamp_delta * (uint64_t)frame) - 250;
+    k4a_result_t result = k4a_playback_seek_timestamp(handle, seek_usec, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED) << "frame " << frame;
+
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED) << "frame " << frame;
+    bool valid = validate_test_capture(capture,
+                                       timestamps,
+                                       config.color_format,
+                                       config.color_resolution,
+                                       config.depth_mode);
+    k4a_capture_release(capture);
+    ASSERT_TRUE(valid) << "frame " << frame;
+}
+
+TEST_F(playback_ut, playback_seek_scrub)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Scrub backwards through every capture, then jump around the recording, seeking just before each capture.
+    std::vector<int> frames;
+    for (int i = 99; i >= 0; i--)
+    {
+        frames.push_back(i);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        frames.push_back((i * 37) % 100);
+    }
+
+    for (int frame : frames)
+    {
+        ASSERT_NO_FATAL_FAILURE(seek_and_validate_capture(handle, config, frame));
+    }
+
+    k4a_playback_close(handle);
+}
+
+static std::vector<char> read_file(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool file_exists(const char *path)
+{
+    std::ifstream file(path);
+    return file.good();
+}
+
+static k4arecord::k4a_playback_context_t *get_playback_context(k4a_playback_t handle)
+{
+    return &((k4arecord::k4a_playback_t_wrapper__cpp *)handle)->context;
+}
+
+// Opens a recording of frame_count captures three times with a seek index. The first open finds no index, scans the
+// recording and writes one. The second loads that index without scanning. The third finds a corrupt index, scans
+// again and writes the same index as the first.
+static void validate_seek_index(const char *path, const char *index_path, int frame_count)
+{
+    std::string temp_path = std::string(index_path) + ".tmp";
+    std::remove(index_path);
+
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open(path, &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t last_timestamp = k4a_playback_get_last_timestamp_usec(handle);
+    k4a_playback_close(handle);
+
+    std::vector<char> index_data;
+    for (int pass = 0; pass < 3; pass++)
+    {
+        if (pass == 2)
+        {
+            std::ofstream corrupt_index(index_path, std::ios::binary | std::ios::trunc);
+            corrupt_index << "not a seek index";
+        }
+
+        result = k4a_playback_open_with_seek_index(path, index_path, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(pass == 1, get_playback_context(handle)->seek_index_loaded) << "pass " << pass;
+
+        if (pass == 0)
+        {
+            index_data = read_file(index_path);
+            ASSERT_GT(index_data.size(), 32u);
+        }
+        else
+        {
+            ASSERT_EQ(read_file(index_path), index_data) << "pass " << pass;
+        }
+        ASSERT_FALSE(file_exists(temp_path.c_str()));
+
+        k4a_record_configuration_t config;
+        result = k4a_playback_get_record_configuration(handle, &config);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        for (int frame : { 0, frame_count - 1, frame_count / 2, 1 })
+        {
+            ASSERT_NO_FATAL_FAILURE(seek_and_validate_capture(handle, config, frame));
+        }
+        ASSERT_EQ(k4a_playback_get_last_timestamp_usec(handle), last_timestamp);
+
+        k4a_playback_close(handle);
+    }
+
+    std::remove(index_path);
+}
+
+TEST_F(playback_ut, open_with_seek_index)
+{
+    ASSERT_NO_FATAL_FAILURE(validate_seek_index("record_test_full.mkv", "record_test_full.k4aidx", 100));
+}
+
+TEST_F(playback_ut, open_with_seek_index_no_cues)
+{
+    k4a_device_configuration_t record_config = {};
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    record_config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    record_config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    { // Write a recording like record_test_full.mkv without the IMU track or any Cue entries
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_no_cues.mkv", NULL, record_config, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        { // A Cue entry is only added once CUE_ENTRY_GAP_NS has passed since the last one.
+            k4arecord::k4a_record_context_t *context = &((k4arecord::k4a_record_t_wrapper__cpp *)handle)->context;
+            context->last_cues_entry_ns = UINT64_MAX / 2;
+        }
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        uint32_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(record_config.camera_fps);
+        for (int i = 0; i < 60; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config.color_format,
+                                                        record_config.color_resolution,
+                                                        record_config.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            k4a_capture_release(capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        k4a_record_close(handle);
+    }
+
+    { // Without the seek index every cluster after the first is found by reading cluster headers
+        k4a_playback_t handle = NULL;
+        k4a_result_t result = k4a_playback_open("record_test_no_cues.mkv", &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        k4arecord::k4a_playback_context_t *context = get_playback_context(handle);
+        ASSERT_TRUE(context->cues == nullptr || context->cues->ListSize() == 0);
+        k4a_playback_close(handle);
+    }
+
+    ASSERT_NO_FATAL_FAILURE(validate_seek_index("record_test_no_cues.mkv", "record_test_no_cues.k4aidx", 60));
+
+    ASSERT_EQ(std::remove("record_test_no_cues.mkv"), 0);
+}
+
 TEST_F(playback_ut, open_skipped_frames_file)
 {
     k4a_playback_t handle = NULL;
@@ -781,6 +1084,525 @@ TEST_F(playback_ut, open_imu_playback_file)
     k4a_playback_close(handle);
 }
 
+// Waits up to 5 seconds for the read-ahead thread to have loaded at least count clusters in total.
+static bool wait_for_background_loads(k4a_playback_t handle, uint64_t count)
+{
+    k4a_playback_read_ahead_stats_t stats = {};
+    for (int i = 0; i < 500; i++)
+    {
+        if (k4a_playback_get_read_ahead_stats(handle, &stats) != K4A_RESULT_SUCCEEDED)
+        {
+            return false;
+        }
+        if (stats.background_loads >= count)
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+TEST_F(playback_ut, playback_read_ahead)
+{
+    k4a_playback_t handle = NULL;
+    k4a_playback_read_ahead_stats_t stats = {};
+    ASSERT_EQ(k4a_playback_set_read_ahead(NULL, 2, 0), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_get_read_ahead_stats(NULL, &stats), K4A_RESULT_FAILED);
+
+    // Read the whole recording forward and back with read-ahead disabled, a deep read-ahead, and a byte limit that
+    // keeps all but the nearest cluster out of the background. Clusters are at most 32ms long, so the recording has
+    // far more clusters than any of these depths.
+    std::pair<uint32_t, uint64_t> read_ahead_settings[] = { { 0, 0 }, { 8, 0 }, { 8, 1 } };
+    for (auto &setting : read_ahead_settings)
+    {
+        k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_get_read_ahead_stats(handle, NULL), K4A_RESULT_FAILED);
+        ASSERT_EQ(k4a_playback_set_read_ahead(handle, 65, 0), K4A_RESULT_FAILED);
+
+        // Opening loads the first cluster with the default read-ahead, let that settle before changing it
+        ASSERT_TRUE(wait_for_background_loads(handle, CLUSTER_READ_AHEAD_COUNT));
+        ASSERT_EQ(k4a_playback_get_read_ahead_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(stats.background_cluster_count, (uint32_t)CLUSTER_READ_AHEAD_COUNT);
+        uint64_t open_loads = stats.background_loads;
+
+        ASSERT_EQ(k4a_playback_set_read_ahead(handle, setting.first, setting.second), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+
+        k4a_record_configuration_t config;
+        result = k4a_playback_get_record_configuration(handle, &config);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t stream_result = K4A_STREAM_RESULT_FAILED;
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+
+        // The depth and byte limits decide how many clusters the background thread loads ahead of the first one. The
+        // two nearest clusters may still be held from opening, every cluster beyond them is a new load. Reading the
+        // first capture may already have moved playback one cluster on.
+        ASSERT_EQ(k4a_playback_get_read_ahead_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+        uint32_t expected_background_count = setting.first == 0 ? 0 : (setting.second == 0 ? setting.first : 1);
+        ASSERT_EQ(stats.background_cluster_count, expected_background_count);
+        if (expected_background_count > CLUSTER_READ_AHEAD_COUNT)
+        {
+            ASSERT_TRUE(
+                wait_for_background_loads(handle,
+                                          open_loads + expected_background_count - CLUSTER_READ_AHEAD_COUNT));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ASSERT_EQ(k4a_playback_get_read_ahead_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+        ASSERT_LE(stats.background_loads, open_loads + expected_background_count + 1);
+
+        int i = 1;
+        for (; i < 100; i++)
+        {
+            stream_result = k4a_playback_get_next_capture(handle, &capture);
+            ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+        for (; i > 0; i--)
+        {
+            timestamps[0] -= timestamp_delta;
+            timestamps[1] -= timestamp_delta;
+            timestamps[2] -= timestamp_delta;
+            stream_result = k4a_playback_get_previous_capture(handle, &capture);
+            ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+        }
+        stream_result = k4a_playback_get_previous_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+        ASSERT_EQ(k4a_playback_get_read_ahead_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(stats.background_cluster_count, expected_background_count);
+        if (setting.first == 0)
+        {
+            // Nothing is read ahead, every cluster is loaded by the playback thread
+            ASSERT_EQ(stats.background_loads, open_loads);
+            ASSERT_EQ(stats.cluster_hits, 0u);
+            ASSERT_EQ(stats.cluster_stalls, 0u);
+        }
+        else
+        {
+            // The first cluster boundary was crossed after the background thread had loaded the clusters ahead
+            ASSERT_GT(stats.cluster_hits, 0u);
+            ASSERT_GT(stats.background_loads, open_loads + expected_background_count);
+        }
+
+        k4a_playback_close(handle);
+    }
+}
+
+TEST_F(playback_ut, playback_image_buffer_reuse)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Image buffers are returned to the playback handle when the capture is released and reused for the next capture.
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_image_t depth_image = k4a_capture_get_depth_image(capture);
+    ASSERT_NE(depth_image, nullptr);
+    uint8_t *depth_buffer = k4a_image_get_buffer(depth_image);
+    k4a_image_release(depth_image);
+    k4a_capture_release(capture);
+
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    depth_image = k4a_capture_get_depth_image(capture);
+    ASSERT_NE(depth_image, nullptr);
+    ASSERT_EQ(k4a_image_get_buffer(depth_image), depth_buffer);
+    k4a_image_release(depth_image);
+
+    // Images remain valid after the playback handle is closed.
+    k4a_playback_close(handle);
+    uint64_t timestamps[3] = { 1000000 / k4a_convert_fps_to_uint(config.camera_fps), 0, 0 };
+    timestamps[1] = timestamps[0] + 1000;
+    timestamps[2] = timestamps[0] + 1000;
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+}
+
+TEST_F(playback_ut, playback_cluster_cache)
+{
+    k4a_playback_t handle = NULL;
+    k4a_playback_cache_stats_t stats;
+    ASSERT_EQ(k4a_playback_set_cluster_cache(NULL, 1ull << 30, true), K4A_RESULT_FAILED);
+
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_cluster_cache_stats(handle, NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_cluster_cache(handle, 1ull << 30, true), K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+
+    // The first pass loads every cluster, the second pass over the same section runs from the cache.
+    uint64_t first_pass_misses = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        for (uint64_t frame = 0; frame < 60; frame++)
+        {
+            uint64_t timestamps[3] = { timestamp_delta * frame,
+                                       timestamp_delta * frame + 1000,
+                                       timestamp_delta * frame + 1000 };
+            k4a_capture_t capture = NULL;
+            ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+        }
+
+        ASSERT_EQ(k4a_playback_get_cluster_cache_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(stats.evictions, 0u);
+        ASSERT_GT(stats.cached_clusters, 0u);
+        ASSERT_GT(stats.cached_bytes, 0u);
+        if (pass == 0)
+        {
+            first_pass_misses = stats.cluster_misses;
+            ASSERT_GT(first_pass_misses, 0u);
+            ASSERT_EQ(stats.color_image_hits, 0u);
+        }
+        else
+        {
+            ASSERT_EQ(stats.cluster_misses, first_pass_misses);
+            ASSERT_GT(stats.cluster_hits, 0u);
+            ASSERT_EQ(stats.color_image_hits, 60u);
+        }
+    }
+
+    // A budget smaller than a cluster evicts everything.
+    ASSERT_EQ(k4a_playback_set_cluster_cache(handle, 1, false), K4A_RESULT_SUCCEEDED);
+    result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_capture_release(capture);
+
+    ASSERT_EQ(k4a_playback_get_cluster_cache_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_GT(stats.evictions, 0u);
+    ASSERT_EQ(stats.cached_clusters, 0u);
+    ASSERT_EQ(stats.cached_bytes, 0u);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_memory_mapped_io)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_set_memory_mapped_io(NULL, true), K4A_RESULT_FAILED);
+
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_memory_mapped_io(handle, true), K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+
+    // Switching between file streams and the mapping keeps the playback position.
+    k4a_capture_t capture = NULL;
+    for (uint64_t frame = 0; frame < 10; frame++)
+    {
+        if (frame == 4 || frame == 7)
+        {
+            ASSERT_EQ(k4a_playback_set_memory_mapped_io(handle, frame == 7), K4A_RESULT_SUCCEEDED);
+        }
+
+        uint64_t timestamps[3] = { timestamp_delta * frame,
+                                   timestamp_delta * frame + 1000,
+                                   timestamp_delta * frame + 1000 };
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        if (frame < 9)
+        {
+            k4a_capture_release(capture);
+        }
+    }
+
+    // Images that point into the mapping remain valid after the playback handle is closed.
+    k4a_playback_close(handle);
+    uint64_t timestamps[3] = { timestamp_delta * 9, timestamp_delta * 9 + 1000, timestamp_delta * 9 + 1000 };
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+}
+
+TEST_F(playback_ut, playback_color_decode_threads)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(NULL, 2, 4), K4A_RESULT_FAILED);
+
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 4, 2), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 33, 64), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 2, 65), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 2, 4), K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = K4A_STREAM_RESULT_FAILED;
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(config.camera_fps);
+    int i = 0;
+    for (; i < 50; i++)
+    {
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    // Changing direction discards the images decoded ahead.
+    timestamps[0] -= timestamp_delta;
+    timestamps[1] -= timestamp_delta;
+    timestamps[2] -= timestamp_delta;
+    for (; i > 40; i--)
+    {
+        timestamps[0] -= timestamp_delta;
+        timestamps[1] -= timestamp_delta;
+        timestamps[2] -= timestamp_delta;
+        stream_result = k4a_playback_get_previous_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+
+    // Seeking discards the images decoded ahead, and the pipeline can be reconfigured while playing.
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, (int64_t)(timestamp_delta * 80 - 250), K4A_PLAYBACK_SEEK_BEGIN),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 3, 8), K4A_RESULT_SUCCEEDED);
+    timestamps[0] = 80 * timestamp_delta;
+    timestamps[1] = timestamps[0] + 1000;
+    timestamps[2] = timestamps[0] + 1000;
+    for (i = 80; i < 100; i++)
+    {
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    // Keep a capture that was decoded ahead across close.
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_capture_release(capture);
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+
+    timestamps[0] = timestamp_delta;
+    timestamps[1] = timestamps[0] + 1000;
+    timestamps[2] = timestamps[0] + 1000;
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+}
+
+// FNV-1a hash of an image buffer, so decoded frames can be compared without keeping them all in memory.
+static uint64_t hash_image(k4a_image_t image)
+{
+    const uint8_t *buffer = k4a_image_get_buffer(image);
+    size_t size = k4a_image_get_size(image);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ buffer[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+TEST_F(playback_ut, playback_color_decode_threads_conversion)
+{
+    // The sample recordings hold placeholder color data that cannot be decoded, so write a short recording with real
+    // YUY2 frames that differ from each other.
+    const char *file_name = "record_test_yuy2.mkv";
+    const int frame_count = 20;
+    k4a_device_configuration_t record_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_YUY2;
+    record_config.color_resolution = K4A_COLOR_RESOLUTION_720P;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+    uint64_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(record_config.camera_fps);
+    {
+        k4a_record_t recording = NULL;
+        ASSERT_EQ(k4a_record_create(file_name, NULL, record_config, &recording), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_write_header(recording), K4A_RESULT_SUCCEEDED);
+        for (int frame = 0; frame < frame_count; frame++)
+        {
+            k4a_capture_t capture = NULL;
+            k4a_image_t image = NULL;
+            ASSERT_EQ(k4a_capture_create(&capture), K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(k4a_image_create(K4A_IMAGE_FORMAT_COLOR_YUY2, 1280, 720, 1280 * 2, &image),
+                      K4A_RESULT_SUCCEEDED);
+            uint8_t *buffer = k4a_image_get_buffer(image);
+            for (size_t i = 0; i < k4a_image_get_size(image); i++)
+            {
+                buffer[i] = (uint8_t)(i * 7 + (i >> 11) * 3 + (size_t)frame * 29);
+            }
+            k4a_image_set_timestamp_usec(image, timestamp_delta * (uint64_t)frame);
+            k4a_capture_set_color_image(capture, image);
+            k4a_image_release(image);
+            ASSERT_EQ(k4a_record_write_capture(recording, capture), K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+        }
+        k4a_record_close(recording);
+    }
+
+    // Decode every frame to BGRA32 on the calling thread as the reference.
+    std::vector<uint64_t> reference(frame_count);
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(file_name, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32), K4A_RESULT_SUCCEEDED);
+    for (int frame = 0; frame < frame_count; frame++)
+    {
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_image_t image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(image, (k4a_image_t)NULL);
+        ASSERT_EQ(k4a_image_get_format(image), K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        ASSERT_EQ(k4a_image_get_size(image), (size_t)1280 * 720 * 4);
+        ASSERT_EQ(k4a_image_get_timestamp_usec(image), timestamp_delta * (uint64_t)frame);
+        reference[(size_t)frame] = hash_image(image);
+        if (frame > 0)
+        {
+            ASSERT_NE(reference[(size_t)frame], reference[(size_t)frame - 1]);
+        }
+        k4a_image_release(image);
+        k4a_capture_release(capture);
+    }
+    k4a_playback_close(handle);
+
+    // The decode threads must return the same images in playback order, reading forward, backward and after a seek.
+    ASSERT_EQ(k4a_playback_open(file_name, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_decode_threads(handle, 4, 8), K4A_RESULT_SUCCEEDED);
+    std::vector<int> frame_order;
+    for (int frame = 0; frame < frame_count; frame++)
+    {
+        frame_order.push_back(frame);
+    }
+    for (int frame = frame_count - 2; frame >= 5; frame--)
+    {
+        frame_order.push_back(-frame - 1);
+    }
+    for (size_t i = 0; i < frame_order.size(); i++)
+    {
+        bool next = frame_order[i] >= 0;
+        int frame = next ? frame_order[i] : -frame_order[i] - 1;
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(next ? k4a_playback_get_next_capture(handle, &capture) :
+                         k4a_playback_get_previous_capture(handle, &capture),
+                  K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_image_t image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(image, (k4a_image_t)NULL);
+        ASSERT_EQ(k4a_image_get_format(image), K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        ASSERT_EQ(k4a_image_get_timestamp_usec(image), timestamp_delta * (uint64_t)frame);
+        ASSERT_EQ(hash_image(image), reference[(size_t)frame]) << "Frame " << frame;
+        k4a_image_release(image);
+        k4a_capture_release(capture);
+    }
+
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, (int64_t)(timestamp_delta * 10), K4A_PLAYBACK_SEEK_BEGIN),
+              K4A_RESULT_SUCCEEDED);
+    for (int frame = 10; frame < frame_count; frame++)
+    {
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_image_t image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(image, (k4a_image_t)NULL);
+        ASSERT_EQ(k4a_image_get_timestamp_usec(image), timestamp_delta * (uint64_t)frame);
+        ASSERT_EQ(hash_image(image), reference[(size_t)frame]) << "Frame " << frame;
+        k4a_image_release(image);
+        k4a_capture_release(capture);
+    }
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+    k4a_playback_close(handle);
+
+    ASSERT_EQ(std::remove(file_name), 0);
+}
+
 int main(int argc, char **argv)
 {
     k4a_unittest_init();
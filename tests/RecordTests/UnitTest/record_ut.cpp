@@ -9,6 +9,8 @@
 #include <ebml/MemIOCallback.h>
 #include <matroska/KaxSegment.h>
 
+#include <algorithm>
+
 using namespace testing;
 using namespace k4arecord;
 
@@ -130,6 +132,91 @@ TEST_F(record_ut, new_cluster_out_of_order)
     ASSERT_EQ(context->pending_clusters->size(), 3u);
 }
 
+TEST_F(record_ut, lossless16_round_trip)
+{
+    // A depth-like frame with invalid pixels, a gradient, noise and a few large jumps, plus a short last row.
+    const uint32_t row_length = 64;
+    std::vector<uint16_t> samples(row_length * 48 + 17);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t x = i % row_length;
+        size_t y = i / row_length;
+        if (x < 8 || y < 4)
+        {
+            samples[i] = 0;
+        }
+        else if ((seed >> 16) % 97 == 0)
+        {
+            samples[i] = (uint16_t)(seed >> 8);
+        }
+        else
+        {
+            samples[i] = (uint16_t)(1000 + 4 * y + x + (seed >> 16) % 5);
+        }
+    }
+
+    std::vector<uint8_t> compressed(lossless16_max_compressed_size(samples.size()));
+    size_t compressed_size = lossless16_compress(samples.data(), samples.size(), row_length, compressed.data());
+    ASSERT_GT(compressed_size, 0u);
+    ASSERT_LT(compressed_size, samples.size() * sizeof(uint16_t));
+    ASSERT_EQ(lossless16_sample_count(compressed.data(), compressed_size), samples.size());
+
+    std::vector<uint16_t> decompressed(samples.size());
+    ASSERT_EQ(lossless16_decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size()),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(decompressed, samples);
+
+    // Truncated frames and frames with trailing data are rejected.
+    ASSERT_EQ(lossless16_decompress(compressed.data(), compressed_size - 1, decompressed.data(), decompressed.size()),
+              K4A_RESULT_FAILED);
+    compressed[compressed_size] = 0;
+    ASSERT_EQ(lossless16_decompress(compressed.data(), compressed_size + 1, decompressed.data(), decompressed.size()),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(lossless16_decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size() - 1),
+              K4A_RESULT_FAILED);
+
+    // Incompressible data stays within the worst case size.
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (uint16_t)((i & 1) ? 0xFFFF : 0);
+    }
+    compressed_size = lossless16_compress(samples.data(), samples.size(), row_length, compressed.data());
+    ASSERT_GT(compressed_size, 0u);
+    ASSERT_LE(compressed_size, compressed.size());
+    ASSERT_EQ(lossless16_decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size()),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(decompressed, samples);
+}
+
+TEST_F(record_ut, swap_bytes_16_copy)
+{
+    // Cover the vector loop, the scalar tail and unaligned buffers.
+    std::vector<uint8_t> source(2 * 77 + 1);
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        source[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    for (size_t count : { (size_t)0, (size_t)1, (size_t)15, (size_t)16, (size_t)33, (size_t)76 })
+    {
+        std::vector<uint8_t> swapped(source.size() + 1, 0xEE);
+        swap_bytes_16_copy(swapped.data() + 1, source.data() + 1, count);
+        for (size_t i = 0; i < count; i++)
+        {
+            ASSERT_EQ(swapped[1 + i * 2], source[1 + i * 2 + 1]);
+            ASSERT_EQ(swapped[1 + i * 2 + 1], source[1 + i * 2]);
+        }
+        ASSERT_EQ(swapped[0], 0xEE);
+        ASSERT_EQ(swapped[1 + count * 2], 0xEE);
+
+        // Swapping in place restores the original byte order.
+        swap_bytes_16_copy(swapped.data() + 1, swapped.data() + 1, count);
+        ASSERT_TRUE(std::equal(source.begin() + 1, source.begin() + 1 + (ptrdiff_t)(count * 2), swapped.begin() + 1));
+    }
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_commmon_main(argc, argv);
@@ -87,6 +87,48 @@ void SampleRecordings::SetUp()
 
         k4a_record_close(handle);
     }
+    { // Create a recording file with compressed depth and IR tracks
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_compressed.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        ASSERT_EQ(k4a_record_set_depth_compression(handle, K4A_RECORD_COMPRESSION_LOSSLESS, 17), K4A_RESULT_FAILED);
+        result = k4a_record_set_depth_compression(handle, K4A_RECORD_COMPRESSION_LOSSLESS, 2);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_set_depth_compression(handle, K4A_RECORD_COMPRESSION_NONE, 0), K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        uint32_t timestamp_delta = 1000000 / k4a_convert_fps_to_uint(record_config_full.camera_fps);
+        for (int i = 0; i < 100; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            // Flush partway through to write clusters while frames may still be compressing.
+            if (i == 50)
+            {
+                result = k4a_record_flush(handle);
+                ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            }
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
     { // Create a recording file with a depth delay offset
         k4a_record_t handle = NULL;
         k4a_result_t result = k4a_record_create("record_test_delay.mkv", NULL, record_config_delay, &handle);
@@ -216,6 +258,7 @@ void SampleRecordings::TearDown()
 {
     ASSERT_EQ(std::remove("record_test_empty.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_full.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_compressed.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_delay.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_skips.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_sub.mkv"), 0);
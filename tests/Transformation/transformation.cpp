@@ -10,8 +10,30 @@
 #include <k4ainternal/common.h>
 #include <k4ainternal/image.h>
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 using namespace testing;
 
+static void set_environment_variable(const char *name, const char *value)
+{
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    if (value[0] == '\0')
+    {
+        unsetenv(name);
+    }
+    else
+    {
+        setenv(name, value, 1);
+    }
+#endif
+}
+
 class transformation_ut : public ::testing::Test
 {
 protected:
@@ -50,6 +72,135 @@ protected:
         ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
     };
 
+    // Builds the depth camera xy tables the same way transformation_create() does
+    void build_depth_xy_tables(std::vector<float> &x_table, std::vector<float> &y_table)
+    {
+        int width = m_calibration.depth_camera_calibration.resolution_width;
+        int height = m_calibration.depth_camera_calibration.resolution_height;
+        x_table.resize((size_t)(width * height));
+        y_table.resize((size_t)(width * height));
+        for (int y = 0, idx = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++, idx++)
+            {
+                float point2d[2] = { (float)x, (float)y };
+                float point3d[3];
+                int valid = 0;
+                ASSERT_EQ(transformation_2d_to_3d(&m_calibration,
+                                                  point2d,
+                                                  1.f,
+                                                  K4A_CALIBRATION_TYPE_DEPTH,
+                                                  K4A_CALIBRATION_TYPE_DEPTH,
+                                                  point3d,
+                                                  &valid),
+                          K4A_RESULT_SUCCEEDED);
+                x_table[(size_t)idx] = valid ? point3d[0] : NAN;
+                y_table[(size_t)idx] = valid ? point3d[1] : 0.f;
+            }
+        }
+    }
+
+    // Depth image of a smooth surface with a depth discontinuity and holes, so occlusion handling and skipped quads are
+    // covered
+    std::vector<uint16_t> build_test_depth_image()
+    {
+        int width = m_calibration.depth_camera_calibration.resolution_width;
+        int height = m_calibration.depth_camera_calibration.resolution_height;
+        std::vector<uint16_t> depth((size_t)(width * height));
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                int value = 800 + (int)(400 * sinf(x * 0.03f) * cosf(y * 0.02f)) + (x > width / 2 ? 700 : 0);
+                depth[(size_t)(y * width + x)] = (uint16_t)((x * 7 + y * 13) % 50 == 0 ? 0 : value);
+            }
+        }
+        return depth;
+    }
+
+    // BGRA32 color image of noise with black patches, so that black pixels are mapped to (1, 0, 0, 0)
+    std::vector<uint8_t> build_test_color_image()
+    {
+        int width = m_calibration.color_camera_calibration.resolution_width;
+        int height = m_calibration.color_camera_calibration.resolution_height;
+        std::vector<uint8_t> color((size_t)(4 * width * height));
+        uint32_t seed = 1;
+        for (size_t i = 0; i < color.size(); i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            color[i] = (i / 4) % 997 < 64 ? 0 : (uint8_t)(seed >> 24);
+        }
+        return color;
+    }
+
+    // Maps a BGRA32 color image into the depth camera one pixel at a time, like color_image_to_depth_camera did before
+    // it was split into bands and kernels: each depth pixel goes through transformation_3d_to_3d() and
+    // transformation_3d_to_2d(), then every channel is interpolated bilinearly on its own.
+    void build_color_to_depth_reference(const std::vector<uint16_t> &depth,
+                                        const std::vector<uint8_t> &color,
+                                        std::vector<uint8_t> &reference)
+    {
+        int width = m_calibration.depth_camera_calibration.resolution_width;
+        int height = m_calibration.depth_camera_calibration.resolution_height;
+        int color_width = m_calibration.color_camera_calibration.resolution_width;
+        int color_height = m_calibration.color_camera_calibration.resolution_height;
+        size_t color_stride = (size_t)(4 * color_width);
+        std::vector<float> x_table, y_table;
+        ASSERT_NO_FATAL_FAILURE(build_depth_xy_tables(x_table, y_table));
+
+        reference.assign((size_t)(4 * width * height), 0);
+        for (size_t idx = 0; idx < (size_t)(width * height); idx++)
+        {
+            if (depth[idx] == 0 || std::isnan(x_table[idx]))
+            {
+                continue;
+            }
+
+            float z = (float)depth[idx];
+            float depth_point3d[3] = { x_table[idx] * z, y_table[idx] * z, z };
+            float color_point3d[3];
+            float point2d[2];
+            int valid = 0;
+            ASSERT_EQ(transformation_3d_to_3d(&m_calibration,
+                                              depth_point3d,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              K4A_CALIBRATION_TYPE_COLOR,
+                                              color_point3d),
+                      K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(transformation_3d_to_2d(&m_calibration,
+                                              color_point3d,
+                                              K4A_CALIBRATION_TYPE_COLOR,
+                                              K4A_CALIBRATION_TYPE_COLOR,
+                                              point2d,
+                                              &valid),
+                      K4A_RESULT_SUCCEEDED);
+
+            int x = (int)floorf(point2d[0]);
+            int y = (int)floorf(point2d[1]);
+            if (!valid || x < 0 || y < 0 || x + 1 >= color_width || y + 1 >= color_height)
+            {
+                continue;
+            }
+
+            float fraction_x = point2d[0] - (float)x;
+            float fraction_y = point2d[1] - (float)y;
+            uint8_t *pixel = &reference[4 * idx];
+            for (size_t channel = 0; channel < 4; channel++)
+            {
+                const uint8_t *top_left = &color[(size_t)y * color_stride + (size_t)(4 * x) + channel];
+                float top = (1.f - fraction_x) * top_left[0] + fraction_x * top_left[4];
+                float bottom = (1.f - fraction_x) * top_left[color_stride] + fraction_x * top_left[color_stride + 4];
+                pixel[channel] = (uint8_t)((1.f - fraction_y) * top + fraction_y * bottom + 0.5f);
+            }
+
+            // (0, 0, 0, 0) marks depth pixels without a color
+            if (pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0 && pixel[3] == 0)
+            {
+                pixel[0] = 1;
+            }
+        }
+    }
+
     k4a_calibration_t m_calibration;
     float m_depth_point2d_reference[2], m_depth_point3d_reference[3];
     float m_color_point2d_reference[2], m_color_point3d_reference[3];
@@ -364,6 +515,881 @@ TEST_F(transformation_ut, transformation_depth_image_to_point_cloud)
     transformation_destroy(transformation_handle);
 }
 
+TEST_F(transformation_ut, transformation_depth_image_to_point_cloud_instruction_sets)
+{
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    std::vector<float> x_table, y_table;
+    ASSERT_NO_FATAL_FAILURE(build_depth_xy_tables(x_table, y_table));
+    k4a_transformation_xy_tables_t xy_tables = { x_table.data(), y_table.data(), width, height };
+
+    // Cover the full uint16_t range so sign handling and 16 bit truncation are exercised too
+    std::vector<uint16_t> depth((size_t)(width * height));
+    uint32_t seed = 1;
+    for (size_t i = 0; i < depth.size(); i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        depth[i] = (uint16_t)(seed >> 16);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width, height, width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { width, height, width * 3 * (int)sizeof(int16_t) };
+
+    std::vector<int16_t> reference((size_t)(3 * width * height));
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_internal(&xy_tables,
+                                                                 K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR,
+                                                                 (const uint8_t *)depth.data(),
+                                                                 &depth_image_descriptor,
+                                                                 (uint8_t *)reference.data(),
+                                                                 &xyz_image_descriptor),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        std::vector<int16_t> xyz((size_t)(3 * width * height));
+        k4a_buffer_result_t result = transformation_depth_image_to_point_cloud_internal(&xy_tables,
+                                                                                        instruction_set,
+                                                                                        (const uint8_t *)depth.data(),
+                                                                                        &depth_image_descriptor,
+                                                                                        (uint8_t *)xyz.data(),
+                                                                                        &xyz_image_descriptor);
+        if (!transformation_instruction_set_supported(instruction_set))
+        {
+            ASSERT_EQ(result, K4A_BUFFER_RESULT_FAILED);
+            continue;
+        }
+
+        ASSERT_EQ(result, K4A_BUFFER_RESULT_SUCCEEDED);
+        ASSERT_EQ(memcmp(xyz.data(), reference.data(), xyz.size() * sizeof(int16_t)), 0)
+            << "Point cloud from " << transformation_instruction_set_name(instruction_set)
+            << " kernel does not match the scalar kernel";
+    }
+}
+
+TEST_F(transformation_ut, transformation_batch_instruction_sets)
+{
+    // Spread pixels beyond the image borders and include zero depths so invalid points are exercised too
+    const size_t point_count = 1001;
+    std::vector<float> points2d(2 * point_count);
+    std::vector<float> depths(point_count);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < point_count; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        points2d[2 * i] = (float)(seed >> 16) / 65536.f * 1280.f - 320.f;
+        seed = seed * 1664525u + 1013904223u;
+        points2d[2 * i + 1] = (float)(seed >> 16) / 65536.f * 1152.f - 288.f;
+        seed = seed * 1664525u + 1013904223u;
+        depths[i] = (i % 17 == 0) ? 0.f : 200.f + (float)(seed >> 16) / 65536.f * 5000.f;
+    }
+
+    for (int camera = 0; camera < 2; camera++)
+    {
+        k4a_calibration_type_t source_camera = camera == 0 ? K4A_CALIBRATION_TYPE_DEPTH : K4A_CALIBRATION_TYPE_COLOR;
+        k4a_calibration_type_t target_camera = camera == 0 ? K4A_CALIBRATION_TYPE_COLOR : K4A_CALIBRATION_TYPE_DEPTH;
+
+        // Reference results from the single point functions
+        std::vector<float> reference3d(3 * point_count), reference2d(2 * point_count);
+        std::vector<int> reference3d_valid(point_count), reference2d_valid(point_count);
+        for (size_t i = 0; i < point_count; i++)
+        {
+            ASSERT_EQ(transformation_2d_to_3d(&m_calibration,
+                                              &points2d[2 * i],
+                                              depths[i],
+                                              source_camera,
+                                              target_camera,
+                                              &reference3d[3 * i],
+                                              &reference3d_valid[i]),
+                      K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(transformation_2d_to_2d(&m_calibration,
+                                              &points2d[2 * i],
+                                              depths[i],
+                                              source_camera,
+                                              target_camera,
+                                              &reference2d[2 * i],
+                                              &reference2d_valid[i]),
+                      K4A_RESULT_SUCCEEDED);
+        }
+
+        for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+        {
+            k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+            std::vector<float> points3d(3 * point_count), target2d(2 * point_count);
+            std::vector<int> points3d_valid(point_count), target2d_valid(point_count);
+
+            k4a_result_t result = transformation_2d_to_3d_batch(&m_calibration,
+                                                                points2d.data(),
+                                                                depths.data(),
+                                                                source_camera,
+                                                                target_camera,
+                                                                points3d.data(),
+                                                                points3d_valid.data(),
+                                                                point_count,
+                                                                instruction_set);
+            if (!transformation_instruction_set_supported(instruction_set))
+            {
+                ASSERT_EQ(result, K4A_RESULT_FAILED);
+                continue;
+            }
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            ASSERT_EQ(transformation_2d_to_2d_batch(&m_calibration,
+                                                    points2d.data(),
+                                                    depths.data(),
+                                                    source_camera,
+                                                    target_camera,
+                                                    target2d.data(),
+                                                    target2d_valid.data(),
+                                                    point_count,
+                                                    instruction_set),
+                      K4A_RESULT_SUCCEEDED);
+
+            for (size_t j = 0; j < point_count; j++)
+            {
+                ASSERT_EQ(points3d_valid[j], reference3d_valid[j])
+                    << "Point " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                    << " kernel";
+                ASSERT_EQ(target2d_valid[j], reference2d_valid[j])
+                    << "Point " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                    << " kernel";
+                if (reference3d_valid[j])
+                {
+                    ASSERT_EQ(memcmp(&points3d[3 * j], &reference3d[3 * j], 3 * sizeof(float)), 0)
+                        << "Point " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                        << " kernel does not match transformation_2d_to_3d()";
+                }
+                if (reference2d_valid[j])
+                {
+                    ASSERT_EQ(memcmp(&target2d[2 * j], &reference2d[2 * j], 2 * sizeof(float)), 0)
+                        << "Point " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                        << " kernel does not match transformation_2d_to_2d()";
+                }
+            }
+        }
+    }
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_multithreaded)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    ASSERT_EQ(transformation_set_thread_count(transformation_handle, 0), K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_set_thread_count(transformation_handle, K4A_TRANSFORMATION_MAX_THREAD_COUNT + 1),
+              K4A_RESULT_FAILED);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth = build_test_depth_image();
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width *
+                                                                                     (int)sizeof(uint16_t) };
+
+    std::vector<uint16_t> reference((size_t)(color_width * color_height));
+    ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                         (const uint8_t *)depth.data(),
+                                                         &depth_image_descriptor,
+                                                         (uint8_t *)reference.data(),
+                                                         &transformed_depth_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // The worker threads persist across calls, so run every count twice and shrink the pool again at the end
+    const uint32_t thread_counts[] = { 2, 3, 8, K4A_TRANSFORMATION_MAX_THREAD_COUNT, 3, 1 };
+    for (uint32_t thread_count : thread_counts)
+    {
+        ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+
+        for (int run = 0; run < 2; run++)
+        {
+            std::vector<uint16_t> transformed_depth((size_t)(color_width * color_height));
+            ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                                 (const uint8_t *)depth.data(),
+                                                                 &depth_image_descriptor,
+                                                                 (uint8_t *)transformed_depth.data(),
+                                                                 &transformed_depth_image_descriptor),
+                      K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(memcmp(transformed_depth.data(), reference.data(), reference.size() * sizeof(uint16_t)), 0)
+                << "Output with " << thread_count << " threads does not match the single threaded output";
+        }
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_thread_count_resize)
+{
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth = build_test_depth_image();
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width *
+                                                                                     (int)sizeof(uint16_t) };
+    std::vector<uint16_t> transformed_depth((size_t)(color_width * color_height));
+
+    // Every job has to wake all parked workers, and every resize has to stop all workers above the new count, or a
+    // call or the resize never returns. Destroy the handle both with the pool grown and shrunk.
+    const uint32_t thread_counts[] = { 3, 8, 4, K4A_TRANSFORMATION_MAX_THREAD_COUNT, 3 };
+    for (int destroy_at = 0; destroy_at < 2; destroy_at++)
+    {
+        k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+        ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+        for (uint32_t thread_count : thread_counts)
+        {
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+            for (int run = 0; run < 4; run++)
+            {
+                ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                                     (const uint8_t *)depth.data(),
+                                                                     &depth_image_descriptor,
+                                                                     (uint8_t *)transformed_depth.data(),
+                                                                     &transformed_depth_image_descriptor),
+                          K4A_RESULT_SUCCEEDED);
+            }
+        }
+        if (destroy_at == 0)
+        {
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, 1), K4A_RESULT_SUCCEEDED);
+        }
+
+        transformation_destroy(transformation_handle);
+    }
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_fast_mode)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    ASSERT_EQ(transformation_set_mode(transformation_handle,
+                                      (k4a_transformation_mode_t)(K4A_TRANSFORMATION_MODE_CPU_FAST + 1)),
+              K4A_RESULT_FAILED);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth = build_test_depth_image();
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width *
+                                                                                     (int)sizeof(uint16_t) };
+
+    std::vector<uint16_t> reference((size_t)(color_width * color_height));
+    ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                         (const uint8_t *)depth.data(),
+                                                         &depth_image_descriptor,
+                                                         (uint8_t *)reference.data(),
+                                                         &transformed_depth_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    std::vector<uint16_t> transformed_depth((size_t)(color_width * color_height));
+    ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU_FAST), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                         (const uint8_t *)depth.data(),
+                                                         &depth_image_descriptor,
+                                                         (uint8_t *)transformed_depth.data(),
+                                                         &transformed_depth_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // The approximation may move triangle edges by a fraction of a pixel, so only a few pixels may change coverage,
+    // and covered pixels may differ by the rounding of the approximated depth
+    size_t covered = 0;
+    size_t coverage_mismatches = 0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        covered += reference[i] != 0;
+        if ((reference[i] == 0) != (transformed_depth[i] == 0))
+        {
+            coverage_mismatches++;
+        }
+        else
+        {
+            ASSERT_LE(abs((int)reference[i] - (int)transformed_depth[i]), 1) << "Pixel " << i;
+        }
+    }
+    ASSERT_GT(covered, (size_t)0);
+    ASSERT_LT(coverage_mismatches, covered / 100);
+
+    // Switching back to the exact mode restores the exact output
+    ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_color_camera(transformation_handle,
+                                                         (const uint8_t *)depth.data(),
+                                                         &depth_image_descriptor,
+                                                         (uint8_t *)transformed_depth.data(),
+                                                         &transformed_depth_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(memcmp(transformed_depth.data(), reference.data(), reference.size() * sizeof(uint16_t)), 0);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_fast_mode_accuracy)
+{
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    std::vector<float> x_table, y_table;
+    ASSERT_NO_FATAL_FAILURE(build_depth_xy_tables(x_table, y_table));
+    k4a_transformation_xy_tables_t xy_tables = { x_table.data(), y_table.data(), width, height };
+
+    k4a_transformation_correspondence_table_t correspondence_table;
+    ASSERT_EQ(transformation_allocate_correspondence_table(&m_calibration, &xy_tables, &correspondence_table),
+              K4A_RESULT_SUCCEEDED);
+
+    // The fast mode is documented to stay within 0.05 pixels of the exact projection from 200 mm to the end of the
+    // depth range. Evaluate the table like the depth to color transformation does and compare with the exact
+    // projection of every third depth pixel.
+    const uint16_t depths[] = { 200, 230, 300, 400, 550, 750, 1000, 1500, 2000, 3000, 4500, 6000, 9000, 20000, 65535 };
+    size_t compared = 0;
+    for (int idx = 0; idx < width * height; idx += 3)
+    {
+        const k4a_transformation_correspondence_coefficients_t *coefficients = &correspondence_table.coefficients[idx];
+        if (std::isnan(coefficients->depth_scale))
+        {
+            continue;
+        }
+
+        for (uint16_t depth : depths)
+        {
+            float u = correspondence_table.reference_depth / (float)depth;
+            if (u < coefficients->u_min || u > coefficients->u_max)
+            {
+                continue;
+            }
+
+            float point3d[3] = { x_table[(size_t)idx] * depth, y_table[(size_t)idx] * depth, (float)depth };
+            float exact[2];
+            int valid = 0;
+            ASSERT_EQ(transformation_3d_to_2d(&m_calibration,
+                                              point3d,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              K4A_CALIBRATION_TYPE_COLOR,
+                                              exact,
+                                              &valid),
+                      K4A_RESULT_SUCCEEDED);
+            if (!valid)
+            {
+                continue;
+            }
+
+            float x = coefficients->point2d[0][0] + u * (coefficients->point2d[1][0] + u * coefficients->point2d[2][0]);
+            float y = coefficients->point2d[0][1] + u * (coefficients->point2d[1][1] + u * coefficients->point2d[2][1]);
+            ASSERT_LE(std::hypot(x - exact[0], y - exact[1]), 0.05f)
+                << "Depth pixel " << idx << " at " << depth << " mm";
+            compared++;
+        }
+    }
+    free(correspondence_table.coefficients);
+
+    ASSERT_GT(compared, (size_t)(width * height / 3));
+}
+
+TEST_F(transformation_ut, transformation_fast_mode_requires_both_cameras)
+{
+    // The fast mode maps depth pixels into the color camera, so it cannot be selected without either camera
+    const k4a_calibration_t calibration = m_calibration;
+    k4a_calibration_t calibrations[2] = { calibration, calibration };
+    calibrations[0].color_resolution = K4A_COLOR_RESOLUTION_OFF;
+    calibrations[1].depth_mode = K4A_DEPTH_MODE_OFF;
+    for (const k4a_calibration_t &camera_disabled : calibrations)
+    {
+        k4a_transformation_t transformation_handle = transformation_create(&camera_disabled, false);
+        ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+        ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU_FAST), K4A_RESULT_FAILED);
+        ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU), K4A_RESULT_SUCCEEDED);
+        transformation_destroy(transformation_handle);
+    }
+}
+
+TEST_F(transformation_ut, transformation_color_image_to_depth_camera_instruction_sets)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    ASSERT_EQ(transformation_set_instruction_set(transformation_handle, K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT),
+              K4A_RESULT_FAILED);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth = build_test_depth_image();
+
+    std::vector<uint8_t> color = build_test_color_image();
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width,
+                                                                     color_height,
+                                                                     color_width * 4 * (int)sizeof(uint8_t) };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t) };
+
+    // Every kernel is compared with the per pixel path, not with another kernel
+    std::vector<uint8_t> reference;
+    ASSERT_NO_FATAL_FAILURE(build_color_to_depth_reference(depth, color, reference));
+
+    size_t covered = 0;
+    for (size_t i = 0; i < reference.size(); i += 4)
+    {
+        covered += reference[i] != 0 || reference[i + 1] != 0 || reference[i + 2] != 0 || reference[i + 3] != 0;
+    }
+    ASSERT_GT(covered, (size_t)(depth_width * depth_height / 8));
+
+    const uint32_t thread_counts[] = { 1, 3, 8 };
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        if (transformation_set_instruction_set(transformation_handle, instruction_set) != K4A_RESULT_SUCCEEDED)
+        {
+            ASSERT_FALSE(transformation_instruction_set_supported(instruction_set));
+            continue;
+        }
+
+        for (uint32_t thread_count : thread_counts)
+        {
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+
+            std::vector<uint8_t> transformed_color(reference.size());
+            ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                                 (const uint8_t *)depth.data(),
+                                                                 &depth_image_descriptor,
+                                                                 color.data(),
+                                                                 &color_image_descriptor,
+                                                                 transformed_color.data(),
+                                                                 &transformed_color_image_descriptor),
+                      K4A_RESULT_SUCCEEDED);
+            for (size_t j = 0; j < reference.size(); j++)
+            {
+                ASSERT_LE(abs((int)transformed_color[j] - (int)reference[j]), 1)
+                    << "Byte " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                    << " kernel with " << thread_count << " threads";
+            }
+        }
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_colored_point_cloud)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+    size_t pixel_count = (size_t)(depth_width * depth_height);
+
+    std::vector<uint16_t> depth = build_test_depth_image();
+
+    std::vector<uint8_t> color = build_test_color_image();
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width,
+                                                                     color_height,
+                                                                     color_width * 4 * (int)sizeof(uint8_t) };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t) };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { depth_width,
+                                                                   depth_height,
+                                                                   depth_width * 3 * (int)sizeof(int16_t) };
+
+    const k4a_colored_point_format_t point_formats[] = { K4A_COLORED_POINT_FORMAT_XYZ16_BGRA32,
+                                                         K4A_COLORED_POINT_FORMAT_XYZ16_RGB24,
+                                                         K4A_COLORED_POINT_FORMAT_XYZ16_PAD16_BGRA32 };
+    const uint32_t thread_counts[] = { 1, 3 };
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        if (transformation_set_instruction_set(transformation_handle, instruction_set) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        for (uint32_t thread_count : thread_counts)
+        {
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+
+            // The fused point cloud must match the two separate transformations with the same settings
+            std::vector<uint8_t> bgra(4 * pixel_count);
+            std::vector<int16_t> xyz(3 * pixel_count);
+            ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                                 (const uint8_t *)depth.data(),
+                                                                 &depth_image_descriptor,
+                                                                 color.data(),
+                                                                 &color_image_descriptor,
+                                                                 bgra.data(),
+                                                                 &transformed_color_image_descriptor),
+                      K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                                (const uint8_t *)depth.data(),
+                                                                &depth_image_descriptor,
+                                                                K4A_CALIBRATION_TYPE_DEPTH,
+                                                                (uint8_t *)xyz.data(),
+                                                                &xyz_image_descriptor),
+                      K4A_RESULT_SUCCEEDED);
+
+            for (k4a_colored_point_format_t point_format : point_formats)
+            {
+                size_t point_size = transformation_get_colored_point_size(point_format);
+                k4a_transformation_image_descriptor_t point_cloud_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * (int)point_size };
+
+                for (int skip_invalid_points = 0; skip_invalid_points < 2; skip_invalid_points++)
+                {
+                    std::vector<uint8_t> point_cloud(point_size * pixel_count);
+                    size_t point_count = 0;
+                    ASSERT_EQ(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                                (const uint8_t *)depth.data(),
+                                                                                &depth_image_descriptor,
+                                                                                color.data(),
+                                                                                &color_image_descriptor,
+                                                                                point_format,
+                                                                                skip_invalid_points != 0,
+                                                                                point_cloud.data(),
+                                                                                &point_cloud_descriptor,
+                                                                                &point_count),
+                              K4A_RESULT_SUCCEEDED);
+
+                    size_t expected_count = 0;
+                    for (size_t j = 0; j < pixel_count; j++)
+                    {
+                        const uint8_t *pixel_bgra = &bgra[4 * j];
+                        const int16_t *pixel_xyz = &xyz[3 * j];
+                        bool has_color = pixel_bgra[0] != 0 || pixel_bgra[1] != 0 || pixel_bgra[2] != 0 ||
+                                         pixel_bgra[3] != 0;
+                        if (skip_invalid_points && (pixel_xyz[2] == 0 || !has_color))
+                        {
+                            continue;
+                        }
+
+                        uint8_t expected[12] = { 0 };
+                        memcpy(expected, pixel_xyz, 3 * sizeof(int16_t));
+                        if (point_format == K4A_COLORED_POINT_FORMAT_XYZ16_RGB24)
+                        {
+                            expected[6] = pixel_bgra[2];
+                            expected[7] = pixel_bgra[1];
+                            expected[8] = pixel_bgra[0];
+                        }
+                        else
+                        {
+                            memcpy(&expected[point_size - 4], pixel_bgra, 4);
+                        }
+
+                        ASSERT_LT(expected_count, point_count);
+                        ASSERT_EQ(memcmp(&point_cloud[expected_count * point_size], expected, point_size), 0)
+                            << "Pixel " << j << " from the " << transformation_instruction_set_name(instruction_set)
+                            << " kernel with " << thread_count << " threads";
+                        expected_count++;
+                    }
+                    ASSERT_EQ(point_count, expected_count);
+                    if (skip_invalid_points)
+                    {
+                        ASSERT_GT(point_count, pixel_count / 8);
+                        ASSERT_LT(point_count, pixel_count);
+                    }
+                }
+            }
+        }
+    }
+
+    // The stride must match the point format
+    std::vector<uint8_t> point_cloud(12 * pixel_count);
+    k4a_transformation_image_descriptor_t point_cloud_descriptor = { depth_width, depth_height, depth_width * 12 };
+    ASSERT_EQ(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                (const uint8_t *)depth.data(),
+                                                                &depth_image_descriptor,
+                                                                color.data(),
+                                                                &color_image_descriptor,
+                                                                K4A_COLORED_POINT_FORMAT_XYZ16_BGRA32,
+                                                                false,
+                                                                point_cloud.data(),
+                                                                &point_cloud_descriptor,
+                                                                NULL),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_formatted_point_cloud)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    size_t pixel_count = (size_t)(width * height);
+
+    // Every 37th pixel has no depth
+    std::vector<uint16_t> depth(pixel_count);
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        depth[i] = (uint16_t)(i % 37 == 0 ? 0 : 500 + (i * 7919) % 3000);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width, height, width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t xyz16_descriptor = { width, height, width * 3 * (int)sizeof(int16_t) };
+    k4a_transformation_image_descriptor_t xyz32f_descriptor = { width, height, width * 3 * (int)sizeof(float) };
+    k4a_transformation_image_descriptor_t planar_descriptor = { width, 3 * height, width * (int)sizeof(float) };
+    k4a_transformation_image_descriptor_t pixel_index_descriptor = { width, height, width * (int)sizeof(uint32_t) };
+
+    std::vector<int16_t> xyz16(3 * pixel_count);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (const uint8_t *)depth.data(),
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        (uint8_t *)xyz16.data(),
+                                                        &xyz16_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // The scalar float point cloud rounds to the int16 point cloud
+    ASSERT_EQ(transformation_set_instruction_set(transformation_handle, K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR),
+              K4A_RESULT_SUCCEEDED);
+    std::vector<float> xyz32f(3 * pixel_count);
+    size_t point_count = 0;
+    ASSERT_EQ(transformation_depth_image_to_formatted_point_cloud(transformation_handle,
+                                                                  (const uint8_t *)depth.data(),
+                                                                  &depth_image_descriptor,
+                                                                  K4A_CALIBRATION_TYPE_DEPTH,
+                                                                  K4A_POINT_CLOUD_FORMAT_XYZ32F,
+                                                                  false,
+                                                                  (uint8_t *)xyz32f.data(),
+                                                                  &xyz32f_descriptor,
+                                                                  NULL,
+                                                                  NULL,
+                                                                  &point_count),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(point_count, pixel_count);
+
+    size_t valid_count = 0;
+    for (size_t i = 0; i < 3 * pixel_count; i++)
+    {
+        ASSERT_EQ((int16_t)floorf(xyz32f[i] + 0.5f), xyz16[i]) << "Value " << i;
+        valid_count += i % 3 == 2 && xyz32f[i] != 0.f;
+    }
+    ASSERT_GT(valid_count, pixel_count / 2);
+    ASSERT_LT(valid_count, pixel_count);
+
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        if (transformation_set_instruction_set(transformation_handle, instruction_set) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        for (int skip_invalid_points = 0; skip_invalid_points < 2; skip_invalid_points++)
+        {
+            std::vector<int16_t> points16(3 * pixel_count);
+            std::vector<float> points32f(3 * pixel_count);
+            std::vector<float> planar(3 * pixel_count);
+            std::vector<uint32_t> pixel_indices[3];
+            size_t point_counts[3] = { 0, 0, 0 };
+            uint8_t *outputs[3] = { (uint8_t *)points16.data(), (uint8_t *)points32f.data(), (uint8_t *)planar.data() };
+            k4a_transformation_image_descriptor_t *descriptors[3] = { &xyz16_descriptor,
+                                                                      &xyz32f_descriptor,
+                                                                      &planar_descriptor };
+            const k4a_point_cloud_format_t point_formats[3] = { K4A_POINT_CLOUD_FORMAT_XYZ16,
+                                                                K4A_POINT_CLOUD_FORMAT_XYZ32F,
+                                                                K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR };
+            for (int f = 0; f < 3; f++)
+            {
+                pixel_indices[f].resize(pixel_count);
+                ASSERT_EQ(transformation_depth_image_to_formatted_point_cloud(transformation_handle,
+                                                                              (const uint8_t *)depth.data(),
+                                                                              &depth_image_descriptor,
+                                                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                                                              point_formats[f],
+                                                                              skip_invalid_points != 0,
+                                                                              outputs[f],
+                                                                              descriptors[f],
+                                                                              (uint8_t *)pixel_indices[f].data(),
+                                                                              &pixel_index_descriptor,
+                                                                              &point_counts[f]),
+                          K4A_RESULT_SUCCEEDED);
+                ASSERT_EQ(point_counts[f], skip_invalid_points ? valid_count : pixel_count);
+            }
+
+            // Every format must hold the reference points of the pixels it lists, bit for bit
+            for (size_t j = 0; j < point_counts[0]; j++)
+            {
+                for (int f = 0; f < 3; f++)
+                {
+                    ASSERT_EQ(pixel_indices[f][j], skip_invalid_points ? pixel_indices[0][j] : (uint32_t)j);
+                }
+                size_t pixel = pixel_indices[0][j];
+                ASSERT_TRUE(skip_invalid_points == 0 || xyz32f[3 * pixel + 2] != 0.f);
+                ASSERT_EQ(memcmp(&points16[3 * j], &xyz16[3 * pixel], 3 * sizeof(int16_t)), 0)
+                    << "Pixel " << pixel << " from the " << transformation_instruction_set_name(instruction_set)
+                    << " kernel";
+                ASSERT_EQ(memcmp(&points32f[3 * j], &xyz32f[3 * pixel], 3 * sizeof(float)), 0)
+                    << "Pixel " << pixel << " from the " << transformation_instruction_set_name(instruction_set)
+                    << " kernel";
+                for (size_t c = 0; c < 3; c++)
+                {
+                    ASSERT_EQ(memcmp(&planar[c * pixel_count + j], &xyz32f[3 * pixel + c], sizeof(float)), 0)
+                        << "Pixel " << pixel << " from the " << transformation_instruction_set_name(instruction_set)
+                        << " kernel";
+                }
+            }
+        }
+    }
+
+    // The planar format stacks the three planes vertically and the pixel index image is optional
+    ASSERT_EQ(transformation_depth_image_to_formatted_point_cloud(transformation_handle,
+                                                                  (const uint8_t *)depth.data(),
+                                                                  &depth_image_descriptor,
+                                                                  K4A_CALIBRATION_TYPE_DEPTH,
+                                                                  K4A_POINT_CLOUD_FORMAT_XYZ32F_PLANAR,
+                                                                  true,
+                                                                  (uint8_t *)xyz32f.data(),
+                                                                  &xyz32f_descriptor,
+                                                                  NULL,
+                                                                  NULL,
+                                                                  NULL),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_depth_image_to_formatted_point_cloud(transformation_handle,
+                                                                  (const uint8_t *)depth.data(),
+                                                                  &depth_image_descriptor,
+                                                                  K4A_CALIBRATION_TYPE_DEPTH,
+                                                                  K4A_POINT_CLOUD_FORMAT_XYZ32F,
+                                                                  true,
+                                                                  (uint8_t *)xyz32f.data(),
+                                                                  &xyz32f_descriptor,
+                                                                  NULL,
+                                                                  &pixel_index_descriptor,
+                                                                  NULL),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+static void transformation_depth_camera_point_cloud(const k4a_calibration_t *calibration, std::vector<int16_t> &xyz)
+{
+    int width = calibration->depth_camera_calibration.resolution_width;
+    int height = calibration->depth_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth((size_t)(width * height));
+    for (size_t i = 0; i < depth.size(); i++)
+    {
+        depth[i] = (uint16_t)(500 + i % 3000);
+    }
+    xyz.resize((size_t)(3 * width * height));
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width, height, width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { width, height, width * 3 * (int)sizeof(int16_t) };
+
+    k4a_transformation_t transformation_handle = transformation_create(calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (const uint8_t *)depth.data(),
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        (uint8_t *)xyz.data(),
+                                                        &xyz_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_xy_tables_cache)
+{
+    char cache_file[64];
+    snprintf(cache_file,
+             sizeof(cache_file),
+             "./k4a_xy_tables_%016llx.bin",
+             (unsigned long long)transformation_get_xy_tables_cache_key(&m_calibration.depth_camera_calibration));
+    remove(cache_file);
+
+    std::vector<int16_t> reference;
+    transformation_depth_camera_point_cloud(&m_calibration, reference);
+
+    set_environment_variable("K4A_TRANSFORMATION_CACHE_PATH", ".");
+
+    // Tables are written on the first build and read back by later handles
+    std::vector<int16_t> xyz;
+    transformation_depth_camera_point_cloud(&m_calibration, xyz);
+    ASSERT_EQ(xyz, reference);
+
+    FILE *stream = fopen(cache_file, "rb");
+    ASSERT_NE(stream, (FILE *)NULL);
+    fclose(stream);
+
+    transformation_depth_camera_point_cloud(&m_calibration, xyz);
+    ASSERT_EQ(xyz, reference);
+
+    // Prove that later handles read the tables from the file instead of building them again: zero the x table under
+    // the valid header, so the cached tables put every point at x = 0 while rebuilt tables would not
+    int table_size = m_calibration.depth_camera_calibration.resolution_width *
+                     m_calibration.depth_camera_calibration.resolution_height;
+    stream = fopen(cache_file, "r+b");
+    ASSERT_NE(stream, (FILE *)NULL);
+    ASSERT_EQ(fseek(stream, 0, SEEK_END), 0);
+    long header_size = ftell(stream) - 2 * table_size * (long)sizeof(float);
+    ASSERT_GT(header_size, 0);
+    ASSERT_EQ(fseek(stream, header_size, SEEK_SET), 0);
+    std::vector<float> zero_x_table((size_t)table_size, 0.f);
+    ASSERT_EQ(fwrite(zero_x_table.data(), sizeof(float), zero_x_table.size(), stream), zero_x_table.size());
+    fclose(stream);
+
+    transformation_depth_camera_point_cloud(&m_calibration, xyz);
+    ASSERT_NE(xyz, reference);
+    for (size_t i = 0; i < xyz.size(); i += 3)
+    {
+        ASSERT_EQ(xyz[i], 0) << "Point " << i / 3 << " was not computed from the cached x table";
+    }
+
+    // A damaged cache file is ignored and replaced
+    stream = fopen(cache_file, "wb");
+    ASSERT_NE(stream, (FILE *)NULL);
+    fputs("not an xy tables cache", stream);
+    fclose(stream);
+
+    transformation_depth_camera_point_cloud(&m_calibration, xyz);
+    ASSERT_EQ(xyz, reference);
+    transformation_depth_camera_point_cloud(&m_calibration, xyz);
+    ASSERT_EQ(xyz, reference);
+
+    // A different calibration uses a different cache file
+    k4a_calibration_camera_t other_calibration = m_calibration.depth_camera_calibration;
+    other_calibration.intrinsics.parameters.param.cx += 1.f;
+    ASSERT_NE(transformation_get_xy_tables_cache_key(&other_calibration),
+              transformation_get_xy_tables_cache_key(&m_calibration.depth_camera_calibration));
+
+    set_environment_variable("K4A_TRANSFORMATION_CACHE_PATH", "");
+    ASSERT_EQ(remove(cache_file), 0);
+}
+
 TEST_F(transformation_ut, transformation_all_image_functions_with_failure_cases)
 {
     int depth_image_width_pixels = 640;
@@ -0,0 +1,272 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <ut_calibration_data.h>
+
+// Module being tested
+#include <k4a/k4a.h>
+#include <k4ainternal/transformation.h>
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+static const int g_iterations = 100;
+
+struct transformation_perf_parameters
+{
+    const char *test_name;
+    k4a_depth_mode_t depth_mode;
+
+    friend std::ostream &operator<<(std::ostream &os, const transformation_perf_parameters &obj)
+    {
+        return os << obj.test_name;
+    }
+};
+
+class transformation_perf : public ::testing::Test, public ::testing::WithParamInterface<transformation_perf_parameters>
+{
+};
+
+TEST_P(transformation_perf, depth_image_to_point_cloud)
+{
+    k4a_calibration_t calibration;
+    ASSERT_EQ(k4a_calibration_get_from_raw(g_test_json,
+                                           sizeof(g_test_json),
+                                           GetParam().depth_mode,
+                                           K4A_COLOR_RESOLUTION_720P,
+                                           &calibration),
+              K4A_RESULT_SUCCEEDED);
+
+    int width = calibration.depth_camera_calibration.resolution_width;
+    int height = calibration.depth_camera_calibration.resolution_height;
+    std::vector<float> x_table((size_t)(width * height));
+    std::vector<float> y_table((size_t)(width * height));
+    for (int y = 0, idx = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++, idx++)
+        {
+            float point2d[2] = { (float)x, (float)y };
+            float point3d[3];
+            int valid = 0;
+            ASSERT_EQ(transformation_2d_to_3d(&calibration,
+                                              point2d,
+                                              1.f,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              point3d,
+                                              &valid),
+                      K4A_RESULT_SUCCEEDED);
+            x_table[(size_t)idx] = valid ? point3d[0] : NAN;
+            y_table[(size_t)idx] = valid ? point3d[1] : 0.f;
+        }
+    }
+    k4a_transformation_xy_tables_t xy_tables = { x_table.data(), y_table.data(), width, height };
+
+    std::vector<uint16_t> depth((size_t)(width * height));
+    for (size_t i = 0; i < depth.size(); i++)
+    {
+        depth[i] = (uint16_t)(500 + i % 3000);
+    }
+    std::vector<int16_t> xyz((size_t)(3 * width * height));
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width, height, width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { width, height, width * 3 * (int)sizeof(int16_t) };
+
+    printf("%s (%dx%d), %d iterations\n", GetParam().test_name, width, height, g_iterations);
+
+    double scalar_ms = 0;
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        if (!transformation_instruction_set_supported(instruction_set))
+        {
+            printf("    %-8s not supported\n", transformation_instruction_set_name(instruction_set));
+            continue;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < g_iterations; iteration++)
+        {
+            ASSERT_EQ(transformation_depth_image_to_point_cloud_internal(&xy_tables,
+                                                                         instruction_set,
+                                                                         (const uint8_t *)depth.data(),
+                                                                         &depth_image_descriptor,
+                                                                         (uint8_t *)xyz.data(),
+                                                                         &xyz_image_descriptor),
+                      K4A_BUFFER_RESULT_SUCCEEDED);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / g_iterations;
+        if (instruction_set == K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR)
+        {
+            scalar_ms = ms;
+        }
+
+        printf("    %-8s %8.3f ms/frame %6.2fx%s\n",
+               transformation_instruction_set_name(instruction_set),
+               ms,
+               scalar_ms / ms,
+               instruction_set == transformation_get_best_instruction_set() ? " (selected)" : "");
+    }
+}
+
+static struct transformation_perf_parameters tests_depth_modes[] = {
+    { "NFOV_2X2BINNED", K4A_DEPTH_MODE_NFOV_2X2BINNED },
+    { "NFOV_UNBINNED", K4A_DEPTH_MODE_NFOV_UNBINNED },
+    { "WFOV_2X2BINNED", K4A_DEPTH_MODE_WFOV_2X2BINNED },
+    { "WFOV_UNBINNED", K4A_DEPTH_MODE_WFOV_UNBINNED },
+};
+
+INSTANTIATE_TEST_CASE_P(point_cloud, transformation_perf, ValuesIn(tests_depth_modes));
+
+struct color_to_depth_perf_parameters
+{
+    const char *test_name;
+    k4a_depth_mode_t depth_mode;
+    k4a_color_resolution_t color_resolution;
+
+    friend std::ostream &operator<<(std::ostream &os, const color_to_depth_perf_parameters &obj)
+    {
+        return os << obj.test_name;
+    }
+};
+
+class color_to_depth_perf : public ::testing::Test, public ::testing::WithParamInterface<color_to_depth_perf_parameters>
+{
+};
+
+TEST_P(color_to_depth_perf, color_image_to_depth_camera)
+{
+    k4a_calibration_t calibration;
+    ASSERT_EQ(k4a_calibration_get_from_raw(g_test_json,
+                                           sizeof(g_test_json),
+                                           GetParam().depth_mode,
+                                           GetParam().color_resolution,
+                                           &calibration),
+              K4A_RESULT_SUCCEEDED);
+
+    k4a_transformation_t transformation_handle = transformation_create(&calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+    ASSERT_EQ(transformation_set_mode(transformation_handle, K4A_TRANSFORMATION_MODE_CPU_FAST), K4A_RESULT_SUCCEEDED);
+
+    int depth_width = calibration.depth_camera_calibration.resolution_width;
+    int depth_height = calibration.depth_camera_calibration.resolution_height;
+    int color_width = calibration.color_camera_calibration.resolution_width;
+    int color_height = calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth((size_t)(depth_width * depth_height));
+    for (size_t i = 0; i < depth.size(); i++)
+    {
+        depth[i] = (uint16_t)(500 + i % 3000);
+    }
+    std::vector<uint8_t> color((size_t)(4 * color_width * color_height));
+    for (size_t i = 0; i < color.size(); i++)
+    {
+        color[i] = (uint8_t)(i * 7);
+    }
+    std::vector<uint8_t> transformed_color((size_t)(4 * depth_width * depth_height));
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t) };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width, color_height, color_width * 4 };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 };
+
+    uint32_t processor_count = std::thread::hardware_concurrency();
+    if (processor_count == 0 || processor_count > K4A_TRANSFORMATION_MAX_THREAD_COUNT)
+    {
+        processor_count = processor_count == 0 ? 1 : K4A_TRANSFORMATION_MAX_THREAD_COUNT;
+    }
+
+    printf("%s (%dx%d from %dx%d), %d iterations\n",
+           GetParam().test_name,
+           depth_width,
+           depth_height,
+           color_width,
+           color_height,
+           g_iterations);
+
+    double scalar_ms = 0;
+    for (int i = 0; i < K4A_TRANSFORMATION_INSTRUCTION_SET_COUNT; i++)
+    {
+        k4a_transformation_instruction_set_t instruction_set = (k4a_transformation_instruction_set_t)i;
+        if (transformation_set_instruction_set(transformation_handle, instruction_set) != K4A_RESULT_SUCCEEDED)
+        {
+            printf("    %-8s not supported\n", transformation_instruction_set_name(instruction_set));
+            continue;
+        }
+
+        for (uint32_t thread_count : { 1u, processor_count })
+        {
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int iteration = 0; iteration < g_iterations; iteration++)
+            {
+                ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                                     (const uint8_t *)depth.data(),
+                                                                     &depth_image_descriptor,
+                                                                     color.data(),
+                                                                     &color_image_descriptor,
+                                                                     transformed_color.data(),
+                                                                     &transformed_color_image_descriptor),
+                          K4A_RESULT_SUCCEEDED);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / g_iterations;
+            if (instruction_set == K4A_TRANSFORMATION_INSTRUCTION_SET_SCALAR && thread_count == 1)
+            {
+                scalar_ms = ms;
+            }
+
+            printf("    %-8s %2u threads %8.3f ms/frame %6.2fx\n",
+                   transformation_instruction_set_name(instruction_set),
+                   thread_count,
+                   ms,
+                   scalar_ms / ms);
+        }
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+static struct color_to_depth_perf_parameters tests_color_to_depth[] = {
+    { "NFOV_2X2BINNED_720P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_720P },
+    { "NFOV_2X2BINNED_1080P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1080P },
+    { "NFOV_2X2BINNED_1440P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1440P },
+    { "NFOV_2X2BINNED_1536P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1536P },
+    { "NFOV_2X2BINNED_2160P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_2160P },
+    { "NFOV_2X2BINNED_3072P", K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_3072P },
+    { "NFOV_UNBINNED_720P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_720P },
+    { "NFOV_UNBINNED_1080P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1080P },
+    { "NFOV_UNBINNED_1440P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1440P },
+    { "NFOV_UNBINNED_1536P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1536P },
+    { "NFOV_UNBINNED_2160P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_2160P },
+    { "NFOV_UNBINNED_3072P", K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_3072P },
+    { "WFOV_2X2BINNED_720P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_720P },
+    { "WFOV_2X2BINNED_1080P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1080P },
+    { "WFOV_2X2BINNED_1440P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1440P },
+    { "WFOV_2X2BINNED_1536P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1536P },
+    { "WFOV_2X2BINNED_2160P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_2160P },
+    { "WFOV_2X2BINNED_3072P", K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_3072P },
+    { "WFOV_UNBINNED_720P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_720P },
+    { "WFOV_UNBINNED_1080P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1080P },
+    { "WFOV_UNBINNED_1440P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1440P },
+    { "WFOV_UNBINNED_1536P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1536P },
+    { "WFOV_UNBINNED_2160P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_2160P },
+    { "WFOV_UNBINNED_3072P", K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_3072P },
+};
+
+INSTANTIATE_TEST_CASE_P(color_to_depth, color_to_depth_perf, ValuesIn(tests_color_to_depth));
+
+int main(int argc, char **argv)
+{
+    return k4a_test_commmon_main(argc, argv);
+}
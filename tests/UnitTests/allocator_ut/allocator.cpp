@@ -514,3 +514,131 @@ TEST(allocator_ut, allocator_threaded)
     ASSERT_EQ(allocator_test_for_leaks(), 0);
     Lock_Deinit(lock);
 }
+
+TEST(allocator_ut, allocator_pool)
+{
+    const size_t block_size = 1024;
+    void *context1 = NULL;
+    void *context2 = NULL;
+    uint8_t *buffer1;
+    uint8_t *buffer2;
+
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_reserve_pool(ALLOCATION_SOURCE_DEPTH, 0, 2));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_reserve_pool(ALLOCATION_SOURCE_DEPTH, block_size, 0));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_reserve_pool((allocation_source_t)99, block_size, 2));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_reserve_pool(ALLOCATION_SOURCE_DEPTH, block_size, 2));
+
+    // A freed block is handed out again
+    ASSERT_NE((uint8_t *)NULL, buffer1 = allocator_alloc(ALLOCATION_SOURCE_DEPTH, block_size, &context1));
+    allocator_free(buffer1, context1);
+    ASSERT_EQ(buffer1, buffer2 = allocator_alloc(ALLOCATION_SOURCE_DEPTH, block_size - 1, &context2));
+    allocator_free(buffer2, context2);
+    ASSERT_EQ(0, allocator_test_for_leaks());
+
+    // Sizes the pool does not serve, and other sources, fall back to the heap
+    ASSERT_NE((uint8_t *)NULL, buffer1 = allocator_alloc(ALLOCATION_SOURCE_DEPTH, block_size, &context1));
+    ASSERT_NE((uint8_t *)NULL, buffer2 = allocator_alloc(ALLOCATION_SOURCE_DEPTH, block_size + 1, &context2));
+    allocator_free(buffer2, context2);
+    ASSERT_NE((uint8_t *)NULL, buffer2 = allocator_alloc(ALLOCATION_SOURCE_DEPTH, block_size / 2, &context2));
+    ASSERT_NE(buffer1, buffer2);
+    allocator_free(buffer2, context2);
+    ASSERT_NE((uint8_t *)NULL, buffer2 = allocator_alloc(ALLOCATION_SOURCE_COLOR, block_size, &context2));
+    ASSERT_NE(buffer1, buffer2);
+    allocator_free(buffer2, context2);
+
+    // Blocks still in use when the pool is released are freed when they are returned
+    allocator_release_pool(ALLOCATION_SOURCE_DEPTH, block_size, 2);
+    allocator_free(buffer1, context1);
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
+
+TEST(allocator_ut, handle_reuse)
+{
+    k4a_capture_t capture1 = NULL;
+    k4a_capture_t capture2 = NULL;
+    k4a_image_t image1 = NULL;
+    k4a_image_t image2 = NULL;
+
+    // Destroyed handles are recycled, and come back in their initial state
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capture_create(&capture1));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create_empty_internal(ALLOCATION_SOURCE_IMU, 16, &image1));
+    image_set_timestamp_usec(image1, 1234);
+    capture_set_temperature_c(capture1, 30.0f);
+    capture_set_color_image(capture1, image1);
+    image_dec_ref(image1);
+    capture_dec_ref(capture1);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capture_create(&capture2));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create_empty_internal(ALLOCATION_SOURCE_IMU, 16, &image2));
+    ASSERT_EQ(0u, image_get_timestamp_usec(image2));
+    ASSERT_TRUE(isnan(capture_get_temperature_c(capture2)));
+    ASSERT_EQ((k4a_image_t)NULL, capture_get_color_image(capture2));
+
+    // A recycled handle gets a new value, so the stale handles do not reach the new objects
+    ASSERT_NE(capture1, capture2);
+    ASSERT_NE(image1, image2);
+    capture_set_temperature_c(capture2, 25.0f);
+    ASSERT_TRUE(isnan(capture_get_temperature_c(capture1)));
+    ASSERT_EQ((uint8_t *)NULL, image_get_buffer(image1));
+    ASSERT_NE((uint8_t *)NULL, image_get_buffer(image2));
+
+    // Replacing an image releases the previous one
+    capture_set_depth_image(capture2, image2);
+    capture_set_depth_image(capture2, NULL);
+    ASSERT_EQ((k4a_image_t)NULL, capture_get_depth_image(capture2));
+    image_dec_ref(image2);
+    capture_dec_ref(capture2);
+
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
+
+static volatile long g_custom_allocate_count = 0;
+static volatile long g_custom_free_count = 0;
+
+static uint8_t *custom_allocate(int size, void **context)
+{
+    g_custom_allocate_count++;
+    *context = (void *)&g_custom_allocate_count;
+    return (uint8_t *)malloc((size_t)size);
+}
+
+static void custom_free(void *buffer, void *context)
+{
+    EXPECT_EQ((void *)&g_custom_allocate_count, context);
+    g_custom_free_count++;
+    free(buffer);
+}
+
+TEST(allocator_ut, allocator_custom)
+{
+    void *context1 = NULL;
+    void *context2 = NULL;
+    uint8_t *buffer1;
+    uint8_t *buffer2;
+
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_set_allocator(custom_allocate, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_set_allocator(NULL, custom_free));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(custom_allocate, custom_free));
+    ASSERT_NE((uint8_t *)NULL, buffer1 = allocator_alloc(ALLOCATION_SOURCE_USER, 100, &context1));
+    ASSERT_EQ(1, g_custom_allocate_count);
+
+    // Pools take their blocks from the custom allocator too
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_reserve_pool(ALLOCATION_SOURCE_COLOR, 100, 3));
+    ASSERT_EQ(4, g_custom_allocate_count);
+
+    // Restoring the default allocator still releases outstanding memory with the custom free
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_NE((uint8_t *)NULL, buffer2 = allocator_alloc(ALLOCATION_SOURCE_USER, 100, &context2));
+    ASSERT_EQ(4, g_custom_allocate_count);
+    allocator_free(buffer2, context2);
+    ASSERT_EQ(0, g_custom_free_count);
+
+    allocator_free(buffer1, context1);
+    ASSERT_EQ(1, g_custom_free_count);
+    allocator_release_pool(ALLOCATION_SOURCE_COLOR, 100, 3);
+    ASSERT_EQ(4, g_custom_free_count);
+
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
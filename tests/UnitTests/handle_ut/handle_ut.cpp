@@ -3,6 +3,7 @@
 
 #include <utcommon.h>
 #include "handle_ut.h"
+#include <k4ainternal/handle_pool.h>
 
 K4A_DECLARE_HANDLE(foo_t);
 
@@ -43,6 +44,10 @@ K4A_DECLARE_CONTEXT(foo_t, context_t);
 K4A_DECLARE_HANDLE(bar_t);
 K4A_DECLARE_CONTEXT(bar_t, context2_t);
 
+// Declare a pooled handle type with room for two handles
+K4A_DECLARE_HANDLE(baz_t);
+K4A_DECLARE_POOLED_CONTEXT(baz_t, context_t, 2);
+
 TEST(handle_ut, create_free)
 {
     foo_t foo = NULL;
@@ -132,6 +137,50 @@ TEST(handle_ut, K4A_DECLARE_CONTEXT_in_shared_header)
     dual_defined_t_destroy(dual);
 }
 
+TEST(handle_ut, pooled_create_free)
+{
+    baz_t baz[3] = { NULL, NULL, NULL };
+    context_t *context[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        context[i] = baz_t_create(&baz[i]);
+        ASSERT_NE((context_t *)NULL, context[i]);
+        ASSERT_EQ(context[i], baz_t_get_context(baz[i]));
+        context[i]->my = i + 1;
+    }
+
+    // The first two come from the pool, the third from the heap
+    EXPECT_EQ(&baz_t_pool[0].context, context[0]);
+    EXPECT_EQ(&baz_t_pool[1].context, context[1]);
+    EXPECT_NE(&baz_t_pool[0].context, context[2]);
+    EXPECT_NE(&baz_t_pool[1].context, context[2]);
+
+    baz_t_destroy(baz[2]);
+    baz_t_destroy(baz[0]);
+    EXPECT_EQ(NULL, baz_t_get_context(baz[0]));
+
+    // A destroyed pooled handle is reused and comes back zero filled, but under a new handle value
+    baz_t reused = NULL;
+    context_t *reused_context = baz_t_create(&reused);
+    ASSERT_NE((context_t *)NULL, reused_context);
+    EXPECT_EQ(context[0], reused_context);
+    EXPECT_NE(baz[0], reused);
+    EXPECT_EQ(0, reused_context->my);
+
+    // The stale handle does not reach the reissued entry, and destroying it again leaves the entry alone
+    EXPECT_EQ(NULL, baz_t_get_context(baz[0]));
+    baz_t_destroy(baz[0]);
+    EXPECT_EQ(reused_context, baz_t_get_context(reused));
+
+    baz_t_destroy(reused);
+    baz_t_destroy(baz[1]);
+    EXPECT_EQ(NULL, baz_t_get_context(baz[1]));
+
+    // Values that are not handles of this pool are rejected
+    EXPECT_EQ(NULL, baz_t_get_context((baz_t)(uintptr_t)((K4A_HANDLE_POOL_MAX_COUNT - 1) * 2 + 1)));
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_commmon_main(argc, argv);
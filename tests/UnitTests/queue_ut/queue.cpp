@@ -873,3 +873,140 @@ TEST(queue_ut, queue_error)
     queue_destroy(queue);
     ASSERT_EQ(allocator_test_for_leaks(), 0);
 }
+
+#define BLOCKING_TEST_WRITERS 2
+#define BLOCKING_TEST_READERS 2
+#define BLOCKING_TEST_CAPTURES 20000
+
+typedef struct
+{
+    queue_t queue;
+    uint32_t id;
+    uint32_t received;
+    uint32_t error;
+    LOCK_HANDLE lock;
+} blocking_queue_data_t;
+
+static int thread_write_queue_no_wait(void *param)
+{
+    blocking_queue_data_t *data = (blocking_queue_data_t *)param;
+
+    // Sync start - its go time when we get this lock
+    Lock(data->lock);
+    Unlock(data->lock);
+
+    for (uint32_t i = 0; i < BLOCKING_TEST_CAPTURES; i++)
+    {
+        k4a_capture_t capture = capture_manufacture(2 * sizeof(uint32_t));
+        uint32_t value[2] = { data->id, i };
+        memcpy(get_raw_byte_ptr(capture, NULL), value, sizeof(value));
+
+        queue_push(data->queue, capture);
+        capture_dec_ref(capture);
+    }
+    return TEST_RETURN_VALUE;
+}
+
+static int thread_read_queue_blocking(void *param)
+{
+    blocking_queue_data_t *data = (blocking_queue_data_t *)param;
+    uint32_t next_expected[BLOCKING_TEST_WRITERS] = { 0 };
+
+    // Sync start - its go time when we get this lock
+    Lock(data->lock);
+    Unlock(data->lock);
+
+    for (;;)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_wait_result_t wresult = queue_pop(data->queue, K4A_WAIT_INFINITE, &capture);
+        if (wresult == K4A_WAIT_RESULT_FAILED)
+        {
+            // The queue was disabled
+            break;
+        }
+        if (wresult != K4A_WAIT_RESULT_SUCCEEDED || capture == NULL)
+        {
+            EXPECT_EQ(wresult, K4A_WAIT_RESULT_SUCCEEDED);
+            EXPECT_NE(capture, (k4a_capture_t)NULL);
+            data->error = 1;
+            break;
+        }
+
+        uint32_t value[2];
+        memcpy(value, get_raw_byte_ptr(capture, NULL), sizeof(value));
+        capture_dec_ref(capture);
+
+        // Captures may be dropped or go to the other reader, but each reader sees a writer's captures in order
+        if (value[0] >= BLOCKING_TEST_WRITERS || value[1] < next_expected[value[0]])
+        {
+            EXPECT_LT(value[0], (uint32_t)BLOCKING_TEST_WRITERS);
+            data->error = 1;
+            break;
+        }
+        next_expected[value[0]] = value[1] + 1;
+        data->received++;
+    }
+    return TEST_RETURN_VALUE;
+}
+
+TEST(queue_ut, queue_threaded_blocking_readers)
+{
+    queue_t queue;
+    LOCK_HANDLE lock;
+    blocking_queue_data_t writer[BLOCKING_TEST_WRITERS] = {};
+    blocking_queue_data_t reader[BLOCKING_TEST_READERS] = {};
+    THREAD_HANDLE writer_thread[BLOCKING_TEST_WRITERS];
+    THREAD_HANDLE reader_thread[BLOCKING_TEST_READERS];
+    int result;
+
+    ASSERT_EQ(queue_create(TEST_QUEUE_DEPTH, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    ASSERT_NE((lock = Lock_Init()), (LOCK_HANDLE)NULL);
+    queue_enable(queue);
+
+    // prevent the threads from running
+    Lock(lock);
+    for (uint32_t i = 0; i < BLOCKING_TEST_READERS; i++)
+    {
+        reader[i].queue = queue;
+        reader[i].lock = lock;
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&reader_thread[i], thread_read_queue_blocking, &reader[i]));
+    }
+    for (uint32_t i = 0; i < BLOCKING_TEST_WRITERS; i++)
+    {
+        writer[i].queue = queue;
+        writer[i].id = i;
+        writer[i].lock = lock;
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&writer_thread[i], thread_write_queue_no_wait, &writer[i]));
+    }
+
+    // start the test
+    Unlock(lock);
+
+    for (uint32_t i = 0; i < BLOCKING_TEST_WRITERS; i++)
+    {
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(writer_thread[i], &result));
+        ASSERT_EQ(result, TEST_RETURN_VALUE);
+    }
+
+    // Let the readers drain the queue and park, then release them
+    ThreadAPI_Sleep(100);
+    queue_disable(queue);
+
+    uint32_t received = 0;
+    for (uint32_t i = 0; i < BLOCKING_TEST_READERS; i++)
+    {
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(reader_thread[i], &result));
+        ASSERT_EQ(result, TEST_RETURN_VALUE);
+        ASSERT_EQ(reader[i].error, 0u);
+        received += reader[i].received;
+    }
+    ASSERT_GT(received, 0u);
+    ASSERT_LE(received, (uint32_t)(BLOCKING_TEST_WRITERS * BLOCKING_TEST_CAPTURES));
+
+    queue_destroy(queue);
+    Lock_Deinit(lock);
+
+    // Verify all our allocations were released
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
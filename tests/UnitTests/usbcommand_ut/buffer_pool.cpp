@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <gtest/gtest.h>
+
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/image.h>
+#include <../src/usbcommand/usb_cmd_priv.h> // include the private buffer pool definitions for testing
+
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_commmon_main(argc, argv);
+}
+
+#define TEST_BUFFER_SIZE 1024
+
+TEST(usbcommand_ut, buffer_pool_reuse)
+{
+    k4a_image_t image1 = NULL;
+    k4a_image_t image2 = NULL;
+
+    usb_cmd_buffer_pool_t *pool = usb_cmd_buffer_pool_create(ALLOCATION_SOURCE_USB_DEPTH, TEST_BUFFER_SIZE, 2);
+    ASSERT_NE((usb_cmd_buffer_pool_t *)NULL, pool);
+    ASSERT_EQ(2u, pool->buffer_count);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_buffer_pool_create_image(pool, &image1));
+    ASSERT_EQ((size_t)TEST_BUFFER_SIZE, image_get_size(image1));
+    uint8_t *buffer = image_get_buffer(image1);
+    ASSERT_EQ(pool->buffer[0], buffer);
+
+    // A released buffer is handed out again instead of a new allocation
+    image_dec_ref(image1);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_buffer_pool_create_image(pool, &image2));
+    ASSERT_EQ(buffer, image_get_buffer(image2));
+
+    // Images may outlive the stream's reference on the pool
+    usb_cmd_buffer_pool_release(pool);
+    memset(image_get_buffer(image2), 0xff, TEST_BUFFER_SIZE);
+    image_dec_ref(image2);
+
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
+
+TEST(usbcommand_ut, buffer_pool_exhaustion)
+{
+    k4a_image_t image[3] = { NULL };
+    k4a_image_t extra_image = NULL;
+
+    usb_cmd_buffer_pool_t *pool = usb_cmd_buffer_pool_create(ALLOCATION_SOURCE_USB_DEPTH, TEST_BUFFER_SIZE, 3);
+    ASSERT_NE((usb_cmd_buffer_pool_t *)NULL, pool);
+
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_buffer_pool_create_image(pool, &image[i]));
+        for (int j = 0; j < i; j++)
+        {
+            ASSERT_NE(image_get_buffer(image[j]), image_get_buffer(image[i]));
+        }
+    }
+
+    // Every buffer is lent out
+    ASSERT_EQ(K4A_RESULT_FAILED, usb_cmd_buffer_pool_create_image(pool, &extra_image));
+    ASSERT_EQ((k4a_image_t)NULL, extra_image);
+
+    // Returning one buffer makes exactly that buffer available again
+    uint8_t *buffer = image_get_buffer(image[1]);
+    image_dec_ref(image[1]);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_buffer_pool_create_image(pool, &image[1]));
+    ASSERT_EQ(buffer, image_get_buffer(image[1]));
+    ASSERT_EQ(K4A_RESULT_FAILED, usb_cmd_buffer_pool_create_image(pool, &extra_image));
+
+    for (int i = 0; i < 3; i++)
+    {
+        image_dec_ref(image[i]);
+    }
+    usb_cmd_buffer_pool_release(pool);
+
+    // The pool never holds more than USB_CMD_BUFFER_POOL_MAX_SIZE buffers
+    pool = usb_cmd_buffer_pool_create(ALLOCATION_SOURCE_USB_DEPTH, TEST_BUFFER_SIZE, USB_CMD_BUFFER_POOL_MAX_SIZE + 5);
+    ASSERT_NE((usb_cmd_buffer_pool_t *)NULL, pool);
+    ASSERT_EQ((uint32_t)USB_CMD_BUFFER_POOL_MAX_SIZE, pool->buffer_count);
+    usb_cmd_buffer_pool_release(pool);
+
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
+
+static int g_allocations_left = 0;
+
+static uint8_t *limited_allocate(int size, void **context)
+{
+    *context = NULL;
+    if (g_allocations_left == 0)
+    {
+        return NULL;
+    }
+    g_allocations_left--;
+    return (uint8_t *)malloc((size_t)size);
+}
+
+static void limited_free(void *buffer, void *context)
+{
+    (void)context;
+    free(buffer);
+}
+
+TEST(usbcommand_ut, buffer_pool_partial_allocation)
+{
+    k4a_image_t image[4] = { NULL };
+
+    // Only two of the five requested buffers can be allocated
+    g_allocations_left = 2;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(limited_allocate, limited_free));
+    usb_cmd_buffer_pool_t *pool = usb_cmd_buffer_pool_create(ALLOCATION_SOURCE_USB_DEPTH, TEST_BUFFER_SIZE, 5);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_NE((usb_cmd_buffer_pool_t *)NULL, pool);
+    ASSERT_EQ(2u, pool->buffer_count);
+
+    // Stream images come from the pool while it has free buffers and from a regular allocation after that
+    usbcmd_context_t usbcmd;
+    memset(&usbcmd, 0, sizeof(usbcmd));
+    usbcmd.source = ALLOCATION_SOURCE_USB_DEPTH;
+    usbcmd.stream_size = TEST_BUFFER_SIZE;
+    usbcmd.buffer_pool = pool;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_create_stream_image(&usbcmd, &image[i]));
+        ASSERT_EQ((size_t)TEST_BUFFER_SIZE, image_get_size(image[i]));
+    }
+    ASSERT_EQ(2u, usbcmd.buffer_pool_stats.hit_count);
+    ASSERT_EQ(2u, usbcmd.buffer_pool_stats.miss_count);
+    ASSERT_EQ(pool->buffer[0], image_get_buffer(image[0]));
+    ASSERT_EQ(pool->buffer[1], image_get_buffer(image[1]));
+    ASSERT_NE(pool->buffer[0], image_get_buffer(image[2]));
+    ASSERT_NE(pool->buffer[1], image_get_buffer(image[2]));
+
+    // Once a pooled buffer is back it is used again
+    image_dec_ref(image[0]);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_create_stream_image(&usbcmd, &image[0]));
+    ASSERT_EQ(pool->buffer[0], image_get_buffer(image[0]));
+    ASSERT_EQ(3u, usbcmd.buffer_pool_stats.hit_count);
+
+    // Without a pool every stream image is a regular allocation
+    usb_cmd_buffer_pool_release(pool);
+    usbcmd.buffer_pool = NULL;
+    image_dec_ref(image[3]);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, usb_cmd_create_stream_image(&usbcmd, &image[3]));
+    ASSERT_EQ(3u, usbcmd.buffer_pool_stats.miss_count);
+
+    for (int i = 0; i < 4; i++)
+    {
+        image_dec_ref(image[i]);
+    }
+
+    ASSERT_EQ(0, allocator_test_for_leaks());
+}
@@ -100,6 +100,7 @@ void k4a_unittest_deinit()
     DefaultValue<k4a_wait_result_t>::Clear();
     DefaultValue<k4a_buffer_result_t>::Clear();
     logger_destroy(g_logger_handle);
+    g_logger_handle = NULL;
 }
 
 #ifdef _WIN32
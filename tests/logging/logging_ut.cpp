@@ -10,8 +10,30 @@
 #include <azure_c_shared_utility/tickcounter.h>
 #include <azure_c_shared_utility/threadapi.h>
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
 using namespace testing;
 
+static void set_environment_variable(const char *name, const char *value)
+{
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    if (value[0] == '\0')
+    {
+        unsetenv(name);
+    }
+    else
+    {
+        setenv(name, value, 1);
+    }
+#endif
+}
+
 class logging_ut : public ::testing::Test
 {
 protected:
@@ -296,6 +318,148 @@ TEST_F(logging_ut, callback_threading)
     tickcounter_destroy(tick);
 }
 
+#define ASYNC_TEST_THREAD_MESSAGES (200)
+
+static int logger_async_thread(void *param)
+{
+    int thread_index = *(int *)param;
+    for (int i = 0; i < ASYNC_TEST_THREAD_MESSAGES; i++)
+    {
+        LOG_ERROR("Async test message %d %d", thread_index, i);
+    }
+    return TEST_RETURN_VALUE;
+}
+
+TEST_F(logging_ut, async)
+{
+    const char *log_file = "logging_ut_async.log";
+    logger_t logger_handle = nullptr;
+    logger_config_t config;
+    THREAD_HANDLE th[2];
+    int thread_index[2] = { 0, 1 };
+
+    // Replace the logger created by k4a_unittest_init with an asynchronous one writing to a file
+    k4a_unittest_deinit();
+    (void)remove(log_file);
+
+    logger_config_init_default(&config);
+    config.env_var_log_to_a_file = "K4A_LOGGING_UT_ASYNC_FILE";
+    config.env_var_log_async = "K4A_LOGGING_UT_ASYNC";
+    set_environment_variable(config.env_var_log_to_a_file, log_file);
+    set_environment_variable(config.env_var_log_async, "1");
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, logger_create(&config, &logger_handle));
+    ASSERT_TRUE(logger_is_file_based());
+
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&th[i], logger_async_thread, &thread_index[i]));
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        int result;
+        ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(th[i], &result));
+        ASSERT_EQ(result, TEST_RETURN_VALUE);
+    }
+
+    // Destroying the logger writes out everything still in the ring
+    logger_destroy(logger_handle);
+    uint64_t dropped_count = logger_get_async_dropped_count();
+
+    set_environment_variable(config.env_var_log_to_a_file, "");
+    set_environment_variable(config.env_var_log_async, "");
+
+    // Every message is either in the file, with the layout of the synchronous logger, or counted as dropped
+    std::ifstream file(log_file);
+    ASSERT_TRUE(file.is_open());
+    std::string line;
+    uint64_t message_count = 0;
+    bool dropped_reported = false;
+    while (std::getline(file, line))
+    {
+        if (line.find("Async test message") != std::string::npos)
+        {
+            EXPECT_EQ('[', line[0]);
+            EXPECT_NE(std::string::npos, line.find("] [error] [t="));
+            message_count++;
+        }
+        dropped_reported |= line.find("Dropped") != std::string::npos;
+    }
+    file.close();
+    (void)remove(log_file);
+
+    EXPECT_EQ((uint64_t)(2 * ASYNC_TEST_THREAD_MESSAGES), message_count + dropped_count);
+    EXPECT_EQ(dropped_count != 0, dropped_reported);
+
+    k4a_unittest_init();
+}
+
+typedef struct
+{
+    std::atomic<bool> done;
+    int thread_index;
+} logger_async_destroy_test_data_t;
+
+static int logger_async_destroy_thread(void *param)
+{
+    logger_async_destroy_test_data_t *data = (logger_async_destroy_test_data_t *)param;
+    int i = 0;
+    while (!data->done)
+    {
+        LOG_ERROR("Async destroy test message %d %d", data->thread_index, i++);
+    }
+    return TEST_RETURN_VALUE;
+}
+
+TEST_F(logging_ut, async_destroy_while_logging)
+{
+    const char *log_file = "logging_ut_async_destroy.log";
+    logger_config_t config;
+    THREAD_HANDLE th[4];
+    logger_async_destroy_test_data_t data[4];
+
+    k4a_unittest_deinit();
+
+    logger_config_init_default(&config);
+    config.env_var_log_to_a_file = "K4A_LOGGING_UT_ASYNC_FILE";
+    config.env_var_log_async = "K4A_LOGGING_UT_ASYNC";
+    set_environment_variable(config.env_var_log_to_a_file, log_file);
+    set_environment_variable(config.env_var_log_async, "1");
+
+    // Destroy the last logger while other threads are in the middle of logging, both before and after they start
+    // pushing into the ring, and create it again so the ring's lock and condition are torn down and rebuilt
+    for (int iteration = 0; iteration < 20; iteration++)
+    {
+        logger_t logger_handle = nullptr;
+        (void)remove(log_file);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, logger_create(&config, &logger_handle));
+
+        for (int i = 0; i < 4; i++)
+        {
+            data[i].done = false;
+            data[i].thread_index = i;
+            ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&th[i], logger_async_destroy_thread, &data[i]));
+        }
+
+        ThreadAPI_Sleep(iteration % 5);
+        logger_destroy(logger_handle);
+
+        for (int i = 0; i < 4; i++)
+        {
+            int result;
+            data[i].done = true;
+            ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(th[i], &result));
+            ASSERT_EQ(result, TEST_RETURN_VALUE);
+        }
+    }
+
+    set_environment_variable(config.env_var_log_to_a_file, "");
+    set_environment_variable(config.env_var_log_async, "");
+    (void)remove(log_file);
+
+    k4a_unittest_init();
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_commmon_main(argc, argv);